@@ -22,31 +22,56 @@
 #include <config.h>
 #endif
 
+#include <math.h>
 #include "calc-number.h"
 #include "calc-exponent.h"
+#include "calc-program.h"
+
+#define CALC_EXPONENT_HASH_SEED G_GUINT64_CONSTANT (0x1f83d9abfb41bd6b)
 
 G_DEFINE_TYPE (CalcExponent, calc_exponent, CALC_TYPE_EXPR)
 
 static void calc_exponent_render (CalcExpr *expr, cairo_t *cr, gsize size);
 static void calc_exponent_get_dims (CalcExpr *expr, cairo_t *cr, gint *width,
 				    gint *height, gsize size);
-static void calc_exponent_print (CalcExpr *expr, FILE *stream);
+static void calc_exponent_print_string (CalcExpr *expr, GString *str,
+					const CalcPrintFormat *format);
 static gboolean calc_exponent_equivalent (CalcExpr *self, CalcExpr *other);
 static gboolean calc_exponent_like_terms (CalcExpr *self, CalcExpr *other);
-static gulong calc_exponent_hash (CalcExpr *expr);
+static guint64 calc_exponent_hash (CalcExpr *expr);
 static gboolean calc_exponent_evaluate (CalcExpr *expr, CalcExpr *result);
+static gboolean calc_exponent_evaluate_approx (CalcExpr *expr,
+					       CalcApprox *result, gdouble tolerance);
+static gint calc_exponent_compile (CalcExpr *expr, CalcProgram *program);
+static void calc_exponent_intern (CalcExpr *expr);
+static void calc_exponent_replace_base (CalcExponent *self, CalcExpr *base,
+					gboolean owned);
+
+static void
+calc_exponent_dispose (GObject *obj)
+{
+  CalcExponent *self = CALC_EXPONENT (obj);
+  if (self->owns_base)
+    g_object_unref (self->base);
+  self->owns_base = FALSE;
+  G_OBJECT_CLASS (calc_exponent_parent_class)->dispose (obj);
+}
 
 static void
 calc_exponent_class_init (CalcExponentClass *klass)
 {
   CalcExprClass *exprclass = CALC_EXPR_CLASS (klass);
+  G_OBJECT_CLASS (klass)->dispose = calc_exponent_dispose;
   exprclass->render = calc_exponent_render;
   exprclass->get_dims = calc_exponent_get_dims;
-  exprclass->print = calc_exponent_print;
+  exprclass->print_string = calc_exponent_print_string;
   exprclass->equivalent = calc_exponent_equivalent;
   exprclass->like_terms = calc_exponent_like_terms;
   exprclass->hash = calc_exponent_hash;
   exprclass->evaluate = calc_exponent_evaluate;
+  exprclass->evaluate_approx = calc_exponent_evaluate_approx;
+  exprclass->compile = calc_exponent_compile;
+  exprclass->intern = calc_exponent_intern;
 }
 
 static void
@@ -97,14 +122,15 @@ calc_exponent_get_dims (CalcExpr *expr, cairo_t *cr, gint *width, gint *height,
 }
 
 static void
-calc_exponent_print (CalcExpr *expr, FILE *stream)
+calc_exponent_print_string (CalcExpr *expr, GString *str,
+			    const CalcPrintFormat *format)
 {
   CalcExponent *self = CALC_EXPONENT (expr);
-  fputc ('(', stream);
-  calc_expr_print (self->base, stream);
-  fprintf (stream, ")^(");
-  calc_expr_print (self->power, stream);
-  fputc (')', stream);
+  g_string_append_c (str, '(');
+  calc_expr_print_string (self->base, str, format);
+  g_string_append_len (str, ")^(", 3);
+  calc_expr_print_string (self->power, str, format);
+  g_string_append_c (str, ')');
 }
 
 static gboolean
@@ -123,30 +149,41 @@ calc_exponent_like_terms (CalcExpr *self, CalcExpr *other)
   return calc_exponent_equivalent (self, other);
 }
 
-static gulong
+static guint64
 calc_exponent_hash (CalcExpr *expr)
 {
   CalcExponent *self = CALC_EXPONENT (expr);
-  return calc_expr_hash (self->base) + calc_expr_hash (self->power);
+  guint64 hash = _calc_hash_combine (CALC_EXPONENT_HASH_SEED,
+				     calc_expr_hash (self->base));
+  return _calc_hash_combine (hash, calc_expr_hash (self->power));
 }
 
 static gboolean
 calc_exponent_evaluate (CalcExpr *expr, CalcExpr *result)
 {
-  CalcNumber *base_result;
+  CalcNumber *base_result = NULL;
   CalcNumber *power_result;
   CalcNumber *nresult;
   CalcExponent *self = CALC_EXPONENT (expr);
 
   g_return_val_if_fail (CALC_IS_NUMBER (result), FALSE);
-  base_result = calc_number_new (NULL);
   power_result = calc_number_new (NULL);
   nresult = CALC_NUMBER (result);
 
-  if (!calc_expr_evaluate (self->base, CALC_EXPR (base_result)))
-    goto err_exit;
   if (!calc_expr_evaluate (self->power, CALC_EXPR (power_result)))
     goto err_exit;
+
+  /* Factors of terms have a power of one, so skip the exponentiation */
+  if (power_result->value.type == CALC_NUMBER_TYPE_INTEGER
+      && calc_number_cmp_ui (power_result, 1) == 0)
+    {
+      g_object_unref (power_result);
+      return calc_expr_evaluate (self->base, result);
+    }
+
+  base_result = calc_number_new (NULL);
+  if (!calc_expr_evaluate (self->base, CALC_EXPR (base_result)))
+    goto err_exit;
   calc_number_pow (&nresult, base_result, power_result);
 
   g_object_unref (base_result);
@@ -154,11 +191,135 @@ calc_exponent_evaluate (CalcExpr *expr, CalcExpr *result)
   return TRUE;
 
  err_exit:
-  g_object_unref (base_result);
+  if (base_result != NULL)
+    g_object_unref (base_result);
   g_object_unref (power_result);
   return FALSE;
 }
 
+/* Only exact integer powers up to this magnitude are computed with
+   doubles. Each multiplication adds to the relative error. */
+#define CALC_EXPONENT_APPROX_MAX_POWER 1024
+
+/* Stores @base raised to the integer power @n in @result */
+
+static gboolean
+calc_exponent_approx_pow (CalcApprox *result, const CalcApprox *base,
+			  glong n)
+{
+  CalcApprox square = *base;
+  CalcApprox one = { 1, 0 };
+  glong i;
+
+  /* Binary powering */
+  *result = one;
+  for (i = n; i != 0; i /= 2)
+    {
+      if (i % 2 != 0 && !_calc_approx_mul (result, result, &square))
+	return FALSE;
+      if (i / 2 != 0 && !_calc_approx_mul (&square, &square, &square))
+	return FALSE;
+    }
+  if (n < 0)
+    return _calc_approx_div (result, &one, result);
+  return TRUE;
+}
+
+static gboolean
+calc_exponent_evaluate_approx (CalcExpr *expr, CalcApprox *result,
+			       gdouble tolerance)
+{
+  CalcExponent *self = CALC_EXPONENT (expr);
+  CalcApprox power;
+  CalcApprox base;
+  gboolean exact = FALSE;
+  glong n;
+
+  if (!_calc_expr_approx (self->power, &power, tolerance)
+      || power.error != 0
+      || fabs (power.value) > CALC_EXPONENT_APPROX_MAX_POWER
+      || power.value != (glong) power.value)
+    return FALSE;
+  n = (glong) power.value;
+  if (n == 1)
+    return _calc_expr_approx (self->base, result, tolerance);
+  if (!_calc_expr_approx (self->base, &base, tolerance))
+    return FALSE;
+
+  /* Powering multiplies the relative error of the base, so the base is
+     evaluated exactly before the whole exponent is */
+  for (;;)
+    {
+      if (!calc_exponent_approx_pow (result, &base, n))
+	return FALSE;
+      if (result->error <= tolerance * fabs (result->value)
+	  || !_calc_approx_escalate (&self->base, &base, &exact, 1, TRUE))
+	return TRUE;
+    }
+}
+
+static gint
+calc_exponent_compile (CalcExpr *expr, CalcProgram *program)
+{
+  CalcExponent *self = CALC_EXPONENT (expr);
+  gint dest;
+  guint mark;
+  gint base;
+  gint power;
+
+  /* Factors of terms have a power of one, so use the base directly. This
+     is checked before allocating any registers, which would otherwise be
+     held until the parent expression releases its own. */
+  if (CALC_IS_NUMBER (self->power)
+      && CALC_NUMBER (self->power)->value.type == CALC_NUMBER_TYPE_INTEGER
+      && calc_value_cmp_ui (&CALC_NUMBER (self->power)->value, 1) == 0)
+    return _calc_program_compile_expr (program, self->base);
+
+  dest = _calc_program_alloc (program);
+  mark = _calc_program_mark (program);
+  power = _calc_program_compile_expr (program, self->power);
+  if (power < 0)
+    return -1;
+  base = _calc_program_compile_expr (program, self->base);
+  if (base < 0)
+    return -1;
+
+  _calc_program_emit (program, CALC_PROGRAM_OP_POW, dest, base, power);
+  _calc_program_release (program, mark);
+  return dest;
+}
+
+/* The power is left alone, since every term containing @expr as a factor
+   holds a reference to it */
+
+static void
+calc_exponent_intern (CalcExpr *expr)
+{
+  CalcExponent *self = CALC_EXPONENT (expr);
+  CalcExpr *base = _calc_expr_intern (self->base);
+  if (base == self->base)
+    return;
+
+  /* The table of interned expressions may release the shared base before
+     @self is disposed */
+  calc_exponent_replace_base (self, g_object_ref (base), TRUE);
+}
+
+/* Changes the base of @self to @base. If @owned is set, @self takes over a
+   reference to @base and releases it when the base is replaced again. */
+
+static void
+calc_exponent_replace_base (CalcExponent *self, CalcExpr *base,
+			    gboolean owned)
+{
+  _calc_expr_unlink (CALC_EXPR (self), self->base);
+  _calc_expr_link (CALC_EXPR (self), base);
+  if (self->owns_base)
+    g_object_unref (self->base);
+  self->base = base;
+  self->owns_base = owned;
+}
+
 /**
  * calc_exponent_new:
  * @base: the base of the exponent
@@ -179,6 +340,8 @@ calc_exponent_new (CalcExpr *base, CalcExpr *power)
   g_return_val_if_fail (CALC_IS_EXPR (base), NULL);
   g_return_val_if_fail (CALC_IS_EXPR (power), NULL);
   self = g_object_new (CALC_TYPE_EXPONENT, NULL);
+  _calc_expr_link (CALC_EXPR (self), base);
+  _calc_expr_link (CALC_EXPR (self), power);
   self->base = base;
   self->power = power;
   return self;
@@ -191,8 +354,8 @@ calc_exponent_new (CalcExpr *base, CalcExpr *power)
  *
  * Changes the base of @self to @base. @base should not be freed until @self
  * is no longer in use, but the previous base value of @self may be freed after
- * calling this function. If @self is an invalid exponent or @base is an
- * invalid expression, no action is performed.
+ * calling this function. If @self is an invalid or interned exponent or @base
+ * is an invalid expression, no action is performed.
  **/
 
 void
@@ -200,7 +363,9 @@ calc_exponent_set_base (CalcExponent *self, CalcExpr *base)
 {
   g_return_if_fail (CALC_IS_EXPONENT (self));
   g_return_if_fail (CALC_IS_EXPR (base));
-  self->base = base;
+  g_return_if_fail (!calc_expr_is_interned (CALC_EXPR (self)));
+  calc_expr_changed (CALC_EXPR (self));
+  calc_exponent_replace_base (self, base, FALSE);
 }
 
 /**
@@ -227,8 +392,8 @@ calc_exponent_get_base (CalcExponent *self)
  *
  * Changes the power of @self to @power. @power should not be freed until @self
  * is no longer in use, but the previous power of @self may be freed after
- * calling this function. If @self is an invalid exponent or @power is an
- * invalid expression, no action is performed.
+ * calling this function. If @self is an invalid or interned exponent or
+ * @power is an invalid expression, no action is performed.
  **/
 
 void
@@ -236,6 +401,10 @@ calc_exponent_set_power (CalcExponent *self, CalcExpr *power)
 {
   g_return_if_fail (CALC_IS_EXPONENT (self));
   g_return_if_fail (CALC_IS_EXPR (power));
+  g_return_if_fail (!calc_expr_is_interned (CALC_EXPR (self)));
+  calc_expr_changed (CALC_EXPR (self));
+  _calc_expr_unlink (CALC_EXPR (self), self->power);
+  _calc_expr_link (CALC_EXPR (self), power);
   self->power = power;
 }
 
@@ -255,3 +424,18 @@ calc_exponent_get_power (CalcExponent *self)
   g_return_val_if_fail (CALC_IS_EXPONENT (self), NULL);
   return self->power;
 }
+
+/* Creates an exponent with the same base and power as @self, which may be
+   modified even if @self is interned */
+
+CalcExponent *
+_calc_exponent_copy (CalcExponent *self)
+{
+  CalcExponent *copy = calc_exponent_new (self->base, self->power);
+  if (self->owns_base)
+    {
+      g_object_ref (self->base);
+      copy->owns_base = TRUE;
+    }
+  return copy;
+}
@@ -44,6 +44,7 @@ struct _CalcExponent
   CalcExpr parent;
   CalcExpr *base;
   CalcExpr *power;
+  gboolean owns_base;
 };
 
 CalcExponent *calc_exponent_new (CalcExpr *base, CalcExpr *power);
@@ -52,6 +53,14 @@ CalcExpr *calc_exponent_get_base (CalcExponent *self);
 void calc_exponent_set_power (CalcExponent *self, CalcExpr *power);
 CalcExpr *calc_exponent_get_power (CalcExponent *self);
 
+#ifdef _LIBCALC_INTERNAL
+
+/*< private >*/
+
+CalcExponent *_calc_exponent_copy (CalcExponent *self);
+
+#endif
+
 G_END_DECLS
 
 #endif
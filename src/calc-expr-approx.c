@@ -0,0 +1,306 @@
+/*************************************************************************
+ * calc-expr-approx.c -- This file is part of libcalc.                   *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+
+#define _LIBCALC_INTERNAL
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <float.h>
+#include <math.h>
+#include "calc-number.h"
+
+/* The largest relative error of a rounded double operation */
+#define CALC_APPROX_UNIT (DBL_EPSILON / 2)
+
+/* Error bounds are computed with doubles as well, so they are enlarged by
+   this factor to remain bounds despite their own rounding errors */
+#define CALC_APPROX_SLACK (1 + 64 * DBL_EPSILON)
+
+/* Integers up to this magnitude are exact doubles */
+#define CALC_APPROX_EXACT_MAX (G_GINT64_CONSTANT (1) << DBL_MANT_DIG)
+
+/* Returns TRUE if the signed integer @x is an exact double */
+#define CALC_APPROX_IS_EXACT(x)				\
+  ((gint64) (x) >= -CALC_APPROX_EXACT_MAX			\
+   && (gint64) (x) <= CALC_APPROX_EXACT_MAX)
+
+/* More digits than this cannot be guaranteed by a double */
+#define CALC_APPROX_MAX_DIGITS 15
+
+/* Approximations with at most this relative error are about as accurate
+   as an exact result rounded to a double */
+#define CALC_APPROX_ROUNDED (2 * DBL_EPSILON)
+
+/* Checks that the value of @self is zero or a normal double, whose rounding
+   errors are bounded relative to the value, and enlarges its error bound to
+   account for the rounding of the bound itself */
+
+static gboolean
+calc_approx_finish (CalcApprox *self)
+{
+  if (!isfinite (self->value) || !isfinite (self->error))
+    return FALSE;
+  if (self->value != 0 && fabs (self->value) < DBL_MIN)
+    return FALSE;
+  self->error *= CALC_APPROX_SLACK;
+  if (self->error != 0 && self->error < DBL_MIN)
+    self->error = DBL_MIN;
+  return TRUE;
+}
+
+/* Approximates @value with a double. Returns FALSE if @value is outside the
+   range of normal doubles. */
+
+gboolean
+_calc_approx_set_value (CalcApprox *self, const CalcValue *value)
+{
+  CalcValueView view;
+  mpz_srcptr z;
+  mpq_srcptr q;
+  glong bits;
+
+  switch (value->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      if (value->small)
+	{
+	  self->value = value->small_num;
+	  self->error = CALC_APPROX_IS_EXACT (value->small_num) ? 0
+	    : CALC_APPROX_UNIT * fabs (self->value);
+	  break;
+	}
+      z = _calc_value_get_z (value, &view);
+      if (mpz_sizeinbase (z, 2) > DBL_MAX_EXP)
+	return FALSE;
+      /* Conversions from GNU MP truncate */
+      self->value = mpz_get_d (z);
+      self->error = DBL_EPSILON * fabs (self->value);
+      break;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      if (value->small && CALC_APPROX_IS_EXACT (value->small_num)
+	  && (guint64) value->small_den <= CALC_APPROX_EXACT_MAX)
+	{
+	  self->value = (gdouble) value->small_num / value->small_den;
+	  self->error = CALC_APPROX_UNIT * fabs (self->value);
+	  break;
+	}
+      q = _calc_value_get_q (value, &view);
+      bits = (glong) mpz_sizeinbase (mpq_numref (q), 2)
+	- (glong) mpz_sizeinbase (mpq_denref (q), 2);
+      if (bits >= DBL_MAX_EXP || bits <= DBL_MIN_EXP)
+	return FALSE;
+      self->value = mpq_get_d (q);
+      self->error = DBL_EPSILON * fabs (self->value);
+      break;
+    case CALC_NUMBER_TYPE_FLOATING:
+      if (!mpfr_number_p (value->floating))
+	return FALSE;
+      if (mpfr_zero_p (value->floating))
+	{
+	  self->value = 0;
+	  self->error = 0;
+	  return TRUE;
+	}
+      if (mpfr_get_exp (value->floating) < DBL_MIN_EXP
+	  || mpfr_get_exp (value->floating) > DBL_MAX_EXP)
+	return FALSE;
+      self->value = mpfr_get_d (value->floating, MPFR_RNDN);
+      self->error = mpfr_get_prec (value->floating) <= DBL_MANT_DIG ? 0
+	: CALC_APPROX_UNIT * fabs (self->value);
+      break;
+    case CALC_NUMBER_TYPE_DECIMAL:
+      /* The conversion rounds to nearest */
+      self->value = calc_value_get_double (value);
+      self->error = CALC_APPROX_UNIT * fabs (self->value);
+      break;
+    case CALC_NUMBER_TYPE_DOUBLE:
+      self->value = value->native;
+      self->error = 0;
+      break;
+    default:
+      return FALSE;
+    }
+  return calc_approx_finish (self);
+}
+
+/* Stores @a + @b in @result, which may be the same as either operand */
+
+gboolean
+_calc_approx_add (CalcApprox *result, const CalcApprox *a,
+		  const CalcApprox *b)
+{
+  gdouble value = a->value + b->value;
+  result->error = a->error + b->error + CALC_APPROX_UNIT * fabs (value);
+  result->value = value;
+  return calc_approx_finish (result);
+}
+
+/* Stores @a * @b in @result, which may be the same as either operand */
+
+gboolean
+_calc_approx_mul (CalcApprox *result, const CalcApprox *a,
+		  const CalcApprox *b)
+{
+  gdouble value = a->value * b->value;
+  result->error = fabs (a->value) * b->error + fabs (b->value) * a->error
+    + a->error * b->error + CALC_APPROX_UNIT * fabs (value);
+  result->value = value;
+  return calc_approx_finish (result);
+}
+
+/* Stores @a / @b in @result, which may be the same as either operand.
+   Fails if the error of @b is more than half of its magnitude, which
+   includes any @b that may be zero. */
+
+gboolean
+_calc_approx_div (CalcApprox *result, const CalcApprox *a,
+		  const CalcApprox *b)
+{
+  gdouble den = fabs (b->value);
+  gdouble value;
+  if (den == 0 || b->error > den / 2)
+    return FALSE;
+  value = a->value / b->value;
+  result->error = (a->error + fabs (value) * b->error) / (den - b->error)
+    + CALC_APPROX_UNIT * fabs (value);
+  result->value = value;
+  return calc_approx_finish (result);
+}
+
+/* Evaluates @self with calc_expr_evaluate() and rounds the result to a
+   double */
+
+static gboolean
+calc_expr_approx_exact (CalcExpr *self, CalcApprox *result)
+{
+  CalcNumber *number = calc_number_new (NULL);
+  gboolean ret = calc_expr_evaluate (self, CALC_EXPR (number))
+    && _calc_approx_set_value (result, &number->value);
+  g_object_unref (number);
+  return ret;
+}
+
+/* Approximates @self with a relative error of at most @tolerance. If the
+   double evaluation of @self fails or has too large an error even after
+   its subexpressions were escalated with _calc_approx_escalate(), @self
+   is evaluated with calc_expr_evaluate() and the result is rounded to a
+   double, so only the subexpressions that need it are computed with GNU MP
+   and MPFR. */
+
+gboolean
+_calc_expr_approx (CalcExpr *self, CalcApprox *result, gdouble tolerance)
+{
+  CalcExprClass *klass = CALC_EXPR_GET_CLASS (self);
+  if (klass->evaluate_approx != NULL
+      && klass->evaluate_approx (self, result, tolerance)
+      && result->error <= tolerance * fabs (result->value))
+    return TRUE;
+  return calc_expr_approx_exact (self, result);
+}
+
+/* Replaces the approximation in @approxs of the subexpression in @exprs
+   with the largest error by the rounded result of calc_expr_evaluate(),
+   so an expression whose combined error is too large only evaluates the
+   subexpressions responsible for it exactly. Errors are compared relative
+   to their values if @relative is set, as for products, and absolutely
+   otherwise, as for sums. @exact marks the subexpressions that were
+   already replaced. Returns FALSE if no subexpression can be made more
+   accurate this way or if its evaluation fails. */
+
+gboolean
+_calc_approx_escalate (CalcExpr **exprs, CalcApprox *approxs,
+		       gboolean *exact, guint n, gboolean relative)
+{
+  gdouble worst = 0;
+  gdouble error;
+  guint index = n;
+  guint i;
+
+  for (i = 0; i < n; i++)
+    {
+      if (exact[i]
+	  || approxs[i].error <= CALC_APPROX_ROUNDED * fabs (approxs[i].value))
+	continue;
+      error = approxs[i].error;
+      if (relative)
+	error = approxs[i].value == 0 ? HUGE_VAL
+	  : error / fabs (approxs[i].value);
+      if (error > worst)
+	{
+	  worst = error;
+	  index = i;
+	}
+    }
+  if (index == n)
+    return FALSE;
+  exact[index] = TRUE;
+  return calc_expr_approx_exact (exprs[index], &approxs[index]);
+}
+
+/**
+ * calc_expr_evaluate_approx:
+ * @self: the expression to evaluate
+ * @result: where to store the result of the calculation
+ * @digits: the number of significant decimal digits needed
+ *
+ * Evaluates the arithmetic expression @self like calc_expr_evaluate(), but
+ * computes with hardware doubles where it can. A bound on the error is kept
+ * alongside each double. If the bound shows that the result has a relative
+ * error of at most 10^-@digits, the result is stored in @result as a
+ * floating-point number with the precision of a double. Subexpressions
+ * whose values are outside the range of doubles are evaluated with
+ * calc_expr_evaluate() instead. When the error of a subexpression is too
+ * large, its own subexpressions contributing the most to the error are
+ * evaluated with calc_expr_evaluate() one at a time, and the subexpression
+ * as a whole only if that is not enough. If the whole expression is, the
+ * result is the same as that of calc_expr_evaluate(). Since a double has
+ * less than 16 significant digits, larger values of @digits always use
+ * calc_expr_evaluate().
+ *
+ * Returns: %TRUE if the calculation succeeded
+ **/
+
+gboolean
+calc_expr_evaluate_approx (CalcExpr *self, CalcExpr *result, guint digits)
+{
+  CalcExprClass *klass;
+  CalcApprox approx;
+  gdouble tolerance = 1;
+  mpfr_t fr;
+  guint i;
+
+  g_return_val_if_fail (CALC_IS_EXPR (self), FALSE);
+  g_return_val_if_fail (CALC_IS_NUMBER (result), FALSE);
+  klass = CALC_EXPR_GET_CLASS (self);
+  if (digits > CALC_APPROX_MAX_DIGITS || klass->evaluate_approx == NULL)
+    return calc_expr_evaluate (self, result);
+
+  for (i = 0; i < digits; i++)
+    tolerance /= 10;
+  if (!klass->evaluate_approx (self, &approx, tolerance)
+      || approx.error > tolerance * fabs (approx.value))
+    return calc_expr_evaluate (self, result);
+
+  calc_expr_changed (result);
+  _calc_value_init_fr (fr, DBL_MANT_DIG);
+  mpfr_set_d (fr, approx.value, MPFR_RNDN);
+  _calc_value_take_fr (&CALC_NUMBER (result)->value, fr);
+  return TRUE;
+}
@@ -22,13 +22,76 @@
 #include <config.h>
 #endif
 
+#include <stdlib.h>
+#include <string.h>
 #include "calc-expr.h"
 
-G_DEFINE_ABSTRACT_TYPE (CalcExpr, calc_expr, G_TYPE_OBJECT)
+/* Initial size of the string used to print expressions */
+#define CALC_EXPR_SCRATCH_SIZE 256
+
+typedef struct
+{
+  guint64 hash;
+  gboolean hash_valid;
+  GHashTable *intern_table;
+  GSList *parents;
+  GSList *children;
+} CalcExprPrivate;
+
+G_DEFINE_ABSTRACT_TYPE_WITH_PRIVATE (CalcExpr, calc_expr, G_TYPE_OBJECT)
+
+/* Protects the links between expressions and their subexpressions. Since
+   the hash of an expression depends on the hashes of its subexpressions,
+   which may be shared by other expressions, changing an expression
+   invalidates the cached hashes of every expression linked above it. */
+G_LOCK_DEFINE_STATIC (calc_expr_links);
+
+static void calc_expr_scratch_free (gpointer data);
+
+static GPrivate calc_expr_scratch = G_PRIVATE_INIT (calc_expr_scratch_free);
+
+static void calc_expr_intern_table_free (gpointer data);
+
+/* Table of interned expressions of the current thread. Each expression in
+   the table is unique up to equivalence, and the table holds a reference
+   to it. */
+static GPrivate calc_expr_intern_table =
+  G_PRIVATE_INIT (calc_expr_intern_table_free);
+
+static void
+calc_expr_dispose (GObject *obj)
+{
+  CalcExpr *self = CALC_EXPR (obj);
+  CalcExprPrivate *priv = calc_expr_get_instance_private (self);
+  CalcExprPrivate *other;
+  GSList *iter;
+
+  G_LOCK (calc_expr_links);
+  for (iter = priv->parents; iter != NULL; iter = iter->next)
+    {
+      other = calc_expr_get_instance_private (iter->data);
+      other->children = g_slist_remove (other->children, self);
+    }
+  for (iter = priv->children; iter != NULL; iter = iter->next)
+    {
+      other = calc_expr_get_instance_private (iter->data);
+      other->parents = g_slist_remove (other->parents, self);
+    }
+  G_UNLOCK (calc_expr_links);
+
+  g_slist_free (priv->parents);
+  g_slist_free (priv->children);
+  priv->parents = NULL;
+  priv->children = NULL;
+  priv->hash_valid = FALSE;
+  G_OBJECT_CLASS (calc_expr_parent_class)->dispose (obj);
+}
 
 static void
 calc_expr_class_init (CalcExprClass *klass)
 {
+  G_OBJECT_CLASS (klass)->dispose = calc_expr_dispose;
+  klass->print_string = NULL;
   klass->render = NULL;
   klass->get_dims = NULL;
   klass->print = NULL;
@@ -42,6 +105,43 @@ calc_expr_init (CalcExpr *self)
 {
 }
 
+/* Invalidates the cached hash of @self and of the expressions containing
+   it. Interned expressions are removed from their table while their hash
+   still locates them, and the references held by the table are added to
+   @released. The caller must hold the lock on expression links. */
+
+static void
+calc_expr_invalidate (CalcExpr *self, GSList **released)
+{
+  CalcExprPrivate *priv = calc_expr_get_instance_private (self);
+  GSList *iter;
+
+  /* Parents of an expression without a cached hash have none either */
+  if (!priv->hash_valid)
+    return;
+  if (priv->intern_table != NULL)
+    {
+      g_hash_table_steal (priv->intern_table, self);
+      priv->intern_table = NULL;
+      *released = g_slist_prepend (*released, self);
+    }
+  priv->hash_valid = FALSE;
+  for (iter = priv->parents; iter != NULL; iter = iter->next)
+    calc_expr_invalidate (iter->data, released);
+}
+
+/* Gets the hash of @self if it has already been computed */
+
+static gboolean
+calc_expr_get_cached_hash (CalcExpr *self, guint64 *hash)
+{
+  CalcExprPrivate *priv = calc_expr_get_instance_private (self);
+  if (!priv->hash_valid)
+    return FALSE;
+  *hash = priv->hash;
+  return TRUE;
+}
+
 /**
  * calc_expr_render:
  * @self: the expression to render
@@ -95,24 +195,170 @@ calc_expr_get_dims (CalcExpr *self, cairo_t *cr, gint *width, gint *height,
   klass->get_dims (self, cr, width, height, size);
 }
 
+static void
+calc_expr_scratch_free (gpointer data)
+{
+  g_string_free (data, TRUE);
+}
+
+/* Takes the string used by the current thread to print expressions, so
+   that printing does not allocate once the string has grown large enough.
+   The string is taken out of the slot while in use, which keeps nested
+   calls through subclasses that only implement the print method safe. */
+
+static GString *
+calc_expr_scratch_acquire (void)
+{
+  GString *str = g_private_get (&calc_expr_scratch);
+  if (str == NULL)
+    return g_string_sized_new (CALC_EXPR_SCRATCH_SIZE);
+  g_private_set (&calc_expr_scratch, NULL);
+  g_string_truncate (str, 0);
+  return str;
+}
+
+static void
+calc_expr_scratch_release (GString *str)
+{
+  if (g_private_get (&calc_expr_scratch) == NULL)
+    g_private_set (&calc_expr_scratch, str);
+  else
+    g_string_free (str, TRUE);
+}
+
 /**
  * calc_expr_print:
  * @self: the expression to print
  * @stream: the stdio stream to print to
  *
- * Prints a textual representation of @self to the stdio stream @stream. If
- * @self is not a valid expression or @stream is %NULL, no action is performed.
+ * Prints a textual representation of @self to the stdio stream @stream, as
+ * formatted by calc_expr_print_string() with the default format. The text
+ * is written to @stream all at once. If @self is not a valid expression or
+ * @stream is %NULL, no action is performed.
  **/
 
 void
 calc_expr_print (CalcExpr *self, FILE *stream)
 {
   CalcExprClass *klass;
+  GString *str;
   g_return_if_fail (CALC_IS_EXPR (self));
   g_return_if_fail (stream != NULL);
   klass = CALC_EXPR_GET_CLASS (self);
-  g_return_if_fail (klass->print != NULL);
-  klass->print (self, stream);
+  if (klass->print_string == NULL)
+    {
+      g_return_if_fail (klass->print != NULL);
+      klass->print (self, stream);
+      return;
+    }
+
+  str = calc_expr_scratch_acquire ();
+  calc_expr_print_string (self, str, NULL);
+  fwrite (str->str, 1, str->len, stream);
+  calc_expr_scratch_release (str);
+}
+
+/**
+ * calc_expr_print_string:
+ * @self: the expression to print
+ * @str: the string to append to
+ * @format: (nullable): the format to use, or %NULL for the default format
+ *
+ * Appends a textual representation of @self to @str. Each expression is
+ * appended directly to @str, so printing into a string that is reused for
+ * many expressions does not allocate memory once the string has grown
+ * large enough. If @self is not a valid expression, @str is %NULL or
+ * @format is invalid, no action is performed.
+ **/
+
+void
+calc_expr_print_string (CalcExpr *self, GString *str,
+			const CalcPrintFormat *format)
+{
+  static const CalcPrintFormat default_format = CALC_PRINT_FORMAT_INIT;
+  CalcExprClass *klass;
+  g_return_if_fail (CALC_IS_EXPR (self));
+  g_return_if_fail (str != NULL);
+  if (format == NULL)
+    format = &default_format;
+  g_return_if_fail (format->precision >= 0);
+  g_return_if_fail (format->conversion == 'f' || format->conversion == 'e'
+		    || format->conversion == 'g');
+  klass = CALC_EXPR_GET_CLASS (self);
+  if (klass->print_string == NULL)
+    {
+      gchar *text;
+      gsize len;
+      FILE *stream;
+      g_return_if_fail (klass->print != NULL);
+      stream = open_memstream (&text, &len);
+      klass->print (self, stream);
+      fclose (stream);
+      g_string_append_len (str, text, len);
+      free (text);
+      return;
+    }
+  klass->print_string (self, str, format);
+}
+
+/**
+ * calc_expr_print_buffer:
+ * @self: the expression to print
+ * @buffer: (out caller-allocates) (array length=size): the buffer to print
+ * to
+ * @size: the size of @buffer in bytes
+ * @format: (nullable): the format to use, or %NULL for the default format
+ *
+ * Prints a textual representation of @self into @buffer, as formatted by
+ * calc_expr_print_string(). Like snprintf(), at most @size bytes including
+ * the terminating nul byte are written, and the text is truncated if
+ * @buffer is too small. @buffer may be %NULL if @size is zero.
+ *
+ * Returns: the length of the full text, not including the terminating nul
+ * byte, or zero if @self or @format is invalid
+ **/
+
+gsize
+calc_expr_print_buffer (CalcExpr *self, gchar *buffer, gsize size,
+			const CalcPrintFormat *format)
+{
+  GString *str;
+  gsize len;
+  g_return_val_if_fail (CALC_IS_EXPR (self), 0);
+  g_return_val_if_fail (buffer != NULL || size == 0, 0);
+  str = calc_expr_scratch_acquire ();
+  calc_expr_print_string (self, str, format);
+  len = str->len;
+  if (size > 0)
+    {
+      gsize n = MIN (len, size - 1);
+      memcpy (buffer, str->str, n);
+      buffer[n] = '\0';
+    }
+  calc_expr_scratch_release (str);
+  return len;
+}
+
+/**
+ * calc_expr_to_string:
+ * @self: the expression to print
+ * @format: (nullable): the format to use, or %NULL for the default format
+ *
+ * Prints a textual representation of @self into a newly allocated string,
+ * as formatted by calc_expr_print_string().
+ *
+ * Returns: (transfer full): the text, which should be freed with g_free(),
+ * or %NULL if @self is not a valid expression
+ **/
+
+gchar *
+calc_expr_to_string (CalcExpr *self, const CalcPrintFormat *format)
+{
+  GString *str;
+  g_return_val_if_fail (CALC_IS_EXPR (self), NULL);
+  str = g_string_new (NULL);
+  calc_expr_print_string (self, str, format);
+  return g_string_free (str, FALSE);
 }
 
 /**
@@ -121,7 +367,9 @@ calc_expr_print (CalcExpr *self, FILE *stream)
  * @other: the second expression
  *
  * Compares two expressions to determine if they are equivalent. Expressions
- * are equivalent if one can be rewritten as the other.
+ * are equivalent if one can be rewritten as the other. Two expressions
+ * interned by the same thread are only equivalent if they are the same
+ * object.
  *
  * Returns: %TRUE if both expressions are valid and equivalent, otherwise %FALSE
  **/
@@ -129,9 +377,30 @@ calc_expr_print (CalcExpr *self, FILE *stream)
 gboolean
 calc_expr_equivalent (CalcExpr *self, CalcExpr *other)
 {
+  CalcExprPrivate *self_priv;
+  CalcExprPrivate *other_priv;
   CalcExprClass *klass;
+  guint64 self_hash;
+  guint64 other_hash;
   g_return_val_if_fail (CALC_IS_EXPR (self), FALSE);
   g_return_val_if_fail (CALC_IS_EXPR (other), FALSE);
+
+  if (self == other)
+    return TRUE;
+
+  /* Interned expressions are unique within their table */
+  self_priv = calc_expr_get_instance_private (self);
+  other_priv = calc_expr_get_instance_private (other);
+  if (self_priv->intern_table != NULL
+      && self_priv->intern_table == other_priv->intern_table)
+    return FALSE;
+
+  /* Expressions with different hashes cannot be equivalent */
+  if (calc_expr_get_cached_hash (self, &self_hash)
+      && calc_expr_get_cached_hash (other, &other_hash)
+      && self_hash != other_hash)
+    return FALSE;
+
   klass = CALC_EXPR_GET_CLASS (self);
   g_return_val_if_fail (klass->equivalent != NULL, FALSE);
   return klass->equivalent (self, other);
@@ -162,22 +431,63 @@ calc_expr_like_terms (CalcExpr *self, CalcExpr *other)
  * calc_expr_hash:
  * @self: the expression
  *
- * Computes a hash of an expression, used internally for sorting purposes.
- * The hash returned by this function should only be used for sorting. Matching
- * hashes does not guarantee equivalent expressions, which should be tested
- * for using calc_expr_equivalent() instead.
+ * Computes a 64-bit hash of the structure of an expression. Equivalent
+ * expressions always have the same hash, including numbers with the same
+ * value but different types, so the hash may be used to index expressions.
+ * Matching hashes do not guarantee equivalent expressions, which should be
+ * tested for using calc_expr_equivalent() instead.
+ *
+ * The hash is computed once and cached until @self or one of its
+ * subexpressions is changed.
  *
  * Returns: the hash of the expression
  **/
 
-gulong
+guint64
 calc_expr_hash (CalcExpr *self)
 {
+  CalcExprPrivate *priv;
   CalcExprClass *klass;
-  g_return_val_if_fail (CALC_IS_EXPR (self), FALSE);
+  g_return_val_if_fail (CALC_IS_EXPR (self), 0);
+  priv = calc_expr_get_instance_private (self);
+  if (priv->hash_valid)
+    return priv->hash;
+
   klass = CALC_EXPR_GET_CLASS (self);
-  g_return_val_if_fail (klass->hash != NULL, FALSE);
-  return klass->hash (self);
+  g_return_val_if_fail (klass->hash != NULL, 0);
+  priv->hash = klass->hash (self);
+  priv->hash_valid = TRUE;
+  return priv->hash;
+}
+
+/**
+ * calc_expr_changed:
+ * @self: the expression
+ *
+ * Invalidates the cached hash of @self and of every expression containing
+ * it. This is done automatically by all functions that modify an
+ * expression, so it only needs to be called after changing the value of a
+ * #CalcNumber directly through its @value field. Interned expressions
+ * containing @self are no longer interned afterwards. If @self is not a
+ * valid expression or is interned itself, no action is performed.
+ **/
+
+void
+calc_expr_changed (CalcExpr *self)
+{
+  CalcExprPrivate *priv;
+  GSList *released = NULL;
+  g_return_if_fail (CALC_IS_EXPR (self));
+  priv = calc_expr_get_instance_private (self);
+  /* Interned expressions are shared and must not be changed */
+  g_return_if_fail (priv->intern_table == NULL);
+  if (!priv->hash_valid)
+    return;
+
+  G_LOCK (calc_expr_links);
+  calc_expr_invalidate (self, &released);
+  G_UNLOCK (calc_expr_links);
+  g_slist_free_full (released, g_object_unref);
 }
 
 /**
@@ -198,11 +508,173 @@ calc_expr_evaluate (CalcExpr *self, CalcExpr *result)
 {
   CalcExprClass *klass;
   g_return_val_if_fail (CALC_IS_EXPR (self), FALSE);
+  g_return_val_if_fail (CALC_IS_EXPR (result), FALSE);
   klass = CALC_EXPR_GET_CLASS (self);
   g_return_val_if_fail (klass->evaluate != NULL, FALSE);
+  calc_expr_changed (result);
   return klass->evaluate (self, result);
 }
 
+static guint
+calc_expr_intern_hash (gconstpointer key)
+{
+  guint64 hash = calc_expr_hash ((CalcExpr *) key);
+  return (guint) (hash ^ (hash >> 32));
+}
+
+static gboolean
+calc_expr_intern_equal (gconstpointer a, gconstpointer b)
+{
+  return G_OBJECT_TYPE (a) == G_OBJECT_TYPE (b)
+    && calc_expr_equivalent ((CalcExpr *) a, (CalcExpr *) b);
+}
+
+static void
+calc_expr_intern_release (gpointer key, gpointer value, gpointer user_data)
+{
+  CalcExprPrivate *priv = calc_expr_get_instance_private (key);
+  priv->intern_table = NULL;
+}
+
+static void
+calc_expr_intern_table_free (gpointer data)
+{
+  g_hash_table_foreach (data, calc_expr_intern_release, NULL);
+  g_hash_table_destroy (data);
+}
+
+/**
+ * calc_expr_intern:
+ * @self: the expression
+ *
+ * Gets the interned instance of an expression. If an expression equivalent
+ * to @self has already been interned by the calling thread, that
+ * expression is returned. Otherwise, @self itself is interned after its
+ * subexpressions, so repeated subtrees of @self end up sharing a single
+ * instance. Interned expressions compare equivalent only to themselves,
+ * and calc_expr_compile() evaluates each of them once per run, however
+ * many times it appears.
+ *
+ * Interning is opt-in, and only applies to sums, terms, exponents and
+ * fractions. Other expressions are returned unchanged. Interned
+ * expressions are shared and cannot be modified: functions that fold like
+ * terms into an interned subexpression modify a copy of it instead.
+ * Changing a number contained in an interned expression, such as the
+ * coefficient of a term, removes that expression from the table. Interned
+ * expressions stay alive until calc_expr_clear_interned() is called or the
+ * thread exits.
+ *
+ * Returns: (transfer full): the interned expression
+ **/
+
+CalcExpr *
+calc_expr_intern (CalcExpr *self)
+{
+  g_return_val_if_fail (CALC_IS_EXPR (self), NULL);
+  return g_object_ref (_calc_expr_intern (self));
+}
+
+/**
+ * calc_expr_is_interned:
+ * @self: the expression
+ *
+ * Checks if @self is the interned instance returned by calc_expr_intern().
+ *
+ * Returns: %TRUE if @self is interned
+ **/
+
+gboolean
+calc_expr_is_interned (CalcExpr *self)
+{
+  CalcExprPrivate *priv;
+  g_return_val_if_fail (CALC_IS_EXPR (self), FALSE);
+  priv = calc_expr_get_instance_private (self);
+  return priv->intern_table != NULL;
+}
+
+/**
+ * calc_expr_clear_interned:
+ *
+ * Releases the references held by the table of interned expressions of
+ * the calling thread. Expressions that are still referenced elsewhere are
+ * no longer interned, and may be modified again.
+ **/
+
+void
+calc_expr_clear_interned (void)
+{
+  GHashTable *table = g_private_get (&calc_expr_intern_table);
+  if (table != NULL)
+    {
+      g_hash_table_foreach (table, calc_expr_intern_release, NULL);
+      g_hash_table_remove_all (table);
+    }
+}
+
+/* Same as calc_expr_intern(), but the returned expression is owned by the
+   table of interned expressions */
+
+CalcExpr *
+_calc_expr_intern (CalcExpr *self)
+{
+  CalcExprPrivate *priv = calc_expr_get_instance_private (self);
+  CalcExprClass *klass = CALC_EXPR_GET_CLASS (self);
+  GHashTable *table;
+  CalcExpr *shared;
+
+  if (priv->intern_table != NULL || klass->intern == NULL)
+    return self;
+  klass->intern (self);
+
+  table = g_private_get (&calc_expr_intern_table);
+  if (table == NULL)
+    {
+      table = g_hash_table_new_full (calc_expr_intern_hash,
+				     calc_expr_intern_equal, g_object_unref,
+				     NULL);
+      g_private_set (&calc_expr_intern_table, table);
+    }
+  shared = g_hash_table_lookup (table, self);
+  if (shared != NULL)
+    return shared;
+
+  /* The hash is cached before interning, and is kept from then on */
+  calc_expr_hash (self);
+  priv->intern_table = table;
+  g_hash_table_add (table, g_object_ref (self));
+  return self;
+}
+
+/* Records that @child is a subexpression of @parent, so changing @child
+   invalidates the cached hash of @parent. An expression linked more than
+   once to the same parent must be unlinked the same number of times. */
+
+void
+_calc_expr_link (CalcExpr *parent, CalcExpr *child)
+{
+  CalcExprPrivate *parent_priv = calc_expr_get_instance_private (parent);
+  CalcExprPrivate *child_priv = calc_expr_get_instance_private (child);
+  GSList *released = NULL;
+  G_LOCK (calc_expr_links);
+  parent_priv->children = g_slist_prepend (parent_priv->children, child);
+  child_priv->parents = g_slist_prepend (child_priv->parents, parent);
+  if (!child_priv->hash_valid)
+    calc_expr_invalidate (parent, &released);
+  G_UNLOCK (calc_expr_links);
+  g_slist_free_full (released, g_object_unref);
+}
+
+void
+_calc_expr_unlink (CalcExpr *parent, CalcExpr *child)
+{
+  CalcExprPrivate *parent_priv = calc_expr_get_instance_private (parent);
+  CalcExprPrivate *child_priv = calc_expr_get_instance_private (child);
+  G_LOCK (calc_expr_links);
+  parent_priv->children = g_slist_remove (parent_priv->children, child);
+  child_priv->parents = g_slist_remove (child_priv->parents, parent);
+  G_UNLOCK (calc_expr_links);
+}
+
 PangoLayout *
 _calc_expr_layout_new (cairo_t *cr, const gchar *face, gsize size,
 		       const gchar *text)
@@ -28,11 +28,68 @@ G_BEGIN_DECLS
 #define CALC_TYPE_EXPR calc_expr_get_type ()
 G_DECLARE_DERIVABLE_TYPE (CalcExpr, calc_expr, CALC, EXPR, GObject)
 
+/**
+ * CalcPrintFormat:
+ * @precision: the number of digits printed after the decimal point of
+ * floating-point numbers
+ * @conversion: the printf() conversion used for floating-point numbers,
+ * one of 'f', 'e' or 'g'
+ *
+ * Options controlling the textual representation of expressions. A format
+ * initialized with %CALC_PRINT_FORMAT_INIT produces the default output.
+ **/
+
+typedef struct
+{
+  gint precision;
+  gchar conversion;
+} CalcPrintFormat;
+
+/**
+ * CALC_PRINT_FORMAT_INIT:
+ *
+ * Initializer for a #CalcPrintFormat with the default options, which print
+ * floating-point numbers with eight digits after the decimal point.
+ **/
+
+#define CALC_PRINT_FORMAT_INIT { 8, 'f' }
+
+/**
+ * CalcApprox:
+ * @value: the approximate value
+ * @error: an upper bound of the absolute difference between @value and the
+ * exact value
+ *
+ * A hardware double approximation of a value, used by
+ * calc_expr_evaluate_approx().
+ **/
+
+typedef struct
+{
+  gdouble value;
+  gdouble error;
+} CalcApprox;
+
+struct _CalcProgram;
+
 /**
  * CalcExprClass:
+ * @evaluate_approx: evaluates an arithmetic expression with hardware
+ * doubles, or returns %FALSE if it cannot be evaluated that way. Operands
+ * should be approximated with _calc_expr_approx().
+ * @compile: appends the instructions that evaluate an arithmetic expression
+ * to a #CalcProgram and returns the operand holding the result, or -1 if it
+ * cannot be compiled. Operands should be compiled with
+ * _calc_program_compile_expr().
+ * @intern: replaces the subexpressions of an expression with their interned
+ * instances from _calc_expr_intern(). Expressions that do not implement it
+ * are never interned.
+ * @print_string: appends the textual representation of an expression to a
+ * #GString
  * @render: renders an expression on a #cairo_t object
  * @get_dims: determines the graphical dimensions of an object
- * @print: prints an expression to a stdio stream
+ * @print: prints an expression to a stdio stream, only used if
+ * @print_string is not implemented
  * @equivalent: checks if two expressions are equivalent
  * @like_terms: checks if two expressions are like terms
  * @hash: computes a hash of an expression
@@ -45,16 +102,22 @@ struct _CalcExprClass
 {
   /*< private >*/
   GObjectClass parent;
-  gpointer padding[9];
+  gpointer padding[5];
 
   /*< public >*/
+  gboolean (*evaluate_approx) (CalcExpr *self, CalcApprox *result,
+			       gdouble tolerance);
+  gint (*compile) (CalcExpr *self, struct _CalcProgram *program);
+  void (*intern) (CalcExpr *self);
+  void (*print_string) (CalcExpr *self, GString *str,
+			const CalcPrintFormat *format);
   void (*render) (CalcExpr *self, cairo_t *cr, gsize size);
   void (*get_dims) (CalcExpr *self, cairo_t *cr, gint *width, gint *height,
 		    gsize size);
   void (*print) (CalcExpr *self, FILE *stream);
   gboolean (*equivalent) (CalcExpr *self, CalcExpr *other);
   gboolean (*like_terms) (CalcExpr *self, CalcExpr *other);
-  gulong (*hash) (CalcExpr *self);
+  guint64 (*hash) (CalcExpr *self);
   gboolean (*evaluate) (CalcExpr *self, CalcExpr *result);
 };
 
@@ -62,10 +125,21 @@ void calc_expr_render (CalcExpr *self, cairo_t *cr, gsize size);
 void calc_expr_get_dims (CalcExpr *self, cairo_t *cr, gint *width, gint *height,
 			 gsize size);
 void calc_expr_print (CalcExpr *self, FILE *stream);
+void calc_expr_print_string (CalcExpr *self, GString *str,
+			     const CalcPrintFormat *format);
+gsize calc_expr_print_buffer (CalcExpr *self, gchar *buffer, gsize size,
+			      const CalcPrintFormat *format);
+gchar *calc_expr_to_string (CalcExpr *self, const CalcPrintFormat *format);
 gboolean calc_expr_equivalent (CalcExpr *self, CalcExpr *other);
 gboolean calc_expr_like_terms (CalcExpr *self, CalcExpr *other);
-gulong calc_expr_hash (CalcExpr *self);
+guint64 calc_expr_hash (CalcExpr *self);
+void calc_expr_changed (CalcExpr *self);
 gboolean calc_expr_evaluate (CalcExpr *self, CalcExpr *result);
+gboolean calc_expr_evaluate_approx (CalcExpr *self, CalcExpr *result,
+				    guint digits);
+CalcExpr *calc_expr_intern (CalcExpr *self);
+gboolean calc_expr_is_interned (CalcExpr *self);
+void calc_expr_clear_interned (void);
 
 #ifdef _LIBCALC_INTERNAL
 
@@ -75,6 +149,20 @@ PangoLayout *_calc_expr_layout_new (cairo_t *cr, const gchar *face, gsize size,
 #define _LIBCALC_REGULAR_FONT "CMU Serif"
 #define _LIBCALC_ITALIC_FONT "CMU Classical Serif Italic"
 
+CalcExpr *_calc_expr_intern (CalcExpr *self);
+void _calc_expr_link (CalcExpr *parent, CalcExpr *child);
+void _calc_expr_unlink (CalcExpr *parent, CalcExpr *child);
+gboolean _calc_expr_approx (CalcExpr *self, CalcApprox *result,
+			    gdouble tolerance);
+gboolean _calc_approx_add (CalcApprox *result, const CalcApprox *a,
+			   const CalcApprox *b);
+gboolean _calc_approx_mul (CalcApprox *result, const CalcApprox *a,
+			   const CalcApprox *b);
+gboolean _calc_approx_div (CalcApprox *result, const CalcApprox *a,
+			   const CalcApprox *b);
+gboolean _calc_approx_escalate (CalcExpr **exprs, CalcApprox *approxs,
+				gboolean *exact, guint n, gboolean relative);
+
 #endif
 
 G_END_DECLS
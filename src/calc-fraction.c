@@ -22,26 +22,55 @@
 #include <config.h>
 #endif
 
+#include <math.h>
 #include "calc-number.h"
 #include "calc-fraction.h"
+#include "calc-program.h"
+
+#define CALC_FRACTION_HASH_SEED G_GUINT64_CONSTANT (0x5be0cd19137e2179)
 
 G_DEFINE_TYPE (CalcFraction, calc_fraction, CALC_TYPE_EXPR)
 
-static void calc_fraction_print (CalcExpr *expr, FILE *stream);
+static void calc_fraction_print_string (CalcExpr *expr, GString *str,
+					const CalcPrintFormat *format);
 static gboolean calc_fraction_equivalent (CalcExpr *self, CalcExpr *other);
 static gboolean calc_fraction_like_terms (CalcExpr *self, CalcExpr *other);
-static gulong calc_fraction_hash (CalcExpr *expr);
+static guint64 calc_fraction_hash (CalcExpr *expr);
 static gboolean calc_fraction_evaluate (CalcExpr *expr, CalcExpr *result);
+static gboolean calc_fraction_evaluate_approx (CalcExpr *expr,
+					       CalcApprox *result, gdouble tolerance);
+static gint calc_fraction_compile (CalcExpr *expr, CalcProgram *program);
+static void calc_fraction_intern (CalcExpr *expr);
+static void calc_fraction_replace (CalcFraction *self, CalcExpr **operand,
+				   gboolean *owns_operand, CalcExpr *expr,
+				   gboolean owned);
+
+static void
+calc_fraction_dispose (GObject *obj)
+{
+  CalcFraction *self = CALC_FRACTION (obj);
+  if (self->owns_num)
+    g_object_unref (self->num);
+  if (self->owns_denom)
+    g_object_unref (self->denom);
+  self->owns_num = FALSE;
+  self->owns_denom = FALSE;
+  G_OBJECT_CLASS (calc_fraction_parent_class)->dispose (obj);
+}
 
 static void
 calc_fraction_class_init (CalcFractionClass *klass)
 {
   CalcExprClass *exprclass = CALC_EXPR_CLASS (klass);
-  exprclass->print = calc_fraction_print;
+  G_OBJECT_CLASS (klass)->dispose = calc_fraction_dispose;
+  exprclass->print_string = calc_fraction_print_string;
   exprclass->equivalent = calc_fraction_equivalent;
   exprclass->like_terms = calc_fraction_like_terms;
   exprclass->hash = calc_fraction_hash;
   exprclass->evaluate = calc_fraction_evaluate;
+  exprclass->evaluate_approx = calc_fraction_evaluate_approx;
+  exprclass->compile = calc_fraction_compile;
+  exprclass->intern = calc_fraction_intern;
 }
 
 static void
@@ -50,14 +79,15 @@ calc_fraction_init (CalcFraction *self)
 }
 
 static void
-calc_fraction_print (CalcExpr *expr, FILE *stream)
+calc_fraction_print_string (CalcExpr *expr, GString *str,
+			    const CalcPrintFormat *format)
 {
   CalcFraction *self = CALC_FRACTION (expr);
-  fputc ('(', stream);
-  calc_expr_print (self->num, stream);
-  fprintf (stream, ")/(");
-  calc_expr_print (self->denom, stream);
-  fputc (')', stream);
+  g_string_append_c (str, '(');
+  calc_expr_print_string (self->num, str, format);
+  g_string_append_len (str, ")/(", 3);
+  calc_expr_print_string (self->denom, str, format);
+  g_string_append_c (str, ')');
 }
 
 static gboolean
@@ -79,11 +109,13 @@ calc_fraction_like_terms (CalcExpr *self, CalcExpr *other)
 			       CALC_FRACTION (other)->denom);
 }
 
-static gulong
+static guint64
 calc_fraction_hash (CalcExpr *expr)
 {
   CalcFraction *self = CALC_FRACTION (expr);
-  return calc_expr_hash (self->num) + calc_expr_hash (self->denom);
+  guint64 hash = _calc_hash_combine (CALC_FRACTION_HASH_SEED,
+				     calc_expr_hash (self->num));
+  return _calc_hash_combine (hash, calc_expr_hash (self->denom));
 }
 
 static gboolean
@@ -115,6 +147,84 @@ calc_fraction_evaluate (CalcExpr *expr, CalcExpr *result)
   return FALSE;
 }
 
+static gboolean
+calc_fraction_evaluate_approx (CalcExpr *expr, CalcApprox *result,
+			       gdouble tolerance)
+{
+  CalcFraction *self = CALC_FRACTION (expr);
+  CalcExpr *operands[2] = { self->num, self->denom };
+  CalcApprox approxs[2];
+  gboolean exact[2] = { FALSE, FALSE };
+  gboolean ret;
+
+  if (!_calc_expr_approx (self->num, &approxs[0], tolerance)
+      || !_calc_expr_approx (self->denom, &approxs[1], tolerance))
+    return FALSE;
+
+  /* A denominator too inexact to divide by, or operands whose errors add
+     up to too much, are evaluated exactly before the whole fraction is */
+  for (;;)
+    {
+      ret = _calc_approx_div (result, &approxs[0], &approxs[1]);
+      if (ret && result->error <= tolerance * fabs (result->value))
+	return TRUE;
+      if (!_calc_approx_escalate (operands, approxs, exact, 2, TRUE))
+	return ret;
+    }
+}
+
+static gint
+calc_fraction_compile (CalcExpr *expr, CalcProgram *program)
+{
+  CalcFraction *self = CALC_FRACTION (expr);
+  gint dest = _calc_program_alloc (program);
+  guint mark = _calc_program_mark (program);
+  gint num;
+  gint denom;
+
+  num = _calc_program_compile_expr (program, self->num);
+  if (num < 0)
+    return -1;
+  denom = _calc_program_compile_expr (program, self->denom);
+  if (denom < 0)
+    return -1;
+  _calc_program_emit (program, CALC_PROGRAM_OP_DIV, dest, num, denom);
+  _calc_program_release (program, mark);
+  return dest;
+}
+
+static void
+calc_fraction_intern (CalcExpr *expr)
+{
+  CalcFraction *self = CALC_FRACTION (expr);
+  CalcExpr *num = _calc_expr_intern (self->num);
+  CalcExpr *denom = _calc_expr_intern (self->denom);
+
+  /* The table of interned expressions may release the shared operands
+     before @self is disposed */
+  if (num != self->num)
+    calc_fraction_replace (self, &self->num, &self->owns_num,
+			   g_object_ref (num), TRUE);
+  if (denom != self->denom)
+    calc_fraction_replace (self, &self->denom, &self->owns_denom,
+			   g_object_ref (denom), TRUE);
+}
+
+/* Changes @operand of @self to @expr. If @owned is set, @self takes over a
+   reference to @expr and releases it when the operand is replaced again. */
+
+static void
+calc_fraction_replace (CalcFraction *self, CalcExpr **operand,
+		       gboolean *owns_operand, CalcExpr *expr, gboolean owned)
+{
+  _calc_expr_unlink (CALC_EXPR (self), *operand);
+  _calc_expr_link (CALC_EXPR (self), expr);
+  if (*owns_operand)
+    g_object_unref (*operand);
+  *operand = expr;
+  *owns_operand = owned;
+}
+
 /**
  * calc_fraction_new:
  * @num: the numerator
@@ -135,6 +245,8 @@ calc_fraction_new (CalcExpr *num, CalcExpr *denom)
   g_return_val_if_fail (CALC_IS_EXPR (num), NULL);
   g_return_val_if_fail (CALC_IS_EXPR (denom), NULL);
   self = g_object_new (CALC_TYPE_FRACTION, NULL);
+  _calc_expr_link (CALC_EXPR (self), num);
+  _calc_expr_link (CALC_EXPR (self), denom);
   self->num = num;
   self->denom = denom;
   return self;
@@ -145,10 +257,10 @@ calc_fraction_new (CalcExpr *num, CalcExpr *denom)
  * @self: the fraction
  * @num: the new numerator
  *
- * Changes the numerator of @self to @num. If @self is an invalid fraction
- * or @num is an invalid expression, no action is performed. @num should not
- * be freed until @self is no longer in use, but the previous numerator of
- * @self may be freed after calling this function.
+ * Changes the numerator of @self to @num. If @self is an invalid or interned
+ * fraction or @num is an invalid expression, no action is performed. @num
+ * should not be freed until @self is no longer in use, but the previous
+ * numerator of @self may be freed after calling this function.
  **/
 
 void
@@ -156,7 +268,9 @@ calc_fraction_set_num (CalcFraction *self, CalcExpr *num)
 {
   g_return_if_fail (CALC_IS_FRACTION (self));
   g_return_if_fail (CALC_IS_EXPR (num));
-  self->num = num;
+  g_return_if_fail (!calc_expr_is_interned (CALC_EXPR (self)));
+  calc_expr_changed (CALC_EXPR (self));
+  calc_fraction_replace (self, &self->num, &self->owns_num, num, FALSE);
 }
 
 /**
@@ -181,10 +295,10 @@ calc_fraction_get_num (CalcFraction *self)
  * @self: the fraction
  * @denom: the new denominator
  *
- * Changes the denominator of @self to @denom. If @self is an invalid fraction
- * or @denom is an invalid expression, no action is performed. @denom should not
- * be freed until @self is no longer in use, but the previous denominator of
- * @self may be freed after calling this function.
+ * Changes the denominator of @self to @denom. If @self is an invalid or
+ * interned fraction or @denom is an invalid expression, no action is
+ * performed. @denom should not be freed until @self is no longer in use, but
+ * the previous denominator of @self may be freed after calling this function.
  **/
 
 void
@@ -192,7 +306,10 @@ calc_fraction_set_denom (CalcFraction *self, CalcExpr *denom)
 {
   g_return_if_fail (CALC_IS_FRACTION (self));
   g_return_if_fail (CALC_IS_EXPR (denom));
-  self->denom = denom;
+  g_return_if_fail (!calc_expr_is_interned (CALC_EXPR (self)));
+  calc_expr_changed (CALC_EXPR (self));
+  calc_fraction_replace (self, &self->denom, &self->owns_denom, denom,
+			 FALSE);
 }
 
 /**
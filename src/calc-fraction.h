@@ -44,6 +44,8 @@ struct _CalcFraction
   CalcExpr parent;
   CalcExpr *num;
   CalcExpr *denom;
+  gboolean owns_num;
+  gboolean owns_denom;
 };
 
 CalcFraction *calc_fraction_new (CalcExpr *num, CalcExpr *denom);
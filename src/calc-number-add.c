@@ -40,47 +40,12 @@
 void
 calc_number_add (CalcNumber **result, CalcNumber *a, CalcNumber *b)
 {
-  CalcNumberType type;
-  CalcNumber *ca;
-  CalcNumber *cb;
-
   g_return_if_fail (result != NULL);
   g_return_if_fail (*result == NULL || CALC_IS_NUMBER (*result));
   g_return_if_fail (CALC_IS_NUMBER (a));
   g_return_if_fail (CALC_IS_NUMBER (b));
-
-  type = _calc_number_get_final_type (a->type, b->type);
-  ca = calc_number_new (a);
-  cb = calc_number_new (b);
-  calc_number_cast (ca, type);
-  calc_number_cast (cb, type);
-
-  if (*result == NULL)
-    {
-      *result = calc_number_new (NULL);
-      mpz_clear ((*result)->integer);
-    }
-  else
-    _calc_number_release (*result);
-  switch (type)
-    {
-    case CALC_NUMBER_TYPE_INTEGER:
-      mpz_init ((*result)->integer);
-      mpz_add ((*result)->integer, ca->integer, cb->integer);
-      break;
-    case CALC_NUMBER_TYPE_RATIONAL:
-      mpq_init ((*result)->rational);
-      mpq_add ((*result)->rational, ca->rational, cb->rational);
-      break;
-    case CALC_NUMBER_TYPE_FLOATING:
-      mpfr_init ((*result)->floating);
-      mpfr_add ((*result)->floating, ca->floating, cb->floating, MPFR_RNDN);
-      break;
-    }
-  (*result)->type = type;
-
-  g_object_unref (ca);
-  g_object_unref (cb);
+  _calc_number_prepare (result);
+  calc_value_add (&(*result)->value, &a->value, &b->value);
 }
 
 /**
@@ -99,36 +64,11 @@ calc_number_add (CalcNumber **result, CalcNumber *a, CalcNumber *b)
 void
 calc_number_add_z (CalcNumber **result, CalcNumber *a, mpz_t b)
 {
-  mpq_t temp;
   g_return_if_fail (result != NULL);
   g_return_if_fail (*result == NULL || CALC_IS_NUMBER (*result));
   g_return_if_fail (CALC_IS_NUMBER (a));
-  if (*result == NULL)
-    {
-      *result = calc_number_new (NULL);
-      mpz_clear ((*result)->integer);
-    }
-  else
-    _calc_number_release (*result);
-  (*result)->type = a->type;
-  switch (a->type)
-    {
-    case CALC_NUMBER_TYPE_INTEGER:
-      mpz_init ((*result)->integer);
-      mpz_add ((*result)->integer, a->integer, b);
-      break;
-    case CALC_NUMBER_TYPE_RATIONAL:
-      mpq_init ((*result)->rational);
-      mpq_init (temp);
-      mpq_set_z (temp, b);
-      mpq_add ((*result)->rational, a->rational, temp);
-      mpq_clear (temp);
-      break;
-    case CALC_NUMBER_TYPE_FLOATING:
-      mpfr_init ((*result)->floating);
-      mpfr_add_z ((*result)->floating, a->floating, b, MPFR_RNDN);
-      break;
-    }
+  _calc_number_prepare (result);
+  calc_value_add_z (&(*result)->value, &a->value, b);
 }
 
 /**
@@ -147,37 +87,11 @@ calc_number_add_z (CalcNumber **result, CalcNumber *a, mpz_t b)
 void
 calc_number_add_q (CalcNumber **result, CalcNumber *a, mpq_t b)
 {
-  mpq_t temp;
   g_return_if_fail (result != NULL);
   g_return_if_fail (*result == NULL || CALC_IS_NUMBER (*result));
   g_return_if_fail (CALC_IS_NUMBER (a));
-  if (*result == NULL)
-    {
-      *result = calc_number_new (NULL);
-      mpz_clear ((*result)->integer);
-    }
-  else
-    _calc_number_release (*result);
-  (*result)->type = a->type;
-  switch (a->type)
-    {
-    case CALC_NUMBER_TYPE_INTEGER:
-      (*result)->type = CALC_NUMBER_TYPE_RATIONAL;
-      mpq_init ((*result)->rational);
-      mpq_init (temp);
-      mpq_set_z (temp, a->integer);
-      mpq_add ((*result)->rational, temp, b);
-      mpq_clear (temp);
-      break;
-    case CALC_NUMBER_TYPE_RATIONAL:
-      mpq_init ((*result)->rational);
-      mpq_add ((*result)->rational, a->rational, b);
-      break;
-    case CALC_NUMBER_TYPE_FLOATING:
-      mpfr_init ((*result)->floating);
-      mpfr_add_q ((*result)->floating, a->floating, b, MPFR_RNDN);
-      break;
-    }
+  _calc_number_prepare (result);
+  calc_value_add_q (&(*result)->value, &a->value, b);
 }
 
 /**
@@ -196,10 +110,11 @@ calc_number_add_q (CalcNumber **result, CalcNumber *a, mpq_t b)
 void
 calc_number_add_f (CalcNumber **result, CalcNumber *a, mpf_t b)
 {
-  mpfr_t temp;
-  mpfr_init_set_f (temp, b, MPFR_RNDN);
-  calc_number_add_fr (result, a, temp);
-  mpfr_clear (temp);
+  g_return_if_fail (result != NULL);
+  g_return_if_fail (*result == NULL || CALC_IS_NUMBER (*result));
+  g_return_if_fail (CALC_IS_NUMBER (a));
+  _calc_number_prepare (result);
+  calc_value_add_f (&(*result)->value, &a->value, b);
 }
 
 /**
@@ -221,29 +136,8 @@ calc_number_add_fr (CalcNumber **result, CalcNumber *a, mpfr_t b)
   g_return_if_fail (result != NULL);
   g_return_if_fail (*result == NULL || CALC_IS_NUMBER (*result));
   g_return_if_fail (CALC_IS_NUMBER (a));
-  if (*result == NULL)
-    {
-      *result = calc_number_new (NULL);
-      mpz_clear ((*result)->integer);
-    }
-  else
-    _calc_number_release (*result);
-  (*result)->type = CALC_NUMBER_TYPE_FLOATING;
-  mpfr_init ((*result)->floating);
-  switch (a->type)
-    {
-    case CALC_NUMBER_TYPE_INTEGER:
-      mpfr_set_z ((*result)->floating, a->integer, MPFR_RNDN);
-      mpfr_add ((*result)->floating, (*result)->floating, b, MPFR_RNDN);
-      break;
-    case CALC_NUMBER_TYPE_RATIONAL:
-      mpfr_set_q ((*result)->floating, a->rational, MPFR_RNDN);
-      mpfr_add ((*result)->floating, (*result)->floating, b, MPFR_RNDN);
-      break;
-    case CALC_NUMBER_TYPE_FLOATING:
-      mpfr_add ((*result)->floating, a->floating, b, MPFR_RNDN);
-      break;
-    }
+  _calc_number_prepare (result);
+  calc_value_add_fr (&(*result)->value, &a->value, b);
 }
 
 /**
@@ -265,29 +159,8 @@ calc_number_add_d (CalcNumber **result, CalcNumber *a, double b)
   g_return_if_fail (result != NULL);
   g_return_if_fail (*result == NULL || CALC_IS_NUMBER (*result));
   g_return_if_fail (CALC_IS_NUMBER (a));
-  if (*result == NULL)
-    {
-      *result = calc_number_new (NULL);
-      mpz_clear ((*result)->integer);
-    }
-  else
-    _calc_number_release (*result);
-  (*result)->type = CALC_NUMBER_TYPE_FLOATING;
-  mpfr_init ((*result)->floating);
-  switch (a->type)
-    {
-    case CALC_NUMBER_TYPE_INTEGER:
-      mpfr_set_z ((*result)->floating, a->integer, MPFR_RNDN);
-      mpfr_add_d ((*result)->floating, (*result)->floating, b, MPFR_RNDN);
-      break;
-    case CALC_NUMBER_TYPE_RATIONAL:
-      mpfr_set_q ((*result)->floating, a->rational, MPFR_RNDN);
-      mpfr_add_d ((*result)->floating, (*result)->floating, b, MPFR_RNDN);
-      break;
-    case CALC_NUMBER_TYPE_FLOATING:
-      mpfr_add_d ((*result)->floating, a->floating, b, MPFR_RNDN);
-      break;
-    }
+  _calc_number_prepare (result);
+  calc_value_add_d (&(*result)->value, &a->value, b);
 }
 
 /**
@@ -306,36 +179,11 @@ calc_number_add_d (CalcNumber **result, CalcNumber *a, double b)
 void
 calc_number_add_ui (CalcNumber **result, CalcNumber *a, unsigned long b)
 {
-  mpq_t temp;
   g_return_if_fail (result != NULL);
   g_return_if_fail (*result == NULL || CALC_IS_NUMBER (*result));
   g_return_if_fail (CALC_IS_NUMBER (a));
-  if (*result == NULL)
-    {
-      *result = calc_number_new (NULL);
-      mpz_clear ((*result)->integer);
-    }
-  else
-    _calc_number_release (*result);
-  (*result)->type = a->type;
-  switch (a->type)
-    {
-    case CALC_NUMBER_TYPE_INTEGER:
-      mpz_init ((*result)->integer);
-      mpz_add_ui ((*result)->integer, a->integer, b);
-      break;
-    case CALC_NUMBER_TYPE_RATIONAL:
-      mpq_init ((*result)->rational);
-      mpq_init (temp);
-      mpq_set_ui (temp, b, 1);
-      mpq_add ((*result)->rational, a->rational, temp);
-      mpq_clear (temp);
-      break;
-    case CALC_NUMBER_TYPE_FLOATING:
-      mpfr_init ((*result)->floating);
-      mpfr_add_ui ((*result)->floating, a->floating, b, MPFR_RNDN);
-      break;
-    }
+  _calc_number_prepare (result);
+  calc_value_add_ui (&(*result)->value, &a->value, b);
 }
 
 /**
@@ -354,37 +202,63 @@ calc_number_add_ui (CalcNumber **result, CalcNumber *a, unsigned long b)
 void
 calc_number_add_si (CalcNumber **result, CalcNumber *a, signed long b)
 {
-  mpq_t temp;
   g_return_if_fail (result != NULL);
   g_return_if_fail (*result == NULL || CALC_IS_NUMBER (*result));
   g_return_if_fail (CALC_IS_NUMBER (a));
-  if (*result == NULL)
-    {
-      *result = calc_number_new (NULL);
-      mpz_clear ((*result)->integer);
-    }
-  else
-    _calc_number_release (*result);
-  (*result)->type = a->type;
-  switch (a->type)
-    {
-    case CALC_NUMBER_TYPE_INTEGER:
-      mpz_init ((*result)->integer);
-      if (b >= 0)
-	mpz_add_ui ((*result)->integer, a->integer, b);
-      else
-	mpz_sub_ui ((*result)->integer, a->integer, -b);
-      break;
-    case CALC_NUMBER_TYPE_RATIONAL:
-      mpq_init ((*result)->rational);
-      mpq_init (temp);
-      mpq_set_si (temp, b, 1);
-      mpq_add ((*result)->rational, a->rational, temp);
-      mpq_clear (temp);
-      break;
-    case CALC_NUMBER_TYPE_FLOATING:
-      mpfr_init ((*result)->floating);
-      mpfr_add_si ((*result)->floating, a->floating, b, MPFR_RNDN);
-      break;
-    }
+  _calc_number_prepare (result);
+  calc_value_add_si (&(*result)->value, &a->value, b);
+}
+
+/**
+ * calc_number_add_inplace:
+ * @self: the number to add to
+ * @value: the number to add
+ *
+ * Adds @value to @self and stores the result in @self. The result is the
+ * same as calling calc_number_add() with @self as both the result and the
+ * first addend, but the storage of @self is reused where possible, which
+ * makes this suitable for accumulating a running total. @value may be the
+ * same number as @self. If @self or @value are invalid numbers, no action
+ * is performed.
+ **/
+
+void
+calc_number_add_inplace (CalcNumber *self, CalcNumber *value)
+{
+  g_return_if_fail (CALC_IS_NUMBER (self));
+  g_return_if_fail (CALC_IS_NUMBER (value));
+  calc_expr_changed (CALC_EXPR (self));
+  calc_value_add_inplace (&self->value, &value->value);
+}
+
+/**
+ * calc_number_sum:
+ * @result: the pointer to store the result
+ * @values: (array length=n): the numbers to add
+ * @n: the number of elements in @values
+ *
+ * Adds all of the numbers in @values and stores the result in @result. Any
+ * previous value in @result will be erased. The sum is exact if all of the
+ * numbers are exact, and otherwise rounded only once as described for
+ * calc_value_sum(). If @result points to %NULL, a new #CalcNumber is
+ * allocated and @result will point to it. If @result is %NULL or any of the
+ * elements of @values are invalid numbers, no action is performed.
+ **/
+
+void
+calc_number_sum (CalcNumber **result, CalcNumber **values, gsize n)
+{
+  CalcValueAcc acc;
+  gsize i;
+  g_return_if_fail (result != NULL);
+  g_return_if_fail (*result == NULL || CALC_IS_NUMBER (*result));
+  g_return_if_fail (n == 0 || values != NULL);
+  for (i = 0; i < n; i++)
+    g_return_if_fail (CALC_IS_NUMBER (values[i]));
+
+  _calc_value_acc_init (&acc);
+  for (i = 0; i < n; i++)
+    _calc_value_acc_add (&acc, &values[i]->value);
+  _calc_number_prepare (result);
+  _calc_value_acc_finish (&acc, &(*result)->value);
 }
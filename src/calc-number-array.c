@@ -0,0 +1,1078 @@
+/*************************************************************************
+ * calc-number-array.c -- This file is part of libcalc.                  *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+
+#define _LIBCALC_INTERNAL
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <float.h>
+#include <math.h>
+#include <string.h>
+#include "calc-number-array.h"
+
+/* The kinds of storage used by elements */
+enum
+{
+  CALC_NUMBER_ARRAY_INTEGER,
+  CALC_NUMBER_ARRAY_FLOATING,
+  CALC_NUMBER_ARRAY_SPILL
+};
+
+/* Element-wise operations */
+typedef enum
+{
+  CALC_NUMBER_ARRAY_ADD,
+  CALC_NUMBER_ARRAY_SUB,
+  CALC_NUMBER_ARRAY_MUL,
+  CALC_NUMBER_ARRAY_DIV,
+  CALC_NUMBER_ARRAY_POW
+} CalcNumberArrayOp;
+
+/* Results are computed in blocks of this many elements. If any word-sized
+   result in a block overflows, the whole block is computed again with GNU
+   MP, which is possible because the results are not stored until the
+   block is finished, even if the result array is one of the operands. */
+#define CALC_NUMBER_ARRAY_BLOCK_SIZE 256
+
+/* Storage for loading word-sized elements as values */
+typedef struct
+{
+  CalcValue integer;
+  CalcValue floating;
+} CalcNumberArrayTemp;
+
+G_DEFINE_TYPE (CalcNumberArray, calc_number_array, G_TYPE_OBJECT)
+
+static void
+calc_number_array_free_spill (CalcNumberArray *self)
+{
+  gsize i;
+  for (i = 0; self->n_spill > 0 && i < self->len; i++)
+    {
+      if (self->kinds[i] == CALC_NUMBER_ARRAY_SPILL)
+	{
+	  calc_value_clear (self->words[i].spill);
+	  g_free (self->words[i].spill);
+	  self->n_spill--;
+	}
+    }
+}
+
+static void
+calc_number_array_finalize (GObject *obj)
+{
+  CalcNumberArray *self = CALC_NUMBER_ARRAY (obj);
+  calc_number_array_free_spill (self);
+  g_free (self->kinds);
+  g_free (self->words);
+  G_OBJECT_CLASS (calc_number_array_parent_class)->finalize (obj);
+}
+
+static void
+calc_number_array_class_init (CalcNumberArrayClass *klass)
+{
+  G_OBJECT_CLASS (klass)->finalize = calc_number_array_finalize;
+}
+
+static void
+calc_number_array_init (CalcNumberArray *self)
+{
+}
+
+/**
+ * calc_number_array_new:
+ * @len: the number of elements
+ *
+ * Constructs a new #CalcNumberArray with @len elements, all of which are
+ * initialized to the integer zero.
+ *
+ * Returns: the newly constructed instance
+ **/
+
+CalcNumberArray *
+calc_number_array_new (gsize len)
+{
+  CalcNumberArray *self = g_object_new (CALC_TYPE_NUMBER_ARRAY, NULL);
+  self->len = len;
+  self->kinds = g_malloc0 (len);
+  self->words = g_new0 (CalcNumberArrayWord, len);
+  return self;
+}
+
+/**
+ * calc_number_array_get_length:
+ * @self: the array
+ *
+ * Gets the number of elements in @self.
+ *
+ * Returns: the length of @self
+ **/
+
+gsize
+calc_number_array_get_length (CalcNumberArray *self)
+{
+  g_return_val_if_fail (CALC_IS_NUMBER_ARRAY (self), 0);
+  return self->len;
+}
+
+/* Makes @result point to an array of length @len, allocating a new array if
+   it points to %NULL. The elements of a resized array are set to zero. */
+
+static void
+calc_number_array_prepare (CalcNumberArray **result, gsize len)
+{
+  CalcNumberArray *self = *result;
+  if (self == NULL)
+    {
+      *result = calc_number_array_new (len);
+      return;
+    }
+  if (self->len == len)
+    return;
+  calc_number_array_free_spill (self);
+  self->len = len;
+  self->kinds = g_realloc (self->kinds, len);
+  self->words = g_renew (CalcNumberArrayWord, self->words, len);
+  memset (self->kinds, 0, len);
+  memset (self->words, 0, len * sizeof (CalcNumberArrayWord));
+  self->n_floating = 0;
+}
+
+/* Sets element @index of @self to the word-sized value @word of kind
+   @kind, freeing any value spilled there before */
+
+static void
+calc_number_array_set_word (CalcNumberArray *self, gsize index, guint8 kind,
+			    CalcNumberArrayWord word)
+{
+  switch (self->kinds[index])
+    {
+    case CALC_NUMBER_ARRAY_FLOATING:
+      self->n_floating--;
+      break;
+    case CALC_NUMBER_ARRAY_SPILL:
+      calc_value_clear (self->words[index].spill);
+      g_free (self->words[index].spill);
+      self->n_spill--;
+      break;
+    }
+  if (kind == CALC_NUMBER_ARRAY_FLOATING)
+    self->n_floating++;
+  self->kinds[index] = kind;
+  self->words[index] = word;
+}
+
+/* Returns TRUE if @value is a floating-point number that a double holds
+   exactly, and that gives the same results as MPFR when operated on as a
+   double. Subnormal doubles do not qualify. */
+
+static gboolean
+calc_number_array_fits_double (const CalcValue *value)
+{
+  mpfr_exp_t exp;
+  if (value->type != CALC_NUMBER_TYPE_FLOATING
+      || mpfr_get_prec (value->floating) != DBL_MANT_DIG)
+    return FALSE;
+  if (!mpfr_regular_p (value->floating))
+    return TRUE;
+  exp = mpfr_get_exp (value->floating);
+  return exp >= DBL_MIN_EXP && exp <= DBL_MAX_EXP;
+}
+
+/* Stores @value in element @index of @self. If @value must be spilled, its
+   storage is moved into the array, and @value is left with the previous
+   contents of the element or zero. In every case the caller must still
+   clear @value. */
+
+static void
+calc_number_array_store (CalcNumberArray *self, gsize index,
+			 CalcValue *value)
+{
+  CalcNumberArrayWord word;
+  CalcValue temp;
+
+  if (value->small && value->type == CALC_NUMBER_TYPE_INTEGER)
+    {
+      word.integer = value->small_num;
+      calc_number_array_set_word (self, index, CALC_NUMBER_ARRAY_INTEGER,
+				  word);
+    }
+  else if (calc_number_array_fits_double (value))
+    {
+      word.floating = mpfr_get_d (value->floating, MPFR_RNDN);
+      calc_number_array_set_word (self, index, CALC_NUMBER_ARRAY_FLOATING,
+				  word);
+    }
+  else if (self->kinds[index] == CALC_NUMBER_ARRAY_SPILL)
+    {
+      temp = *self->words[index].spill;
+      *self->words[index].spill = *value;
+      *value = temp;
+    }
+  else
+    {
+      word.spill = g_new (CalcValue, 1);
+      *word.spill = *value;
+      calc_value_init (value);
+      calc_number_array_set_word (self, index, CALC_NUMBER_ARRAY_SPILL, word);
+      self->n_spill++;
+    }
+}
+
+static void
+calc_number_array_temp_init (CalcNumberArrayTemp *temp)
+{
+  calc_value_init (&temp->integer);
+  calc_value_init_d (&temp->floating, 0);
+}
+
+static void
+calc_number_array_temp_clear (CalcNumberArrayTemp *temp)
+{
+  calc_value_clear (&temp->integer);
+  calc_value_clear (&temp->floating);
+}
+
+/* Returns element @index of @self as a value, using @temp to hold elements
+   stored in words. The value is only valid until the next load using the
+   same @temp. */
+
+static const CalcValue *
+calc_number_array_load (CalcNumberArray *self, gsize index,
+			CalcNumberArrayTemp *temp)
+{
+  switch (self->kinds[index])
+    {
+    case CALC_NUMBER_ARRAY_INTEGER:
+      _calc_value_set_small (&temp->integer, CALC_NUMBER_TYPE_INTEGER,
+			     self->words[index].integer, 1);
+      return &temp->integer;
+    case CALC_NUMBER_ARRAY_FLOATING:
+      mpfr_set_d (temp->floating.floating, self->words[index].floating,
+		  MPFR_RNDN);
+      return &temp->floating;
+    default:
+      return self->words[index].spill;
+    }
+}
+
+/**
+ * calc_number_array_set:
+ * @self: the array
+ * @index: the index of the element to set
+ * @value: the new value of the element
+ *
+ * Sets element @index of @self to a copy of @value. If @self or @value are
+ * invalid or @index is out of bounds, no action is performed.
+ **/
+
+void
+calc_number_array_set (CalcNumberArray *self, gsize index, CalcNumber *value)
+{
+  g_return_if_fail (CALC_IS_NUMBER (value));
+  calc_number_array_set_value (self, index, &value->value);
+}
+
+/**
+ * calc_number_array_set_value:
+ * @self: the array
+ * @index: the index of the element to set
+ * @value: the new value of the element
+ *
+ * Sets element @index of @self to a copy of @value. If @self is invalid or
+ * @index is out of bounds, no action is performed.
+ **/
+
+void
+calc_number_array_set_value (CalcNumberArray *self, gsize index,
+			     const CalcValue *value)
+{
+  CalcValue temp;
+  g_return_if_fail (CALC_IS_NUMBER_ARRAY (self));
+  g_return_if_fail (index < self->len);
+  calc_value_init_set (&temp, value);
+  calc_number_array_store (self, index, &temp);
+  calc_value_clear (&temp);
+}
+
+/**
+ * calc_number_array_set_si:
+ * @self: the array
+ * @index: the index of the element to set
+ * @value: the new value of the element
+ *
+ * Sets element @index of @self to the signed integer @value. If @self is
+ * invalid or @index is out of bounds, no action is performed.
+ **/
+
+void
+calc_number_array_set_si (CalcNumberArray *self, gsize index,
+			  signed long value)
+{
+  CalcNumberArrayWord word;
+  g_return_if_fail (CALC_IS_NUMBER_ARRAY (self));
+  g_return_if_fail (index < self->len);
+  word.integer = value;
+  calc_number_array_set_word (self, index, CALC_NUMBER_ARRAY_INTEGER, word);
+}
+
+/**
+ * calc_number_array_set_d:
+ * @self: the array
+ * @index: the index of the element to set
+ * @value: the new value of the element
+ *
+ * Sets element @index of @self to the floating-point number @value, which
+ * has the precision of a double like calc_value_init_d(). If @self is
+ * invalid or @index is out of bounds, no action is performed.
+ **/
+
+void
+calc_number_array_set_d (CalcNumberArray *self, gsize index, double value)
+{
+  CalcNumberArrayWord word;
+  CalcValue temp;
+  g_return_if_fail (CALC_IS_NUMBER_ARRAY (self));
+  g_return_if_fail (index < self->len);
+  if (value == 0 || isnormal (value) || !isfinite (value))
+    {
+      word.floating = value;
+      calc_number_array_set_word (self, index, CALC_NUMBER_ARRAY_FLOATING,
+				  word);
+      return;
+    }
+  calc_value_init_d (&temp, value);
+  calc_number_array_store (self, index, &temp);
+  calc_value_clear (&temp);
+}
+
+/**
+ * calc_number_array_get:
+ * @self: the array
+ * @index: the index of the element to get
+ *
+ * Constructs a new #CalcNumber with the value of element @index of @self.
+ *
+ * Returns: (transfer full) (nullable): the newly constructed instance, or
+ * %NULL if @self is invalid or @index is out of bounds
+ **/
+
+CalcNumber *
+calc_number_array_get (CalcNumberArray *self, gsize index)
+{
+  CalcNumber *result;
+  g_return_val_if_fail (CALC_IS_NUMBER_ARRAY (self), NULL);
+  g_return_val_if_fail (index < self->len, NULL);
+  result = _calc_number_alloc ();
+  calc_value_init (&result->value);
+  calc_number_array_get_value (self, index, &result->value);
+  return result;
+}
+
+/**
+ * calc_number_array_get_value:
+ * @self: the array
+ * @index: the index of the element to get
+ * @result: where to store the value of the element
+ *
+ * Copies the value of element @index of @self into @result. Any previous
+ * value of @result is erased. If @self is invalid or @index is out of
+ * bounds, no action is performed.
+ **/
+
+void
+calc_number_array_get_value (CalcNumberArray *self, gsize index,
+			     CalcValue *result)
+{
+  mpfr_t fr;
+  g_return_if_fail (CALC_IS_NUMBER_ARRAY (self));
+  g_return_if_fail (index < self->len);
+  switch (self->kinds[index])
+    {
+    case CALC_NUMBER_ARRAY_INTEGER:
+      _calc_value_release (result);
+      _calc_value_set_small (result, CALC_NUMBER_TYPE_INTEGER,
+			     self->words[index].integer, 1);
+      break;
+    case CALC_NUMBER_ARRAY_FLOATING:
+      _calc_value_init_fr (fr, DBL_MANT_DIG);
+      mpfr_set_d (fr, self->words[index].floating, MPFR_RNDN);
+      _calc_value_take_fr (result, fr);
+      break;
+    default:
+      calc_value_set (result, self->words[index].spill);
+      break;
+    }
+}
+
+/* Computes @n integer results of @op into @out, where @b advances by
+   @stride elements at a time. Returns FALSE if any result does not fit in
+   a word or is not an integer, in which case @out is partly written. The
+   overflow checks of addition and subtraction are written without branches
+   so that the loops can be vectorized. */
+
+static inline gboolean
+calc_number_array_block_z (CalcNumberArrayWord *out,
+			   const CalcNumberArrayWord *a,
+			   const CalcNumberArrayWord *b, gsize stride, gsize n,
+			   CalcNumberArrayOp op)
+{
+  gboolean overflow = FALSE;
+  glong sign = 0;
+  gsize i;
+
+  switch (op)
+    {
+    case CALC_NUMBER_ARRAY_ADD:
+      for (i = 0; i < n; i++)
+	{
+	  glong x = a[i].integer;
+	  glong y = b[i * stride].integer;
+	  glong r = (glong) ((gulong) x + (gulong) y);
+	  sign |= (x ^ r) & (y ^ r);
+	  out[i].integer = r;
+	}
+      return sign >= 0;
+    case CALC_NUMBER_ARRAY_SUB:
+      for (i = 0; i < n; i++)
+	{
+	  glong x = a[i].integer;
+	  glong y = b[i * stride].integer;
+	  glong r = (glong) ((gulong) x - (gulong) y);
+	  sign |= (x ^ y) & (x ^ r);
+	  out[i].integer = r;
+	}
+      return sign >= 0;
+    case CALC_NUMBER_ARRAY_MUL:
+      for (i = 0; i < n; i++)
+	overflow |= __builtin_mul_overflow (a[i].integer,
+					    b[i * stride].integer,
+					    &out[i].integer);
+      return !overflow;
+    case CALC_NUMBER_ARRAY_DIV:
+      /* Only exact quotients stay integers */
+      for (i = 0; i < n; i++)
+	{
+	  glong x = a[i].integer;
+	  glong y = b[i * stride].integer;
+	  if (y == 0 || (y == -1 && x == G_MINLONG) || x % y != 0)
+	    return FALSE;
+	  out[i].integer = x / y;
+	}
+      return TRUE;
+    default:
+      return FALSE;
+    }
+}
+
+/* Computes @n double results of @op into @out like
+   calc_number_array_block_z(). Returns FALSE if any result is not zero or a
+   normal double, since MPFR does not round those results the same way. The
+   results are checked in a second pass over their bits, which is free of
+   branches and conversions so that both loops can be vectorized. */
+
+static inline gboolean
+calc_number_array_block_d (CalcNumberArrayWord *out,
+			   const CalcNumberArrayWord *a,
+			   const CalcNumberArrayWord *b, gsize stride, gsize n,
+			   CalcNumberArrayOp op)
+{
+  gint64 sign = 0;
+  gsize i;
+
+  switch (op)
+    {
+    case CALC_NUMBER_ARRAY_ADD:
+      for (i = 0; i < n; i++)
+	out[i].floating = a[i].floating + b[i * stride].floating;
+      break;
+    case CALC_NUMBER_ARRAY_SUB:
+      for (i = 0; i < n; i++)
+	out[i].floating = a[i].floating - b[i * stride].floating;
+      break;
+    case CALC_NUMBER_ARRAY_MUL:
+      for (i = 0; i < n; i++)
+	out[i].floating = a[i].floating * b[i * stride].floating;
+      break;
+    case CALC_NUMBER_ARRAY_DIV:
+      for (i = 0; i < n; i++)
+	out[i].floating = a[i].floating / b[i * stride].floating;
+      break;
+    default:
+      return FALSE;
+    }
+
+  /* The biased exponent of a normal double is between 1 and 2046, and a
+     nonzero magnitude makes its negation negative */
+  for (i = 0; i < n; i++)
+    {
+      gint64 bits = out[i].bits & G_MAXINT64;
+      gint64 exp = bits >> (DBL_MANT_DIG - 1);
+      sign |= ((exp - 1) | (2046 - exp)) & -bits;
+    }
+  return sign >= 0;
+}
+
+/* Applies @op to one element of each operand with GNU MP */
+
+static void
+calc_number_array_op (CalcValue *result, const CalcValue *a,
+		      const CalcValue *b, CalcNumberArrayOp op)
+{
+  switch (op)
+    {
+    case CALC_NUMBER_ARRAY_ADD:
+      calc_value_add (result, a, b);
+      break;
+    case CALC_NUMBER_ARRAY_SUB:
+      calc_value_sub (result, a, b);
+      break;
+    case CALC_NUMBER_ARRAY_MUL:
+      calc_value_mul (result, a, b);
+      break;
+    case CALC_NUMBER_ARRAY_DIV:
+      calc_value_div (result, a, b);
+      break;
+    case CALC_NUMBER_ARRAY_POW:
+      calc_value_pow (result, a, b);
+      break;
+    }
+}
+
+/* Stores @op applied to each element of @a and the corresponding element of
+   @b in @result, which has the length of @a. If @stride is zero, @b has a
+   single element that is used for every element of @a. */
+
+static void
+calc_number_array_apply (CalcNumberArray *result, CalcNumberArray *a,
+			 CalcNumberArray *b, gsize stride,
+			 CalcNumberArrayOp op)
+{
+  CalcNumberArrayWord out[CALC_NUMBER_ARRAY_BLOCK_SIZE];
+  CalcNumberArrayTemp ta;
+  CalcNumberArrayTemp tb;
+  CalcValue value;
+  mpfr_prec_t prec = calc_value_get_prec_override ();
+  gboolean integers = a->n_floating == 0 && a->n_spill == 0
+    && b->n_floating == 0 && b->n_spill == 0;
+  gboolean doubles = a->n_floating == a->len && b->n_floating == b->len
+    && (prec == 0 || prec == DBL_MANT_DIG) && FLT_EVAL_METHOD == 0;
+  gboolean fast;
+  gsize start;
+  gsize n;
+  gsize i;
+
+  calc_number_array_temp_init (&ta);
+  calc_number_array_temp_init (&tb);
+  calc_value_init (&value);
+  for (start = 0; start < a->len; start += n)
+    {
+      const CalcNumberArrayWord *wb = b->words + start * stride;
+      n = MIN (a->len - start, CALC_NUMBER_ARRAY_BLOCK_SIZE);
+      if (integers)
+	fast = stride ? calc_number_array_block_z (out, a->words + start, wb,
+						   1, n, op)
+	  : calc_number_array_block_z (out, a->words + start, wb, 0, n, op);
+      else if (doubles)
+	fast = stride ? calc_number_array_block_d (out, a->words + start, wb,
+						   1, n, op)
+	  : calc_number_array_block_d (out, a->words + start, wb, 0, n, op);
+      else
+	fast = FALSE;
+
+      if (fast)
+	{
+	  guint8 kind = integers ? CALC_NUMBER_ARRAY_INTEGER
+	    : CALC_NUMBER_ARRAY_FLOATING;
+	  for (i = 0; i < n; i++)
+	    calc_number_array_set_word (result, start + i, kind, out[i]);
+	  continue;
+	}
+      for (i = start; i < start + n; i++)
+	{
+	  calc_number_array_op (&value, calc_number_array_load (a, i, &ta),
+				calc_number_array_load (b, i * stride, &tb),
+				op);
+	  calc_number_array_store (result, i, &value);
+	}
+    }
+  calc_value_clear (&value);
+  calc_number_array_temp_clear (&ta);
+  calc_number_array_temp_clear (&tb);
+}
+
+/* Checks the operands of an element-wise operation and prepares @result */
+
+static gboolean
+calc_number_array_check (CalcNumberArray **result, CalcNumberArray *a,
+			 CalcNumberArray *b)
+{
+  g_return_val_if_fail (result != NULL, FALSE);
+  g_return_val_if_fail (*result == NULL || CALC_IS_NUMBER_ARRAY (*result),
+			FALSE);
+  g_return_val_if_fail (CALC_IS_NUMBER_ARRAY (a), FALSE);
+  g_return_val_if_fail (CALC_IS_NUMBER_ARRAY (b), FALSE);
+  g_return_val_if_fail (a->len == b->len, FALSE);
+  calc_number_array_prepare (result, a->len);
+  return TRUE;
+}
+
+/* Checks the operands of an operation with a scalar and prepares @result.
+   Returns a new array holding only @b. */
+
+static CalcNumberArray *
+calc_number_array_check_scalar (CalcNumberArray **result, CalcNumberArray *a,
+				CalcNumber *b)
+{
+  CalcNumberArray *scalar;
+  g_return_val_if_fail (result != NULL, NULL);
+  g_return_val_if_fail (*result == NULL || CALC_IS_NUMBER_ARRAY (*result),
+			NULL);
+  g_return_val_if_fail (CALC_IS_NUMBER_ARRAY (a), NULL);
+  g_return_val_if_fail (CALC_IS_NUMBER (b), NULL);
+  calc_number_array_prepare (result, a->len);
+  scalar = calc_number_array_new (1);
+  calc_number_array_set_value (scalar, 0, &b->value);
+  return scalar;
+}
+
+/**
+ * calc_number_array_add:
+ * @result: the pointer to store the result
+ * @a: the first array
+ * @b: the second array
+ *
+ * Adds the corresponding elements of @a and @b and stores the results in
+ * @result, as calc_value_add() would. @result may be the same array as @a or
+ * @b. If @result points to %NULL, a new #CalcNumberArray is allocated and
+ * @result will point to it. If @result is %NULL, @a or @b are invalid
+ * arrays, or @a and @b have different lengths, no action is performed.
+ **/
+
+void
+calc_number_array_add (CalcNumberArray **result, CalcNumberArray *a,
+		       CalcNumberArray *b)
+{
+  if (calc_number_array_check (result, a, b))
+    calc_number_array_apply (*result, a, b, 1, CALC_NUMBER_ARRAY_ADD);
+}
+
+/**
+ * calc_number_array_sub:
+ * @result: the pointer to store the result
+ * @a: the first array
+ * @b: the second array
+ *
+ * Subtracts each element of @b from the corresponding element of @a and
+ * stores the results in @result, as calc_value_sub() would. @result may be
+ * the same array as @a or @b. If @result points to %NULL, a new
+ * #CalcNumberArray is allocated and @result will point to it. If @result is
+ * %NULL, @a or @b are invalid arrays, or @a and @b have different lengths,
+ * no action is performed.
+ **/
+
+void
+calc_number_array_sub (CalcNumberArray **result, CalcNumberArray *a,
+		       CalcNumberArray *b)
+{
+  if (calc_number_array_check (result, a, b))
+    calc_number_array_apply (*result, a, b, 1, CALC_NUMBER_ARRAY_SUB);
+}
+
+/**
+ * calc_number_array_mul:
+ * @result: the pointer to store the result
+ * @a: the first array
+ * @b: the second array
+ *
+ * Multiplies the corresponding elements of @a and @b and stores the results
+ * in @result, as calc_value_mul() would. @result may be the same array as @a
+ * or @b. If @result points to %NULL, a new #CalcNumberArray is allocated and
+ * @result will point to it. If @result is %NULL, @a or @b are invalid
+ * arrays, or @a and @b have different lengths, no action is performed.
+ **/
+
+void
+calc_number_array_mul (CalcNumberArray **result, CalcNumberArray *a,
+		       CalcNumberArray *b)
+{
+  if (calc_number_array_check (result, a, b))
+    calc_number_array_apply (*result, a, b, 1, CALC_NUMBER_ARRAY_MUL);
+}
+
+/**
+ * calc_number_array_div:
+ * @result: the pointer to store the result
+ * @a: the first array
+ * @b: the second array
+ *
+ * Divides each element of @a by the corresponding element of @b and stores
+ * the results in @result, as calc_value_div() would. @result may be the same
+ * array as @a or @b. If @result points to %NULL, a new #CalcNumberArray is
+ * allocated and @result will point to it. If @result is %NULL, @a or @b are
+ * invalid arrays, or @a and @b have different lengths, no action is
+ * performed.
+ **/
+
+void
+calc_number_array_div (CalcNumberArray **result, CalcNumberArray *a,
+		       CalcNumberArray *b)
+{
+  if (calc_number_array_check (result, a, b))
+    calc_number_array_apply (*result, a, b, 1, CALC_NUMBER_ARRAY_DIV);
+}
+
+/**
+ * calc_number_array_pow:
+ * @result: the pointer to store the result
+ * @a: the first array
+ * @b: the second array
+ *
+ * Raises each element of @a to the power of the corresponding element of @b
+ * and stores the results in @result, as calc_value_pow() would. @result may
+ * be the same array as @a or @b. If @result points to %NULL, a new
+ * #CalcNumberArray is allocated and @result will point to it. If @result is
+ * %NULL, @a or @b are invalid arrays, or @a and @b have different lengths,
+ * no action is performed.
+ **/
+
+void
+calc_number_array_pow (CalcNumberArray **result, CalcNumberArray *a,
+		       CalcNumberArray *b)
+{
+  if (calc_number_array_check (result, a, b))
+    calc_number_array_apply (*result, a, b, 1, CALC_NUMBER_ARRAY_POW);
+}
+
+/**
+ * calc_number_array_add_scalar:
+ * @result: the pointer to store the result
+ * @a: the array
+ * @b: the number
+ *
+ * Adds @b to each element of @a and stores the results in @result. @result
+ * may be the same array as @a. If @result points to %NULL, a new
+ * #CalcNumberArray is allocated and @result will point to it. If @result is
+ * %NULL or @a or @b are invalid, no action is performed.
+ **/
+
+void
+calc_number_array_add_scalar (CalcNumberArray **result,
+			      CalcNumberArray *a, CalcNumber *b)
+{
+  CalcNumberArray *scalar = calc_number_array_check_scalar (result, a, b);
+  if (scalar == NULL)
+    return;
+  calc_number_array_apply (*result, a, scalar, 0, CALC_NUMBER_ARRAY_ADD);
+  g_object_unref (scalar);
+}
+
+/**
+ * calc_number_array_sub_scalar:
+ * @result: the pointer to store the result
+ * @a: the array
+ * @b: the number
+ *
+ * Subtracts @b from each element of @a and stores the results in @result.
+ * @result may be the same array as @a. If @result points to %NULL, a new
+ * #CalcNumberArray is allocated and @result will point to it. If @result is
+ * %NULL or @a or @b are invalid, no action is performed.
+ **/
+
+void
+calc_number_array_sub_scalar (CalcNumberArray **result,
+			      CalcNumberArray *a, CalcNumber *b)
+{
+  CalcNumberArray *scalar = calc_number_array_check_scalar (result, a, b);
+  if (scalar == NULL)
+    return;
+  calc_number_array_apply (*result, a, scalar, 0, CALC_NUMBER_ARRAY_SUB);
+  g_object_unref (scalar);
+}
+
+/**
+ * calc_number_array_mul_scalar:
+ * @result: the pointer to store the result
+ * @a: the array
+ * @b: the number
+ *
+ * Multiplies each element of @a by @b and stores the results in @result.
+ * @result may be the same array as @a. If @result points to %NULL, a new
+ * #CalcNumberArray is allocated and @result will point to it. If @result is
+ * %NULL or @a or @b are invalid, no action is performed.
+ **/
+
+void
+calc_number_array_mul_scalar (CalcNumberArray **result,
+			      CalcNumberArray *a, CalcNumber *b)
+{
+  CalcNumberArray *scalar = calc_number_array_check_scalar (result, a, b);
+  if (scalar == NULL)
+    return;
+  calc_number_array_apply (*result, a, scalar, 0, CALC_NUMBER_ARRAY_MUL);
+  g_object_unref (scalar);
+}
+
+/**
+ * calc_number_array_div_scalar:
+ * @result: the pointer to store the result
+ * @a: the array
+ * @b: the number
+ *
+ * Divides each element of @a by @b and stores the results in @result.
+ * @result may be the same array as @a. If @result points to %NULL, a new
+ * #CalcNumberArray is allocated and @result will point to it. If @result is
+ * %NULL or @a or @b are invalid, no action is performed.
+ **/
+
+void
+calc_number_array_div_scalar (CalcNumberArray **result,
+			      CalcNumberArray *a, CalcNumber *b)
+{
+  CalcNumberArray *scalar = calc_number_array_check_scalar (result, a, b);
+  if (scalar == NULL)
+    return;
+  calc_number_array_apply (*result, a, scalar, 0, CALC_NUMBER_ARRAY_DIV);
+  g_object_unref (scalar);
+}
+
+/**
+ * calc_number_array_pow_scalar:
+ * @result: the pointer to store the result
+ * @a: the array
+ * @b: the number
+ *
+ * Raises each element of @a to the power of @b and stores the results in
+ * @result. @result may be the same array as @a. If @result points to %NULL,
+ * a new #CalcNumberArray is allocated and @result will point to it. If
+ * @result is %NULL or @a or @b are invalid, no action is performed.
+ **/
+
+void
+calc_number_array_pow_scalar (CalcNumberArray **result,
+			      CalcNumberArray *a, CalcNumber *b)
+{
+  CalcNumberArray *scalar = calc_number_array_check_scalar (result, a, b);
+  if (scalar == NULL)
+    return;
+  calc_number_array_apply (*result, a, scalar, 0, CALC_NUMBER_ARRAY_POW);
+  g_object_unref (scalar);
+}
+
+/* Stores the comparison of each element of @a with the corresponding
+   element of @b in @result, where @stride is as for
+   calc_number_array_apply() */
+
+static void
+calc_number_array_compare (gint *result, CalcNumberArray *a,
+			   CalcNumberArray *b, gsize stride)
+{
+  CalcNumberArrayTemp ta;
+  CalcNumberArrayTemp tb;
+  gsize i;
+
+  if (a->n_floating == 0 && a->n_spill == 0 && b->n_floating == 0
+      && b->n_spill == 0)
+    {
+      for (i = 0; i < a->len; i++)
+	{
+	  glong x = a->words[i].integer;
+	  glong y = b->words[i * stride].integer;
+	  result[i] = (x > y) - (x < y);
+	}
+      return;
+    }
+  if (a->n_floating == a->len && b->n_floating == b->len)
+    {
+      for (i = 0; i < a->len; i++)
+	{
+	  double x = a->words[i].floating;
+	  double y = b->words[i * stride].floating;
+	  result[i] = (x > y) - (x < y);
+	}
+      return;
+    }
+
+  calc_number_array_temp_init (&ta);
+  calc_number_array_temp_init (&tb);
+  for (i = 0; i < a->len; i++)
+    result[i] = calc_value_cmp (calc_number_array_load (a, i, &ta),
+				calc_number_array_load (b, i * stride, &tb));
+  calc_number_array_temp_clear (&ta);
+  calc_number_array_temp_clear (&tb);
+}
+
+/**
+ * calc_number_array_cmp:
+ * @result: (array): where to store the results of the comparisons
+ * @a: the first array
+ * @b: the second array
+ *
+ * Compares each element of @a with the corresponding element of @b as
+ * calc_value_cmp() would, and stores the results in @result, which must
+ * have room for as many elements as @a. If @result is %NULL, @a or @b are
+ * invalid arrays, or @a and @b have different lengths, no action is
+ * performed.
+ **/
+
+void
+calc_number_array_cmp (gint *result, CalcNumberArray *a, CalcNumberArray *b)
+{
+  g_return_if_fail (result != NULL);
+  g_return_if_fail (CALC_IS_NUMBER_ARRAY (a));
+  g_return_if_fail (CALC_IS_NUMBER_ARRAY (b));
+  g_return_if_fail (a->len == b->len);
+  calc_number_array_compare (result, a, b, 1);
+}
+
+/**
+ * calc_number_array_cmp_scalar:
+ * @result: (array): where to store the results of the comparisons
+ * @a: the array
+ * @b: the number
+ *
+ * Compares each element of @a with @b as calc_value_cmp() would, and stores
+ * the results in @result, which must have room for as many elements as @a.
+ * If @result is %NULL or @a or @b are invalid, no action is performed.
+ **/
+
+void
+calc_number_array_cmp_scalar (gint *result, CalcNumberArray *a,
+			      CalcNumber *b)
+{
+  CalcNumberArray *scalar;
+  g_return_if_fail (result != NULL);
+  g_return_if_fail (CALC_IS_NUMBER_ARRAY (a));
+  g_return_if_fail (CALC_IS_NUMBER (b));
+  scalar = calc_number_array_new (1);
+  calc_number_array_set_value (scalar, 0, &b->value);
+  calc_number_array_compare (result, a, scalar, 0);
+  g_object_unref (scalar);
+}
+
+/**
+ * calc_number_array_sum:
+ * @result: the pointer to store the result
+ * @self: the array
+ *
+ * Adds all of the elements of @self and stores the result in @result. Any
+ * previous value in @result will be erased. The sum is exact if all of the
+ * elements are exact, and otherwise rounded only once as described for
+ * calc_value_sum(). If @result points to %NULL, a new #CalcNumber is
+ * allocated and @result will point to it. If @result is %NULL or @self is
+ * invalid, no action is performed.
+ **/
+
+void
+calc_number_array_sum (CalcNumber **result, CalcNumberArray *self)
+{
+  CalcNumberArrayTemp temp;
+  CalcValueAcc acc;
+  gboolean overflow = FALSE;
+  glong total = 0;
+  gsize i;
+
+  g_return_if_fail (result != NULL);
+  g_return_if_fail (*result == NULL || CALC_IS_NUMBER (*result));
+  g_return_if_fail (CALC_IS_NUMBER_ARRAY (self));
+  _calc_number_prepare (result);
+  if (self->n_floating == 0 && self->n_spill == 0)
+    {
+      for (i = 0; i < self->len; i++)
+	overflow |= __builtin_add_overflow (total, self->words[i].integer,
+					    &total);
+      if (!overflow)
+	{
+	  _calc_value_release (&(*result)->value);
+	  _calc_value_set_small (&(*result)->value, CALC_NUMBER_TYPE_INTEGER,
+				 total, 1);
+	  return;
+	}
+    }
+
+  calc_number_array_temp_init (&temp);
+  _calc_value_acc_init (&acc);
+  for (i = 0; i < self->len; i++)
+    _calc_value_acc_add (&acc, calc_number_array_load (self, i, &temp));
+  _calc_value_acc_finish (&acc, &(*result)->value);
+  calc_number_array_temp_clear (&temp);
+}
+
+/**
+ * calc_number_array_dot:
+ * @result: the pointer to store the result
+ * @a: the first array
+ * @b: the second array
+ *
+ * Computes the sum of the products of the corresponding elements of @a and
+ * @b and stores the result in @result. Any previous value in @result will be
+ * erased. The sum is exact if all of the elements are exact, and otherwise
+ * rounded only once as described for calc_value_dot(). If @result points to
+ * %NULL, a new #CalcNumber is allocated and @result will point to it. If
+ * @result is %NULL, @a or @b are invalid arrays, or @a and @b have different
+ * lengths, no action is performed.
+ **/
+
+void
+calc_number_array_dot (CalcNumber **result, CalcNumberArray *a,
+		       CalcNumberArray *b)
+{
+  CalcNumberArrayTemp ta;
+  CalcNumberArrayTemp tb;
+  CalcValueAcc acc;
+  gboolean overflow = FALSE;
+  glong total = 0;
+  glong product;
+  gsize i;
+
+  g_return_if_fail (result != NULL);
+  g_return_if_fail (*result == NULL || CALC_IS_NUMBER (*result));
+  g_return_if_fail (CALC_IS_NUMBER_ARRAY (a));
+  g_return_if_fail (CALC_IS_NUMBER_ARRAY (b));
+  g_return_if_fail (a->len == b->len);
+  _calc_number_prepare (result);
+  if (a->n_floating == 0 && a->n_spill == 0 && b->n_floating == 0
+      && b->n_spill == 0)
+    {
+      for (i = 0; i < a->len; i++)
+	{
+	  overflow |= __builtin_mul_overflow (a->words[i].integer,
+					      b->words[i].integer, &product);
+	  overflow |= __builtin_add_overflow (total, product, &total);
+	}
+      if (!overflow)
+	{
+	  _calc_value_release (&(*result)->value);
+	  _calc_value_set_small (&(*result)->value, CALC_NUMBER_TYPE_INTEGER,
+				 total, 1);
+	  return;
+	}
+    }
+
+  calc_number_array_temp_init (&ta);
+  calc_number_array_temp_init (&tb);
+  _calc_value_acc_init (&acc);
+  for (i = 0; i < a->len; i++)
+    _calc_value_acc_addmul (&acc, calc_number_array_load (a, i, &ta),
+			    calc_number_array_load (b, i, &tb));
+  _calc_value_acc_finish (&acc, &(*result)->value);
+  calc_number_array_temp_clear (&ta);
+  calc_number_array_temp_clear (&tb);
+}
@@ -0,0 +1,116 @@
+/*************************************************************************
+ * calc-number-array.h -- This file is part of libcalc.                  *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+
+#ifndef _CALC_NUMBER_ARRAY_H
+#define _CALC_NUMBER_ARRAY_H
+
+#include "calc-number.h"
+
+G_BEGIN_DECLS
+
+#define CALC_TYPE_NUMBER_ARRAY calc_number_array_get_type ()
+G_DECLARE_FINAL_TYPE (CalcNumberArray, calc_number_array, CALC, NUMBER_ARRAY,
+		      GObject)
+
+struct _CalcNumberArrayClass
+{
+  /*< private >*/
+  GObjectClass parent;
+};
+
+/**
+ * CalcNumberArray:
+ *
+ * A fixed-length array of real numbers stored contiguously. Integers that
+ * fit in a machine word and floating-point numbers with the precision of a
+ * double are stored in plain word-sized lanes, so element-wise operations
+ * on arrays of such numbers run as simple loops over machine integers and
+ * doubles. Any other element is stored as a #CalcValue on the side. The
+ * results of every operation are the same as those of the corresponding
+ * calc_value_*() function applied to each element.
+ **/
+
+/* The storage of each element. Integer and double elements store their
+   values in @words directly, while spilled elements point to a #CalcValue
+   of their own. @bits is the representation of @floating. */
+typedef union
+{
+  glong integer;
+  double floating;
+  gint64 bits;
+  CalcValue *spill;
+} CalcNumberArrayWord;
+
+struct _CalcNumberArray
+{
+  /*< private >*/
+  GObject parent;
+  gsize len;
+  guint8 *kinds;
+  CalcNumberArrayWord *words;
+  gsize n_floating;
+  gsize n_spill;
+};
+
+CalcNumberArray *calc_number_array_new (gsize len);
+gsize calc_number_array_get_length (CalcNumberArray *self);
+void calc_number_array_set (CalcNumberArray *self, gsize index,
+			    CalcNumber *value);
+void calc_number_array_set_value (CalcNumberArray *self, gsize index,
+				  const CalcValue *value);
+void calc_number_array_set_si (CalcNumberArray *self, gsize index,
+			       signed long value);
+void calc_number_array_set_d (CalcNumberArray *self, gsize index,
+			      double value);
+CalcNumber *calc_number_array_get (CalcNumberArray *self, gsize index);
+void calc_number_array_get_value (CalcNumberArray *self, gsize index,
+				  CalcValue *result);
+
+void calc_number_array_add (CalcNumberArray **result, CalcNumberArray *a,
+			    CalcNumberArray *b);
+void calc_number_array_sub (CalcNumberArray **result, CalcNumberArray *a,
+			    CalcNumberArray *b);
+void calc_number_array_mul (CalcNumberArray **result, CalcNumberArray *a,
+			    CalcNumberArray *b);
+void calc_number_array_div (CalcNumberArray **result, CalcNumberArray *a,
+			    CalcNumberArray *b);
+void calc_number_array_pow (CalcNumberArray **result, CalcNumberArray *a,
+			    CalcNumberArray *b);
+void calc_number_array_cmp (gint *result, CalcNumberArray *a,
+			    CalcNumberArray *b);
+
+void calc_number_array_add_scalar (CalcNumberArray **result,
+				   CalcNumberArray *a, CalcNumber *b);
+void calc_number_array_sub_scalar (CalcNumberArray **result,
+				   CalcNumberArray *a, CalcNumber *b);
+void calc_number_array_mul_scalar (CalcNumberArray **result,
+				   CalcNumberArray *a, CalcNumber *b);
+void calc_number_array_div_scalar (CalcNumberArray **result,
+				   CalcNumberArray *a, CalcNumber *b);
+void calc_number_array_pow_scalar (CalcNumberArray **result,
+				   CalcNumberArray *a, CalcNumber *b);
+void calc_number_array_cmp_scalar (gint *result, CalcNumberArray *a,
+				   CalcNumber *b);
+
+void calc_number_array_sum (CalcNumber **result, CalcNumberArray *self);
+void calc_number_array_dot (CalcNumber **result, CalcNumberArray *a,
+			    CalcNumberArray *b);
+
+G_END_DECLS
+
+#endif
@@ -40,65 +40,12 @@
 void
 calc_number_div (CalcNumber **result, CalcNumber *a, CalcNumber *b)
 {
-  CalcNumberType type;
-  CalcNumber *ca;
-  CalcNumber *cb;
-  mpz_t temp;
-
   g_return_if_fail (result != NULL);
   g_return_if_fail (*result == NULL || CALC_IS_NUMBER (*result));
   g_return_if_fail (CALC_IS_NUMBER (a));
   g_return_if_fail (CALC_IS_NUMBER (b));
-
-  type = _calc_number_get_final_type (a->type, b->type);
-  ca = calc_number_new (a);
-  cb = calc_number_new (b);
-  calc_number_cast (ca, type);
-  calc_number_cast (cb, type);
-
-  if (*result == NULL)
-    {
-      *result = calc_number_new (NULL);
-      mpz_clear ((*result)->integer);
-    }
-  else
-    _calc_number_release (*result);
-  (*result)->type = type;
-  switch (type)
-    {
-    case CALC_NUMBER_TYPE_INTEGER:
-      mpz_init (temp);
-      mpz_mod (temp, ca->integer, cb->integer);
-      if (mpz_cmp_ui (temp, 0) == 0)
-	{
-	  mpz_init ((*result)->integer);
-	  mpz_divexact ((*result)->integer, ca->integer, cb->integer);
-	}
-      else
-	{
-	  mpq_t qa;
-	  mpq_t qb;
-	  (*result)->type = CALC_NUMBER_TYPE_RATIONAL;
-	  mpq_inits ((*result)->rational, qa, qb, NULL);
-	  mpq_set_z (qa, ca->integer);
-	  mpq_set_z (qb, cb->integer);
-	  mpq_div ((*result)->rational, qa, qb);
-	  mpq_clears (qa, qb, NULL);
-	}
-      mpz_clear (temp);
-      break;
-    case CALC_NUMBER_TYPE_RATIONAL:
-      mpq_init ((*result)->rational);
-      mpq_div ((*result)->rational, ca->rational, cb->rational);
-      break;
-    case CALC_NUMBER_TYPE_FLOATING:
-      mpfr_init ((*result)->floating);
-      mpfr_div ((*result)->floating, ca->floating, cb->floating, MPFR_RNDN);
-      break;
-    }
-
-  g_object_unref (ca);
-  g_object_unref (cb);
+  _calc_number_prepare (result);
+  calc_value_div (&(*result)->value, &a->value, &b->value);
 }
 
 /**
@@ -117,55 +64,11 @@ calc_number_div (CalcNumber **result, CalcNumber *a, CalcNumber *b)
 void
 calc_number_div_z (CalcNumber **result, CalcNumber *a, mpz_t b)
 {
-  mpz_t temp;
-  mpq_t rb;
   g_return_if_fail (result != NULL);
   g_return_if_fail (*result == NULL || CALC_IS_NUMBER (*result));
   g_return_if_fail (CALC_IS_NUMBER (a));
-
-  if (*result == NULL)
-    {
-      *result = calc_number_new (NULL);
-      mpz_clear ((*result)->integer);
-    }
-  else
-    _calc_number_release (*result);
-  (*result)->type = a->type;
-  switch (a->type)
-    {
-    case CALC_NUMBER_TYPE_INTEGER:
-      mpz_init (temp);
-      mpz_mod (temp, a->integer, b);
-      if (mpz_cmp_ui (temp, 0) == 0)
-	{
-	  mpz_init ((*result)->integer);
-	  mpz_tdiv_q ((*result)->integer, a->integer, b);
-	}
-      else
-	{
-	  mpq_t qa;
-	  mpq_t qb;
-	  (*result)->type = CALC_NUMBER_TYPE_RATIONAL;
-	  mpq_inits ((*result)->rational, qa, qb, NULL);
-	  mpq_set_z (qa, a->integer);
-	  mpq_set_z (qb, b);
-	  mpq_div ((*result)->rational, qa, qb);
-	  mpq_clears (qa, qb, NULL);
-	}
-      mpz_clear (temp);
-      break;
-    case CALC_NUMBER_TYPE_RATIONAL:
-      mpq_init ((*result)->rational);
-      mpq_init (rb);
-      mpq_set_z (rb, b);
-      mpq_div ((*result)->rational, a->rational, rb);
-      mpq_clear (rb);
-      break;
-    case CALC_NUMBER_TYPE_FLOATING:
-      mpfr_init ((*result)->floating);
-      mpfr_div_z ((*result)->floating, a->floating, b, MPFR_RNDN);
-      break;
-    }
+  _calc_number_prepare (result);
+  calc_value_div_z (&(*result)->value, &a->value, b);
 }
 
 /**
@@ -187,32 +90,8 @@ calc_number_div_q (CalcNumber **result, CalcNumber *a, mpq_t b)
   g_return_if_fail (result != NULL);
   g_return_if_fail (*result == NULL || CALC_IS_NUMBER (*result));
   g_return_if_fail (CALC_IS_NUMBER (a));
-
-  if (*result == NULL)
-    {
-      *result = calc_number_new (NULL);
-      mpz_clear ((*result)->integer);
-    }
-  else
-    _calc_number_release (*result);
-  (*result)->type = a->type;
-  switch (a->type)
-    {
-    case CALC_NUMBER_TYPE_INTEGER:
-      (*result)->type = CALC_NUMBER_TYPE_RATIONAL;
-      mpq_init ((*result)->rational);
-      mpq_set_z ((*result)->rational, a->integer);
-      mpq_div ((*result)->rational, (*result)->rational, b);
-      break;
-    case CALC_NUMBER_TYPE_RATIONAL:
-      mpq_init ((*result)->rational);
-      mpq_div ((*result)->rational, a->rational, b);
-      break;
-    case CALC_NUMBER_TYPE_FLOATING:
-      mpfr_init ((*result)->floating);
-      mpfr_div_q ((*result)->floating, a->floating, b, MPFR_RNDN);
-      break;
-    }
+  _calc_number_prepare (result);
+  calc_value_div_q (&(*result)->value, &a->value, b);
 }
 
 /**
@@ -231,10 +110,11 @@ calc_number_div_q (CalcNumber **result, CalcNumber *a, mpq_t b)
 void
 calc_number_div_f (CalcNumber **result, CalcNumber *a, mpf_t b)
 {
-  mpfr_t temp;
-  mpfr_init_set_f (temp, b, MPFR_RNDN);
-  calc_number_div_fr (result, a, temp);
-  mpfr_clear (temp);
+  g_return_if_fail (result != NULL);
+  g_return_if_fail (*result == NULL || CALC_IS_NUMBER (*result));
+  g_return_if_fail (CALC_IS_NUMBER (a));
+  _calc_number_prepare (result);
+  calc_value_div_f (&(*result)->value, &a->value, b);
 }
 
 /**
@@ -256,30 +136,8 @@ calc_number_div_fr (CalcNumber **result, CalcNumber *a, mpfr_t b)
   g_return_if_fail (result != NULL);
   g_return_if_fail (*result == NULL || CALC_IS_NUMBER (*result));
   g_return_if_fail (CALC_IS_NUMBER (a));
-
-  if (*result == NULL)
-    {
-      *result = calc_number_new (NULL);
-      mpz_clear ((*result)->integer);
-    }
-  else
-    _calc_number_release (*result);
-  (*result)->type = CALC_NUMBER_TYPE_FLOATING;
-  mpfr_init ((*result)->floating);
-  switch (a->type)
-    {
-    case CALC_NUMBER_TYPE_INTEGER:
-      mpfr_set_z ((*result)->floating, a->integer, MPFR_RNDN);
-      mpfr_div ((*result)->floating, (*result)->floating, b, MPFR_RNDN);
-      break;
-    case CALC_NUMBER_TYPE_RATIONAL:
-      mpfr_set_q ((*result)->floating, a->rational, MPFR_RNDN);
-      mpfr_div ((*result)->floating, (*result)->floating, b, MPFR_RNDN);
-      break;
-    case CALC_NUMBER_TYPE_FLOATING:
-      mpfr_div ((*result)->floating, a->floating, b, MPFR_RNDN);
-      break;
-    }
+  _calc_number_prepare (result);
+  calc_value_div_fr (&(*result)->value, &a->value, b);
 }
 
 /**
@@ -301,30 +159,8 @@ calc_number_div_d (CalcNumber **result, CalcNumber *a, double b)
   g_return_if_fail (result != NULL);
   g_return_if_fail (*result == NULL || CALC_IS_NUMBER (*result));
   g_return_if_fail (CALC_IS_NUMBER (a));
-
-  if (*result == NULL)
-    {
-      *result = calc_number_new (NULL);
-      mpz_clear ((*result)->integer);
-    }
-  else
-    _calc_number_release (*result);
-  (*result)->type = CALC_NUMBER_TYPE_FLOATING;
-  mpfr_init ((*result)->floating);
-  switch (a->type)
-    {
-    case CALC_NUMBER_TYPE_INTEGER:
-      mpfr_set_z ((*result)->floating, a->integer, MPFR_RNDN);
-      mpfr_div_d ((*result)->floating, (*result)->floating, b, MPFR_RNDN);
-      break;
-    case CALC_NUMBER_TYPE_RATIONAL:
-      mpfr_set_q ((*result)->floating, a->rational, MPFR_RNDN);
-      mpfr_div_d ((*result)->floating, (*result)->floating, b, MPFR_RNDN);
-      break;
-    case CALC_NUMBER_TYPE_FLOATING:
-      mpfr_div_d ((*result)->floating, a->floating, b, MPFR_RNDN);
-      break;
-    }
+  _calc_number_prepare (result);
+  calc_value_div_d (&(*result)->value, &a->value, b);
 }
 
 /**
@@ -343,55 +179,11 @@ calc_number_div_d (CalcNumber **result, CalcNumber *a, double b)
 void
 calc_number_div_ui (CalcNumber **result, CalcNumber *a, unsigned long b)
 {
-  mpz_t temp;
-  mpq_t rb;
   g_return_if_fail (result != NULL);
   g_return_if_fail (*result == NULL || CALC_IS_NUMBER (*result));
   g_return_if_fail (CALC_IS_NUMBER (a));
-
-  if (*result == NULL)
-    {
-      *result = calc_number_new (NULL);
-      mpz_clear ((*result)->integer);
-    }
-  else
-    _calc_number_release (*result);
-  (*result)->type = a->type;
-  switch (a->type)
-    {
-    case CALC_NUMBER_TYPE_INTEGER:
-      mpz_init (temp);
-      mpz_mod_ui (temp, a->integer, b);
-      if (mpz_cmp_ui (temp, 0) == 0)
-	{
-	  mpz_init ((*result)->integer);
-	  mpz_divexact_ui ((*result)->integer, a->integer, b);
-	}
-      else
-	{
-	  mpq_t qa;
-	  mpq_t qb;
-	  (*result)->type = CALC_NUMBER_TYPE_RATIONAL;
-	  mpq_inits ((*result)->rational, qa, qb, NULL);
-	  mpq_set_z (qa, a->integer);
-	  mpq_set_ui (qb, b, 1);
-	  mpq_div ((*result)->rational, qa, qb);
-	  mpq_clears (qa, qb, NULL);
-	}
-      mpz_clear (temp);
-      break;
-    case CALC_NUMBER_TYPE_RATIONAL:
-      mpq_init ((*result)->rational);
-      mpq_init (rb);
-      mpq_set_ui (rb, b, 1);
-      mpq_div ((*result)->rational, a->rational, rb);
-      mpq_clear (rb);
-      break;
-    case CALC_NUMBER_TYPE_FLOATING:
-      mpfr_init ((*result)->floating);
-      mpfr_div_ui ((*result)->floating, a->floating, b, MPFR_RNDN);
-      break;
-    }
+  _calc_number_prepare (result);
+  calc_value_div_ui (&(*result)->value, &a->value, b);
 }
 
 /**
@@ -410,22 +202,30 @@ calc_number_div_ui (CalcNumber **result, CalcNumber *a, unsigned long b)
 void
 calc_number_div_si (CalcNumber **result, CalcNumber *a, signed long b)
 {
-  if (b >= 0)
-    calc_number_div_ui (result, a, b);
-  else
-    {
-      calc_number_div_ui (result, a, -b);
-      switch ((*result)->type)
-	{
-	case CALC_NUMBER_TYPE_INTEGER:
-	  mpz_neg ((*result)->integer, (*result)->integer);
-	  break;
-	case CALC_NUMBER_TYPE_RATIONAL:
-	  mpq_neg ((*result)->rational, (*result)->rational);
-	  break;
-	case CALC_NUMBER_TYPE_FLOATING:
-	  mpfr_neg ((*result)->floating, (*result)->floating, MPFR_RNDN);
-	  break;
-	}
-    }
+  g_return_if_fail (result != NULL);
+  g_return_if_fail (*result == NULL || CALC_IS_NUMBER (*result));
+  g_return_if_fail (CALC_IS_NUMBER (a));
+  _calc_number_prepare (result);
+  calc_value_div_si (&(*result)->value, &a->value, b);
+}
+
+/**
+ * calc_number_div_inplace:
+ * @self: the number to divide
+ * @value: the number to divide by
+ *
+ * Divides @self by @value and stores the result in @self. The result is the
+ * same as calling calc_number_div() with @self as both the result and the
+ * dividend, but the storage of @self is reused where possible. @value may
+ * be the same number as @self. If @self or @value are invalid numbers, no
+ * action is performed.
+ **/
+
+void
+calc_number_div_inplace (CalcNumber *self, CalcNumber *value)
+{
+  g_return_if_fail (CALC_IS_NUMBER (self));
+  g_return_if_fail (CALC_IS_NUMBER (value));
+  calc_expr_changed (CALC_EXPR (self));
+  calc_value_div_inplace (&self->value, &value->value);
 }
@@ -0,0 +1,119 @@
+/*************************************************************************
+ * calc-number-fma.c -- This file is part of libcalc.                    *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+
+#define _LIBCALC_INTERNAL
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "calc-number.h"
+
+/**
+ * calc_number_fma:
+ * @result: the pointer to store the result
+ * @a: the first multiplicand
+ * @b: the second multiplicand
+ * @c: the addend
+ *
+ * Computes @a * @b + @c and stores the result in @result. Any previous value
+ * in @result will be erased. The type of @result is dependent on the types of
+ * @a, @b and @c, and a floating-point result is rounded only once. If @result
+ * points to %NULL, a new #CalcNumber is allocated and @result will point to
+ * it. If @result is %NULL or @a, @b or @c are invalid numbers, no action is
+ * performed.
+ **/
+
+void
+calc_number_fma (CalcNumber **result, CalcNumber *a, CalcNumber *b,
+		 CalcNumber *c)
+{
+  g_return_if_fail (result != NULL);
+  g_return_if_fail (*result == NULL || CALC_IS_NUMBER (*result));
+  g_return_if_fail (CALC_IS_NUMBER (a));
+  g_return_if_fail (CALC_IS_NUMBER (b));
+  g_return_if_fail (CALC_IS_NUMBER (c));
+  _calc_number_prepare (result);
+  calc_value_fma (&(*result)->value, &a->value, &b->value, &c->value);
+}
+
+/**
+ * calc_number_fms:
+ * @result: the pointer to store the result
+ * @a: the first multiplicand
+ * @b: the second multiplicand
+ * @c: the subtrahend
+ *
+ * Computes @a * @b - @c and stores the result in @result. Any previous value
+ * in @result will be erased. The type of @result is dependent on the types of
+ * @a, @b and @c, and a floating-point result is rounded only once. If @result
+ * points to %NULL, a new #CalcNumber is allocated and @result will point to
+ * it. If @result is %NULL or @a, @b or @c are invalid numbers, no action is
+ * performed.
+ **/
+
+void
+calc_number_fms (CalcNumber **result, CalcNumber *a, CalcNumber *b,
+		 CalcNumber *c)
+{
+  g_return_if_fail (result != NULL);
+  g_return_if_fail (*result == NULL || CALC_IS_NUMBER (*result));
+  g_return_if_fail (CALC_IS_NUMBER (a));
+  g_return_if_fail (CALC_IS_NUMBER (b));
+  g_return_if_fail (CALC_IS_NUMBER (c));
+  _calc_number_prepare (result);
+  calc_value_fms (&(*result)->value, &a->value, &b->value, &c->value);
+}
+
+/**
+ * calc_number_dot:
+ * @result: the pointer to store the result
+ * @a: (array length=n): the first array of numbers
+ * @b: (array length=n): the second array of numbers
+ * @n: the number of elements in each array
+ *
+ * Computes the sum of the products of the corresponding elements of @a and
+ * @b and stores the result in @result. Any previous value in @result will be
+ * erased. The sum is exact if all of the numbers are exact, and otherwise
+ * rounded only once as described for calc_value_dot(). If @result points to
+ * %NULL, a new #CalcNumber is allocated and @result will point to it. If
+ * @result is %NULL or any of the elements of @a or @b are invalid numbers,
+ * no action is performed.
+ **/
+
+void
+calc_number_dot (CalcNumber **result, CalcNumber **a, CalcNumber **b,
+		 gsize n)
+{
+  CalcValueAcc acc;
+  gsize i;
+  g_return_if_fail (result != NULL);
+  g_return_if_fail (*result == NULL || CALC_IS_NUMBER (*result));
+  g_return_if_fail (n == 0 || (a != NULL && b != NULL));
+  for (i = 0; i < n; i++)
+    {
+      g_return_if_fail (CALC_IS_NUMBER (a[i]));
+      g_return_if_fail (CALC_IS_NUMBER (b[i]));
+    }
+
+  _calc_value_acc_init (&acc);
+  for (i = 0; i < n; i++)
+    _calc_value_acc_addmul (&acc, &a[i]->value, &b[i]->value);
+  _calc_number_prepare (result);
+  _calc_value_acc_finish (&acc, &(*result)->value);
+}
@@ -0,0 +1,298 @@
+/*************************************************************************
+ * calc-number-pool.c -- This file is part of libcalc.                   *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+
+#define _LIBCALC_INTERNAL
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "calc-number.h"
+
+/* Maximum number of objects and of each kind of GNU MP storage kept by a
+   single thread */
+#define CALC_NUMBER_POOL_SIZE 256
+
+/* Largest GNU MP storage kept by the pool, in limbs. Larger storage is
+   freed, so that one huge temporary does not stay allocated in every
+   thread that used it. */
+#define CALC_NUMBER_POOL_MAX_LIMBS 64
+
+typedef struct
+{
+  CalcNumber *numbers[CALC_NUMBER_POOL_SIZE];
+  __mpz_struct integers[CALC_NUMBER_POOL_SIZE];
+  __mpq_struct rationals[CALC_NUMBER_POOL_SIZE];
+  __mpfr_struct floatings[CALC_NUMBER_POOL_SIZE];
+  guint n_numbers;
+  guint n_integers;
+  guint n_rationals;
+  guint n_floatings;
+  guint64 hits;
+  guint64 misses;
+} CalcNumberMagazine;
+
+static void calc_number_magazine_free (gpointer data);
+
+static gint calc_number_pool_enabled;
+static GPrivate calc_number_magazine =
+  G_PRIVATE_INIT (calc_number_magazine_free);
+
+static void
+calc_number_magazine_drain (CalcNumberMagazine *mag)
+{
+  while (mag->n_numbers > 0)
+    g_object_unref (mag->numbers[--mag->n_numbers]);
+  while (mag->n_integers > 0)
+    mpz_clear (&mag->integers[--mag->n_integers]);
+  while (mag->n_rationals > 0)
+    mpq_clear (&mag->rationals[--mag->n_rationals]);
+  while (mag->n_floatings > 0)
+    mpfr_clear (&mag->floatings[--mag->n_floatings]);
+}
+
+/* Called on thread exit. The magazine of the thread is no longer reachable
+   at this point, so the numbers being released are not recycled again. */
+
+static void
+calc_number_magazine_free (gpointer data)
+{
+  calc_number_magazine_drain (data);
+  g_free (data);
+}
+
+/* Only the allocation path creates a magazine, so threads that never
+   allocate numbers and threads being torn down do not pool anything */
+
+static CalcNumberMagazine *
+calc_number_magazine_get (gboolean create)
+{
+  CalcNumberMagazine *mag;
+  if (!g_atomic_int_get (&calc_number_pool_enabled))
+    return NULL;
+  mag = g_private_get (&calc_number_magazine);
+  if (mag == NULL && create)
+    {
+      mag = g_new0 (CalcNumberMagazine, 1);
+      g_private_set (&calc_number_magazine, mag);
+    }
+  return mag;
+}
+
+/**
+ * calc_number_pool_set_enabled:
+ * @enabled: whether to enable the pool
+ *
+ * Enables or disables recycling of #CalcNumber instances. While the pool is
+ * enabled, each thread keeps numbers that are no longer referenced, along
+ * with the GNU MP and MPFR storage of released values, and reuses them for
+ * new numbers instead of allocating memory. Each thread keeps at most a
+ * fixed number of objects, and frees the storage of very large values
+ * instead of keeping it. The pool is disabled by default.
+ *
+ * Disabling the pool does not release numbers that were already pooled; use
+ * calc_number_pool_trim() for that.
+ **/
+
+void
+calc_number_pool_set_enabled (gboolean enabled)
+{
+  g_atomic_int_set (&calc_number_pool_enabled, enabled != FALSE);
+}
+
+/**
+ * calc_number_pool_get_enabled:
+ *
+ * Checks whether recycling of #CalcNumber instances is enabled.
+ *
+ * Returns: whether the pool is enabled
+ **/
+
+gboolean
+calc_number_pool_get_enabled (void)
+{
+  return g_atomic_int_get (&calc_number_pool_enabled);
+}
+
+/**
+ * calc_number_pool_get_stats:
+ * @hits: (out) (optional): the location to store the number of hits
+ * @misses: (out) (optional): the location to store the number of misses
+ *
+ * Retrieves the number of #CalcNumber allocations made by the calling
+ * thread while the pool was enabled. A hit is an allocation that reused a
+ * pooled number, and a miss is one that had to create a new instance.
+ **/
+
+void
+calc_number_pool_get_stats (guint64 *hits, guint64 *misses)
+{
+  CalcNumberMagazine *mag = g_private_get (&calc_number_magazine);
+  if (hits != NULL)
+    *hits = mag == NULL ? 0 : mag->hits;
+  if (misses != NULL)
+    *misses = mag == NULL ? 0 : mag->misses;
+}
+
+/**
+ * calc_number_pool_trim:
+ *
+ * Frees all numbers and storage pooled by the calling thread. Pooled
+ * objects are freed automatically when a thread exits.
+ **/
+
+void
+calc_number_pool_trim (void)
+{
+  CalcNumberMagazine *mag = g_private_get (&calc_number_magazine);
+  if (mag == NULL)
+    return;
+
+  /* Prevent the numbers being freed from being recycled */
+  g_private_set (&calc_number_magazine, NULL);
+  calc_number_magazine_drain (mag);
+  g_private_set (&calc_number_magazine, mag);
+}
+
+CalcNumber *
+_calc_number_alloc (void)
+{
+  CalcNumberMagazine *mag = calc_number_magazine_get (TRUE);
+  if (mag == NULL)
+    return g_object_new (CALC_TYPE_NUMBER, NULL);
+  if (mag->n_numbers > 0)
+    {
+      mag->hits++;
+      return mag->numbers[--mag->n_numbers];
+    }
+  mag->misses++;
+  return g_object_new (CALC_TYPE_NUMBER, NULL);
+}
+
+/* Counts the qdata entries of a number other than the notification queue,
+   which GObject keeps frozen while the number is being disposed */
+
+static void
+calc_number_pool_count_data (GQuark key, gpointer data, gpointer user_data)
+{
+  static gsize notify_queue;
+  if (g_once_init_enter (&notify_queue))
+    g_once_init_leave (&notify_queue,
+		       g_quark_from_static_string ("GObject-notify-queue"));
+  if (key != notify_queue)
+    (*(guint *) user_data)++;
+}
+
+/* Called when the last reference to a released number is dropped, after
+   GObject has released its signal handlers and weak references. If the
+   number is pooled, a new reference is taken on behalf of the pool and the
+   object will not be finalized. Numbers still carrying data or toggle
+   references are not pooled, since those belong to the previous owner and
+   are only released by finalizing the object. */
+
+gboolean
+_calc_number_recycle (CalcNumber *self)
+{
+  CalcNumberMagazine *mag = calc_number_magazine_get (FALSE);
+  guint n_data = 0;
+  if (mag == NULL || mag->n_numbers == CALC_NUMBER_POOL_SIZE)
+    return FALSE;
+  g_datalist_foreach (&G_OBJECT (self)->qdata, calc_number_pool_count_data,
+		      &n_data);
+  if (n_data > 0)
+    return FALSE;
+  mag->numbers[mag->n_numbers++] = g_object_ref (self);
+  return TRUE;
+}
+
+void
+_calc_value_init_z (mpz_ptr value)
+{
+  CalcNumberMagazine *mag = calc_number_magazine_get (FALSE);
+  if (mag != NULL && mag->n_integers > 0)
+    {
+      *value = mag->integers[--mag->n_integers];
+      mpz_set_ui (value, 0);
+    }
+  else
+    mpz_init (value);
+}
+
+void
+_calc_value_init_q (mpq_ptr value)
+{
+  CalcNumberMagazine *mag = calc_number_magazine_get (FALSE);
+  if (mag != NULL && mag->n_rationals > 0)
+    {
+      *value = mag->rationals[--mag->n_rationals];
+      mpq_set_ui (value, 0, 1);
+    }
+  else
+    mpq_init (value);
+}
+
+void
+_calc_value_init_fr (mpfr_ptr value, mpfr_prec_t prec)
+{
+  CalcNumberMagazine *mag = calc_number_magazine_get (FALSE);
+  if (mag != NULL && mag->n_floatings > 0)
+    {
+      *value = mag->floatings[--mag->n_floatings];
+      if (mpfr_get_prec (value) != prec)
+	mpfr_set_prec (value, prec);
+      else
+	mpfr_set_nan (value);
+    }
+  else
+    mpfr_init2 (value, prec);
+}
+
+void
+_calc_value_clear_z (mpz_ptr value)
+{
+  CalcNumberMagazine *mag = calc_number_magazine_get (FALSE);
+  if (mag != NULL && mag->n_integers < CALC_NUMBER_POOL_SIZE
+      && value->_mp_alloc <= CALC_NUMBER_POOL_MAX_LIMBS)
+    mag->integers[mag->n_integers++] = *value;
+  else
+    mpz_clear (value);
+}
+
+void
+_calc_value_clear_q (mpq_ptr value)
+{
+  CalcNumberMagazine *mag = calc_number_magazine_get (FALSE);
+  if (mag != NULL && mag->n_rationals < CALC_NUMBER_POOL_SIZE
+      && mpq_numref (value)->_mp_alloc <= CALC_NUMBER_POOL_MAX_LIMBS
+      && mpq_denref (value)->_mp_alloc <= CALC_NUMBER_POOL_MAX_LIMBS)
+    mag->rationals[mag->n_rationals++] = *value;
+  else
+    mpq_clear (value);
+}
+
+void
+_calc_value_clear_fr (mpfr_ptr value)
+{
+  CalcNumberMagazine *mag = calc_number_magazine_get (FALSE);
+  if (mag != NULL && mag->n_floatings < CALC_NUMBER_POOL_SIZE
+      && mpfr_get_prec (value)
+      <= CALC_NUMBER_POOL_MAX_LIMBS * GMP_NUMB_BITS)
+    mag->floatings[mag->n_floatings++] = *value;
+  else
+    mpfr_clear (value);
+}
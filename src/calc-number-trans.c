@@ -42,40 +42,11 @@
 gint
 calc_number_log (CalcNumber **result, CalcNumber *self)
 {
-  gint ret;
-  mpfr_t temp;
   g_return_val_if_fail (result != NULL, -1);
   g_return_val_if_fail (*result == NULL || CALC_IS_NUMBER (*result), -1);
   g_return_val_if_fail (CALC_IS_NUMBER (self), -1);
-
-  if (*result == NULL)
-    {
-      *result = calc_number_new (NULL);
-      mpz_clear ((*result)->integer);
-    }
-  else
-    _calc_number_release (*result);
-  (*result)->type = CALC_NUMBER_TYPE_FLOATING;
-  mpfr_init ((*result)->floating);
-  switch (self->type)
-    {
-    case CALC_NUMBER_TYPE_INTEGER:
-      mpfr_init_set_z (temp, self->integer, MPFR_RNDN);
-      ret = mpfr_log ((*result)->floating, temp, MPFR_RNDN);
-      mpfr_clear (temp);
-      break;
-    case CALC_NUMBER_TYPE_RATIONAL:
-      mpfr_init_set_q (temp, self->rational, MPFR_RNDN);
-      ret = mpfr_log ((*result)->floating, temp, MPFR_RNDN);
-      mpfr_clear (temp);
-      break;
-    case CALC_NUMBER_TYPE_FLOATING:
-      ret = mpfr_log ((*result)->floating, self->floating, MPFR_RNDN);
-      break;
-    default:
-      return -1;
-    }
-  return ret;
+  _calc_number_prepare (result);
+  return calc_value_log (&(*result)->value, &self->value);
 }
 
 /**
@@ -96,40 +67,11 @@ calc_number_log (CalcNumber **result, CalcNumber *self)
 gint
 calc_number_log2 (CalcNumber **result, CalcNumber *self)
 {
-  gint ret;
-  mpfr_t temp;
   g_return_val_if_fail (result != NULL, -1);
   g_return_val_if_fail (*result == NULL || CALC_IS_NUMBER (*result), -1);
   g_return_val_if_fail (CALC_IS_NUMBER (self), -1);
-
-  if (*result == NULL)
-    {
-      *result = calc_number_new (NULL);
-      mpz_clear ((*result)->integer);
-    }
-  else
-    _calc_number_release (*result);
-  (*result)->type = CALC_NUMBER_TYPE_FLOATING;
-  mpfr_init ((*result)->floating);
-  switch (self->type)
-    {
-    case CALC_NUMBER_TYPE_INTEGER:
-      mpfr_init_set_z (temp, self->integer, MPFR_RNDN);
-      ret = mpfr_log2 ((*result)->floating, temp, MPFR_RNDN);
-      mpfr_clear (temp);
-      break;
-    case CALC_NUMBER_TYPE_RATIONAL:
-      mpfr_init_set_q (temp, self->rational, MPFR_RNDN);
-      ret = mpfr_log2 ((*result)->floating, temp, MPFR_RNDN);
-      mpfr_clear (temp);
-      break;
-    case CALC_NUMBER_TYPE_FLOATING:
-      ret = mpfr_log2 ((*result)->floating, self->floating, MPFR_RNDN);
-      break;
-    default:
-      return -1;
-    }
-  return ret;
+  _calc_number_prepare (result);
+  return calc_value_log2 (&(*result)->value, &self->value);
 }
 
 /**
@@ -150,40 +92,11 @@ calc_number_log2 (CalcNumber **result, CalcNumber *self)
 gint
 calc_number_log10 (CalcNumber **result, CalcNumber *self)
 {
-  gint ret;
-  mpfr_t temp;
   g_return_val_if_fail (result != NULL, -1);
   g_return_val_if_fail (*result == NULL || CALC_IS_NUMBER (*result), -1);
   g_return_val_if_fail (CALC_IS_NUMBER (self), -1);
-
-  if (*result == NULL)
-    {
-      *result = calc_number_new (NULL);
-      mpz_clear ((*result)->integer);
-    }
-  else
-    _calc_number_release (*result);
-  (*result)->type = CALC_NUMBER_TYPE_FLOATING;
-  mpfr_init ((*result)->floating);
-  switch (self->type)
-    {
-    case CALC_NUMBER_TYPE_INTEGER:
-      mpfr_init_set_z (temp, self->integer, MPFR_RNDN);
-      ret = mpfr_log10 ((*result)->floating, temp, MPFR_RNDN);
-      mpfr_clear (temp);
-      break;
-    case CALC_NUMBER_TYPE_RATIONAL:
-      mpfr_init_set_q (temp, self->rational, MPFR_RNDN);
-      ret = mpfr_log10 ((*result)->floating, temp, MPFR_RNDN);
-      mpfr_clear (temp);
-      break;
-    case CALC_NUMBER_TYPE_FLOATING:
-      ret = mpfr_log10 ((*result)->floating, self->floating, MPFR_RNDN);
-      break;
-    default:
-      return -1;
-    }
-  return ret;
+  _calc_number_prepare (result);
+  return calc_value_log10 (&(*result)->value, &self->value);
 }
 
 /**
@@ -193,10 +106,11 @@ calc_number_log10 (CalcNumber **result, CalcNumber *self)
  * @base: the base of the logarithm
  *
  * Sets the value of @result to the base-@base logarithm of @self. Any
- * previous value of @result will be erased. If @result points to %NULL, a new
- * #CalcNumber is allocated and @result will point to it. If @result is %NULL,
- * @base is zero or one, or @self is an invalid number, no action is performed
- * and this function returns -1.
+ * previous value of @result will be erased. The result is exact if @self is
+ * an exact power of @base; see calc_value_logn() for details. If @result
+ * points to %NULL, a new #CalcNumber is allocated and @result will point to
+ * it. If @result is %NULL, @base is zero or one, or @self is an invalid
+ * number, no action is performed and this function returns -1.
  *
  * Returns: zero if the calculation succeeded
  **/
@@ -204,29 +118,12 @@ calc_number_log10 (CalcNumber **result, CalcNumber *self)
 gint
 calc_number_logn (CalcNumber **result, CalcNumber *self, unsigned long base)
 {
-  CalcNumber *a = NULL;
-  CalcNumber *b = NULL;
-  CalcNumber *fbase;
   g_return_val_if_fail (result != NULL, -1);
   g_return_val_if_fail (*result == NULL || CALC_IS_NUMBER (*result), -1);
   g_return_val_if_fail (CALC_IS_NUMBER (self), -1);
   g_return_val_if_fail (base > 1, -1);
-
-  fbase = calc_number_new_ui (base);
-  calc_number_log2 (&a, self);
-  calc_number_log2 (&b, fbase);
-  g_object_unref (fbase);
-  if (a == NULL || b == NULL)
-    {
-      g_object_unref (a);
-      g_object_unref (b);
-      return -1;
-    }
-
-  calc_number_div (result, a, b);
-  g_object_unref (a);
-  g_object_unref (b);
-  return 0;
+  _calc_number_prepare (result);
+  return calc_value_logn (&(*result)->value, &self->value, base);
 }
 
 /**
@@ -236,9 +133,11 @@ calc_number_logn (CalcNumber **result, CalcNumber *self, unsigned long base)
  * @b: the power to raise the base to
  *
  * Sets the value of @result to @a raised the @b power. Any previous value in
- * @result will be erased. If @result points to %NULL, a new #CalcNumber is
- * allocated and @result will point to it. If @result is %NULL or @a or @b are
- * invalid numbers, no action is performed and the function returns -1.
+ * @result will be erased. The result is exact if @a and @b are exact and the
+ * result is rational; see calc_value_pow() for details. If @result points to
+ * %NULL, a new #CalcNumber is allocated and @result will point to it. If
+ * @result is %NULL or @a or @b are invalid numbers, no action is performed
+ * and the function returns -1.
  *
  * Returns: zero if the calculation is exact, positive if the calculation is
  * slightly larger than the actual value, and negative if the calculation is
@@ -248,56 +147,374 @@ calc_number_logn (CalcNumber **result, CalcNumber *self, unsigned long base)
 gint
 calc_number_pow (CalcNumber **result, CalcNumber *a, CalcNumber *b)
 {
-  gint ret;
-  mpfr_t base;
-  mpfr_t power;
-
   g_return_val_if_fail (result != NULL, -1);
   g_return_val_if_fail (*result == NULL || CALC_IS_NUMBER (*result), -1);
   g_return_val_if_fail (CALC_IS_NUMBER (a), -1);
   g_return_val_if_fail (CALC_IS_NUMBER (b), -1);
+  _calc_number_prepare (result);
+  return calc_value_pow (&(*result)->value, &a->value, &b->value);
+}
+
+/**
+ * calc_number_exp:
+ * @result: the pointer to store the result
+ * @self: the number
+ *
+ * Sets the value of @result to the exponential of @self. Any previous value
+ * in @result is erased. See calc_value_exp() for the cases where the result
+ * is exact. If @result points to %NULL, a new #CalcNumber is allocated and
+ * @result will point to it. If @result is %NULL or @self is an invalid
+ * number, no action is performed and this function returns -1.
+ *
+ * Returns: zero if the calculation is exact, positive if the calculation is
+ * slightly larger than the actual value, and negative if the calculation is
+ * slightly smaller than the actual value or invalid arguments were given
+ **/
 
-  switch (a->type)
-    {
-    case CALC_NUMBER_TYPE_INTEGER:
-      mpfr_init_set_z (base, a->integer, MPFR_RNDN);
-      break;
-    case CALC_NUMBER_TYPE_RATIONAL:
-      mpfr_init_set_q (base, a->rational, MPFR_RNDN);
-      break;
-    case CALC_NUMBER_TYPE_FLOATING:
-      mpfr_init_set (base, a->floating, MPFR_RNDN);
-      break;
-    default:
-      return -1;
-    }
-  switch (b->type)
-    {
-    case CALC_NUMBER_TYPE_INTEGER:
-      mpfr_init_set_z (power, b->integer, MPFR_RNDN);
-      break;
-    case CALC_NUMBER_TYPE_RATIONAL:
-      mpfr_init_set_q (power, b->rational, MPFR_RNDN);
-      break;
-    case CALC_NUMBER_TYPE_FLOATING:
-      mpfr_init_set (power, b->floating, MPFR_RNDN);
-      break;
-    default:
-      mpfr_clear (base);
-      return -1;
-    }
-
-  if (*result == NULL)
-    {
-      *result = calc_number_new (NULL);
-      mpz_clear ((*result)->integer);
-    }
-  else
-    _calc_number_release (*result);
-  (*result)->type = CALC_NUMBER_TYPE_FLOATING;
-  mpfr_init ((*result)->floating);
-  ret = mpfr_pow ((*result)->floating, base, power, MPFR_RNDN);
-  mpfr_clear (base);
-  mpfr_clear (power);
-  return ret;
+gint
+calc_number_exp (CalcNumber **result, CalcNumber *self)
+{
+  g_return_val_if_fail (result != NULL, -1);
+  g_return_val_if_fail (*result == NULL || CALC_IS_NUMBER (*result), -1);
+  g_return_val_if_fail (CALC_IS_NUMBER (self), -1);
+  _calc_number_prepare (result);
+  return calc_value_exp (&(*result)->value, &self->value);
+}
+
+/**
+ * calc_number_sqrt:
+ * @result: the pointer to store the result
+ * @self: the number
+ *
+ * Sets the value of @result to the square root of @self. Any previous value
+ * in @result is erased. See calc_value_sqrt() for the cases where the result
+ * is exact. If @result points to %NULL, a new #CalcNumber is allocated and
+ * @result will point to it. If @result is %NULL or @self is an invalid
+ * number, no action is performed and this function returns -1.
+ *
+ * Returns: zero if the calculation is exact, positive if the calculation is
+ * slightly larger than the actual value, and negative if the calculation is
+ * slightly smaller than the actual value or invalid arguments were given
+ **/
+
+gint
+calc_number_sqrt (CalcNumber **result, CalcNumber *self)
+{
+  g_return_val_if_fail (result != NULL, -1);
+  g_return_val_if_fail (*result == NULL || CALC_IS_NUMBER (*result), -1);
+  g_return_val_if_fail (CALC_IS_NUMBER (self), -1);
+  _calc_number_prepare (result);
+  return calc_value_sqrt (&(*result)->value, &self->value);
+}
+
+/**
+ * calc_number_sin:
+ * @result: the pointer to store the result
+ * @self: the number
+ *
+ * Sets the value of @result to the sine of @self, in radians. Any previous
+ * value in @result is erased. See calc_value_sin() for the cases where the
+ * result is exact. If @result points to %NULL, a new #CalcNumber is
+ * allocated and @result will point to it. If @result is %NULL or @self is an
+ * invalid number, no action is performed and this function returns -1.
+ *
+ * Returns: zero if the calculation is exact, positive if the calculation is
+ * slightly larger than the actual value, and negative if the calculation is
+ * slightly smaller than the actual value or invalid arguments were given
+ **/
+
+gint
+calc_number_sin (CalcNumber **result, CalcNumber *self)
+{
+  g_return_val_if_fail (result != NULL, -1);
+  g_return_val_if_fail (*result == NULL || CALC_IS_NUMBER (*result), -1);
+  g_return_val_if_fail (CALC_IS_NUMBER (self), -1);
+  _calc_number_prepare (result);
+  return calc_value_sin (&(*result)->value, &self->value);
+}
+
+/**
+ * calc_number_cos:
+ * @result: the pointer to store the result
+ * @self: the number
+ *
+ * Sets the value of @result to the cosine of @self, in radians. Any previous
+ * value in @result is erased. See calc_value_cos() for the cases where the
+ * result is exact. If @result points to %NULL, a new #CalcNumber is
+ * allocated and @result will point to it. If @result is %NULL or @self is an
+ * invalid number, no action is performed and this function returns -1.
+ *
+ * Returns: zero if the calculation is exact, positive if the calculation is
+ * slightly larger than the actual value, and negative if the calculation is
+ * slightly smaller than the actual value or invalid arguments were given
+ **/
+
+gint
+calc_number_cos (CalcNumber **result, CalcNumber *self)
+{
+  g_return_val_if_fail (result != NULL, -1);
+  g_return_val_if_fail (*result == NULL || CALC_IS_NUMBER (*result), -1);
+  g_return_val_if_fail (CALC_IS_NUMBER (self), -1);
+  _calc_number_prepare (result);
+  return calc_value_cos (&(*result)->value, &self->value);
+}
+
+/**
+ * calc_number_tan:
+ * @result: the pointer to store the result
+ * @self: the number
+ *
+ * Sets the value of @result to the tangent of @self, in radians. Any
+ * previous value in @result is erased. See calc_value_tan() for the cases
+ * where the result is exact. If @result points to %NULL, a new #CalcNumber
+ * is allocated and @result will point to it. If @result is %NULL or @self is
+ * an invalid number, no action is performed and this function returns -1.
+ *
+ * Returns: zero if the calculation is exact, positive if the calculation is
+ * slightly larger than the actual value, and negative if the calculation is
+ * slightly smaller than the actual value or invalid arguments were given
+ **/
+
+gint
+calc_number_tan (CalcNumber **result, CalcNumber *self)
+{
+  g_return_val_if_fail (result != NULL, -1);
+  g_return_val_if_fail (*result == NULL || CALC_IS_NUMBER (*result), -1);
+  g_return_val_if_fail (CALC_IS_NUMBER (self), -1);
+  _calc_number_prepare (result);
+  return calc_value_tan (&(*result)->value, &self->value);
+}
+
+/**
+ * calc_number_asin:
+ * @result: the pointer to store the result
+ * @self: the number
+ *
+ * Sets the value of @result to the arc-sine of @self in radians. Any
+ * previous value in @result is erased. See calc_value_asin() for the cases
+ * where the result is exact. If @result points to %NULL, a new #CalcNumber
+ * is allocated and @result will point to it. If @result is %NULL or @self is
+ * an invalid number, no action is performed and this function returns -1.
+ *
+ * Returns: zero if the calculation is exact, positive if the calculation is
+ * slightly larger than the actual value, and negative if the calculation is
+ * slightly smaller than the actual value or invalid arguments were given
+ **/
+
+gint
+calc_number_asin (CalcNumber **result, CalcNumber *self)
+{
+  g_return_val_if_fail (result != NULL, -1);
+  g_return_val_if_fail (*result == NULL || CALC_IS_NUMBER (*result), -1);
+  g_return_val_if_fail (CALC_IS_NUMBER (self), -1);
+  _calc_number_prepare (result);
+  return calc_value_asin (&(*result)->value, &self->value);
+}
+
+/**
+ * calc_number_acos:
+ * @result: the pointer to store the result
+ * @self: the number
+ *
+ * Sets the value of @result to the arc-cosine of @self in radians. Any
+ * previous value in @result is erased. See calc_value_acos() for the cases
+ * where the result is exact. If @result points to %NULL, a new #CalcNumber
+ * is allocated and @result will point to it. If @result is %NULL or @self is
+ * an invalid number, no action is performed and this function returns -1.
+ *
+ * Returns: zero if the calculation is exact, positive if the calculation is
+ * slightly larger than the actual value, and negative if the calculation is
+ * slightly smaller than the actual value or invalid arguments were given
+ **/
+
+gint
+calc_number_acos (CalcNumber **result, CalcNumber *self)
+{
+  g_return_val_if_fail (result != NULL, -1);
+  g_return_val_if_fail (*result == NULL || CALC_IS_NUMBER (*result), -1);
+  g_return_val_if_fail (CALC_IS_NUMBER (self), -1);
+  _calc_number_prepare (result);
+  return calc_value_acos (&(*result)->value, &self->value);
+}
+
+/**
+ * calc_number_atan:
+ * @result: the pointer to store the result
+ * @self: the number
+ *
+ * Sets the value of @result to the arc-tangent of @self in radians. Any
+ * previous value in @result is erased. See calc_value_atan() for the cases
+ * where the result is exact. If @result points to %NULL, a new #CalcNumber
+ * is allocated and @result will point to it. If @result is %NULL or @self is
+ * an invalid number, no action is performed and this function returns -1.
+ *
+ * Returns: zero if the calculation is exact, positive if the calculation is
+ * slightly larger than the actual value, and negative if the calculation is
+ * slightly smaller than the actual value or invalid arguments were given
+ **/
+
+gint
+calc_number_atan (CalcNumber **result, CalcNumber *self)
+{
+  g_return_val_if_fail (result != NULL, -1);
+  g_return_val_if_fail (*result == NULL || CALC_IS_NUMBER (*result), -1);
+  g_return_val_if_fail (CALC_IS_NUMBER (self), -1);
+  _calc_number_prepare (result);
+  return calc_value_atan (&(*result)->value, &self->value);
+}
+
+/**
+ * calc_number_sinh:
+ * @result: the pointer to store the result
+ * @self: the number
+ *
+ * Sets the value of @result to the hyperbolic sine of @self. Any previous
+ * value in @result is erased. See calc_value_sinh() for the cases where the
+ * result is exact. If @result points to %NULL, a new #CalcNumber is
+ * allocated and @result will point to it. If @result is %NULL or @self is an
+ * invalid number, no action is performed and this function returns -1.
+ *
+ * Returns: zero if the calculation is exact, positive if the calculation is
+ * slightly larger than the actual value, and negative if the calculation is
+ * slightly smaller than the actual value or invalid arguments were given
+ **/
+
+gint
+calc_number_sinh (CalcNumber **result, CalcNumber *self)
+{
+  g_return_val_if_fail (result != NULL, -1);
+  g_return_val_if_fail (*result == NULL || CALC_IS_NUMBER (*result), -1);
+  g_return_val_if_fail (CALC_IS_NUMBER (self), -1);
+  _calc_number_prepare (result);
+  return calc_value_sinh (&(*result)->value, &self->value);
+}
+
+/**
+ * calc_number_cosh:
+ * @result: the pointer to store the result
+ * @self: the number
+ *
+ * Sets the value of @result to the hyperbolic cosine of @self. Any previous
+ * value in @result is erased. See calc_value_cosh() for the cases where the
+ * result is exact. If @result points to %NULL, a new #CalcNumber is
+ * allocated and @result will point to it. If @result is %NULL or @self is an
+ * invalid number, no action is performed and this function returns -1.
+ *
+ * Returns: zero if the calculation is exact, positive if the calculation is
+ * slightly larger than the actual value, and negative if the calculation is
+ * slightly smaller than the actual value or invalid arguments were given
+ **/
+
+gint
+calc_number_cosh (CalcNumber **result, CalcNumber *self)
+{
+  g_return_val_if_fail (result != NULL, -1);
+  g_return_val_if_fail (*result == NULL || CALC_IS_NUMBER (*result), -1);
+  g_return_val_if_fail (CALC_IS_NUMBER (self), -1);
+  _calc_number_prepare (result);
+  return calc_value_cosh (&(*result)->value, &self->value);
+}
+
+/**
+ * calc_number_tanh:
+ * @result: the pointer to store the result
+ * @self: the number
+ *
+ * Sets the value of @result to the hyperbolic tangent of @self. Any previous
+ * value in @result is erased. See calc_value_tanh() for the cases where the
+ * result is exact. If @result points to %NULL, a new #CalcNumber is
+ * allocated and @result will point to it. If @result is %NULL or @self is an
+ * invalid number, no action is performed and this function returns -1.
+ *
+ * Returns: zero if the calculation is exact, positive if the calculation is
+ * slightly larger than the actual value, and negative if the calculation is
+ * slightly smaller than the actual value or invalid arguments were given
+ **/
+
+gint
+calc_number_tanh (CalcNumber **result, CalcNumber *self)
+{
+  g_return_val_if_fail (result != NULL, -1);
+  g_return_val_if_fail (*result == NULL || CALC_IS_NUMBER (*result), -1);
+  g_return_val_if_fail (CALC_IS_NUMBER (self), -1);
+  _calc_number_prepare (result);
+  return calc_value_tanh (&(*result)->value, &self->value);
+}
+
+/**
+ * calc_number_asinh:
+ * @result: the pointer to store the result
+ * @self: the number
+ *
+ * Sets the value of @result to the inverse hyperbolic sine of @self. Any
+ * previous value in @result is erased. See calc_value_asinh() for the cases
+ * where the result is exact. If @result points to %NULL, a new #CalcNumber
+ * is allocated and @result will point to it. If @result is %NULL or @self is
+ * an invalid number, no action is performed and this function returns -1.
+ *
+ * Returns: zero if the calculation is exact, positive if the calculation is
+ * slightly larger than the actual value, and negative if the calculation is
+ * slightly smaller than the actual value or invalid arguments were given
+ **/
+
+gint
+calc_number_asinh (CalcNumber **result, CalcNumber *self)
+{
+  g_return_val_if_fail (result != NULL, -1);
+  g_return_val_if_fail (*result == NULL || CALC_IS_NUMBER (*result), -1);
+  g_return_val_if_fail (CALC_IS_NUMBER (self), -1);
+  _calc_number_prepare (result);
+  return calc_value_asinh (&(*result)->value, &self->value);
+}
+
+/**
+ * calc_number_acosh:
+ * @result: the pointer to store the result
+ * @self: the number
+ *
+ * Sets the value of @result to the inverse hyperbolic cosine of @self. Any
+ * previous value in @result is erased. See calc_value_acosh() for the cases
+ * where the result is exact. If @result points to %NULL, a new #CalcNumber
+ * is allocated and @result will point to it. If @result is %NULL or @self is
+ * an invalid number, no action is performed and this function returns -1.
+ *
+ * Returns: zero if the calculation is exact, positive if the calculation is
+ * slightly larger than the actual value, and negative if the calculation is
+ * slightly smaller than the actual value or invalid arguments were given
+ **/
+
+gint
+calc_number_acosh (CalcNumber **result, CalcNumber *self)
+{
+  g_return_val_if_fail (result != NULL, -1);
+  g_return_val_if_fail (*result == NULL || CALC_IS_NUMBER (*result), -1);
+  g_return_val_if_fail (CALC_IS_NUMBER (self), -1);
+  _calc_number_prepare (result);
+  return calc_value_acosh (&(*result)->value, &self->value);
+}
+
+/**
+ * calc_number_atanh:
+ * @result: the pointer to store the result
+ * @self: the number
+ *
+ * Sets the value of @result to the inverse hyperbolic tangent of @self. Any
+ * previous value in @result is erased. See calc_value_atanh() for the cases
+ * where the result is exact. If @result points to %NULL, a new #CalcNumber
+ * is allocated and @result will point to it. If @result is %NULL or @self is
+ * an invalid number, no action is performed and this function returns -1.
+ *
+ * Returns: zero if the calculation is exact, positive if the calculation is
+ * slightly larger than the actual value, and negative if the calculation is
+ * slightly smaller than the actual value or invalid arguments were given
+ **/
+
+gint
+calc_number_atanh (CalcNumber **result, CalcNumber *self)
+{
+  g_return_val_if_fail (result != NULL, -1);
+  g_return_val_if_fail (*result == NULL || CALC_IS_NUMBER (*result), -1);
+  g_return_val_if_fail (CALC_IS_NUMBER (self), -1);
+  _calc_number_prepare (result);
+  return calc_value_atanh (&(*result)->value, &self->value);
 }
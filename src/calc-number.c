@@ -22,24 +22,34 @@
 #include <config.h>
 #endif
 
-#include <stdio.h> /* mpfr_fprintf() */
+#include <stdio.h> /* mpfr_snprintf() */
+#include <string.h>
 #include "calc-number.h"
+#include "calc-program.h"
 
 G_DEFINE_TYPE (CalcNumber, calc_number, CALC_TYPE_EXPR)
 
 static void calc_number_render (CalcExpr *expr, cairo_t *cr, gsize size);
 static void calc_number_get_dims (CalcExpr *expr, cairo_t *cr, gint *width,
 				  gint *height, gsize size);
-static void calc_number_print (CalcExpr *expr, FILE *stream);
+static void calc_number_print_string (CalcExpr *expr, GString *str,
+				      const CalcPrintFormat *format);
 static gboolean calc_number_equivalent (CalcExpr *self, CalcExpr *other);
 static gboolean calc_number_like_terms (CalcExpr *self, CalcExpr *other);
-static gulong calc_number_hash (CalcExpr *expr);
+static guint64 calc_number_hash (CalcExpr *expr);
 static gboolean calc_number_evaluate (CalcExpr *expr, CalcExpr *result);
+static gboolean calc_number_evaluate_approx (CalcExpr *expr,
+					     CalcApprox *result,
+					     gdouble tolerance);
+static gint calc_number_compile (CalcExpr *expr, CalcProgram *program);
 
 static void
 calc_number_dispose (GObject *obj)
 {
-  _calc_number_release (CALC_NUMBER (obj));
+  CalcNumber *self = CALC_NUMBER (obj);
+  calc_value_clear (&self->value);
+  G_OBJECT_CLASS (calc_number_parent_class)->dispose (obj);
+  _calc_number_recycle (self);
 }
 
 static void
@@ -49,11 +59,13 @@ calc_number_class_init (CalcNumberClass *klass)
   G_OBJECT_CLASS (klass)->dispose = calc_number_dispose;
   exprclass->render = calc_number_render;
   exprclass->get_dims = calc_number_get_dims;
-  exprclass->print = calc_number_print;
+  exprclass->print_string = calc_number_print_string;
   exprclass->equivalent = calc_number_equivalent;
   exprclass->like_terms = calc_number_like_terms;
   exprclass->hash = calc_number_hash;
   exprclass->evaluate = calc_number_evaluate;
+  exprclass->evaluate_approx = calc_number_evaluate_approx;
+  exprclass->compile = calc_number_compile;
   
 }
 
@@ -66,19 +78,29 @@ static void
 calc_number_render (CalcExpr *expr, cairo_t *cr, gsize size)
 {
   CalcNumber *self = CALC_NUMBER (expr);
+  CalcValueView view;
+  GString *buf;
   gchar *text;
   PangoLayout *layout;
 
-  switch (self->type)
+  switch (self->value.type)
     {
     case CALC_NUMBER_TYPE_INTEGER:
-      gmp_asprintf (&text, "%Zd", self->integer);
+      gmp_asprintf (&text, "%Zd", _calc_value_get_z (&self->value, &view));
       break;
     case CALC_NUMBER_TYPE_RATIONAL:
-      gmp_asprintf (&text, "%Qd", self->rational);
+      gmp_asprintf (&text, "%Qd", _calc_value_get_q (&self->value, &view));
       break;
+    case CALC_NUMBER_TYPE_DECIMAL:
+      buf = g_string_new (NULL);
+      _calc_value_decimal_print (&self->value, buf);
+      text = strdup (buf->str);
+      g_string_free (buf, TRUE);
+      break;
+    case CALC_NUMBER_TYPE_DOUBLE:
     case CALC_NUMBER_TYPE_FLOATING:
-      mpfr_asprintf (&text, "%.8RNf", self->floating);
+      mpfr_asprintf (&text, "%.8RNf",
+		     _calc_value_get_fr (&self->value, &view));
       break;
     default:
       g_return_if_reached ();
@@ -95,19 +117,29 @@ calc_number_get_dims (CalcExpr *expr, cairo_t *cr, gint *width, gint *height,
 		      gsize size)
 {
   CalcNumber *self = CALC_NUMBER (expr);
+  CalcValueView view;
+  GString *buf;
   gchar *text;
   PangoLayout *layout;
 
-  switch (self->type)
+  switch (self->value.type)
     {
     case CALC_NUMBER_TYPE_INTEGER:
-      gmp_asprintf (&text, "%Zd", self->integer);
+      gmp_asprintf (&text, "%Zd", _calc_value_get_z (&self->value, &view));
       break;
     case CALC_NUMBER_TYPE_RATIONAL:
-      gmp_asprintf (&text, "%Qd", self->rational);
+      gmp_asprintf (&text, "%Qd", _calc_value_get_q (&self->value, &view));
+      break;
+    case CALC_NUMBER_TYPE_DECIMAL:
+      buf = g_string_new (NULL);
+      _calc_value_decimal_print (&self->value, buf);
+      text = strdup (buf->str);
+      g_string_free (buf, TRUE);
       break;
+    case CALC_NUMBER_TYPE_DOUBLE:
     case CALC_NUMBER_TYPE_FLOATING:
-      mpfr_asprintf (&text, "%.8RNf", self->floating);
+      mpfr_asprintf (&text, "%.8RNf",
+		     _calc_value_get_fr (&self->value, &view));
       break;
     default:
       g_return_if_reached ();
@@ -119,23 +151,58 @@ calc_number_get_dims (CalcExpr *expr, cairo_t *cr, gint *width, gint *height,
   g_object_unref (layout);
 }
 
+/* Numbers are converted directly into the space reserved at the end of
+   @str. The sizes reserved for integers and rationals are upper bounds, so
+   the string is shortened afterwards to the length actually written. */
+
 static void
-calc_number_print (CalcExpr *expr, FILE *stream)
+calc_number_print_string (CalcExpr *expr, GString *str,
+			  const CalcPrintFormat *format)
 {
   CalcNumber *self = CALC_NUMBER (expr);
-  switch (self->type)
+  CalcValueView view;
+  mpz_srcptr z;
+  mpq_srcptr q;
+  mpfr_srcptr fr;
+  gsize len = str->len;
+  gchar conv[] = "%.*RNf";
+  gint n;
+
+  switch (self->value.type)
     {
     case CALC_NUMBER_TYPE_INTEGER:
-      mpz_out_str (stream, 10, self->integer);
+      z = _calc_value_get_z (&self->value, &view);
+      g_string_set_size (str, len + mpz_sizeinbase (z, 10) + 2);
+      mpz_get_str (str->str + len, 10, z);
       break;
     case CALC_NUMBER_TYPE_RATIONAL:
-      mpq_out_str (stream, 10, self->rational);
+      q = _calc_value_get_q (&self->value, &view);
+      g_string_set_size (str, len + mpz_sizeinbase (mpq_numref (q), 10)
+			 + mpz_sizeinbase (mpq_denref (q), 10) + 3);
+      mpq_get_str (str->str + len, 10, q);
       break;
+    case CALC_NUMBER_TYPE_DECIMAL:
+      _calc_value_decimal_print (&self->value, str);
+      return;
+    case CALC_NUMBER_TYPE_DOUBLE:
     case CALC_NUMBER_TYPE_FLOATING:
-      /* TODO Customizable precision printing */
-      mpfr_fprintf (stream, "%.8RNf", self->floating);
-      break;
+      fr = _calc_value_get_fr (&self->value, &view);
+      conv[sizeof (conv) - 2] = format->conversion;
+      n = mpfr_snprintf (str->str + len, str->allocated_len - len, conv,
+			 format->precision, fr);
+      if (n < 0)
+	return;
+      if ((gsize) n >= str->allocated_len - len)
+	{
+	  g_string_set_size (str, len + n);
+	  mpfr_snprintf (str->str + len, n + 1, conv, format->precision, fr);
+	}
+      g_string_set_size (str, len + n);
+      return;
+    default:
+      return;
     }
+  g_string_truncate (str, len + strlen (str->str + len));
 }
 
 static gboolean
@@ -151,39 +218,34 @@ calc_number_like_terms (CalcExpr *self, CalcExpr *other)
   return CALC_IS_NUMBER (other);
 }
 
-static gulong
+static guint64
 calc_number_hash (CalcExpr *expr)
 {
-  return 0; /* Hashes for constant numbers are meaningless */
+  return calc_value_hash (&CALC_NUMBER (expr)->value);
 }
 
 static gboolean
 calc_number_evaluate (CalcExpr *expr, CalcExpr *result)
 {
   CalcNumber *self = CALC_NUMBER (expr);
-  CalcNumber *ans;
   g_return_val_if_fail (CALC_IS_NUMBER (result), FALSE);
-  ans = CALC_NUMBER (result);
-  _calc_number_release (ans);
-  ans->type = self->type;
-  switch (ans->type)
-    {
-    case CALC_NUMBER_TYPE_INTEGER:
-      mpz_init_set (ans->integer, self->integer);
-      break;
-    case CALC_NUMBER_TYPE_RATIONAL:
-      mpq_init (ans->rational);
-      mpq_set (ans->rational, self->rational);
-      break;
-    case CALC_NUMBER_TYPE_FLOATING:
-      mpfr_init_set (ans->floating, self->floating, MPFR_RNDN);
-      break;
-    default:
-      return FALSE;
-    }
+  calc_value_set (&CALC_NUMBER (result)->value, &self->value);
   return TRUE;
 }
 
+static gboolean
+calc_number_evaluate_approx (CalcExpr *expr, CalcApprox *result,
+			     gdouble tolerance)
+{
+  return _calc_approx_set_value (result, &CALC_NUMBER (expr)->value);
+}
+
+static gint
+calc_number_compile (CalcExpr *expr, CalcProgram *program)
+{
+  return _calc_program_add_const (program, &CALC_NUMBER (expr)->value);
+}
+
 /**
  * calc_number_new:
  * @value: the value to initialize to
@@ -200,17 +262,11 @@ calc_number_new (CalcNumber *value)
 {
   CalcNumber *self;
   g_return_val_if_fail (value == NULL || CALC_IS_NUMBER (value), NULL);
-  self = g_object_new (CALC_TYPE_NUMBER, NULL);
+  self = _calc_number_alloc ();
   if (value == NULL)
-    {
-      self->type = CALC_NUMBER_TYPE_INTEGER;
-      mpz_init (self->integer);
-    }
+    calc_value_init (&self->value);
   else
-    {
-      self->type = -1; /* Don't free anything */
-      calc_number_copy (self, value);
-    }
+    calc_value_init_set (&self->value, &value->value);
   return self;
 }
 
@@ -227,9 +283,8 @@ calc_number_new (CalcNumber *value)
 CalcNumber *
 calc_number_new_z (mpz_t value)
 {
-  CalcNumber *self = g_object_new (CALC_TYPE_NUMBER, NULL);
-  mpz_init_set (self->integer, value);
-  self->type = CALC_NUMBER_TYPE_INTEGER;
+  CalcNumber *self = _calc_number_alloc ();
+  calc_value_init_z (&self->value, value);
   return self;
 }
 
@@ -246,10 +301,8 @@ calc_number_new_z (mpz_t value)
 CalcNumber *
 calc_number_new_q (mpq_t value)
 {
-  CalcNumber *self = g_object_new (CALC_TYPE_NUMBER, NULL);
-  mpq_init (self->rational);
-  mpq_set (self->rational, value);
-  self->type = CALC_NUMBER_TYPE_RATIONAL;
+  CalcNumber *self = _calc_number_alloc ();
+  calc_value_init_q (&self->value, value);
   return self;
 }
 
@@ -266,9 +319,8 @@ calc_number_new_q (mpq_t value)
 CalcNumber *
 calc_number_new_f (mpf_t value)
 {
-  CalcNumber *self = g_object_new (CALC_TYPE_NUMBER, NULL);
-  mpfr_init_set_f (self->floating, value, MPFR_RNDN);
-  self->type = CALC_NUMBER_TYPE_FLOATING;
+  CalcNumber *self = _calc_number_alloc ();
+  calc_value_init_f (&self->value, value);
   return self;
 }
 
@@ -286,9 +338,8 @@ calc_number_new_f (mpf_t value)
 CalcNumber *
 calc_number_new_fr (mpfr_t value)
 {
-  CalcNumber *self = g_object_new (CALC_TYPE_NUMBER, NULL);
-  mpfr_init_set (self->floating, value, MPFR_RNDN);
-  self->type = CALC_NUMBER_TYPE_FLOATING;
+  CalcNumber *self = _calc_number_alloc ();
+  calc_value_init_fr (&self->value, value);
   return self;
 }
 
@@ -305,9 +356,46 @@ calc_number_new_fr (mpfr_t value)
 CalcNumber *
 calc_number_new_d (double value)
 {
-  CalcNumber *self = g_object_new (CALC_TYPE_NUMBER, NULL);
-  mpfr_init_set_d (self->floating, value, MPFR_RNDN);
-  self->type = CALC_NUMBER_TYPE_FLOATING;
+  CalcNumber *self = _calc_number_alloc ();
+  calc_value_init_d (&self->value, value);
+  return self;
+}
+
+/**
+ * calc_number_new_double:
+ * @value: the value to initialize to
+ *
+ * Constructs a new #CalcNumber and initializes it to the hardware double
+ * @value. The number will have a type set to %CALC_NUMBER_TYPE_DOUBLE.
+ *
+ * Returns: the newly constructed instance
+ **/
+
+CalcNumber *
+calc_number_new_double (gdouble value)
+{
+  CalcNumber *self = _calc_number_alloc ();
+  calc_value_init_double (&self->value, value);
+  return self;
+}
+
+/**
+ * calc_number_new_decimal:
+ * @coefficient: the digits of the value
+ * @scale: the number of digits after the decimal point
+ *
+ * Constructs a new #CalcNumber and initializes it to @coefficient divided
+ * by 10 raised to @scale. The number will have a type set to
+ * %CALC_NUMBER_TYPE_DECIMAL.
+ *
+ * Returns: the newly constructed instance
+ **/
+
+CalcNumber *
+calc_number_new_decimal (signed long coefficient, guint scale)
+{
+  CalcNumber *self = _calc_number_alloc ();
+  calc_value_init_decimal (&self->value, coefficient, scale);
   return self;
 }
 
@@ -324,9 +412,8 @@ calc_number_new_d (double value)
 CalcNumber *
 calc_number_new_ui (unsigned long value)
 {
-  CalcNumber *self = g_object_new (CALC_TYPE_NUMBER, NULL);
-  mpz_init_set_ui (self->integer, value);
-  self->type = CALC_NUMBER_TYPE_INTEGER;
+  CalcNumber *self = _calc_number_alloc ();
+  calc_value_init_ui (&self->value, value);
   return self;
 }
 
@@ -343,9 +430,54 @@ calc_number_new_ui (unsigned long value)
 CalcNumber *
 calc_number_new_si (signed long value)
 {
-  CalcNumber *self = g_object_new (CALC_TYPE_NUMBER, NULL);
-  mpz_init_set_si (self->integer, value);
-  self->type = CALC_NUMBER_TYPE_INTEGER;
+  CalcNumber *self = _calc_number_alloc ();
+  calc_value_init_si (&self->value, value);
+  return self;
+}
+
+/**
+ * calc_number_new_const:
+ * @constant: the constant
+ *
+ * Constructs a new #CalcNumber and initializes it to a floating-point
+ * approximation of @constant. See calc_value_set_const() for details.
+ *
+ * Returns: the newly constructed instance
+ **/
+
+CalcNumber *
+calc_number_new_const (CalcConstant constant)
+{
+  CalcNumber *self = _calc_number_alloc ();
+  calc_value_init (&self->value);
+  calc_value_set_const (&self->value, constant);
+  return self;
+}
+
+/**
+ * calc_number_new_str:
+ * @str: the string to parse
+ *
+ * Constructs a new #CalcNumber and initializes it to the number written in
+ * @str, which may be an integer, a fraction of two integers, or a decimal
+ * in plain or scientific notation. See calc_value_set_str() for details.
+ *
+ * Returns: (transfer full) (nullable): the newly constructed instance, or
+ * %NULL if @str is not a valid number
+ **/
+
+CalcNumber *
+calc_number_new_str (const gchar *str)
+{
+  CalcNumber *self;
+  g_return_val_if_fail (str != NULL, NULL);
+  self = _calc_number_alloc ();
+  calc_value_init (&self->value);
+  if (!calc_value_set_str (&self->value, str, -1))
+    {
+      g_object_unref (self);
+      return NULL;
+    }
   return self;
 }
 
@@ -363,21 +495,33 @@ calc_number_copy (CalcNumber *result, CalcNumber *self)
 {
   g_return_if_fail (CALC_IS_NUMBER (result));
   g_return_if_fail (CALC_IS_NUMBER (self));
-  _calc_number_release (result);
-  result->type = self->type;
-  switch (self->type)
-    {
-    case CALC_NUMBER_TYPE_INTEGER:
-      mpz_init_set (result->integer, self->integer);
-      break;
-    case CALC_NUMBER_TYPE_RATIONAL:
-      mpq_init (result->rational);
-      mpq_set (result->rational, self->rational);
-      break;
-    case CALC_NUMBER_TYPE_FLOATING:
-      mpfr_init_set (result->floating, self->floating, MPFR_RNDN);
-      break;
-    }
+  calc_expr_changed (CALC_EXPR (result));
+  calc_value_set (&result->value, &self->value);
+}
+
+/**
+ * calc_number_set_str:
+ * @self: the number to set
+ * @str: the string to parse
+ * @len: the length of @str in bytes, or -1 if @str is nul-terminated
+ *
+ * Sets @self to the number written in @str, reusing the storage of @self.
+ * This avoids allocating a new instance for every number when parsing many
+ * numbers in a row. See calc_value_set_str() for the accepted syntax.
+ *
+ * Returns: %TRUE on success, or %FALSE if @self is invalid or @str is not
+ * a valid number, in which case @self is not modified
+ **/
+
+gboolean
+calc_number_set_str (CalcNumber *self, const gchar *str, gssize len)
+{
+  g_return_val_if_fail (CALC_IS_NUMBER (self), FALSE);
+  g_return_val_if_fail (str != NULL, FALSE);
+  if (!calc_value_set_str (&self->value, str, len))
+    return FALSE;
+  calc_expr_changed (CALC_EXPR (self));
+  return TRUE;
 }
 
 /**
@@ -395,33 +539,7 @@ void
 calc_number_cast (CalcNumber *self, CalcNumberType type)
 {
   g_return_if_fail (CALC_IS_NUMBER (self));
-  if (self->type == type)
-    return;
-  g_return_if_fail (type > self->type && type < N_CALC_NUMBER_TYPE);
-  switch (type)
-    {
-    case CALC_NUMBER_TYPE_RATIONAL:
-      mpq_init (self->rational);
-      mpq_set_z (self->rational, self->integer);
-      mpz_clear (self->integer);
-      break;
-    case CALC_NUMBER_TYPE_FLOATING:
-      mpfr_init (self->floating);
-      if (self->type == CALC_NUMBER_TYPE_RATIONAL)
-	{
-	  mpfr_set_q (self->floating, self->rational, MPFR_RNDN);
-	  mpq_clear (self->rational);
-	}
-      else
-	{
-	  mpfr_set_z (self->floating, self->integer, MPFR_RNDD);
-	  mpz_clear (self->integer);
-	}
-      break;
-    default:
-      break;
-    }
-  self->type = type;
+  calc_value_cast (&self->value, type);
 }
 
 /**
@@ -439,31 +557,10 @@ void
 calc_number_neg (CalcNumber **result, CalcNumber *self)
 {
   g_return_if_fail (result != NULL);
+  g_return_if_fail (*result == NULL || CALC_IS_NUMBER (*result));
   g_return_if_fail (CALC_IS_NUMBER (self));
-
-  if (*result == NULL)
-    {
-      *result = calc_number_new (NULL);
-      mpz_clear ((*result)->integer);
-    }
-  else
-    _calc_number_release (*result);
-  (*result)->type = self->type;
-  switch (self->type)
-    {
-    case CALC_NUMBER_TYPE_INTEGER:
-      mpz_init ((*result)->integer);
-      mpz_neg ((*result)->integer, self->integer);
-      break;
-    case CALC_NUMBER_TYPE_RATIONAL:
-      mpq_init ((*result)->rational);
-      mpq_neg ((*result)->rational, self->rational);
-      break;
-    case CALC_NUMBER_TYPE_FLOATING:
-      mpfr_init ((*result)->floating);
-      mpfr_neg ((*result)->floating, self->floating, MPFR_RNDN);
-      break;
-    }
+  _calc_number_prepare (result);
+  calc_value_neg (&(*result)->value, &self->value);
 }
 
 /**
@@ -481,31 +578,10 @@ void
 calc_number_abs (CalcNumber **result, CalcNumber *self)
 {
   g_return_if_fail (result != NULL);
+  g_return_if_fail (*result == NULL || CALC_IS_NUMBER (*result));
   g_return_if_fail (CALC_IS_NUMBER (self));
-
-  if (*result == NULL)
-    {
-      *result = calc_number_new (NULL);
-      mpz_clear ((*result)->integer);
-    }
-  else
-    _calc_number_release (*result);
-  (*result)->type = self->type;
-  switch (self->type)
-    {
-    case CALC_NUMBER_TYPE_INTEGER:
-      mpz_init ((*result)->integer);
-      mpz_abs ((*result)->integer, self->integer);
-      break;
-    case CALC_NUMBER_TYPE_RATIONAL:
-      mpq_init ((*result)->rational);
-      mpq_abs ((*result)->rational, self->rational);
-      break;
-    case CALC_NUMBER_TYPE_FLOATING:
-      mpfr_init ((*result)->floating);
-      mpfr_abs ((*result)->floating, self->floating, MPFR_RNDN);
-      break;
-    }
+  _calc_number_prepare (result);
+  calc_value_abs (&(*result)->value, &self->value);
 }
 
 /**
@@ -522,41 +598,84 @@ gint
 calc_number_sgn (CalcNumber *self)
 {
   g_return_val_if_fail (CALC_IS_NUMBER (self), -1);
-  switch (self->type)
-    {
-    case CALC_NUMBER_TYPE_INTEGER:
-      return mpz_sgn (self->integer);
-    case CALC_NUMBER_TYPE_RATIONAL:
-      return mpq_sgn (self->rational);
-    case CALC_NUMBER_TYPE_FLOATING:
-      return mpfr_sgn (self->floating);
-    default:
-      return -1;
-    }
+  return calc_value_sgn (&self->value);
 }
 
-CalcNumberType
-_calc_number_get_final_type (CalcNumberType a, CalcNumberType b)
+/**
+ * calc_number_normalize:
+ * @self: the number
+ *
+ * Reduces a rational @self to lowest terms. See calc_value_normalize().
+ **/
+
+void
+calc_number_normalize (CalcNumber *self)
 {
-  return a > b ? a : b;
+  g_return_if_fail (CALC_IS_NUMBER (self));
+  calc_value_normalize (&self->value);
 }
 
+/**
+ * calc_number_get_double:
+ * @self: the number
+ *
+ * Converts @self to the nearest hardware double. See
+ * calc_value_get_double().
+ *
+ * Returns: the value of @self as a double, or zero if @self is invalid
+ **/
+
+gdouble
+calc_number_get_double (CalcNumber *self)
+{
+  g_return_val_if_fail (CALC_IS_NUMBER (self), 0);
+  return calc_value_get_double (&self->value);
+}
+
+/**
+ * calc_number_quantize:
+ * @result: where to store the result
+ * @self: the number
+ * @scale: the number of digits after the decimal point
+ *
+ * Sets @result to the decimal with @scale digits after the decimal point
+ * nearest to @self. See calc_value_quantize().
+ **/
+
 void
-_calc_number_release (CalcNumber *self)
+calc_number_quantize (CalcNumber **result, CalcNumber *self, guint scale)
 {
-  if (self->type == -1)
-    return;
-  switch (self->type)
-    {
-    case CALC_NUMBER_TYPE_INTEGER:
-      mpz_clear (self->integer);
-      break;
-    case CALC_NUMBER_TYPE_RATIONAL:
-      mpq_clear (self->rational);
-      break;
-    case CALC_NUMBER_TYPE_FLOATING:
-      mpfr_clear (self->floating);
-      break;
-    }
-  self->type = -1;
+  g_return_if_fail (result != NULL);
+  g_return_if_fail (*result == NULL || CALC_IS_NUMBER (*result));
+  g_return_if_fail (CALC_IS_NUMBER (self));
+  _calc_number_prepare (result);
+  calc_value_quantize (&(*result)->value, &self->value, scale);
+}
+
+/**
+ * calc_number_get_prec:
+ * @self: the number
+ *
+ * Gets the precision of a floating-point number in bits. See
+ * calc_value_get_prec().
+ *
+ * Returns: the precision of @self, or zero if @self is exact
+ **/
+
+mpfr_prec_t
+calc_number_get_prec (CalcNumber *self)
+{
+  g_return_val_if_fail (CALC_IS_NUMBER (self), 0);
+  return calc_value_get_prec (&self->value);
+}
+
+/* Allocates a new number for @result to point to if it points to %NULL */
+
+void
+_calc_number_prepare (CalcNumber **result)
+{
+  if (*result == NULL)
+    *result = calc_number_new (NULL);
+  else
+    calc_expr_changed (CALC_EXPR (*result));
 }
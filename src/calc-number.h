@@ -19,31 +19,11 @@
 #ifndef _CALC_NUMBER_H
 #define _CALC_NUMBER_H
 
-#include <mpfr.h>
 #include "calc-expr.h"
+#include "calc-value.h"
 
 G_BEGIN_DECLS
 
-/**
- * CalcNumberType:
- * @CALC_NUMBER_TYPE_INTEGER: an integer
- * @CALC_NUMBER_TYPE_RATIONAL: a rational number
- * @CALC_NUMBER_TYPE_FLOATING: an arbitrary floating-point real number
- *
- * Contains the types of values used for a #CalcNumber instance.
- **/
-
-typedef enum
-{
-  /*< public >*/
-  CALC_NUMBER_TYPE_INTEGER = 1,
-  CALC_NUMBER_TYPE_RATIONAL,
-  CALC_NUMBER_TYPE_FLOATING,
-
-  /*< private >*/
-  N_CALC_NUMBER_TYPE
-} CalcNumberType;
-
 #define CALC_TYPE_NUMBER calc_number_get_type ()
 G_DECLARE_FINAL_TYPE (CalcNumber, calc_number, CALC, NUMBER, CalcExpr)
 
@@ -55,6 +35,7 @@ struct _CalcNumberClass
 
 /**
  * CalcNumber:
+ * @value: the value of the number
  *
  * Represents a real rational number.
  **/
@@ -63,10 +44,9 @@ struct _CalcNumber
 {
   /*< private >*/
   CalcExpr parent;
-  mpz_t integer;
-  mpq_t rational;
-  mpfr_t floating;
-  CalcNumberType type;
+
+  /*< public >*/
+  CalcValue value;
 };
 
 CalcNumber *calc_number_new (CalcNumber *value);
@@ -75,8 +55,12 @@ CalcNumber *calc_number_new_q (mpq_t value);
 CalcNumber *calc_number_new_f (mpf_t value);
 CalcNumber *calc_number_new_fr (mpfr_t value);
 CalcNumber *calc_number_new_d (double value);
+CalcNumber *calc_number_new_double (gdouble value);
+CalcNumber *calc_number_new_decimal (signed long coefficient, guint scale);
 CalcNumber *calc_number_new_ui (unsigned long value);
 CalcNumber *calc_number_new_si (signed long value);
+CalcNumber *calc_number_new_str (const gchar *str);
+CalcNumber *calc_number_new_const (CalcConstant constant);
 
 void calc_number_add (CalcNumber **result, CalcNumber *a, CalcNumber *b);
 void calc_number_add_z (CalcNumber **result, CalcNumber *a, mpz_t b);
@@ -86,6 +70,8 @@ void calc_number_add_fr (CalcNumber **result, CalcNumber *a, mpfr_t b);
 void calc_number_add_d (CalcNumber **result, CalcNumber *a, double b);
 void calc_number_add_ui (CalcNumber **result, CalcNumber *a, unsigned long b);
 void calc_number_add_si (CalcNumber **result, CalcNumber *a, signed long b);
+void calc_number_add_inplace (CalcNumber *self, CalcNumber *value);
+void calc_number_sum (CalcNumber **result, CalcNumber **values, gsize n);
 
 void calc_number_div (CalcNumber **result, CalcNumber *a, CalcNumber *b);
 void calc_number_div_z (CalcNumber **result, CalcNumber *a, mpz_t b);
@@ -95,6 +81,7 @@ void calc_number_div_fr (CalcNumber **result, CalcNumber *a, mpfr_t b);
 void calc_number_div_d (CalcNumber **result, CalcNumber *a, double b);
 void calc_number_div_ui (CalcNumber **result, CalcNumber *a, unsigned long b);
 void calc_number_div_si (CalcNumber **result, CalcNumber *a, signed long b);
+void calc_number_div_inplace (CalcNumber *self, CalcNumber *value);
 
 void calc_number_mul (CalcNumber **result, CalcNumber *a, CalcNumber *b);
 void calc_number_mul_z (CalcNumber **result, CalcNumber *a, mpz_t b);
@@ -104,6 +91,14 @@ void calc_number_mul_fr (CalcNumber **result, CalcNumber *a, mpfr_t b);
 void calc_number_mul_d (CalcNumber **result, CalcNumber *a, double b);
 void calc_number_mul_ui (CalcNumber **result, CalcNumber *a, unsigned long b);
 void calc_number_mul_si (CalcNumber **result, CalcNumber *a, signed long b);
+void calc_number_mul_inplace (CalcNumber *self, CalcNumber *value);
+
+void calc_number_fma (CalcNumber **result, CalcNumber *a, CalcNumber *b,
+		      CalcNumber *c);
+void calc_number_fms (CalcNumber **result, CalcNumber *a, CalcNumber *b,
+		      CalcNumber *c);
+void calc_number_dot (CalcNumber **result, CalcNumber **a, CalcNumber **b,
+		      gsize n);
 
 void calc_number_sub (CalcNumber **result, CalcNumber *a, CalcNumber *b);
 void calc_number_sub_z (CalcNumber **result, CalcNumber *a, mpz_t b);
@@ -124,10 +119,16 @@ gint calc_number_cmp_ui (CalcNumber *a, unsigned long b);
 gint calc_number_cmp_si (CalcNumber *a, signed long b);
 
 void calc_number_copy (CalcNumber *result, CalcNumber *self);
+gboolean calc_number_set_str (CalcNumber *self, const gchar *str, gssize len);
 void calc_number_cast (CalcNumber *self, CalcNumberType type);
 void calc_number_neg (CalcNumber **result, CalcNumber *self);
 void calc_number_abs (CalcNumber **result, CalcNumber *self);
 gint calc_number_sgn (CalcNumber *self);
+void calc_number_normalize (CalcNumber *self);
+mpfr_prec_t calc_number_get_prec (CalcNumber *self);
+gdouble calc_number_get_double (CalcNumber *self);
+void calc_number_quantize (CalcNumber **result, CalcNumber *self,
+			   guint scale);
 
 gint calc_number_log (CalcNumber **result, CalcNumber *self);
 gint calc_number_log2 (CalcNumber **result, CalcNumber *self);
@@ -135,12 +136,34 @@ gint calc_number_log10 (CalcNumber **result, CalcNumber *self);
 gint calc_number_logn (CalcNumber **result, CalcNumber *self,
 		       unsigned long base);
 gint calc_number_pow (CalcNumber **result, CalcNumber *a, CalcNumber *b);
+gint calc_number_exp (CalcNumber **result, CalcNumber *self);
+gint calc_number_sqrt (CalcNumber **result, CalcNumber *self);
+gint calc_number_sin (CalcNumber **result, CalcNumber *self);
+gint calc_number_cos (CalcNumber **result, CalcNumber *self);
+gint calc_number_tan (CalcNumber **result, CalcNumber *self);
+gint calc_number_asin (CalcNumber **result, CalcNumber *self);
+gint calc_number_acos (CalcNumber **result, CalcNumber *self);
+gint calc_number_atan (CalcNumber **result, CalcNumber *self);
+gint calc_number_sinh (CalcNumber **result, CalcNumber *self);
+gint calc_number_cosh (CalcNumber **result, CalcNumber *self);
+gint calc_number_tanh (CalcNumber **result, CalcNumber *self);
+gint calc_number_asinh (CalcNumber **result, CalcNumber *self);
+gint calc_number_acosh (CalcNumber **result, CalcNumber *self);
+gint calc_number_atanh (CalcNumber **result, CalcNumber *self);
+
+void calc_number_pool_set_enabled (gboolean enabled);
+gboolean calc_number_pool_get_enabled (void);
+void calc_number_pool_get_stats (guint64 *hits, guint64 *misses);
+void calc_number_pool_trim (void);
 
 #ifdef _LIBCALC_INTERNAL
 
 /*< private >*/
-CalcNumberType _calc_number_get_final_type (CalcNumberType a, CalcNumberType b);
-void _calc_number_release (CalcNumber *self);
+
+CalcNumber *_calc_number_alloc (void);
+gboolean _calc_number_recycle (CalcNumber *self);
+void _calc_number_prepare (CalcNumber **result);
+gboolean _calc_approx_set_value (CalcApprox *self, const CalcValue *value);
 
 #endif
 
@@ -0,0 +1,319 @@
+/*************************************************************************
+ * calc-program-batch.c -- This file is part of libcalc.                 *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+
+#define _LIBCALC_INTERNAL
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <math.h>
+#include <string.h>
+#include "calc-program.h"
+
+/* Points are evaluated in blocks, so that the cost of dispatching each
+   instruction is shared by many points. Within a block, every operation
+   works on vectors of CALC_PROGRAM_LANES doubles, which the compiler maps
+   to SSE or AVX registers where they are available and to plain scalar
+   code otherwise. */
+#define CALC_PROGRAM_LANES 4
+#define CALC_PROGRAM_BLOCK_VECS 16
+#define CALC_PROGRAM_BLOCK_SIZE (CALC_PROGRAM_LANES * CALC_PROGRAM_BLOCK_VECS)
+
+/* Constant integer powers up to this magnitude are computed by repeated
+   multiplication instead of calling pow() for every point */
+#define CALC_PROGRAM_BATCH_MAX_POWER 1024
+#define CALC_PROGRAM_BATCH_POW_GENERIC G_MININT
+
+/* The operand table is allocated with g_new(), so vectors are only
+   assumed to be aligned like a double */
+typedef gdouble CalcProgramVec
+  __attribute__ ((vector_size (CALC_PROGRAM_LANES * sizeof (gdouble)),
+		  aligned (sizeof (gdouble))));
+
+/* On x86-64, a version of the block loop is also built for AVX and picked
+   at load time on processors that support it. The default version uses
+   SSE2, which every x86-64 processor has. */
+#if defined (__x86_64__) && defined (__GLIBC__) && !defined (__clang__) \
+  && __GNUC__ >= 6
+#define CALC_PROGRAM_TARGET_CLONES					\
+  __attribute__ ((target_clones ("avx", "default")))
+#else
+#define CALC_PROGRAM_TARGET_CLONES
+#endif
+
+#define CALC_PROGRAM_VEC(slots, index)				\
+  ((CalcProgramVec *) ((slots) + (gsize) (index) * CALC_PROGRAM_BLOCK_SIZE))
+
+static void
+calc_program_batch_fill (gdouble *slot, gdouble value)
+{
+  guint i;
+  for (i = 0; i < CALC_PROGRAM_BLOCK_SIZE; i++)
+    slot[i] = value;
+}
+
+/* Runs @len instructions of @code on one block of points. @powers holds
+   the constant integer power of each POW instruction. */
+
+CALC_PROGRAM_TARGET_CLONES static void
+calc_program_batch_block (const CalcProgramInsn *code, guint len,
+			  const gint *powers, gdouble *slots)
+{
+  const CalcProgramVec one = { 1, 1, 1, 1 };
+  const CalcProgramVec zero = { 0, 0, 0, 0 };
+  CalcProgramVec acc[CALC_PROGRAM_BLOCK_VECS];
+  guint i;
+  guint k;
+
+  for (i = 0; i < len; i++)
+    {
+      const CalcProgramInsn *insn = code + i;
+      CalcProgramVec *dest = CALC_PROGRAM_VEC (slots, insn->dest);
+      const CalcProgramVec *a = CALC_PROGRAM_VEC (slots, insn->a);
+      const CalcProgramVec *b = CALC_PROGRAM_VEC (slots, insn->b);
+      switch (insn->op)
+	{
+	case CALC_PROGRAM_OP_ONE:
+	  for (k = 0; k < CALC_PROGRAM_BLOCK_VECS; k++)
+	    dest[k] = one;
+	  break;
+	case CALC_PROGRAM_OP_SET:
+	  for (k = 0; k < CALC_PROGRAM_BLOCK_VECS; k++)
+	    dest[k] = a[k];
+	  break;
+	case CALC_PROGRAM_OP_MUL:
+	  for (k = 0; k < CALC_PROGRAM_BLOCK_VECS; k++)
+	    dest[k] = a[k] * b[k];
+	  break;
+	case CALC_PROGRAM_OP_MUL_INPLACE:
+	  for (k = 0; k < CALC_PROGRAM_BLOCK_VECS; k++)
+	    dest[k] *= a[k];
+	  break;
+	case CALC_PROGRAM_OP_DIV:
+	  for (k = 0; k < CALC_PROGRAM_BLOCK_VECS; k++)
+	    dest[k] = a[k] / b[k];
+	  break;
+	case CALC_PROGRAM_OP_POW:
+	  if (powers[i] == CALC_PROGRAM_BATCH_POW_GENERIC)
+	    {
+	      const gdouble *x = (const gdouble *) a;
+	      const gdouble *y = (const gdouble *) b;
+	      gdouble *d = (gdouble *) dest;
+	      for (k = 0; k < CALC_PROGRAM_BLOCK_SIZE; k++)
+		d[k] = y[k] == 1 ? x[k] : pow (x[k], y[k]);
+	    }
+	  else if (powers[i] == 1)
+	    memcpy (dest, a, CALC_PROGRAM_BLOCK_SIZE * sizeof (gdouble));
+	  else
+	    {
+	      /* Binary powering */
+	      for (k = 0; k < CALC_PROGRAM_BLOCK_VECS; k++)
+		{
+		  CalcProgramVec x = a[k];
+		  CalcProgramVec r = one;
+		  guint n = ABS (powers[i]);
+		  for (; n != 0; n /= 2)
+		    {
+		      if (n % 2 != 0)
+			r *= x;
+		      if (n / 2 != 0)
+			x *= x;
+		    }
+		  dest[k] = powers[i] < 0 ? one / r : r;
+		}
+	    }
+	  break;
+	case CALC_PROGRAM_OP_ACC_INIT:
+	  for (k = 0; k < CALC_PROGRAM_BLOCK_VECS; k++)
+	    acc[k] = zero;
+	  break;
+	case CALC_PROGRAM_OP_ACC_ADD:
+	  for (k = 0; k < CALC_PROGRAM_BLOCK_VECS; k++)
+	    acc[k] += a[k];
+	  break;
+	case CALC_PROGRAM_OP_ACC_ADDMUL:
+	  for (k = 0; k < CALC_PROGRAM_BLOCK_VECS; k++)
+	    acc[k] += a[k] * b[k];
+	  break;
+	case CALC_PROGRAM_OP_ACC_FINISH:
+	  for (k = 0; k < CALC_PROGRAM_BLOCK_VECS; k++)
+	    dest[k] = acc[k];
+	  break;
+	}
+    }
+}
+
+/* Runs @self at @len points with the vector interpreter. Variables with
+   an input column in @inputs read from it, while the others take their
+   values from @uniform. */
+
+static void
+calc_program_batch_run (CalcProgram *self, const gdouble *const *inputs,
+			const gdouble *uniform, gdouble *output, gsize len)
+{
+  const CalcProgramInsn *code = (const CalcProgramInsn *) self->code->data;
+  guint vars = self->n_regs + self->consts->len;
+  gdouble *slots;
+  gint *powers;
+  gsize start;
+  gsize n;
+  guint i;
+
+  slots = g_new (gdouble,
+		 (gsize) (vars + self->vars->len) * CALC_PROGRAM_BLOCK_SIZE);
+  powers = g_new (gint, self->code->len);
+
+  /* Constants and variables without columns are the same at every point */
+  for (i = 0; i < self->consts->len; i++)
+    calc_program_batch_fill (slots + (gsize) (self->n_regs + i)
+			     * CALC_PROGRAM_BLOCK_SIZE,
+			     self->const_doubles[i]);
+  for (i = 0; i < self->vars->len; i++)
+    {
+      if (inputs[i] == NULL)
+	calc_program_batch_fill (slots + (gsize) (vars + i)
+				 * CALC_PROGRAM_BLOCK_SIZE, uniform[i]);
+    }
+  for (i = 0; i < self->code->len; i++)
+    {
+      if (code[i].op != CALC_PROGRAM_OP_POW
+	  || !_calc_program_get_power (self, code + i, powers + i))
+	powers[i] = CALC_PROGRAM_BATCH_POW_GENERIC;
+    }
+
+  for (start = 0; start < len; start += CALC_PROGRAM_BLOCK_SIZE)
+    {
+      n = MIN (len - start, CALC_PROGRAM_BLOCK_SIZE);
+      for (i = 0; i < self->vars->len; i++)
+	{
+	  gdouble *slot;
+	  if (inputs[i] == NULL)
+	    continue;
+	  slot = slots + (gsize) (vars + i) * CALC_PROGRAM_BLOCK_SIZE;
+	  memcpy (slot, inputs[i] + start, n * sizeof (gdouble));
+	  if (n < CALC_PROGRAM_BLOCK_SIZE)
+	    memset (slot + n, 0,
+		    (CALC_PROGRAM_BLOCK_SIZE - n) * sizeof (gdouble));
+	}
+      calc_program_batch_block (code, self->code->len, powers, slots);
+      memcpy (output + start,
+	      slots + (gsize) self->result * CALC_PROGRAM_BLOCK_SIZE,
+	      n * sizeof (gdouble));
+    }
+
+  g_free (slots);
+  g_free (powers);
+}
+
+/**
+ * calc_program_run_batch:
+ * @self: the program
+ * @names: (array zero-terminated=1): the names of the variables that have
+ * input columns, terminated by %NULL
+ * @columns: the input column of each variable in @names, each of which
+ * holds @len values
+ * @output: the column to store the results
+ * @len: the number of points
+ *
+ * Evaluates a program compiled by calc_expr_compile() at @len points with
+ * hardware doubles. At the point with index i, each variable in @names
+ * takes the value at index i of its column, while every other variable
+ * takes its current value. The value of the expression at that point is
+ * stored at index i of @output.
+ *
+ * Unlike calc_program_run(), the results are not exact. Every constant and
+ * every value is converted to a double, and each operation rounds its
+ * result to a double. Points are processed several at a time with the
+ * vector instructions of the processor, so this is much faster than
+ * evaluating the expression at each point separately. If native code was
+ * loaded for @self with calc_program_load_native(), it is used instead.
+ *
+ * Returns: %TRUE if the expression was evaluated, or %FALSE if a variable
+ * without a column has no value
+ **/
+
+gboolean
+calc_program_run_batch (CalcProgram *self, const gchar *const *names,
+			const gdouble *const *columns, gdouble *output,
+			gsize len)
+{
+  const CalcValue *value;
+  const gdouble **inputs;
+  gdouble *uniform;
+  guint n_vars;
+  guint i;
+  guint j;
+
+  g_return_val_if_fail (CALC_IS_PROGRAM (self), FALSE);
+  g_return_val_if_fail (names != NULL, FALSE);
+  g_return_val_if_fail (columns != NULL || names[0] == NULL, FALSE);
+  g_return_val_if_fail (output != NULL || len == 0, FALSE);
+
+  n_vars = self->vars->len;
+  inputs = g_new0 (const gdouble *, n_vars);
+  uniform = g_new (gdouble, n_vars);
+  for (i = 0; i < n_vars; i++)
+    {
+      for (j = 0; names[j] != NULL; j++)
+	{
+	  if (strcmp (names[j], self->vars->pdata[i]) == 0)
+	    {
+	      inputs[i] = columns[j];
+	      break;
+	    }
+	}
+      if (inputs[i] != NULL)
+	continue;
+      value = _calc_program_bind_variable (self, i);
+      if (value == NULL)
+	{
+	  g_free (inputs);
+	  g_free (uniform);
+	  return FALSE;
+	}
+      uniform[i] = calc_value_get_double (value);
+    }
+
+  if (self->native != NULL)
+    _calc_program_run_native (self, inputs, uniform, output, len);
+  else
+    calc_program_batch_run (self, inputs, uniform, output, len);
+  g_free (inputs);
+  g_free (uniform);
+  return TRUE;
+}
+
+/* Checks whether the POW instruction @insn of @self raises to a constant
+   integer power small enough to be computed by repeated multiplication,
+   and stores it in @power if so */
+
+gboolean
+_calc_program_get_power (CalcProgram *self, const CalcProgramInsn *insn,
+			 gint *power)
+{
+  gdouble value;
+  if (insn->b < self->n_regs || insn->b >= self->n_regs + self->consts->len)
+    return FALSE;
+  value = self->const_doubles[insn->b - self->n_regs];
+  if (!isfinite (value) || fabs (value) > CALC_PROGRAM_BATCH_MAX_POWER
+      || value != (gint) value)
+    return FALSE;
+  *power = (gint) value;
+  return TRUE;
+}
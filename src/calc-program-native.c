@@ -0,0 +1,354 @@
+/*************************************************************************
+ * calc-program-native.c -- This file is part of libcalc.                *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+
+#define _LIBCALC_INTERNAL
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <glib/gstdio.h>
+#include "calc-program.h"
+
+#if defined (G_OS_UNIX) && defined (HAVE_DLFCN_H)
+#define CALC_PROGRAM_HAVE_NATIVE
+#include <dlfcn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+/* Variables without an input column are filled into buffers of this many
+   points, and the native function is called once per block */
+#define CALC_PROGRAM_NATIVE_BLOCK_SIZE 1024
+
+/* Name of the function in generated objects */
+#define CALC_PROGRAM_NATIVE_SYMBOL "calc_native_run"
+
+#ifdef CALC_PROGRAM_HAVE_NATIVE
+
+static void
+calc_program_native_operand (CalcProgram *self, GString *str, guint operand)
+{
+  guint vars = self->n_regs + self->consts->len;
+  if (operand < self->n_regs)
+    g_string_append_printf (str, "r%u", operand);
+  else if (operand < vars)
+    g_string_append_printf (str, "k%u", operand - self->n_regs);
+  else
+    g_string_append_printf (str, "x%u", operand - vars);
+}
+
+/* Appends the statement of a single instruction to @str. Each operation is
+   done with doubles in the same order as calc_program_run_batch() does, so
+   both produce the same results. */
+
+static void
+calc_program_native_insn (CalcProgram *self, GString *str,
+			  const CalcProgramInsn *insn)
+{
+  gint power;
+
+  g_string_append (str, "      ");
+  if (insn->op != CALC_PROGRAM_OP_ACC_INIT
+      && insn->op != CALC_PROGRAM_OP_ACC_ADD
+      && insn->op != CALC_PROGRAM_OP_ACC_ADDMUL)
+    {
+      calc_program_native_operand (self, str, insn->dest);
+      g_string_append (str, insn->op == CALC_PROGRAM_OP_MUL_INPLACE
+		       ? " *= " : " = ");
+    }
+
+  switch (insn->op)
+    {
+    case CALC_PROGRAM_OP_ONE:
+      g_string_append (str, "1");
+      break;
+    case CALC_PROGRAM_OP_MUL:
+    case CALC_PROGRAM_OP_DIV:
+      calc_program_native_operand (self, str, insn->a);
+      g_string_append (str, insn->op == CALC_PROGRAM_OP_MUL ? " * " : " / ");
+      calc_program_native_operand (self, str, insn->b);
+      break;
+    case CALC_PROGRAM_OP_SET:
+    case CALC_PROGRAM_OP_MUL_INPLACE:
+      calc_program_native_operand (self, str, insn->a);
+      break;
+    case CALC_PROGRAM_OP_POW:
+      if (!_calc_program_get_power (self, insn, &power))
+	{
+	  g_string_append (str, "calc_native_pow (");
+	  calc_program_native_operand (self, str, insn->a);
+	  g_string_append (str, ", ");
+	  calc_program_native_operand (self, str, insn->b);
+	  g_string_append (str, ")");
+	}
+      else if (power == 1)
+	calc_program_native_operand (self, str, insn->a);
+      else
+	{
+	  g_string_append (str, "calc_native_powi (");
+	  calc_program_native_operand (self, str, insn->a);
+	  g_string_append_printf (str, ", %d)", power);
+	}
+      break;
+    case CALC_PROGRAM_OP_ACC_INIT:
+      g_string_append (str, "acc = 0");
+      break;
+    case CALC_PROGRAM_OP_ACC_ADD:
+      g_string_append (str, "acc += ");
+      calc_program_native_operand (self, str, insn->a);
+      break;
+    case CALC_PROGRAM_OP_ACC_ADDMUL:
+      g_string_append (str, "acc += ");
+      calc_program_native_operand (self, str, insn->a);
+      g_string_append (str, " * ");
+      calc_program_native_operand (self, str, insn->b);
+      break;
+    case CALC_PROGRAM_OP_ACC_FINISH:
+      g_string_append (str, "acc");
+      break;
+    }
+  g_string_append (str, ";\n");
+}
+
+/* Generates the C source of a function evaluating @self at every point of
+   its input columns. Constants are passed to the function rather than
+   written into the source, so the source only depends on the structure of
+   the expression and on its constant integer powers. */
+
+static gchar *
+calc_program_native_source (CalcProgram *self)
+{
+  GString *str = g_string_new ("/* Generated by libcalc */\n\n");
+  guint i;
+
+  g_string_append (str, "#include <math.h>\n#include <stddef.h>\n\n"
+		   "static inline double\n"
+		   "calc_native_powi (double x, int n)\n{\n"
+		   "  double r = 1;\n"
+		   "  unsigned int m = n < 0 ? -n : n;\n"
+		   "  for (; m != 0; m /= 2)\n    {\n"
+		   "      if (m % 2 != 0)\n\tr *= x;\n"
+		   "      if (m / 2 != 0)\n\tx *= x;\n    }\n"
+		   "  return n < 0 ? 1 / r : r;\n}\n\n"
+		   "static inline double\n"
+		   "calc_native_pow (double x, double y)\n{\n"
+		   "  return y == 1 ? x : pow (x, y);\n}\n\n");
+  g_string_append (str, "void\n" CALC_PROGRAM_NATIVE_SYMBOL
+		   " (const double *const *columns, const double *consts,\n"
+		   "  double *output, size_t len)\n{\n");
+  for (i = 0; i < self->consts->len; i++)
+    g_string_append_printf (str, "  const double k%u = consts[%u];\n", i, i);
+  for (i = 0; i < self->vars->len; i++)
+    g_string_append_printf (str, "  const double *v%u = columns[%u];\n", i,
+			    i);
+  g_string_append (str, "  size_t i;\n\n  for (i = 0; i < len; i++)\n"
+		   "    {\n      double acc;\n");
+  for (i = 0; i < self->n_regs; i++)
+    g_string_append_printf (str, "      double r%u;\n", i);
+  for (i = 0; i < self->vars->len; i++)
+    g_string_append_printf (str, "      const double x%u = v%u[i];\n", i, i);
+  for (i = 0; i < self->code->len; i++)
+    calc_program_native_insn (self, str,
+			      &g_array_index (self->code, CalcProgramInsn,
+					      i));
+  g_string_append (str, "      output[i] = ");
+  calc_program_native_operand (self, str, self->result);
+  g_string_append (str, ";\n    }\n}\n");
+  return g_string_free (str, FALSE);
+}
+
+/* Serial number of the temporary files written by this process */
+static gint calc_program_native_serial;
+
+/* Compiles @source into a shared object at @object_path. The object is
+   written under a name unique to this process and call and renamed into
+   place, so other threads and processes sharing the cache never see a
+   partial object. */
+
+static gboolean
+calc_program_native_build (const gchar *source, const gchar *object_path)
+{
+  const gchar *cc = g_getenv ("CC");
+  gchar *base =
+    g_strdup_printf ("%s.%d.%d", object_path, (gint) getpid (),
+		     g_atomic_int_add (&calc_program_native_serial, 1));
+  gchar *tmp_source = g_strconcat (base, ".c", NULL);
+  gchar *tmp_object = g_strconcat (base, ".so", NULL);
+  gchar *argv[] = {
+    (gchar *) (cc != NULL && *cc != '\0' ? cc : "cc"),
+    "-O3", "-ffp-contract=off", "-fPIC", "-shared", "-o", tmp_object,
+    tmp_source, "-lm", NULL
+  };
+  gboolean ret;
+  gint status;
+
+  ret = g_file_set_contents (tmp_source, source, -1, NULL)
+    && g_spawn_sync (NULL, argv, NULL,
+		     G_SPAWN_SEARCH_PATH | G_SPAWN_STDOUT_TO_DEV_NULL
+		     | G_SPAWN_STDERR_TO_DEV_NULL, NULL, NULL, NULL, NULL,
+		     &status, NULL)
+    && WIFEXITED (status) && WEXITSTATUS (status) == 0
+    && g_rename (tmp_object, object_path) == 0;
+  g_unlink (tmp_source);
+  g_unlink (tmp_object);
+  g_free (base);
+  g_free (tmp_source);
+  g_free (tmp_object);
+  return ret;
+}
+
+static gboolean
+calc_program_native_open (CalcProgram *self, const gchar *object_path)
+{
+  gpointer module = dlopen (object_path, RTLD_NOW | RTLD_LOCAL);
+  gpointer symbol;
+  if (module == NULL)
+    return FALSE;
+  symbol = dlsym (module, CALC_PROGRAM_NATIVE_SYMBOL);
+  if (symbol == NULL)
+    {
+      dlclose (module);
+      return FALSE;
+    }
+  self->native_module = module;
+  *(gpointer *) &self->native = symbol;
+  return TRUE;
+}
+
+#endif
+
+/**
+ * calc_program_load_native:
+ * @self: the program
+ *
+ * Generates C source code evaluating @self with hardware doubles, compiles
+ * it into a shared object with the system C compiler and loads it. After
+ * this, calc_program_run_batch() calls the native code instead of
+ * interpreting the program, which is faster for long-running jobs that
+ * evaluate the same expression many times. The results are the same as
+ * those of the interpreter.
+ *
+ * Compiled objects are cached in the libcalc directory under the user's
+ * cache directory, named after a digest of the generated source, so
+ * loading the same expression again does not run the compiler. The
+ * compiler is taken from the CC environment variable, or is cc by default.
+ *
+ * Returns: %TRUE if native code was loaded, or %FALSE if no compiler is
+ * available or native code is not supported on this platform, in which
+ * case calc_program_run_batch() keeps interpreting @self
+ **/
+
+gboolean
+calc_program_load_native (CalcProgram *self)
+{
+#ifdef CALC_PROGRAM_HAVE_NATIVE
+  gchar *source;
+  gchar *digest;
+  gchar *dir;
+  gchar *name;
+  gchar *object_path;
+  gboolean ret;
+
+  g_return_val_if_fail (CALC_IS_PROGRAM (self), FALSE);
+  if (self->native != NULL)
+    return TRUE;
+
+  dir = g_build_filename (g_get_user_cache_dir (), "libcalc", NULL);
+  if (g_mkdir_with_parents (dir, 0700) != 0)
+    {
+      g_free (dir);
+      return FALSE;
+    }
+
+  /* Objects are named after their full source, so an object at a given
+     path is always the same code, even if it was already loaded */
+  source = calc_program_native_source (self);
+  digest = g_compute_checksum_for_string (G_CHECKSUM_SHA256, source, -1);
+  name = g_strconcat ("expr-", digest, ".so", NULL);
+  object_path = g_build_filename (dir, name, NULL);
+  ret = calc_program_native_open (self, object_path)
+    || (calc_program_native_build (source, object_path)
+	&& calc_program_native_open (self, object_path));
+
+  g_free (dir);
+  g_free (digest);
+  g_free (name);
+  g_free (object_path);
+  g_free (source);
+  return ret;
+#else
+  g_return_val_if_fail (CALC_IS_PROGRAM (self), FALSE);
+  return FALSE;
+#endif
+}
+
+/* Runs the native code of @self at @len points. Arguments are the same as
+   those of the vector interpreter. */
+
+void
+_calc_program_run_native (CalcProgram *self, const gdouble *const *inputs,
+			  const gdouble *uniform, gdouble *output, gsize len)
+{
+  const gdouble **columns = g_new (const gdouble *, self->vars->len);
+  gdouble *fill = NULL;
+  gsize block = len;
+  gsize start;
+  guint i;
+
+  /* Variables without columns need a buffer of the block size, so the
+     points are only split into blocks if there are any */
+  for (i = 0; i < self->vars->len; i++)
+    {
+      if (inputs[i] != NULL)
+	continue;
+      if (fill == NULL)
+	{
+	  fill = g_new (gdouble, (gsize) self->vars->len
+			* CALC_PROGRAM_NATIVE_BLOCK_SIZE);
+	  block = CALC_PROGRAM_NATIVE_BLOCK_SIZE;
+	}
+      columns[i] = fill + (gsize) i * CALC_PROGRAM_NATIVE_BLOCK_SIZE;
+      for (start = 0; start < CALC_PROGRAM_NATIVE_BLOCK_SIZE; start++)
+	fill[(gsize) i * CALC_PROGRAM_NATIVE_BLOCK_SIZE + start] = uniform[i];
+    }
+
+  for (start = 0; start < len; start += block)
+    {
+      for (i = 0; i < self->vars->len; i++)
+	{
+	  if (inputs[i] != NULL)
+	    columns[i] = inputs[i] + start;
+	}
+      self->native (columns, self->const_doubles, output + start,
+		    MIN (block, len - start));
+    }
+  g_free (columns);
+  g_free (fill);
+}
+
+void
+_calc_program_unload_native (CalcProgram *self)
+{
+#ifdef CALC_PROGRAM_HAVE_NATIVE
+  if (self->native_module != NULL)
+    dlclose (self->native_module);
+#endif
+  self->native_module = NULL;
+  self->native = NULL;
+}
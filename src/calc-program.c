@@ -0,0 +1,452 @@
+/*************************************************************************
+ * calc-program.c -- This file is part of libcalc.                       *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+
+#define _LIBCALC_INTERNAL
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "calc-program.h"
+#include "calc-variable.h"
+
+/* While compiling, constants and variables are numbered separately from
+   registers and marked with these flags. Once the number of registers is
+   known, every operand is replaced by its index in the operand table,
+   which lists the registers, then the constants, then the variables.
+   Registers holding shared subexpressions are placed after the others. */
+#define CALC_PROGRAM_SHARED_FLAG (1 << 28)
+#define CALC_PROGRAM_CONST_FLAG (1 << 29)
+#define CALC_PROGRAM_VAR_FLAG (1 << 30)
+#define CALC_PROGRAM_INDEX_MASK (CALC_PROGRAM_SHARED_FLAG - 1)
+
+G_DEFINE_TYPE (CalcProgram, calc_program, G_TYPE_OBJECT)
+
+static void
+calc_program_finalize (GObject *obj)
+{
+  CalcProgram *self = CALC_PROGRAM (obj);
+  guint i;
+
+  for (i = 0; i < self->consts->len; i++)
+    calc_value_clear (&g_array_index (self->consts, CalcValue, i));
+  if (self->var_values != NULL)
+    {
+      for (i = 0; i < self->vars->len; i++)
+	{
+	  if (self->var_values[i] != NULL)
+	    g_object_unref (self->var_values[i]);
+	}
+      g_free (self->var_values);
+    }
+  if (self->regs != NULL)
+    {
+      for (i = 0; i < self->n_regs; i++)
+	calc_value_clear (&self->regs[i]);
+      g_free (self->regs);
+    }
+  if (self->var_index != NULL)
+    g_hash_table_destroy (self->var_index);
+  _calc_program_unload_native (self);
+  g_free (self->operands);
+  g_free (self->const_doubles);
+  g_array_free (self->code, TRUE);
+  g_array_free (self->consts, TRUE);
+  g_ptr_array_free (self->vars, TRUE);
+  G_OBJECT_CLASS (calc_program_parent_class)->finalize (obj);
+}
+
+static void
+calc_program_class_init (CalcProgramClass *klass)
+{
+  G_OBJECT_CLASS (klass)->finalize = calc_program_finalize;
+}
+
+static void
+calc_program_init (CalcProgram *self)
+{
+  self->code = g_array_new (FALSE, FALSE, sizeof (CalcProgramInsn));
+  self->consts = g_array_new (FALSE, FALSE, sizeof (CalcValue));
+  self->vars = g_ptr_array_new_with_free_func (g_free);
+}
+
+static guint32
+calc_program_resolve (CalcProgram *self, guint32 operand)
+{
+  if (operand & CALC_PROGRAM_SHARED_FLAG)
+    return self->n_regs - self->n_shared
+      + (operand & CALC_PROGRAM_INDEX_MASK);
+  if (operand & CALC_PROGRAM_CONST_FLAG)
+    return self->n_regs + (operand & CALC_PROGRAM_INDEX_MASK);
+  if (operand & CALC_PROGRAM_VAR_FLAG)
+    return self->n_regs + self->consts->len
+      + (operand & CALC_PROGRAM_INDEX_MASK);
+  return operand;
+}
+
+/* Allocates the registers and builds the operand table once compilation
+   has finished. The constant pool does not grow after this, so pointers
+   into it remain valid. */
+
+static void
+calc_program_link (CalcProgram *self, gint result)
+{
+  CalcProgramInsn *insn;
+  guint i;
+
+  self->n_regs += self->n_shared;
+  self->regs = g_new (CalcValue, self->n_regs);
+  for (i = 0; i < self->n_regs; i++)
+    calc_value_init (&self->regs[i]);
+  self->operands =
+    g_new0 (const CalcValue *,
+	    self->n_regs + self->consts->len + self->vars->len);
+  for (i = 0; i < self->n_regs; i++)
+    self->operands[i] = &self->regs[i];
+  for (i = 0; i < self->consts->len; i++)
+    self->operands[self->n_regs + i] =
+      &g_array_index (self->consts, CalcValue, i);
+  self->var_values = g_new0 (CalcNumber *, self->vars->len);
+
+  /* Constants are converted for calc_program_run_batch() only once */
+  self->const_doubles = g_new (gdouble, self->consts->len);
+  for (i = 0; i < self->consts->len; i++)
+    self->const_doubles[i] =
+      calc_value_get_double (&g_array_index (self->consts, CalcValue, i));
+
+  for (i = 0; i < self->code->len; i++)
+    {
+      insn = &g_array_index (self->code, CalcProgramInsn, i);
+      insn->dest = calc_program_resolve (self, insn->dest);
+      insn->a = calc_program_resolve (self, insn->a);
+      insn->b = calc_program_resolve (self, insn->b);
+    }
+  self->result = calc_program_resolve (self, result);
+}
+
+/**
+ * calc_expr_compile:
+ * @self: the expression
+ *
+ * Compiles @self into a #CalcProgram that can be run repeatedly with
+ * calc_program_run() to evaluate @self without walking the expression
+ * tree. The program refers to variables by name, so it picks up their
+ * current values every time it is run. Later changes to @self itself are
+ * not reflected in the program.
+ *
+ * Returns: the compiled program, or %NULL if @self contains an expression
+ * that cannot be compiled
+ **/
+
+CalcProgram *
+calc_expr_compile (CalcExpr *self)
+{
+  CalcProgram *program;
+  gint result;
+
+  g_return_val_if_fail (CALC_IS_EXPR (self), NULL);
+  program = g_object_new (CALC_TYPE_PROGRAM, NULL);
+  program->var_index = g_hash_table_new (g_str_hash, g_str_equal);
+  program->shared = g_hash_table_new (NULL, NULL);
+  result = _calc_program_compile_expr (program, self);
+  g_hash_table_destroy (program->var_index);
+  g_hash_table_destroy (program->shared);
+  program->var_index = NULL;
+  program->shared = NULL;
+  if (result < 0)
+    {
+      g_object_unref (program);
+      return NULL;
+    }
+  calc_program_link (program, result);
+  return program;
+}
+
+/* Gets the current value of the variable with index @index in @self.
+   Values that are numbers are read in place, while other expressions are
+   evaluated into a number owned by the program. Returns %NULL if the
+   variable has no value or its value cannot be evaluated. */
+
+const CalcValue *
+_calc_program_bind_variable (CalcProgram *self, guint index)
+{
+  CalcExpr *value = calc_variable_get_value (self->vars->pdata[index]);
+  if (value == NULL)
+    return NULL;
+  if (CALC_IS_NUMBER (value))
+    return &CALC_NUMBER (value)->value;
+  if (self->var_values[index] == NULL)
+    self->var_values[index] = calc_number_new (NULL);
+  if (!calc_expr_evaluate (value, CALC_EXPR (self->var_values[index])))
+    return NULL;
+  return &self->var_values[index]->value;
+}
+
+static gboolean
+calc_program_bind (CalcProgram *self)
+{
+  const CalcValue **operands;
+  guint i;
+
+  operands = self->operands + self->n_regs + self->consts->len;
+  for (i = 0; i < self->vars->len; i++)
+    {
+      operands[i] = _calc_program_bind_variable (self, i);
+      if (operands[i] == NULL)
+	return FALSE;
+    }
+  return TRUE;
+}
+
+/**
+ * calc_program_run:
+ * @self: the program
+ * @result: the number to store the result
+ *
+ * Runs a program compiled by calc_expr_compile() and stores the value of
+ * the compiled expression in @result. The result is identical to the one
+ * computed by calc_expr_evaluate() on the same expression.
+ *
+ * Returns: %TRUE if the expression was evaluated, or %FALSE if a variable
+ * has no value or its value could not be evaluated
+ **/
+
+gboolean
+calc_program_run (CalcProgram *self, CalcExpr *result)
+{
+  const CalcValue **operands;
+  const CalcProgramInsn *insn;
+  const CalcProgramInsn *end;
+  CalcValueAcc acc;
+  CalcValue *dest;
+  CalcValue temp;
+
+  g_return_val_if_fail (CALC_IS_PROGRAM (self), FALSE);
+  g_return_val_if_fail (CALC_IS_NUMBER (result), FALSE);
+  if (!calc_program_bind (self))
+    return FALSE;
+
+  operands = self->operands;
+  insn = (const CalcProgramInsn *) self->code->data;
+  end = insn + self->code->len;
+  for (; insn < end; insn++)
+    {
+      dest = &self->regs[insn->dest];
+      switch (insn->op)
+	{
+	case CALC_PROGRAM_OP_ONE:
+	  calc_value_clear (dest);
+	  calc_value_init_ui (dest, 1);
+	  break;
+	case CALC_PROGRAM_OP_SET:
+	  calc_value_set (dest, operands[insn->a]);
+	  break;
+	case CALC_PROGRAM_OP_MUL:
+	  calc_value_mul (dest, operands[insn->a], operands[insn->b]);
+	  break;
+	case CALC_PROGRAM_OP_MUL_INPLACE:
+	  calc_value_mul_inplace (dest, operands[insn->a]);
+	  break;
+	case CALC_PROGRAM_OP_DIV:
+	  calc_value_div (dest, operands[insn->a], operands[insn->b]);
+	  break;
+	case CALC_PROGRAM_OP_POW:
+	  /* Factors of terms have a power of one, so skip the
+	     exponentiation */
+	  if (operands[insn->b]->type == CALC_NUMBER_TYPE_INTEGER
+	      && calc_value_cmp_ui (operands[insn->b], 1) == 0)
+	    calc_value_set (dest, operands[insn->a]);
+	  else
+	    calc_value_pow (dest, operands[insn->a], operands[insn->b]);
+	  break;
+	case CALC_PROGRAM_OP_ACC_INIT:
+	  _calc_value_acc_init (&acc);
+	  break;
+	case CALC_PROGRAM_OP_ACC_ADD:
+	  _calc_value_acc_add (&acc, operands[insn->a]);
+	  break;
+	case CALC_PROGRAM_OP_ACC_ADDMUL:
+	  _calc_value_acc_addmul (&acc, operands[insn->a], operands[insn->b]);
+	  break;
+	case CALC_PROGRAM_OP_ACC_FINISH:
+	  _calc_value_acc_finish (&acc, dest);
+	  break;
+	}
+    }
+
+  calc_expr_changed (result);
+  if (self->result < self->n_regs)
+    {
+      /* Hand the result register over instead of copying it. The old
+	 value of @result is overwritten by the next run. */
+      dest = &self->regs[self->result];
+      temp = CALC_NUMBER (result)->value;
+      CALC_NUMBER (result)->value = *dest;
+      *dest = temp;
+    }
+  else
+    calc_value_set (&CALC_NUMBER (result)->value, operands[self->result]);
+  return TRUE;
+}
+
+/* Keeps the value of the interned expression @expr, held in @operand, in
+   a register of its own so that later occurrences of @expr reuse it
+   instead of being compiled again. The registers used while computing
+   @expr, starting from @top, are released. */
+
+static gint
+calc_program_share (CalcProgram *self, CalcExpr *expr, gint operand,
+		    guint top)
+{
+  gint shared = operand;
+  if (!(operand & (CALC_PROGRAM_SHARED_FLAG | CALC_PROGRAM_CONST_FLAG
+		   | CALC_PROGRAM_VAR_FLAG)))
+    {
+      shared = CALC_PROGRAM_SHARED_FLAG | self->n_shared++;
+      _calc_program_emit (self, CALC_PROGRAM_OP_SET, shared, operand, -1);
+      self->top = top;
+    }
+  g_hash_table_insert (self->shared, expr, GINT_TO_POINTER (shared));
+  return shared;
+}
+
+/* Compiles @expr into @self and returns the operand holding its value, or
+   -1 if @expr cannot be compiled. A subexpression without variables whose
+   value is exact is evaluated once here and replaced by a constant, since
+   exact results do not depend on the precision or rounding mode in effect
+   when the program is run.
+   Interned subexpressions that depend on variables are compiled only
+   once. */
+
+gint
+_calc_program_compile_expr (CalcProgram *self, CalcExpr *expr)
+{
+  CalcExprClass *klass = CALC_EXPR_GET_CLASS (expr);
+  guint n_insns = self->code->len;
+  guint n_consts = self->consts->len;
+  guint n_var_refs = self->n_var_refs;
+  guint top = self->top;
+  CalcNumber *value;
+  gpointer shared;
+  gint result;
+  guint i;
+
+  if (klass->compile == NULL)
+    return -1;
+  if (g_hash_table_lookup_extended (self->shared, expr, NULL, &shared))
+    {
+      self->n_var_refs++;
+      return GPOINTER_TO_INT (shared);
+    }
+  result = klass->compile (expr, self);
+  if (result < 0 || self->code->len == n_insns)
+    return result;
+  if (self->n_var_refs != n_var_refs)
+    {
+      if (calc_expr_is_interned (expr))
+	result = calc_program_share (self, expr, result, top);
+      return result;
+    }
+
+  value = calc_number_new (NULL);
+  if (calc_expr_evaluate (expr, CALC_EXPR (value))
+      && (value->value.type == CALC_NUMBER_TYPE_INTEGER
+	  || value->value.type == CALC_NUMBER_TYPE_RATIONAL))
+    {
+      g_array_set_size (self->code, n_insns);
+      for (i = n_consts; i < self->consts->len; i++)
+	calc_value_clear (&g_array_index (self->consts, CalcValue, i));
+      g_array_set_size (self->consts, n_consts);
+      self->top = top;
+      result = _calc_program_add_const (self, &value->value);
+    }
+  g_object_unref (value);
+  return result;
+}
+
+/* Appends an instruction to @self. Unused operands may be passed as -1. */
+
+void
+_calc_program_emit (CalcProgram *self, CalcProgramOp op, gint dest, gint a,
+		    gint b)
+{
+  CalcProgramInsn insn;
+  insn.op = op;
+  insn.dest = MAX (dest, 0);
+  insn.a = MAX (a, 0);
+  insn.b = MAX (b, 0);
+  g_array_append_val (self->code, insn);
+}
+
+/* Copies @value into the constant pool of @self and returns its operand */
+
+gint
+_calc_program_add_const (CalcProgram *self, const CalcValue *value)
+{
+  guint index = self->consts->len;
+  g_array_set_size (self->consts, index + 1);
+  calc_value_init_set (&g_array_index (self->consts, CalcValue, index),
+		       value);
+  return CALC_PROGRAM_CONST_FLAG | index;
+}
+
+/* Returns the operand holding the value of the variable @name. Each
+   variable is only looked up once per run, however many times it
+   appears. */
+
+gint
+_calc_program_add_variable (CalcProgram *self, const gchar *name)
+{
+  gpointer index;
+  gchar *key;
+
+  self->n_var_refs++;
+  if (!g_hash_table_lookup_extended (self->var_index, name, NULL, &index))
+    {
+      key = g_strdup (name);
+      index = GUINT_TO_POINTER (self->vars->len);
+      g_ptr_array_add (self->vars, key);
+      g_hash_table_insert (self->var_index, key, index);
+    }
+  return CALC_PROGRAM_VAR_FLAG | GPOINTER_TO_UINT (index);
+}
+
+/* Registers are allocated as a stack. Nodes allocate the register of their
+   result before compiling their operands and release the registers of the
+   operands afterwards with _calc_program_release(), so a result never
+   shares a register with its operands. */
+
+gint
+_calc_program_alloc (CalcProgram *self)
+{
+  gint reg = self->top++;
+  self->n_regs = MAX (self->n_regs, self->top);
+  return reg;
+}
+
+guint
+_calc_program_mark (CalcProgram *self)
+{
+  return self->top;
+}
+
+void
+_calc_program_release (CalcProgram *self, guint mark)
+{
+  self->top = mark;
+}
@@ -0,0 +1,131 @@
+/*************************************************************************
+ * calc-program.h -- This file is part of libcalc.                       *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+
+#ifndef _CALC_PROGRAM_H
+#define _CALC_PROGRAM_H
+
+#include "calc-number.h"
+
+G_BEGIN_DECLS
+
+#define CALC_TYPE_PROGRAM calc_program_get_type ()
+G_DECLARE_FINAL_TYPE (CalcProgram, calc_program, CALC, PROGRAM, GObject)
+
+struct _CalcProgramClass
+{
+  /*< private >*/
+  GObjectClass parent;
+};
+
+/**
+ * CalcProgram:
+ *
+ * An expression compiled by calc_expr_compile() into a flat list of
+ * instructions. Each instruction applies one calc_value_*() operation to
+ * operands stored in a table of registers, constants copied from the
+ * expression and the values of its variables. Running a program performs
+ * exactly the same operations as calc_expr_evaluate() on the original
+ * expression, so both produce the same results, but the tree is not
+ * traversed again and no temporary numbers are allocated after the first
+ * run. A program can also be evaluated at many points at once with hardware
+ * doubles by calc_program_run_batch().
+ **/
+
+/* Instruction opcodes. Operands not used by an instruction are zero. */
+typedef enum
+{
+  CALC_PROGRAM_OP_ONE,		/* dest = 1 */
+  CALC_PROGRAM_OP_SET,		/* dest = a */
+  CALC_PROGRAM_OP_MUL,		/* dest = a * b */
+  CALC_PROGRAM_OP_MUL_INPLACE,	/* dest *= a */
+  CALC_PROGRAM_OP_DIV,		/* dest = a / b */
+  CALC_PROGRAM_OP_POW,		/* dest = a ^ b */
+  CALC_PROGRAM_OP_ACC_INIT,	/* Start a sum */
+  CALC_PROGRAM_OP_ACC_ADD,	/* Add a to the sum */
+  CALC_PROGRAM_OP_ACC_ADDMUL,	/* Add a * b to the sum */
+  CALC_PROGRAM_OP_ACC_FINISH	/* dest = the sum */
+} CalcProgramOp;
+
+/* A single instruction. @dest is always a register, while @a and @b are
+   indices into the operand table of the program. */
+typedef struct
+{
+  guint32 op;
+  guint32 dest;
+  guint32 a;
+  guint32 b;
+} CalcProgramInsn;
+
+struct _CalcProgram
+{
+  /*< private >*/
+  GObject parent;
+  GArray *code;
+  GArray *consts;
+  GPtrArray *vars;
+  CalcNumber **var_values;
+  CalcValue *regs;
+  guint n_regs;
+  const CalcValue **operands;
+  gdouble *const_doubles;
+  guint result;
+  gpointer native_module;
+  void (*native) (const gdouble *const *columns, const gdouble *consts,
+		  gdouble *output, gsize len);
+  guint top;
+  guint n_var_refs;
+  guint n_shared;
+  GHashTable *var_index;
+  GHashTable *shared;
+};
+
+CalcProgram *calc_expr_compile (CalcExpr *self);
+gboolean calc_program_run (CalcProgram *self, CalcExpr *result);
+gboolean calc_program_run_batch (CalcProgram *self,
+				 const gchar *const *names,
+				 const gdouble *const *columns,
+				 gdouble *output, gsize len);
+gboolean calc_program_load_native (CalcProgram *self);
+
+#ifdef _LIBCALC_INTERNAL
+
+/*< private >*/
+
+gint _calc_program_compile_expr (CalcProgram *self, CalcExpr *expr);
+void _calc_program_emit (CalcProgram *self, CalcProgramOp op, gint dest,
+			 gint a, gint b);
+gint _calc_program_add_const (CalcProgram *self, const CalcValue *value);
+gint _calc_program_add_variable (CalcProgram *self, const gchar *name);
+gint _calc_program_alloc (CalcProgram *self);
+guint _calc_program_mark (CalcProgram *self);
+void _calc_program_release (CalcProgram *self, guint mark);
+const CalcValue *_calc_program_bind_variable (CalcProgram *self,
+					      guint index);
+gboolean _calc_program_get_power (CalcProgram *self,
+				  const CalcProgramInsn *insn, gint *power);
+void _calc_program_run_native (CalcProgram *self,
+			       const gdouble *const *inputs,
+			       const gdouble *uniform, gdouble *output,
+			       gsize len);
+void _calc_program_unload_native (CalcProgram *self);
+
+#endif
+
+G_END_DECLS
+
+#endif
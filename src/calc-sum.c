@@ -22,22 +22,32 @@
 #include <config.h>
 #endif
 
+#include <math.h>
 #include "calc-sum.h"
 #include "calc-term.h"
+#include "calc-program.h"
+
+#define CALC_SUM_HASH_SEED G_GUINT64_CONSTANT (0x510e527fade682d1)
 
 G_DEFINE_TYPE (CalcSum, calc_sum, CALC_TYPE_EXPR)
 
-static void calc_sum_print (CalcExpr *expr, FILE *stream);
+static void calc_sum_print_string (CalcExpr *expr, GString *str,
+				   const CalcPrintFormat *format);
 static gboolean calc_sum_equivalent (CalcExpr *self, CalcExpr *other);
 static gboolean calc_sum_like_terms (CalcExpr *self, CalcExpr *other);
-static gulong calc_sum_hash (CalcExpr *expr);
+static guint64 calc_sum_hash (CalcExpr *expr);
 static gboolean calc_sum_evaluate (CalcExpr *expr, CalcExpr *result);
+static gboolean calc_sum_evaluate_approx (CalcExpr *expr,
+					  CalcApprox *result, gdouble tolerance);
+static gint calc_sum_compile (CalcExpr *expr, CalcProgram *program);
+static void calc_sum_intern (CalcExpr *expr);
 
 static void
 calc_sum_dispose (GObject *obj)
 {
   CalcSum *self = CALC_SUM (obj);
   g_ptr_array_unref (self->terms);
+  G_OBJECT_CLASS (calc_sum_parent_class)->dispose (obj);
 }
 
 static void
@@ -55,11 +65,14 @@ calc_sum_class_init (CalcSumClass *klass)
 {
   CalcExprClass *exprclass = CALC_EXPR_CLASS (klass);
   G_OBJECT_CLASS (klass)->dispose = calc_sum_dispose;
-  exprclass->print = calc_sum_print;
+  exprclass->print_string = calc_sum_print_string;
   exprclass->equivalent = calc_sum_equivalent;
   exprclass->like_terms = calc_sum_like_terms;
   exprclass->hash = calc_sum_hash;
   exprclass->evaluate = calc_sum_evaluate;
+  exprclass->evaluate_approx = calc_sum_evaluate_approx;
+  exprclass->compile = calc_sum_compile;
+  exprclass->intern = calc_sum_intern;
 }
 
 static void
@@ -71,14 +84,17 @@ calc_sum_init (CalcSum *self)
 static void
 calc_sum_term_hash (gpointer data, gpointer user_data)
 {
-  *((gulong *) user_data) += calc_expr_hash (CALC_EXPR (data));
+  /* Terms are unordered, so their mixed hashes are combined with an
+     addition rather than a chained combine */
+  *((guint64 *) user_data) +=
+    _calc_hash_mix (calc_expr_hash (CALC_EXPR (data)));
 }
 
 static gint
 calc_sum_term_compare (gconstpointer a, gconstpointer b)
 {
-  gulong ha = calc_expr_hash (*((CalcExpr **) a));
-  gulong hb = calc_expr_hash (*((CalcExpr **) b));
+  guint64 ha = calc_expr_hash (*((CalcExpr **) a));
+  guint64 hb = calc_expr_hash (*((CalcExpr **) b));
   if (ha > hb)
     return 1;
   if (ha < hb)
@@ -87,7 +103,8 @@ calc_sum_term_compare (gconstpointer a, gconstpointer b)
 }
 
 static void
-calc_sum_print (CalcExpr *expr, FILE *stream)
+calc_sum_print_string (CalcExpr *expr, GString *str,
+		       const CalcPrintFormat *format)
 {
   CalcSum *self = CALC_SUM (expr);
   guint i;
@@ -98,32 +115,18 @@ calc_sum_print (CalcExpr *expr, FILE *stream)
 	CALC_IS_NUMBER (ex) && calc_number_sgn (CALC_NUMBER (ex)) < 0;
       gboolean neg_term =
 	CALC_IS_TERM (ex) && calc_number_sgn (CALC_TERM (ex)->coefficient) < 0;
+      gsize start;
       if (i > 0)
-	{
-	  if (neg_num || neg_term)
-	    fputc ('-', stream);
-	  else
-	    fputc ('+', stream);
-	}
-      fputc ('(', stream);
-      if (neg_num)
-	{
-	  CalcNumber *temp = NULL;
-	  calc_number_abs (&temp, CALC_NUMBER (ex));
-	  calc_expr_print (CALC_EXPR (temp), stream);
-	  g_object_unref (temp);
-	}
-      else if (neg_term)
-	{
-	  CalcNumber *temp = calc_number_new (CALC_TERM (ex)->coefficient);
-	  calc_number_abs (&CALC_TERM (ex)->coefficient, temp);
-	  calc_expr_print (ex, stream);
-	  calc_number_copy (CALC_TERM (ex)->coefficient, temp);
-	  g_object_unref (temp);
-	}
-      else
-	calc_expr_print (ex, stream);
-      fputc (')', stream);
+	g_string_append_c (str, neg_num || neg_term ? '-' : '+');
+      g_string_append_c (str, '(');
+
+      /* A negative number or coefficient is printed first with its minus
+	 sign, which is then dropped in place of printing a negated copy */
+      start = str->len;
+      calc_expr_print_string (ex, str, format);
+      if ((neg_num || neg_term) && str->str[start] == '-')
+	g_string_erase (str, start, 1);
+      g_string_append_c (str, ')');
     }
 }
 
@@ -156,44 +159,191 @@ calc_sum_like_terms (CalcExpr *self, CalcExpr *other)
   return calc_sum_equivalent (self, other);
 }
 
-static gulong
+static guint64
 calc_sum_hash (CalcExpr *expr)
 {
   CalcSum *self = CALC_SUM (expr);
-  gulong hash;
+  guint64 hash = 0;
   g_ptr_array_foreach (self->terms, calc_sum_term_hash, &hash);
-  return hash;
+  return _calc_hash_combine (CALC_SUM_HASH_SEED, hash);
 }
 
+/* The coefficient of each term is multiplied by the product of its factors
+   and accumulated into the sum with a single rounding at the end, instead
+   of rounding every product and every partial sum. Exact terms are summed
+   exactly and folded into the floating-point terms only at the end. */
+
 static gboolean
 calc_sum_evaluate (CalcExpr *expr, CalcExpr *result)
 {
   CalcSum *self = CALC_SUM (expr);
-  CalcNumber *total = NULL;
+  CalcValueAcc acc;
+  CalcNumber *ans;
   guint i;
 
   g_return_val_if_fail (CALC_IS_NUMBER (result), FALSE);
+  ans = calc_number_new (NULL);
+  _calc_value_acc_init (&acc);
   for (i = 0; i < self->terms->len; i++)
     {
-      CalcNumber *ans = calc_number_new (NULL);
-      CalcNumber *temp;
-      if (!calc_expr_evaluate (self->terms->pdata[i], CALC_EXPR (ans)))
+      CalcExpr *ex = self->terms->pdata[i];
+      CalcTerm *term = CALC_IS_TERM (ex) ? CALC_TERM (ex) : NULL;
+      if (term != NULL && term->factors->len == 0)
+	{
+	  _calc_value_acc_add (&acc, &term->coefficient->value);
+	  continue;
+	}
+      if (term != NULL ? !_calc_term_evaluate_factors (term, ans)
+	  : !calc_expr_evaluate (ex, CALC_EXPR (ans)))
 	{
+	  _calc_value_acc_clear (&acc);
 	  g_object_unref (ans);
-	  g_object_unref (total);
 	  return FALSE;
 	}
-      temp = calc_number_new (total);
-      calc_number_add (&total, temp, ans);
-      g_object_unref (ans);
-      g_object_unref (temp);
+      if (term != NULL)
+	_calc_value_acc_addmul (&acc, &term->coefficient->value,
+				&ans->value);
+      else
+	_calc_value_acc_add (&acc, &ans->value);
     }
 
-  calc_expr_evaluate (CALC_EXPR (total), result);
-  g_object_unref (total);
+  calc_expr_changed (result);
+  _calc_value_acc_finish (&acc, &CALC_NUMBER (result)->value);
+  g_object_unref (ans);
   return TRUE;
 }
 
+static gboolean
+calc_sum_evaluate_approx (CalcExpr *expr, CalcApprox *result,
+			  gdouble tolerance)
+{
+  CalcSum *self = CALC_SUM (expr);
+  guint len = self->terms->len;
+  CalcApprox *terms = g_new (CalcApprox, len);
+  gboolean *exact = g_new0 (gboolean, len);
+  gboolean ret = TRUE;
+  guint i;
+
+  for (i = 0; i < len && ret; i++)
+    ret = _calc_expr_approx (self->terms->pdata[i], &terms[i], tolerance);
+  while (ret)
+    {
+      result->value = 0;
+      result->error = 0;
+      for (i = 0; i < len && ret; i++)
+	ret = _calc_approx_add (result, result, &terms[i]);
+
+      /* Evaluate the terms with the largest errors exactly until the sum
+	 is accurate enough */
+      if (!ret || result->error <= tolerance * fabs (result->value)
+	  || !_calc_approx_escalate ((CalcExpr **) self->terms->pdata, terms,
+				     exact, len, FALSE))
+	break;
+    }
+  g_free (terms);
+  g_free (exact);
+  return ret;
+}
+
+static gint
+calc_sum_compile (CalcExpr *expr, CalcProgram *program)
+{
+  CalcSum *self = CALC_SUM (expr);
+  gint dest = _calc_program_alloc (program);
+  guint mark = _calc_program_mark (program);
+  gint *operands = g_new (gint, self->terms->len * 2);
+  guint i;
+
+  /* Every operand is computed before the sum is started, since the terms
+     may contain sums of their own */
+  for (i = 0; i < self->terms->len; i++)
+    {
+      CalcExpr *ex = self->terms->pdata[i];
+      CalcTerm *term = CALC_IS_TERM (ex) ? CALC_TERM (ex) : NULL;
+      gint *op = operands + i * 2;
+      op[1] = -1;
+      if (term != NULL)
+	{
+	  op[0] = _calc_program_compile_expr (program,
+					      CALC_EXPR (term->coefficient));
+	  if (op[0] >= 0 && term->factors->len > 0)
+	    op[1] = _calc_term_compile_factors (term, program);
+	  if (op[0] < 0 || (term->factors->len > 0 && op[1] < 0))
+	    goto err_exit;
+	}
+      else
+	{
+	  op[0] = _calc_program_compile_expr (program, ex);
+	  if (op[0] < 0)
+	    goto err_exit;
+	}
+    }
+
+  _calc_program_emit (program, CALC_PROGRAM_OP_ACC_INIT, -1, -1, -1);
+  for (i = 0; i < self->terms->len; i++)
+    {
+      gint *op = operands + i * 2;
+      if (op[1] >= 0)
+	_calc_program_emit (program, CALC_PROGRAM_OP_ACC_ADDMUL, -1, op[0],
+			    op[1]);
+      else
+	_calc_program_emit (program, CALC_PROGRAM_OP_ACC_ADD, -1, op[0], -1);
+    }
+  _calc_program_emit (program, CALC_PROGRAM_OP_ACC_FINISH, dest, -1, -1);
+  _calc_program_release (program, mark);
+  g_free (operands);
+  return dest;
+
+ err_exit:
+  _calc_program_release (program, mark);
+  g_free (operands);
+  return -1;
+}
+
+static void
+calc_sum_intern (CalcExpr *expr)
+{
+  CalcSum *self = CALC_SUM (expr);
+  CalcTerm *term;
+  guint i;
+
+  for (i = 0; i < self->terms->len; i++)
+    {
+      term = CALC_TERM (_calc_expr_intern (self->terms->pdata[i]));
+      if (term == self->terms->pdata[i])
+	continue;
+
+      /* Take the same references as calc_sum_add_term() */
+      g_object_ref (term);
+      g_object_ref (term->coefficient);
+      _calc_expr_unlink (expr, self->terms->pdata[i]);
+      _calc_expr_link (expr, CALC_EXPR (term));
+      calc_sum_term_dispose (self->terms->pdata[i]);
+      self->terms->pdata[i] = term;
+    }
+}
+
+/* Replaces the term at @index of @self with a copy if it is interned, so
+   like terms can be folded into it without changing other expressions
+   sharing it. Returns the term that may be modified. */
+
+static CalcTerm *
+calc_sum_unshare_term (CalcSum *self, guint index)
+{
+  CalcTerm *term = self->terms->pdata[index];
+  CalcTerm *copy;
+  if (!calc_expr_is_interned (CALC_EXPR (term)))
+    return term;
+
+  /* The copy and its coefficient are only referenced by @self */
+  copy = _calc_term_copy (term);
+  _calc_expr_unlink (CALC_EXPR (self), CALC_EXPR (term));
+  _calc_expr_link (CALC_EXPR (self), CALC_EXPR (copy));
+  calc_sum_term_dispose (term);
+  self->terms->pdata[index] = copy;
+  return copy;
+}
+
 /**
  * calc_sum_new:
  * @term: the initial term
@@ -223,8 +373,9 @@ calc_sum_new (CalcExpr *term)
  *
  * Adds @term to the list of terms of @sum. The value of @term may be modified
  * through calls to #CalcSum functions. @term should not be freed until
- * @self is no longer in use. If @self or @term are invalid, no actions is
- * performed.
+ * @self is no longer in use. If @self is invalid or interned or @term is
+ * invalid, no actions is performed. Interned terms of @self are copied
+ * before @term is folded into them.
  **/
 
 void
@@ -233,6 +384,8 @@ calc_sum_add_term (CalcSum *self, CalcExpr *term)
   guint i;
   g_return_if_fail (CALC_IS_SUM (self));
   g_return_if_fail (CALC_IS_EXPR (term));
+  g_return_if_fail (!calc_expr_is_interned (CALC_EXPR (self)));
+  calc_expr_changed (CALC_EXPR (self));
 
   /* Check for like terms */
   for (i = 0; i < self->terms->len; i++)
@@ -240,17 +393,16 @@ calc_sum_add_term (CalcSum *self, CalcExpr *term)
       CalcTerm *expr = CALC_TERM (self->terms->pdata[i]);
       if (CALC_IS_NUMBER (term) && expr->factors->len == 0)
 	{
-	  CalcNumber *temp = calc_number_new (expr->coefficient);
-	  calc_number_add (&expr->coefficient, temp, CALC_NUMBER (term));
-	  g_object_unref (temp);
+	  expr = calc_sum_unshare_term (self, i);
+	  calc_number_add_inplace (expr->coefficient, CALC_NUMBER (term));
 	  return;
 	}
       else if (calc_expr_like_terms (term, CALC_EXPR (expr)))
 	{
 	  /* term is a CalcTerm instance */
-	  CalcNumber *temp = calc_number_new (expr->coefficient);
-	  calc_number_add (&expr->coefficient, temp,
-			   CALC_TERM (term)->coefficient);
+	  expr = calc_sum_unshare_term (self, i);
+	  calc_number_add_inplace (expr->coefficient,
+				   CALC_TERM (term)->coefficient);
 	  return;
 	}
       else if (expr->factors->len == 1)
@@ -258,7 +410,9 @@ calc_sum_add_term (CalcSum *self, CalcExpr *term)
 	  CalcExpr *e = expr->factors->pdata[0];
 	  if (calc_expr_like_terms (e, term))
 	    {
-	      CalcNumber *temp = calc_number_new (expr->coefficient);
+	      CalcNumber *temp;
+	      expr = calc_sum_unshare_term (self, i);
+	      temp = calc_number_new (expr->coefficient);
 	      calc_number_add_ui (&expr->coefficient, temp, 1);
 	      return;
 	    }
@@ -269,12 +423,14 @@ calc_sum_add_term (CalcSum *self, CalcExpr *term)
     {
       g_object_ref (term);
       g_object_ref (CALC_TERM (term)->coefficient);
+      _calc_expr_link (CALC_EXPR (self), term);
       g_ptr_array_add (self->terms, term);
     }
   else
     {
       CalcTerm *temp = calc_term_new (calc_number_new_ui (1));
       calc_term_add_factor (temp, term);
+      _calc_expr_link (CALC_EXPR (self), CALC_EXPR (temp));
       g_ptr_array_add (self->terms, temp);
     }
 }
@@ -22,23 +22,33 @@
 #include <config.h>
 #endif
 
+#include <math.h>
 #include "calc-exponent.h"
 #include "calc-sum.h"
 #include "calc-term.h"
+#include "calc-program.h"
+
+#define CALC_TERM_HASH_SEED G_GUINT64_CONSTANT (0x6a09e667f3bcc908)
 
 G_DEFINE_TYPE (CalcTerm, calc_term, CALC_TYPE_EXPR)
 
-static void calc_term_print (CalcExpr *expr, FILE *stream);
+static void calc_term_print_string (CalcExpr *expr, GString *str,
+				    const CalcPrintFormat *format);
 static gboolean calc_term_equivalent (CalcExpr *self, CalcExpr *other);
 static gboolean calc_term_like_terms (CalcExpr *self, CalcExpr *other);
-static gulong calc_term_hash (CalcExpr *expr);
+static guint64 calc_term_hash (CalcExpr *expr);
 static gboolean calc_term_evaluate (CalcExpr *expr, CalcExpr *result);
+static gboolean calc_term_evaluate_approx (CalcExpr *expr,
+					   CalcApprox *result, gdouble tolerance);
+static gint calc_term_compile (CalcExpr *expr, CalcProgram *program);
+static void calc_term_intern (CalcExpr *expr);
 
 static void
 calc_term_dispose (GObject *obj)
 {
   CalcTerm *self = CALC_TERM (obj);
   g_ptr_array_unref (self->factors);
+  G_OBJECT_CLASS (calc_term_parent_class)->dispose (obj);
 }
 
 static void
@@ -56,11 +66,14 @@ calc_term_class_init (CalcTermClass *klass)
 {
   CalcExprClass *exprclass = CALC_EXPR_CLASS (klass);
   G_OBJECT_CLASS (klass)->dispose = calc_term_dispose;
-  exprclass->print = calc_term_print;
+  exprclass->print_string = calc_term_print_string;
   exprclass->equivalent = calc_term_equivalent;
   exprclass->like_terms = calc_term_like_terms;
   exprclass->hash = calc_term_hash;
   exprclass->evaluate = calc_term_evaluate;
+  exprclass->evaluate_approx = calc_term_evaluate_approx;
+  exprclass->compile = calc_term_compile;
+  exprclass->intern = calc_term_intern;
 }
 
 static void
@@ -69,27 +82,19 @@ calc_term_init (CalcTerm *self)
   self->factors = g_ptr_array_new_with_free_func (calc_term_factor_dispose);
 }
 
-static void
-calc_term_factor_print (gpointer data, gpointer user_data)
-{
-  FILE *stream = (FILE *) user_data;
-  CalcExpr *factor = CALC_EXPR (data);
-  fputc ('(', stream);
-  calc_expr_print (factor, stream);
-  fputc (')', stream);
-}
-
 static void
 calc_term_factor_hash (gpointer data, gpointer user_data)
 {
-  *((gulong *) user_data) += calc_expr_hash (CALC_EXPR (data));
+  /* Factors are unordered, see calc_sum_term_hash () */
+  *((guint64 *) user_data) +=
+    _calc_hash_mix (calc_expr_hash (CALC_EXPR (data)));
 }
 
 static gint
 calc_term_factor_compare (gconstpointer a, gconstpointer b)
 {
-  gulong ha = calc_expr_hash (*((CalcExpr **) a));
-  gulong hb = calc_expr_hash (*((CalcExpr **) b));
+  guint64 ha = calc_expr_hash (*((CalcExpr **) a));
+  guint64 hb = calc_expr_hash (*((CalcExpr **) b));
   if (ha > hb)
     return 1;
   if (ha < hb)
@@ -98,11 +103,18 @@ calc_term_factor_compare (gconstpointer a, gconstpointer b)
 }
 
 static void
-calc_term_print (CalcExpr *expr, FILE *stream)
+calc_term_print_string (CalcExpr *expr, GString *str,
+			const CalcPrintFormat *format)
 {
   CalcTerm *self = CALC_TERM (expr);
-  calc_expr_print (CALC_EXPR (self->coefficient), stream);
-  g_ptr_array_foreach (self->factors, calc_term_factor_print, stream);
+  guint i;
+  calc_expr_print_string (CALC_EXPR (self->coefficient), str, format);
+  for (i = 0; i < self->factors->len; i++)
+    {
+      g_string_append_c (str, '(');
+      calc_expr_print_string (self->factors->pdata[i], str, format);
+      g_string_append_c (str, ')');
+    }
 }
 
 static gboolean
@@ -137,49 +149,146 @@ calc_term_like_terms (CalcExpr *self, CalcExpr *other)
   return TRUE;
 }
 
-static gulong
+static guint64
 calc_term_hash (CalcExpr *expr)
 {
   CalcTerm *self = CALC_TERM (expr);
-  gulong hash;
-  g_ptr_array_foreach (self->factors, calc_term_factor_hash, &hash);
-  return hash;
+  guint64 factors = 0;
+  guint64 hash =
+    _calc_hash_combine (CALC_TERM_HASH_SEED,
+			calc_expr_hash (CALC_EXPR (self->coefficient)));
+  g_ptr_array_foreach (self->factors, calc_term_factor_hash, &factors);
+  return _calc_hash_combine (hash, factors);
 }
 
 static gboolean
 calc_term_evaluate (CalcExpr *expr, CalcExpr *result)
 {
   CalcTerm *self = CALC_TERM (expr);
-  CalcNumber *total = NULL;
-  guint i;
+  CalcNumber *nresult;
+  CalcNumber *total;
 
   g_return_val_if_fail (CALC_IS_NUMBER (result), FALSE);
   /* Terms without factors behave as numbers */
   if (self->factors->len == 0)
     return calc_expr_evaluate (CALC_EXPR (self->coefficient), result);
 
-  total = calc_number_new (self->coefficient);
-  for (i = 0; i < self->factors->len; i++)
+  total = calc_number_new (NULL);
+  if (!_calc_term_evaluate_factors (self, total))
     {
-      CalcNumber *ans = calc_number_new (NULL);
-      CalcNumber *temp;
-      if (!calc_expr_evaluate (self->factors->pdata[i], CALC_EXPR (ans)))
-	{
-	  g_object_unref (ans);
-	  g_object_unref (total);
-	  return FALSE;
-	}
-      temp = calc_number_new (total);
-      calc_number_mul (&total, temp, ans);
-      g_object_unref (ans);
-      g_object_unref (temp);
+      g_object_unref (total);
+      return FALSE;
     }
-
-  calc_expr_evaluate (CALC_EXPR (total), result);
+  nresult = CALC_NUMBER (result);
+  calc_number_mul (&nresult, self->coefficient, total);
   g_object_unref (total);
   return TRUE;
 }
 
+static gboolean
+calc_term_evaluate_approx (CalcExpr *expr, CalcApprox *result,
+			   gdouble tolerance)
+{
+  CalcTerm *self = CALC_TERM (expr);
+  guint len = self->factors->len;
+  CalcApprox *factors = g_new (CalcApprox, len);
+  gboolean *exact = g_new0 (gboolean, len);
+  CalcApprox coefficient;
+  gboolean ret;
+  guint i;
+
+  ret = _calc_approx_set_value (&coefficient, &self->coefficient->value);
+  for (i = 0; i < len && ret; i++)
+    ret = _calc_expr_approx (self->factors->pdata[i], &factors[i], tolerance);
+  while (ret)
+    {
+      *result = coefficient;
+      for (i = 0; i < len && ret; i++)
+	ret = _calc_approx_mul (result, result, &factors[i]);
+
+      /* Evaluate the factors with the largest relative errors exactly
+	 until the product is accurate enough */
+      if (!ret || result->error <= tolerance * fabs (result->value)
+	  || !_calc_approx_escalate ((CalcExpr **) self->factors->pdata,
+				     factors, exact, len, TRUE))
+	break;
+    }
+  g_free (factors);
+  g_free (exact);
+  return ret;
+}
+
+static gint
+calc_term_compile (CalcExpr *expr, CalcProgram *program)
+{
+  CalcTerm *self = CALC_TERM (expr);
+  gint coefficient;
+  gint product;
+  gint dest;
+  guint mark;
+
+  coefficient =
+    _calc_program_compile_expr (program, CALC_EXPR (self->coefficient));
+  /* Terms without factors behave as numbers */
+  if (self->factors->len == 0 || coefficient < 0)
+    return coefficient;
+
+  dest = _calc_program_alloc (program);
+  mark = _calc_program_mark (program);
+  product = _calc_term_compile_factors (self, program);
+  if (product < 0)
+    return -1;
+  _calc_program_emit (program, CALC_PROGRAM_OP_MUL, dest, coefficient,
+		      product);
+  _calc_program_release (program, mark);
+  return dest;
+}
+
+static void
+calc_term_intern (CalcExpr *expr)
+{
+  CalcTerm *self = CALC_TERM (expr);
+  CalcExponent *factor;
+  guint i;
+
+  for (i = 0; i < self->factors->len; i++)
+    {
+      factor = CALC_EXPONENT (_calc_expr_intern (self->factors->pdata[i]));
+      if (factor == self->factors->pdata[i])
+	continue;
+
+      /* Take the same references as calc_term_add_factor() */
+      g_object_ref (factor);
+      g_object_ref (factor->power);
+      _calc_expr_unlink (expr, self->factors->pdata[i]);
+      _calc_expr_link (expr, CALC_EXPR (factor));
+      calc_term_factor_dispose (self->factors->pdata[i]);
+      self->factors->pdata[i] = factor;
+    }
+}
+
+/* Replaces the factor at @index of @self with a copy if it is interned, so
+   its power can be changed without changing other expressions sharing it.
+   Returns the factor that may be modified. */
+
+static CalcExponent *
+calc_term_unshare_factor (CalcTerm *self, guint index)
+{
+  CalcExponent *factor = self->factors->pdata[index];
+  CalcExponent *copy;
+  if (!calc_expr_is_interned (CALC_EXPR (factor)))
+    return factor;
+
+  /* Take the same references as calc_term_add_factor() */
+  copy = _calc_exponent_copy (factor);
+  g_object_ref (copy->power);
+  _calc_expr_unlink (CALC_EXPR (self), CALC_EXPR (factor));
+  _calc_expr_link (CALC_EXPR (self), CALC_EXPR (copy));
+  calc_term_factor_dispose (factor);
+  self->factors->pdata[index] = copy;
+  return copy;
+}
+
 /**
  * calc_term_new:
  * @coefficient: the coefficient of the term
@@ -197,6 +306,7 @@ calc_term_new (CalcNumber *coefficient)
   CalcTerm *self;
   g_return_val_if_fail (CALC_IS_NUMBER (coefficient), NULL);
   self = g_object_new (CALC_TYPE_TERM, NULL);
+  _calc_expr_link (CALC_EXPR (self), CALC_EXPR (coefficient));
   self->coefficient = coefficient;
   return self;
 }
@@ -208,8 +318,8 @@ calc_term_new (CalcNumber *coefficient)
  *
  * Changes the coefficient of @self to @coefficient. @coefficient should not
  * be freed until @self is no longer in use, but the previous coefficient of
- * @self may be freed after calling this function. If @self or @coefficient
- * are invalid, no action is performed.
+ * @self may be freed after calling this function. If @self is invalid or
+ * interned or @coefficient is invalid, no action is performed.
  **/
 
 void
@@ -217,6 +327,10 @@ calc_term_set_coefficient (CalcTerm *self, CalcNumber *coefficient)
 {
   g_return_if_fail (CALC_IS_TERM (self));
   g_return_if_fail (CALC_IS_NUMBER (coefficient));
+  g_return_if_fail (!calc_expr_is_interned (CALC_EXPR (self)));
+  calc_expr_changed (CALC_EXPR (self));
+  _calc_expr_unlink (CALC_EXPR (self), CALC_EXPR (self->coefficient));
+  _calc_expr_link (CALC_EXPR (self), CALC_EXPR (coefficient));
   self->coefficient = coefficient;
 }
 
@@ -237,14 +351,68 @@ calc_term_get_coefficient (CalcTerm *self)
   return self->coefficient;
 }
 
+/* Evaluates the product of the factors of @self, without its coefficient,
+   and stores it in @result. The product of no factors is one. */
+
+gboolean
+_calc_term_evaluate_factors (CalcTerm *self, CalcNumber *result)
+{
+  CalcNumber *ans;
+  guint i;
+
+  calc_expr_changed (CALC_EXPR (result));
+  calc_value_clear (&result->value);
+  calc_value_init_ui (&result->value, 1);
+  if (self->factors->len == 0)
+    return TRUE;
+
+  ans = calc_number_new (NULL);
+  for (i = 0; i < self->factors->len; i++)
+    {
+      if (!calc_expr_evaluate (self->factors->pdata[i], CALC_EXPR (ans)))
+	{
+	  g_object_unref (ans);
+	  return FALSE;
+	}
+      calc_number_mul_inplace (result, ans);
+    }
+  g_object_unref (ans);
+  return TRUE;
+}
+
+/* Compiles the product of the factors of @self, without its coefficient,
+   as _calc_term_evaluate_factors() computes it. Returns the register
+   holding the product, or -1 on failure. */
+
+gint
+_calc_term_compile_factors (CalcTerm *self, CalcProgram *program)
+{
+  gint product = _calc_program_alloc (program);
+  guint mark = _calc_program_mark (program);
+  gint factor;
+  guint i;
+
+  _calc_program_emit (program, CALC_PROGRAM_OP_ONE, product, -1, -1);
+  for (i = 0; i < self->factors->len; i++)
+    {
+      factor = _calc_program_compile_expr (program, self->factors->pdata[i]);
+      if (factor < 0)
+	return -1;
+      _calc_program_emit (program, CALC_PROGRAM_OP_MUL_INPLACE, product,
+			  factor, -1);
+      _calc_program_release (program, mark);
+    }
+  return product;
+}
+
 /**
  * calc_term_add_factor:
  * @self: the term
  * @factor: the factor to add
  *
  * Adds the expression @factor as a factor of @self. @factor should not
- * be freed until @self is no longer in use. If @self or @factor are invalid,
- * no action is performed.
+ * be freed until @self is no longer in use. If @self is invalid or interned
+ * or @factor is invalid, no action is performed.
  *
  * Depending on the type of @factor, this function performs different actions.
  * If @factor is an instance of #CalcNumber, its value will be multiplied to
@@ -252,7 +420,8 @@ calc_term_get_coefficient (CalcTerm *self)
  * factor of @self with the same base, the power of @factor is added to the
  * power of the other factor. For all other valid expressions, an instance
  * of #CalcExponent is appended to the list of factors of @self with a base of
- * @factor and a power of 1.
+ * @factor and a power of 1. Interned factors of @self are copied before their
+ * powers are changed.
  **/
 
 /* TODO Fix memory leaks with allocating constant numbers in exponents */
@@ -263,11 +432,12 @@ calc_term_add_factor (CalcTerm *self, CalcExpr *factor)
   guint i;
   g_return_if_fail (CALC_IS_TERM (self));
   g_return_if_fail (CALC_IS_EXPR (factor));
+  g_return_if_fail (!calc_expr_is_interned (CALC_EXPR (self)));
+  calc_expr_changed (CALC_EXPR (self));
 
   if (CALC_IS_NUMBER (factor))
     {
-      CalcNumber *temp = calc_number_new (self->coefficient);
-      calc_number_mul (&self->coefficient, temp, CALC_NUMBER (factor));
+      calc_number_mul_inplace (self->coefficient, CALC_NUMBER (factor));
       return;
     }
 
@@ -282,7 +452,8 @@ calc_term_add_factor (CalcTerm *self, CalcExpr *factor)
 	  CalcExponent *efactor = CALC_EXPONENT (factor);
 	  CalcSum *sum = calc_sum_new (efactor->power);
 	  calc_sum_add_term (sum, CALC_EXPONENT (expr)->power);
-	  CALC_EXPONENT (expr)->power = CALC_EXPR (sum);
+	  calc_exponent_set_power (calc_term_unshare_factor (self, i),
+				   CALC_EXPR (sum));
 	  return;
 	}
       else if (calc_expr_equivalent (factor, expr))
@@ -290,6 +461,7 @@ calc_term_add_factor (CalcTerm *self, CalcExpr *factor)
 	  /* Square the expression */
 	  CalcExponent *temp =
 	    calc_exponent_new (expr, CALC_EXPR (calc_number_new_ui (2)));
+	  _calc_expr_link (CALC_EXPR (self), CALC_EXPR (temp));
 	  g_ptr_array_add (self->factors, temp);
 	  return;
 	}
@@ -298,14 +470,17 @@ calc_term_add_factor (CalcTerm *self, CalcExpr *factor)
 	  CalcExponent *ex = CALC_EXPONENT (expr);
 	  if (calc_expr_equivalent (ex->base, factor))
 	    {
-	      if (CALC_IS_SUM (ex->power))
+	      /* The power of a copied factor is still shared */
+	      ex = calc_term_unshare_factor (self, i);
+	      if (CALC_IS_SUM (ex->power) && ex == CALC_EXPONENT (expr)
+		  && !calc_expr_is_interned (ex->power))
 	        calc_sum_add_term (CALC_SUM (ex->power),
 				   CALC_EXPR (calc_number_new_ui (1)));
 	      else
 		{
 		  CalcSum *temp = calc_sum_new (ex->power);
 		  calc_sum_add_term (temp, CALC_EXPR (calc_number_new_ui (1)));
-		  ex->power = CALC_EXPR (temp);
+		  calc_exponent_set_power (ex, CALC_EXPR (temp));
 		}
 	      return;
 	    }
@@ -317,10 +492,36 @@ calc_term_add_factor (CalcTerm *self, CalcExpr *factor)
       /* Will be unref-ed on disposal */
       g_object_ref (factor);
       g_object_ref (CALC_EXPONENT (factor)->power);
+      _calc_expr_link (CALC_EXPR (self), factor);
       g_ptr_array_add (self->factors, factor);
     }
   else
-    g_ptr_array_add (self->factors,
-		     calc_exponent_new (factor,
-					CALC_EXPR (calc_number_new_ui (1))));
+    {
+      CalcExponent *temp =
+	calc_exponent_new (factor, CALC_EXPR (calc_number_new_ui (1)));
+      _calc_expr_link (CALC_EXPR (self), CALC_EXPR (temp));
+      g_ptr_array_add (self->factors, temp);
+    }
+}
+
+/* Creates a term with a copy of the coefficient of @self and the same
+   factors, which may be modified even if @self is interned */
+
+CalcTerm *
+_calc_term_copy (CalcTerm *self)
+{
+  CalcTerm *copy = calc_term_new (calc_number_new (self->coefficient));
+  CalcExponent *factor;
+  guint i;
+
+  for (i = 0; i < self->factors->len; i++)
+    {
+      /* Take the same references as calc_term_add_factor() */
+      factor = self->factors->pdata[i];
+      g_object_ref (factor);
+      g_object_ref (factor->power);
+      _calc_expr_link (CALC_EXPR (copy), CALC_EXPR (factor));
+      g_ptr_array_add (copy->factors, factor);
+    }
+  return copy;
 }
@@ -51,6 +51,17 @@ void calc_term_set_coefficient (CalcTerm *self, CalcNumber *coefficient);
 CalcNumber *calc_term_get_coefficient (CalcTerm *self);
 void calc_term_add_factor (CalcTerm *self, CalcExpr *factor);
 
+#ifdef _LIBCALC_INTERNAL
+
+/*< private >*/
+
+gboolean _calc_term_evaluate_factors (CalcTerm *self, CalcNumber *result);
+gint _calc_term_compile_factors (CalcTerm *self,
+				 struct _CalcProgram *program);
+CalcTerm *_calc_term_copy (CalcTerm *self);
+
+#endif
+
 G_END_DECLS
 
 #endif
@@ -0,0 +1,670 @@
+/*************************************************************************
+ * calc-value-add.c -- This file is part of libcalc.                    *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+
+#define _LIBCALC_INTERNAL
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <float.h>
+#include "calc-value.h"
+
+/**
+ * calc_value_add:
+ * @result: where to store the result of the addition
+ * @a: the first addend
+ * @b: the second addend
+ *
+ * Adds @a and @b and stores the result in @result. Any previous value in
+ * @result will be erased. The type of @result is dependent on the types of
+ * @a and @b.
+ **/
+
+void
+calc_value_add (CalcValue *result, const CalcValue *a, const CalcValue *b)
+{
+  CalcValueView va;
+  CalcValueView vb;
+  CalcNumberType type;
+  mpz_t z;
+  mpq_t q;
+  mpfr_t fr;
+
+  if (a->type == CALC_NUMBER_TYPE_DECIMAL
+      || b->type == CALC_NUMBER_TYPE_DECIMAL)
+    {
+      _calc_value_decimal_add (result, a, b, FALSE);
+      return;
+    }
+
+  type = _calc_value_get_final_type (a->type, b->type);
+  if (a->small && b->small)
+    {
+      glong num;
+      gulong den;
+      if (_calc_value_small_add (&num, &den, a->small_num, a->small_den,
+				 b->small_num, b->small_den))
+	{
+	  _calc_value_release (result);
+	  _calc_value_set_small (result, type, num, den);
+	  return;
+	}
+    }
+
+  /* Addition is commutative, so only handle @a having the lower type */
+  if (_calc_value_type_rank (a->type) > _calc_value_type_rank (b->type))
+    {
+      const CalcValue *temp = a;
+      a = b;
+      b = temp;
+    }
+
+  switch (type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      _calc_value_init_z (z);
+      mpz_add (z, _calc_value_get_z (a, &va), _calc_value_get_z (b, &vb));
+      _calc_value_take_z (result, z);
+      break;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      _calc_value_init_q (q);
+      if (a->type == CALC_NUMBER_TYPE_INTEGER)
+	{
+	  /* n/d + a = (n + ad)/d is already in lowest terms */
+	  mpq_srcptr qb = _calc_value_get_q (b, &vb);
+	  mpz_set (mpq_numref (q), mpq_numref (qb));
+	  mpz_addmul (mpq_numref (q), _calc_value_get_z (a, &va),
+		      mpq_denref (qb));
+	  mpz_set (mpq_denref (q), mpq_denref (qb));
+	}
+      else
+	mpq_add (q, _calc_value_get_q (a, &va), _calc_value_get_q (b, &vb));
+      _calc_value_take_q (result, q);
+      break;
+    case CALC_NUMBER_TYPE_DOUBLE:
+      _calc_value_take_d (result, calc_value_get_double (a)
+			  + calc_value_get_double (b));
+      break;
+    case CALC_NUMBER_TYPE_FLOATING:
+      _calc_value_init_fr (fr,
+			   _calc_value_result_prec (a,
+						    calc_value_get_prec (b)));
+      switch (a->type)
+	{
+	case CALC_NUMBER_TYPE_INTEGER:
+	  mpfr_add_z (fr, b->floating, _calc_value_get_z (a, &va),
+		      MPFR_RNDN);
+	  break;
+	case CALC_NUMBER_TYPE_RATIONAL:
+	  mpfr_add_q (fr, b->floating, _calc_value_get_q (a, &va),
+		      MPFR_RNDN);
+	  break;
+	case CALC_NUMBER_TYPE_DOUBLE:
+	case CALC_NUMBER_TYPE_FLOATING:
+	  mpfr_add (fr, _calc_value_get_fr (a, &va), b->floating, MPFR_RNDN);
+	  break;
+	}
+      _calc_value_take_fr (result, fr);
+      break;
+    }
+}
+
+/**
+ * calc_value_add_z:
+ * @result: where to store the result of the addition
+ * @a: the first addend
+ * @b: the second addend
+ *
+ * Adds @a and @b and stores the result in @result. Any previous value in
+ * @result will be erased. The type of @result is dependent on the types of
+ * @a and @b.
+ **/
+
+void
+calc_value_add_z (CalcValue *result, const CalcValue *a, mpz_t b)
+{
+  CalcValue saved;
+  CalcValueView view;
+  mpq_t temp;
+
+  /* Decimals are handled by the generic function */
+  if (a->type == CALC_NUMBER_TYPE_DECIMAL)
+    {
+      CalcValue value;
+      calc_value_init_z (&value, b);
+      calc_value_add (result, a, &value);
+      calc_value_clear (&value);
+      return;
+    }
+
+  if (a->type == CALC_NUMBER_TYPE_DOUBLE)
+    {
+      _calc_value_take_d (result, a->native + _calc_value_get_d_z (b));
+      return;
+    }
+
+  a = _calc_value_prepare (result, a, &saved);
+  result->type = a->type;
+  switch (a->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      _calc_value_init_z (result->integer);
+      mpz_add (result->integer, _calc_value_get_z (a, &view), b);
+      break;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      _calc_value_init_q (result->rational);
+      mpq_init (temp);
+      mpq_set_z (temp, b);
+      mpq_add (result->rational, _calc_value_get_q (a, &view), temp);
+      mpq_clear (temp);
+      break;
+    case CALC_NUMBER_TYPE_FLOATING:
+      _calc_value_init_fr (result->floating, _calc_value_result_prec (a, 0));
+      mpfr_add_z (result->floating, a->floating, b, MPFR_RNDN);
+      break;
+    }
+  _calc_value_shrink (result);
+  if (a == &saved)
+    calc_value_clear (&saved);
+}
+
+/**
+ * calc_value_add_q:
+ * @result: where to store the result of the addition
+ * @a: the first addend
+ * @b: the second addend
+ *
+ * Adds @a and @b and stores the result in @result. Any previous value in
+ * @result will be erased. The type of @result is dependent on the types of
+ * @a and @b.
+ **/
+
+void
+calc_value_add_q (CalcValue *result, const CalcValue *a, mpq_t b)
+{
+  CalcValue saved;
+  CalcValueView view;
+  mpq_t temp;
+
+  /* Decimals are handled by the generic function */
+  if (a->type == CALC_NUMBER_TYPE_DECIMAL)
+    {
+      CalcValue value;
+      calc_value_init_q (&value, b);
+      calc_value_add (result, a, &value);
+      calc_value_clear (&value);
+      return;
+    }
+
+  if (a->type == CALC_NUMBER_TYPE_DOUBLE)
+    {
+      _calc_value_take_d (result, a->native + _calc_value_get_d_q (b));
+      return;
+    }
+
+  a = _calc_value_prepare (result, a, &saved);
+  result->type = a->type;
+  switch (a->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      result->type = CALC_NUMBER_TYPE_RATIONAL;
+      _calc_value_init_q (result->rational);
+      mpq_init (temp);
+      mpq_set_z (temp, _calc_value_get_z (a, &view));
+      mpq_add (result->rational, temp, b);
+      mpq_clear (temp);
+      break;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      _calc_value_init_q (result->rational);
+      mpq_add (result->rational, _calc_value_get_q (a, &view), b);
+      break;
+    case CALC_NUMBER_TYPE_FLOATING:
+      _calc_value_init_fr (result->floating, _calc_value_result_prec (a, 0));
+      mpfr_add_q (result->floating, a->floating, b, MPFR_RNDN);
+      break;
+    }
+  _calc_value_shrink (result);
+  if (a == &saved)
+    calc_value_clear (&saved);
+}
+
+/**
+ * calc_value_add_f:
+ * @result: where to store the result of the addition
+ * @a: the first addend
+ * @b: the second addend
+ *
+ * Adds @a and @b and stores the result in @result. Any previous value in
+ * @result will be erased. The type of @result is dependent on the types of
+ * @a and @b.
+ **/
+
+void
+calc_value_add_f (CalcValue *result, const CalcValue *a, mpf_t b)
+{
+  mpfr_t temp;
+  mpfr_init2 (temp, mpf_get_prec (b));
+  mpfr_set_f (temp, b, MPFR_RNDN);
+  calc_value_add_fr (result, a, temp);
+  mpfr_clear (temp);
+}
+
+/**
+ * calc_value_add_fr:
+ * @result: where to store the result of the addition
+ * @a: the first addend
+ * @b: the second addend
+ *
+ * Adds @a and @b and stores the result in @result. Any previous value in
+ * @result will be erased. The type of @result is dependent on the types of
+ * @a and @b.
+ **/
+
+void
+calc_value_add_fr (CalcValue *result, const CalcValue *a, mpfr_t b)
+{
+  CalcValue saved;
+  CalcValueView view;
+
+  /* Decimals are handled by the generic function */
+  if (a->type == CALC_NUMBER_TYPE_DECIMAL)
+    {
+      CalcValue value;
+      calc_value_init_fr (&value, b);
+      calc_value_add (result, a, &value);
+      calc_value_clear (&value);
+      return;
+    }
+
+  a = _calc_value_prepare (result, a, &saved);
+  result->type = CALC_NUMBER_TYPE_FLOATING;
+  _calc_value_init_fr (result->floating,
+		       _calc_value_result_prec (a, mpfr_get_prec (b)));
+  switch (a->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      mpfr_set_z (result->floating, _calc_value_get_z (a, &view),
+		  MPFR_RNDN);
+      mpfr_add (result->floating, result->floating, b, MPFR_RNDN);
+      break;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      mpfr_set_q (result->floating, _calc_value_get_q (a, &view),
+		  MPFR_RNDN);
+      mpfr_add (result->floating, result->floating, b, MPFR_RNDN);
+      break;
+    case CALC_NUMBER_TYPE_DOUBLE:
+    case CALC_NUMBER_TYPE_FLOATING:
+      mpfr_add (result->floating, _calc_value_get_fr (a, &view), b,
+	       MPFR_RNDN);
+      break;
+    }
+  if (a == &saved)
+    calc_value_clear (&saved);
+}
+
+/**
+ * calc_value_add_d:
+ * @result: where to store the result of the addition
+ * @a: the first addend
+ * @b: the second addend
+ *
+ * Adds @a and @b and stores the result in @result. Any previous value in
+ * @result will be erased. The type of @result is dependent on the types of
+ * @a and @b.
+ **/
+
+void
+calc_value_add_d (CalcValue *result, const CalcValue *a, double b)
+{
+  CalcValue saved;
+  CalcValueView view;
+
+  /* Decimals are handled by the generic function */
+  if (a->type == CALC_NUMBER_TYPE_DECIMAL)
+    {
+      CalcValue value;
+      calc_value_init_d (&value, b);
+      calc_value_add (result, a, &value);
+      calc_value_clear (&value);
+      return;
+    }
+
+  if (a->type == CALC_NUMBER_TYPE_DOUBLE)
+    {
+      _calc_value_take_d (result, a->native + b);
+      return;
+    }
+
+  a = _calc_value_prepare (result, a, &saved);
+  result->type = CALC_NUMBER_TYPE_FLOATING;
+  _calc_value_init_fr (result->floating,
+		       _calc_value_result_prec (a, DBL_MANT_DIG));
+  switch (a->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      mpfr_set_z (result->floating, _calc_value_get_z (a, &view),
+		  MPFR_RNDN);
+      mpfr_add_d (result->floating, result->floating, b, MPFR_RNDN);
+      break;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      mpfr_set_q (result->floating, _calc_value_get_q (a, &view),
+		  MPFR_RNDN);
+      mpfr_add_d (result->floating, result->floating, b, MPFR_RNDN);
+      break;
+    case CALC_NUMBER_TYPE_FLOATING:
+      mpfr_add_d (result->floating, a->floating, b, MPFR_RNDN);
+      break;
+    }
+  if (a == &saved)
+    calc_value_clear (&saved);
+}
+
+/**
+ * calc_value_add_ui:
+ * @result: where to store the result of the addition
+ * @a: the first addend
+ * @b: the second addend
+ *
+ * Adds @a and @b and stores the result in @result. Any previous value in
+ * @result will be erased. The type of @result is dependent on the types of
+ * @a and @b.
+ **/
+
+void
+calc_value_add_ui (CalcValue *result, const CalcValue *a, unsigned long b)
+{
+  CalcValue saved;
+  CalcValueView view;
+  mpq_t temp;
+
+  /* Decimals are handled by the generic function */
+  if (a->type == CALC_NUMBER_TYPE_DECIMAL)
+    {
+      CalcValue value;
+      calc_value_init_ui (&value, b);
+      calc_value_add (result, a, &value);
+      calc_value_clear (&value);
+      return;
+    }
+
+  if (a->type == CALC_NUMBER_TYPE_DOUBLE)
+    {
+      _calc_value_take_d (result, a->native + b);
+      return;
+    }
+
+  if (a->small && b <= G_MAXLONG)
+    {
+      CalcNumberType type = a->type;
+      glong num;
+      gulong den;
+      if (_calc_value_small_add (&num, &den, a->small_num, a->small_den,
+				 (glong) b, 1))
+	{
+	  _calc_value_release (result);
+	  _calc_value_set_small (result, type, num, den);
+	  return;
+	}
+    }
+
+  a = _calc_value_prepare (result, a, &saved);
+  result->type = a->type;
+  switch (a->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      _calc_value_init_z (result->integer);
+      mpz_add_ui (result->integer, _calc_value_get_z (a, &view), b);
+      break;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      _calc_value_init_q (result->rational);
+      mpq_init (temp);
+      mpq_set_ui (temp, b, 1);
+      mpq_add (result->rational, _calc_value_get_q (a, &view), temp);
+      mpq_clear (temp);
+      break;
+    case CALC_NUMBER_TYPE_FLOATING:
+      _calc_value_init_fr (result->floating, _calc_value_result_prec (a, 0));
+      mpfr_add_ui (result->floating, a->floating, b, MPFR_RNDN);
+      break;
+    }
+  _calc_value_shrink (result);
+  if (a == &saved)
+    calc_value_clear (&saved);
+}
+
+/**
+ * calc_value_add_si:
+ * @result: where to store the result of the addition
+ * @a: the first addend
+ * @b: the second addend
+ *
+ * Adds @a and @b and stores the result in @result. Any previous value in
+ * @result will be erased. The type of @result is dependent on the types of
+ * @a and @b.
+ **/
+
+void
+calc_value_add_si (CalcValue *result, const CalcValue *a, signed long b)
+{
+  CalcValue saved;
+  CalcValueView view;
+  mpq_t temp;
+
+  /* Decimals are handled by the generic function */
+  if (a->type == CALC_NUMBER_TYPE_DECIMAL)
+    {
+      CalcValue value;
+      calc_value_init_si (&value, b);
+      calc_value_add (result, a, &value);
+      calc_value_clear (&value);
+      return;
+    }
+
+  if (a->type == CALC_NUMBER_TYPE_DOUBLE)
+    {
+      _calc_value_take_d (result, a->native + b);
+      return;
+    }
+
+  if (a->small)
+    {
+      CalcNumberType type = a->type;
+      glong num;
+      gulong den;
+      if (_calc_value_small_add (&num, &den, a->small_num, a->small_den,
+				 b, 1))
+	{
+	  _calc_value_release (result);
+	  _calc_value_set_small (result, type, num, den);
+	  return;
+	}
+    }
+
+  a = _calc_value_prepare (result, a, &saved);
+  result->type = a->type;
+  switch (a->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      _calc_value_init_z (result->integer);
+      if (b >= 0)
+	mpz_add_ui (result->integer, _calc_value_get_z (a, &view), b);
+      else
+	mpz_sub_ui (result->integer, _calc_value_get_z (a, &view),
+		    -(unsigned long) b);
+      break;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      _calc_value_init_q (result->rational);
+      mpq_init (temp);
+      mpq_set_si (temp, b, 1);
+      mpq_add (result->rational, _calc_value_get_q (a, &view), temp);
+      mpq_clear (temp);
+      break;
+    case CALC_NUMBER_TYPE_FLOATING:
+      _calc_value_init_fr (result->floating, _calc_value_result_prec (a, 0));
+      mpfr_add_si (result->floating, a->floating, b, MPFR_RNDN);
+      break;
+    }
+  _calc_value_shrink (result);
+  if (a == &saved)
+    calc_value_clear (&saved);
+}
+
+/**
+ * calc_value_add_inplace:
+ * @self: the value to add to
+ * @value: the value to add
+ *
+ * Adds @value to @self and stores the result in @self. The result is the
+ * same as calling calc_value_add() with @self as both the result and the
+ * first addend, but the storage of @self is reused where possible, which
+ * makes this suitable for accumulating a running total. @value may be the
+ * same value as @self.
+ *
+ * A rational result is not reduced to lowest terms until it is read or
+ * calc_value_normalize() is called, so a long sum of rationals only
+ * computes a GCD occasionally instead of once for every term.
+ **/
+
+void
+calc_value_add_inplace (CalcValue *self, const CalcValue *value)
+{
+  CalcValueView view;
+
+  if (self->small && value->small)
+    {
+      glong num;
+      gulong den;
+      if (_calc_value_small_add (&num, &den, self->small_num,
+				 self->small_den, value->small_num,
+				 value->small_den))
+	{
+	  _calc_value_set_small (self,
+				 _calc_value_get_final_type (self->type,
+							     value->type),
+				 num, den);
+	  return;
+	}
+    }
+
+  /* Only reuse the storage of @self if the result has the same type, and
+     leave decimals to the generic function */
+  if (self->small || self->type == CALC_NUMBER_TYPE_DECIMAL
+      || value->type == CALC_NUMBER_TYPE_DECIMAL
+      || _calc_value_get_final_type (self->type, value->type) != self->type)
+    {
+      calc_value_add (self, self, value);
+      return;
+    }
+
+  switch (self->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      mpz_add (self->integer, self->integer,
+	       _calc_value_get_z (value, &view));
+      break;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      /* The sum is not reduced until its value is needed */
+      if (value->type == CALC_NUMBER_TYPE_INTEGER)
+	{
+	  mpz_addmul (mpq_numref (self->rational),
+		      _calc_value_get_z (value, &view),
+		      mpq_denref (self->rational));
+
+	  /* Adding an integer keeps a reduced rational reduced */
+	  if (self->unreduced)
+	    _calc_value_defer_reduce (self);
+	}
+      else if (value == self)
+	{
+	  mpz_mul_2exp (mpq_numref (self->rational),
+			mpq_numref (self->rational), 1);
+	  _calc_value_defer_reduce (self);
+	}
+      else
+	{
+	  mpq_srcptr q = _calc_value_get_q (value, &view);
+	  if (mpz_cmp (mpq_denref (self->rational), mpq_denref (q)) == 0)
+	    mpz_add (mpq_numref (self->rational),
+		     mpq_numref (self->rational), mpq_numref (q));
+	  else
+	    {
+	      mpz_mul (mpq_numref (self->rational),
+		       mpq_numref (self->rational), mpq_denref (q));
+	      mpz_addmul (mpq_numref (self->rational), mpq_numref (q),
+			  mpq_denref (self->rational));
+	      mpz_mul (mpq_denref (self->rational),
+		       mpq_denref (self->rational), mpq_denref (q));
+	    }
+	  _calc_value_defer_reduce (self);
+	}
+      break;
+    case CALC_NUMBER_TYPE_FLOATING:
+      /* Round to the precision the generic function would give first */
+      mpfr_prec_round (self->floating,
+		       _calc_value_result_prec (self,
+						calc_value_get_prec (value)),
+		       MPFR_RNDN);
+      switch (value->type)
+	{
+	case CALC_NUMBER_TYPE_INTEGER:
+	  mpfr_add_z (self->floating, self->floating,
+		      _calc_value_get_z (value, &view), MPFR_RNDN);
+	  break;
+	case CALC_NUMBER_TYPE_RATIONAL:
+	  mpfr_add_q (self->floating, self->floating,
+		      _calc_value_get_q (value, &view), MPFR_RNDN);
+	  break;
+	case CALC_NUMBER_TYPE_DOUBLE:
+	case CALC_NUMBER_TYPE_FLOATING:
+	  mpfr_add (self->floating, self->floating,
+		    _calc_value_get_fr (value, &view), MPFR_RNDN);
+	  break;
+	}
+      break;
+    case CALC_NUMBER_TYPE_DOUBLE:
+      self->native += calc_value_get_double (value);
+      break;
+    }
+  _calc_value_shrink (self);
+}
+
+/**
+ * calc_value_sum:
+ * @result: where to store the result
+ * @values: (array length=n): the values to add
+ * @n: the number of values
+ *
+ * Adds all of the values in @values and stores the result in @result. Any
+ * previous value in @result will be erased. Integers and rationals are
+ * added exactly, and the floating-point values are added together with
+ * the exact part in one step, so the result is rounded only once no matter
+ * how many values there are. This is both faster and more accurate than
+ * calling calc_value_add_inplace() for each value.
+ **/
+
+void
+calc_value_sum (CalcValue *result, const CalcValue *values, gsize n)
+{
+  CalcValueAcc acc;
+  gsize i;
+  _calc_value_acc_init (&acc);
+  for (i = 0; i < n; i++)
+    _calc_value_acc_add (&acc, &values[i]);
+  _calc_value_acc_finish (&acc, result);
+}
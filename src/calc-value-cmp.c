@@ -0,0 +1,385 @@
+/*************************************************************************
+ * calc-value-cmp.c -- This file is part of libcalc.                    *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+
+#define _LIBCALC_INTERNAL
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "calc-value.h"
+
+/**
+ * calc_value_cmp:
+ * @a: the first value to compare
+ * @b: the second value to compare
+ *
+ * Compares the values of @a and @b.
+ *
+ * Returns: a positive value if @a > @b, negative if @a < @b, and zero if
+ * @a = @b
+ **/
+
+gint
+calc_value_cmp (const CalcValue *a, const CalcValue *b)
+{
+  CalcValueView va;
+  CalcValueView vb;
+  CalcNumberType type;
+  gint result;
+
+  if (a->small && b->small
+      && _calc_value_small_cmp (&result, a->small_num, a->small_den,
+				b->small_num, b->small_den))
+    return result;
+
+  if (a->type == CALC_NUMBER_TYPE_DECIMAL
+      || b->type == CALC_NUMBER_TYPE_DECIMAL)
+    return _calc_value_decimal_cmp (a, b);
+
+  type = _calc_value_get_final_type (a->type, b->type);
+  switch (type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      return mpz_cmp (_calc_value_get_z (a, &va),
+		      _calc_value_get_z (b, &vb));
+    case CALC_NUMBER_TYPE_RATIONAL:
+      return mpq_cmp (_calc_value_get_q (a, &va),
+		      _calc_value_get_q (b, &vb));
+    case CALC_NUMBER_TYPE_DOUBLE:
+    case CALC_NUMBER_TYPE_FLOATING:
+      if (a->type == CALC_NUMBER_TYPE_DOUBLE
+	  && b->type == CALC_NUMBER_TYPE_DOUBLE)
+	return (a->native > b->native) - (a->native < b->native);
+
+      /* Doubles are compared with exact values through MPFR, since
+	 converting the exact value to a double could round it */
+      switch (a->type)
+	{
+	case CALC_NUMBER_TYPE_INTEGER:
+	  return -mpfr_cmp_z (_calc_value_get_fr (b, &vb),
+			      _calc_value_get_z (a, &va));
+	case CALC_NUMBER_TYPE_RATIONAL:
+	  return -mpfr_cmp_q (_calc_value_get_fr (b, &vb),
+			      _calc_value_get_q (a, &va));
+	}
+      switch (b->type)
+	{
+	case CALC_NUMBER_TYPE_INTEGER:
+	  return mpfr_cmp_z (_calc_value_get_fr (a, &va),
+			     _calc_value_get_z (b, &vb));
+	case CALC_NUMBER_TYPE_RATIONAL:
+	  return mpfr_cmp_q (_calc_value_get_fr (a, &va),
+			     _calc_value_get_q (b, &vb));
+	default:
+	  return mpfr_cmp (_calc_value_get_fr (a, &va),
+			   _calc_value_get_fr (b, &vb));
+	}
+    default:
+      return 0;
+    }
+}
+
+/**
+ * calc_value_cmp_z:
+ * @a: the first value to compare
+ * @b: the second value to compare
+ *
+ * Compares the values of @a and @b.
+ *
+ * Returns: a positive value if @a > @b, negative if @a < @b, and zero if
+ * @a = @b
+ **/
+
+gint
+calc_value_cmp_z (const CalcValue *a, mpz_t b)
+{
+  CalcValueView view;
+  switch (a->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      return mpz_cmp (_calc_value_get_z (a, &view), b);
+    case CALC_NUMBER_TYPE_RATIONAL:
+      return mpq_cmp_z (_calc_value_get_q (a, &view), b);
+    case CALC_NUMBER_TYPE_DOUBLE:
+    case CALC_NUMBER_TYPE_FLOATING:
+      return mpfr_cmp_z (_calc_value_get_fr (a, &view), b);
+    case CALC_NUMBER_TYPE_DECIMAL:
+      {
+	CalcValue value;
+	gint cmp;
+	calc_value_init_z (&value, b);
+	cmp = calc_value_cmp (a, &value);
+	calc_value_clear (&value);
+	return cmp;
+      }
+    default:
+      return 0;
+    }
+}
+
+/**
+ * calc_value_cmp_q:
+ * @a: the first value to compare
+ * @b: the second value to compare
+ *
+ * Compares the values of @a and @b.
+ *
+ * Returns: a positive value if @a > @b, negative if @a < @b, and zero if
+ * @a = @b
+ **/
+
+gint
+calc_value_cmp_q (const CalcValue *a, mpq_t b)
+{
+  CalcValueView view;
+  switch (a->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      return -mpq_cmp_z (b, _calc_value_get_z (a, &view));
+    case CALC_NUMBER_TYPE_RATIONAL:
+      return mpq_cmp (_calc_value_get_q (a, &view), b);
+    case CALC_NUMBER_TYPE_DOUBLE:
+    case CALC_NUMBER_TYPE_FLOATING:
+      return mpfr_cmp_q (_calc_value_get_fr (a, &view), b);
+    case CALC_NUMBER_TYPE_DECIMAL:
+      {
+	CalcValue value;
+	gint cmp;
+	calc_value_init_q (&value, b);
+	cmp = calc_value_cmp (a, &value);
+	calc_value_clear (&value);
+	return cmp;
+      }
+    default:
+      return 0;
+    }
+}
+
+/**
+ * calc_value_cmp_f:
+ * @a: the first value to compare
+ * @b: the second value to compare
+ *
+ * Compares the values of @a and @b.
+ *
+ * Returns: a positive value if @a > @b, negative if @a < @b, and zero if
+ * @a = @b
+ **/
+
+gint
+calc_value_cmp_f (const CalcValue *a, mpf_t b)
+{
+  CalcValueView view;
+  mpq_t temp;
+  gint result;
+  switch (a->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      return -mpf_cmp_z (b, _calc_value_get_z (a, &view));
+    case CALC_NUMBER_TYPE_RATIONAL:
+      mpq_init (temp);
+      mpq_set_f (temp, b);
+      result = mpq_cmp (_calc_value_get_q (a, &view), temp);
+      mpq_clear (temp);
+      return result;
+    case CALC_NUMBER_TYPE_DOUBLE:
+    case CALC_NUMBER_TYPE_FLOATING:
+      return mpfr_cmp_f (_calc_value_get_fr (a, &view), b);
+    case CALC_NUMBER_TYPE_DECIMAL:
+      {
+	CalcValue value;
+	gint cmp;
+	calc_value_init_f (&value, b);
+	cmp = calc_value_cmp (a, &value);
+	calc_value_clear (&value);
+	return cmp;
+      }
+    default:
+      return 0;
+    }
+}
+
+/**
+ * calc_value_cmp_fr:
+ * @a: the first value to compare
+ * @b: the second value to compare
+ *
+ * Compares the values of @a and @b.
+ *
+ * Returns: a positive value if @a > @b, negative if @a < @b, and zero if
+ * @a = @b
+ **/
+
+gint
+calc_value_cmp_fr (const CalcValue *a, mpfr_t b)
+{
+  CalcValueView view;
+  switch (a->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      return -mpfr_cmp_z (b, _calc_value_get_z (a, &view));
+    case CALC_NUMBER_TYPE_RATIONAL:
+      return -mpfr_cmp_q (b, _calc_value_get_q (a, &view));
+    case CALC_NUMBER_TYPE_DOUBLE:
+    case CALC_NUMBER_TYPE_FLOATING:
+      return mpfr_cmp (_calc_value_get_fr (a, &view), b);
+    case CALC_NUMBER_TYPE_DECIMAL:
+      {
+	CalcValue value;
+	gint cmp;
+	calc_value_init_fr (&value, b);
+	cmp = calc_value_cmp (a, &value);
+	calc_value_clear (&value);
+	return cmp;
+      }
+    default:
+      return 0;
+    }
+}
+
+/**
+ * calc_value_cmp_d:
+ * @a: the first value to compare
+ * @b: the second value to compare
+ *
+ * Compares the values of @a and @b.
+ *
+ * Returns: a positive value if @a > @b, negative if @a < @b, and zero if
+ * @a = @b
+ **/
+
+gint
+calc_value_cmp_d (const CalcValue *a, double b)
+{
+  CalcValueView view;
+  mpfr_t temp;
+  gint result;
+  switch (a->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      return mpz_cmp_d (_calc_value_get_z (a, &view), b);
+    case CALC_NUMBER_TYPE_RATIONAL:
+      mpfr_init (temp);
+      mpfr_set_q (temp, _calc_value_get_q (a, &view), MPFR_RNDN);
+      result = mpfr_cmp_d (temp, b);
+      mpfr_clear (temp);
+      return result;
+    case CALC_NUMBER_TYPE_DOUBLE:
+      return (a->native > b) - (a->native < b);
+    case CALC_NUMBER_TYPE_FLOATING:
+      return mpfr_cmp_d (a->floating, b);
+    case CALC_NUMBER_TYPE_DECIMAL:
+      {
+	CalcValue value;
+	gint cmp;
+	calc_value_init_d (&value, b);
+	cmp = calc_value_cmp (a, &value);
+	calc_value_clear (&value);
+	return cmp;
+      }
+    default:
+      return 0;
+    }
+}
+
+/**
+ * calc_value_cmp_ui:
+ * @a: the first value to compare
+ * @b: the second value to compare
+ *
+ * Compares the values of @a and @b.
+ *
+ * Returns: a positive value if @a > @b, negative if @a < @b, and zero if
+ * @a = @b
+ **/
+
+gint
+calc_value_cmp_ui (const CalcValue *a, unsigned long b)
+{
+  CalcValueView view;
+  gint result;
+  if (a->small && b <= G_MAXLONG
+      && _calc_value_small_cmp (&result, a->small_num, a->small_den, (glong) b,
+				1))
+    return result;
+  switch (a->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      return mpz_cmp_ui (_calc_value_get_z (a, &view), b);
+    case CALC_NUMBER_TYPE_RATIONAL:
+      return mpq_cmp_ui (_calc_value_get_q (a, &view), b, 1);
+    case CALC_NUMBER_TYPE_DOUBLE:
+    case CALC_NUMBER_TYPE_FLOATING:
+      return mpfr_cmp_ui (_calc_value_get_fr (a, &view), b);
+    case CALC_NUMBER_TYPE_DECIMAL:
+      {
+	CalcValue value;
+	gint cmp;
+	calc_value_init_ui (&value, b);
+	cmp = calc_value_cmp (a, &value);
+	calc_value_clear (&value);
+	return cmp;
+      }
+    default:
+      return 0;
+    }
+}
+
+/**
+ * calc_value_cmp_si:
+ * @a: the first value to compare
+ * @b: the second value to compare
+ *
+ * Compares the values of @a and @b.
+ *
+ * Returns: a positive value if @a > @b, negative if @a < @b, and zero if
+ * @a = @b
+ **/
+
+gint
+calc_value_cmp_si (const CalcValue *a, signed long b)
+{
+  CalcValueView view;
+  gint result;
+  if (a->small
+      && _calc_value_small_cmp (&result, a->small_num, a->small_den, b,
+				1))
+    return result;
+  switch (a->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      return mpz_cmp_si (_calc_value_get_z (a, &view), b);
+    case CALC_NUMBER_TYPE_RATIONAL:
+      return mpq_cmp_si (_calc_value_get_q (a, &view), b, 1);
+    case CALC_NUMBER_TYPE_DOUBLE:
+    case CALC_NUMBER_TYPE_FLOATING:
+      return mpfr_cmp_si (_calc_value_get_fr (a, &view), b);
+    case CALC_NUMBER_TYPE_DECIMAL:
+      {
+	CalcValue value;
+	gint cmp;
+	calc_value_init_si (&value, b);
+	cmp = calc_value_cmp (a, &value);
+	calc_value_clear (&value);
+	return cmp;
+      }
+    default:
+      return 0;
+    }
+}
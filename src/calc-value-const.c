@@ -0,0 +1,159 @@
+/*************************************************************************
+ * calc-value-const.c -- This file is part of libcalc.                   *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+
+#define _LIBCALC_INTERNAL
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "calc-value.h"
+
+/* Number of constants cached by each thread. Each precision of a constant
+   uses one entry. */
+#define CALC_VALUE_CONST_CACHE_SIZE 16
+
+typedef struct
+{
+  CalcConstant constant;
+  mpfr_t value;
+} CalcValueConstEntry;
+
+typedef struct
+{
+  CalcValueConstEntry entries[CALC_VALUE_CONST_CACHE_SIZE];
+  guint n_entries;
+  guint next;
+} CalcValueConstCache;
+
+static void calc_value_const_cache_free (gpointer data);
+
+static GPrivate calc_value_const_cache =
+  G_PRIVATE_INIT (calc_value_const_cache_free);
+
+static void
+calc_value_const_cache_free (gpointer data)
+{
+  CalcValueConstCache *cache = data;
+  while (cache->n_entries > 0)
+    mpfr_clear (cache->entries[--cache->n_entries].value);
+  g_free (cache);
+}
+
+/* Computes @constant to the precision of @value */
+
+static void
+calc_value_const_compute (mpfr_ptr value, CalcConstant constant)
+{
+  mpfr_t temp;
+  switch (constant)
+    {
+    case CALC_CONSTANT_PI:
+      mpfr_const_pi (value, MPFR_RNDN);
+      break;
+    case CALC_CONSTANT_E:
+      mpfr_init2 (temp, MPFR_PREC_MIN);
+      mpfr_set_ui (temp, 1, MPFR_RNDN);
+      mpfr_exp (value, temp, MPFR_RNDN);
+      mpfr_clear (temp);
+      break;
+    case CALC_CONSTANT_LN2:
+      mpfr_const_log2 (value, MPFR_RNDN);
+      break;
+    case CALC_CONSTANT_LN10:
+      mpfr_init2 (temp, 4);
+      mpfr_set_ui (temp, 10, MPFR_RNDN);
+      mpfr_log (value, temp, MPFR_RNDN);
+      mpfr_clear (temp);
+      break;
+    case CALC_CONSTANT_LOG2_10:
+      mpfr_init2 (temp, 4);
+      mpfr_set_ui (temp, 10, MPFR_RNDN);
+      mpfr_log2 (value, temp, MPFR_RNDN);
+      mpfr_clear (temp);
+      break;
+    default:
+      mpfr_set_nan (value);
+      break;
+    }
+}
+
+/* Looks up @constant with a precision of @prec in the cache of the calling
+   thread, computing it if it is not already cached. The least recently
+   computed entry is replaced when the cache is full. */
+
+static mpfr_srcptr
+calc_value_const_get (CalcConstant constant, mpfr_prec_t prec)
+{
+  CalcValueConstCache *cache = g_private_get (&calc_value_const_cache);
+  CalcValueConstEntry *entry;
+  guint i;
+
+  if (cache == NULL)
+    {
+      cache = g_new0 (CalcValueConstCache, 1);
+      g_private_set (&calc_value_const_cache, cache);
+    }
+  for (i = 0; i < cache->n_entries; i++)
+    {
+      entry = &cache->entries[i];
+      if (entry->constant == constant
+	  && mpfr_get_prec (entry->value) == prec)
+	return entry->value;
+    }
+
+  if (cache->n_entries < CALC_VALUE_CONST_CACHE_SIZE)
+    {
+      entry = &cache->entries[cache->n_entries++];
+      mpfr_init2 (entry->value, prec);
+    }
+  else
+    {
+      entry = &cache->entries[cache->next];
+      cache->next = (cache->next + 1) % CALC_VALUE_CONST_CACHE_SIZE;
+      mpfr_set_prec (entry->value, prec);
+    }
+  entry->constant = constant;
+  calc_value_const_compute (entry->value, constant);
+  return entry->value;
+}
+
+/**
+ * calc_value_set_const:
+ * @self: the value to set
+ * @constant: the constant
+ *
+ * Sets @self to the floating-point approximation of @constant, using the
+ * precision override of the calling thread or the default precision of GNU
+ * MPFR. Any previous value in @self is erased. Each thread caches the
+ * constants it has computed for each precision, so repeated calls at the
+ * same precision only copy the cached value.
+ **/
+
+void
+calc_value_set_const (CalcValue *self, CalcConstant constant)
+{
+  mpfr_prec_t prec = calc_value_get_prec_override ();
+  mpfr_t fr;
+  g_return_if_fail (constant >= 0 && constant < N_CALC_CONSTANT);
+  if (prec == 0)
+    prec = mpfr_get_default_prec ();
+  _calc_value_init_fr (fr, prec);
+  mpfr_set (fr, calc_value_const_get (constant, prec), MPFR_RNDN);
+  _calc_value_take_fr (self, fr);
+}
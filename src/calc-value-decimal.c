@@ -0,0 +1,603 @@
+/*************************************************************************
+ * calc-value-decimal.c -- This file is part of libcalc.                 *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+
+#define _LIBCALC_INTERNAL
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+#include "calc-value.h"
+
+#define ABS_SMALL(x) ((x) < 0 ? -(gulong) (x) : (gulong) (x))
+
+/* Number of powers of ten in calc_value_pow10 */
+#define CALC_VALUE_POW10_COUNT 19
+
+typedef void (*CalcValueBinaryFunc) (CalcValue *, const CalcValue *,
+				     const CalcValue *);
+
+/* Rounding mode of the current thread, stored directly in the pointer */
+static GPrivate calc_value_decimal_round;
+
+static const gint64 calc_value_pow10[CALC_VALUE_POW10_COUNT] = {
+  G_GINT64_CONSTANT (1),
+  G_GINT64_CONSTANT (10),
+  G_GINT64_CONSTANT (100),
+  G_GINT64_CONSTANT (1000),
+  G_GINT64_CONSTANT (10000),
+  G_GINT64_CONSTANT (100000),
+  G_GINT64_CONSTANT (1000000),
+  G_GINT64_CONSTANT (10000000),
+  G_GINT64_CONSTANT (100000000),
+  G_GINT64_CONSTANT (1000000000),
+  G_GINT64_CONSTANT (10000000000),
+  G_GINT64_CONSTANT (100000000000),
+  G_GINT64_CONSTANT (1000000000000),
+  G_GINT64_CONSTANT (10000000000000),
+  G_GINT64_CONSTANT (100000000000000),
+  G_GINT64_CONSTANT (1000000000000000),
+  G_GINT64_CONSTANT (10000000000000000),
+  G_GINT64_CONSTANT (100000000000000000),
+  G_GINT64_CONSTANT (1000000000000000000)
+};
+
+/* Gets the coefficient of a decimal or an integer if it is stored inline */
+
+static gboolean
+calc_value_decimal_word (const CalcValue *self, glong *coefficient)
+{
+  if (self->small)
+    *coefficient = self->small_num;
+  else if (self->type == CALC_NUMBER_TYPE_DECIMAL && !self->wide)
+    *coefficient = self->decimal;
+  else
+    return FALSE;
+  return TRUE;
+}
+
+static guint
+calc_value_decimal_scale (const CalcValue *self)
+{
+  return self->type == CALC_NUMBER_TYPE_DECIMAL ? self->scale : 0;
+}
+
+/* Multiplies @coefficient by 10 raised to @shift, returning FALSE if the
+   result does not fit in a word */
+
+static gboolean
+calc_value_decimal_shift (glong *result, glong coefficient, guint shift)
+{
+  if (shift >= CALC_VALUE_POW10_COUNT || calc_value_pow10[shift] > G_MAXLONG)
+    return FALSE;
+  return !__builtin_mul_overflow (coefficient, (glong) calc_value_pow10[shift],
+				  result);
+}
+
+/* Decides whether a quotient truncated towards zero must be moved one unit
+   away from zero. @sign is the sign of the exact quotient, @half compares
+   the remainder with half the divisor and @odd is whether the truncated
+   quotient is odd. */
+
+static gboolean
+calc_value_decimal_round_away (gint sign, gint half, gboolean odd)
+{
+  switch (calc_value_get_decimal_round ())
+    {
+    case CALC_DECIMAL_ROUND_DOWN:
+      return FALSE;
+    case CALC_DECIMAL_ROUND_UP:
+      return TRUE;
+    case CALC_DECIMAL_ROUND_FLOOR:
+      return sign < 0;
+    case CALC_DECIMAL_ROUND_CEILING:
+      return sign > 0;
+    case CALC_DECIMAL_ROUND_HALF_UP:
+      return half >= 0;
+    default:
+      return half > 0 || (half == 0 && odd);
+    }
+}
+
+/* Sets @q to @n / @d rounded to an integer */
+
+static void
+calc_value_decimal_round_div (mpz_ptr q, mpz_srcptr n, mpz_srcptr d)
+{
+  gint sign = mpz_sgn (n) * mpz_sgn (d);
+  gint half;
+  mpz_t r;
+  _calc_value_init_z (r);
+  mpz_tdiv_qr (q, r, n, d);
+  if (mpz_sgn (r) != 0)
+    {
+      mpz_mul_2exp (r, r, 1);
+      half = mpz_cmpabs (r, d);
+      if (calc_value_decimal_round_away (sign, half, mpz_odd_p (q)))
+	{
+	  if (sign < 0)
+	    mpz_sub_ui (q, q, 1);
+	  else
+	    mpz_add_ui (q, q, 1);
+	}
+    }
+  _calc_value_clear_z (r);
+}
+
+/* Sets @q to @n / @d rounded to an integer if it fits in a word */
+
+static gboolean
+calc_value_decimal_round_div_word (glong *q, glong n, glong d)
+{
+  gint sign = (n < 0) != (d < 0) ? -1 : 1;
+  gulong r;
+  gulong m;
+  if (d == 0 || (n == G_MINLONG && d == -1))
+    return FALSE;
+  *q = n / d;
+  r = ABS_SMALL (n % d);
+  if (r == 0)
+    return TRUE;
+  m = ABS_SMALL (d) - r;
+  if (calc_value_decimal_round_away (sign, (r > m) - (r < m), *q & 1))
+    *q += sign;
+  return TRUE;
+}
+
+/* Computes @func of @a and @b when the result is not a decimal, treating
+   any decimal operand as the rational number it represents */
+
+static void
+calc_value_decimal_mixed (CalcValue *result, const CalcValue *a,
+			  const CalcValue *b, CalcValueBinaryFunc func)
+{
+  CalcValue ta;
+  CalcValue tb;
+  const CalcValue *qa = _calc_value_decimal_to_q (a, &ta);
+  const CalcValue *qb = _calc_value_decimal_to_q (b, &tb);
+  func (result, qa, qb);
+  if (qa == &ta)
+    calc_value_clear (&ta);
+  if (qb == &tb)
+    calc_value_clear (&tb);
+}
+
+/**
+ * calc_value_set_decimal_round:
+ * @mode: the rounding mode
+ *
+ * Sets the rounding mode used by the calling thread when a decimal result
+ * has more digits after the decimal point than its scale allows, such as a
+ * quotient or a value passed to calc_value_quantize(). The default mode is
+ * %CALC_DECIMAL_ROUND_HALF_EVEN.
+ **/
+
+void
+calc_value_set_decimal_round (CalcDecimalRound mode)
+{
+  g_return_if_fail (mode >= 0 && mode < N_CALC_DECIMAL_ROUND);
+  g_private_set (&calc_value_decimal_round, GINT_TO_POINTER (mode));
+}
+
+/**
+ * calc_value_get_decimal_round:
+ *
+ * Gets the rounding mode of the calling thread set by
+ * calc_value_set_decimal_round().
+ *
+ * Returns: the rounding mode
+ **/
+
+CalcDecimalRound
+calc_value_get_decimal_round (void)
+{
+  return GPOINTER_TO_INT (g_private_get (&calc_value_decimal_round));
+}
+
+/**
+ * calc_value_quantize:
+ * @result: where to store the result
+ * @self: the value
+ * @scale: the number of digits after the decimal point
+ *
+ * Sets the value of @result to the decimal with @scale digits after the
+ * decimal point nearest to @self, rounding with the mode set by
+ * calc_value_set_decimal_round(). The conversion is exact if @self has no
+ * more digits than @scale, so quantizing the parsed string "12.5" to a
+ * scale of 2 gives 12.50. If @self is not finite or @scale is greater than
+ * %CALC_VALUE_DECIMAL_MAX_SCALE, no action is performed.
+ **/
+
+void
+calc_value_quantize (CalcValue *result, const CalcValue *self, guint scale)
+{
+  CalcValueView view;
+  mpfr_srcptr fr;
+  mpfr_exp_t exp;
+  guint from;
+  mpq_t q;
+  g_return_if_fail (scale <= CALC_VALUE_DECIMAL_MAX_SCALE);
+
+  switch (self->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+    case CALC_NUMBER_TYPE_RATIONAL:
+      _calc_value_set_decimal_q (result, _calc_value_get_q (self, &view),
+				 scale);
+      break;
+    case CALC_NUMBER_TYPE_DECIMAL:
+      _calc_value_init_q (q);
+      mpz_set (mpq_numref (q), _calc_value_get_dec (self, &view, &from));
+      mpz_ui_pow_ui (mpq_denref (q), 10, from);
+      _calc_value_set_decimal_q (result, q, scale);
+      _calc_value_clear_q (q);
+      break;
+    case CALC_NUMBER_TYPE_DOUBLE:
+    case CALC_NUMBER_TYPE_FLOATING:
+      /* Floating-point numbers are dyadic rationals, so they can be
+	 converted exactly before rounding once */
+      fr = _calc_value_get_fr (self, &view);
+      g_return_if_fail (mpfr_number_p (fr));
+      /* The exponent of zero is the smallest one MPFR has, which would
+	 make a huge denominator */
+      if (mpfr_zero_p (fr))
+	{
+	  _calc_value_release (result);
+	  _calc_value_set_decimal (result, 0, scale);
+	  break;
+	}
+      _calc_value_init_q (q);
+      exp = mpfr_get_z_2exp (mpq_numref (q), fr);
+      mpz_set_ui (mpq_denref (q), 1);
+      if (exp >= 0)
+	mpz_mul_2exp (mpq_numref (q), mpq_numref (q), exp);
+      else
+	mpz_mul_2exp (mpq_denref (q), mpq_denref (q), -exp);
+      _calc_value_set_decimal_q (result, q, scale);
+      _calc_value_clear_q (q);
+      break;
+    }
+}
+
+/* Sets @result to the decimal with @scale digits nearest to @value, which
+   need not be in lowest terms */
+
+void
+_calc_value_set_decimal_q (CalcValue *result, mpq_srcptr value, guint scale)
+{
+  mpz_t coefficient;
+  mpz_t num;
+  _calc_value_init_z (coefficient);
+  _calc_value_init_z (num);
+  mpz_ui_pow_ui (num, 10, scale);
+  mpz_mul (num, num, mpq_numref (value));
+  calc_value_decimal_round_div (coefficient, num, mpq_denref (value));
+  _calc_value_clear_z (num);
+  _calc_value_take_dec (result, coefficient, scale);
+}
+
+/* Returns @self, or a copy of it as a rational number in @temp if it is a
+   decimal, in which case the caller must clear @temp */
+
+const CalcValue *
+_calc_value_decimal_to_q (const CalcValue *self, CalcValue *temp)
+{
+  if (self->type != CALC_NUMBER_TYPE_DECIMAL)
+    return self;
+  calc_value_init_set (temp, self);
+  calc_value_cast (temp, CALC_NUMBER_TYPE_RATIONAL);
+  return temp;
+}
+
+/* These functions compute results where at least one operand is a decimal.
+   When the other operand is an integer or a decimal, the coefficients are
+   combined directly, in a word if they fit and with GNU MP otherwise. */
+
+void
+_calc_value_decimal_add (CalcValue *result, const CalcValue *a,
+			 const CalcValue *b, gboolean negate)
+{
+  CalcValueView va;
+  CalcValueView vb;
+  guint sa = calc_value_decimal_scale (a);
+  guint sb = calc_value_decimal_scale (b);
+  guint scale = MAX (sa, sb);
+  glong x;
+  glong y;
+  glong n;
+  mpz_t z;
+  mpz_t t;
+
+  if (_calc_value_get_final_type (a->type, b->type)
+      != CALC_NUMBER_TYPE_DECIMAL)
+    {
+      calc_value_decimal_mixed (result, a, b,
+				negate ? calc_value_sub : calc_value_add);
+      return;
+    }
+
+  if (calc_value_decimal_word (a, &x) && calc_value_decimal_word (b, &y)
+      && calc_value_decimal_shift (&x, x, scale - sa)
+      && calc_value_decimal_shift (&y, y, scale - sb)
+      && !(negate ? __builtin_sub_overflow (x, y, &n)
+	   : __builtin_add_overflow (x, y, &n)))
+    {
+      _calc_value_release (result);
+      _calc_value_set_decimal (result, n, scale);
+      return;
+    }
+
+  _calc_value_init_z (z);
+  _calc_value_init_z (t);
+  mpz_ui_pow_ui (t, 10, scale - sa);
+  mpz_mul (z, t, _calc_value_get_dec (a, &va, &sa));
+  mpz_ui_pow_ui (t, 10, scale - sb);
+  mpz_mul (t, t, _calc_value_get_dec (b, &vb, &sb));
+  if (negate)
+    mpz_sub (z, z, t);
+  else
+    mpz_add (z, z, t);
+  _calc_value_clear_z (t);
+  _calc_value_take_dec (result, z, scale);
+}
+
+void
+_calc_value_decimal_mul (CalcValue *result, const CalcValue *a,
+			 const CalcValue *b)
+{
+  CalcValueView va;
+  CalcValueView vb;
+  guint sa = calc_value_decimal_scale (a);
+  guint sb = calc_value_decimal_scale (b);
+  guint scale = sa + sb;
+  glong x;
+  glong y;
+  glong n;
+  mpz_t z;
+  mpz_t t;
+
+  if (_calc_value_get_final_type (a->type, b->type)
+      != CALC_NUMBER_TYPE_DECIMAL)
+    {
+      calc_value_decimal_mixed (result, a, b, calc_value_mul);
+      return;
+    }
+
+  if (scale <= CALC_VALUE_DECIMAL_MAX_SCALE
+      && calc_value_decimal_word (a, &x) && calc_value_decimal_word (b, &y)
+      && !__builtin_mul_overflow (x, y, &n))
+    {
+      _calc_value_release (result);
+      _calc_value_set_decimal (result, n, scale);
+      return;
+    }
+
+  _calc_value_init_z (z);
+  mpz_mul (z, _calc_value_get_dec (a, &va, &sa),
+	   _calc_value_get_dec (b, &vb, &sb));
+  if (scale > CALC_VALUE_DECIMAL_MAX_SCALE)
+    {
+      _calc_value_init_z (t);
+      mpz_ui_pow_ui (t, 10, scale - CALC_VALUE_DECIMAL_MAX_SCALE);
+      calc_value_decimal_round_div (z, z, t);
+      _calc_value_clear_z (t);
+      scale = CALC_VALUE_DECIMAL_MAX_SCALE;
+    }
+  _calc_value_take_dec (result, z, scale);
+}
+
+/* The quotient has the larger scale of the operands. Its coefficient is
+   a * 10^sb * 10^scale / (b * 10^sa), where a and b are the coefficients of
+   the operands and sa and sb their scales. */
+
+void
+_calc_value_decimal_div (CalcValue *result, const CalcValue *a,
+			 const CalcValue *b)
+{
+  CalcValueView va;
+  CalcValueView vb;
+  guint sa = calc_value_decimal_scale (a);
+  guint sb = calc_value_decimal_scale (b);
+  guint scale = MAX (sa, sb);
+  glong x;
+  glong y;
+  glong n;
+  mpz_t z;
+
+  if (_calc_value_get_final_type (a->type, b->type)
+      != CALC_NUMBER_TYPE_DECIMAL)
+    {
+      calc_value_decimal_mixed (result, a, b, calc_value_div);
+      return;
+    }
+
+  if (calc_value_decimal_word (a, &x) && calc_value_decimal_word (b, &y)
+      && calc_value_decimal_shift (&x, x, scale + sb - sa)
+      && calc_value_decimal_round_div_word (&n, x, y))
+    {
+      _calc_value_release (result);
+      _calc_value_set_decimal (result, n, scale);
+      return;
+    }
+
+  /* Let GNU MP handle division by zero */
+  _calc_value_init_z (z);
+  mpz_ui_pow_ui (z, 10, scale + sb - sa);
+  mpz_mul (z, z, _calc_value_get_dec (a, &va, &sa));
+  calc_value_decimal_round_div (z, z, _calc_value_get_dec (b, &vb, &sb));
+  _calc_value_take_dec (result, z, scale);
+}
+
+gint
+_calc_value_decimal_cmp (const CalcValue *a, const CalcValue *b)
+{
+  CalcValueView va;
+  CalcValueView vb;
+  guint sa = calc_value_decimal_scale (a);
+  guint sb = calc_value_decimal_scale (b);
+  guint scale = MAX (sa, sb);
+  CalcValue ta;
+  CalcValue tb;
+  const CalcValue *qa;
+  const CalcValue *qb;
+  glong x;
+  glong y;
+  mpz_t t;
+  mpz_t z;
+  gint result;
+
+  if (_calc_value_get_final_type (a->type, b->type)
+      != CALC_NUMBER_TYPE_DECIMAL)
+    {
+      qa = _calc_value_decimal_to_q (a, &ta);
+      qb = _calc_value_decimal_to_q (b, &tb);
+      result = calc_value_cmp (qa, qb);
+      if (qa == &ta)
+	calc_value_clear (&ta);
+      if (qb == &tb)
+	calc_value_clear (&tb);
+      return result;
+    }
+
+  if (calc_value_decimal_word (a, &x) && calc_value_decimal_word (b, &y)
+      && calc_value_decimal_shift (&x, x, scale - sa)
+      && calc_value_decimal_shift (&y, y, scale - sb))
+    return (x > y) - (x < y);
+
+  _calc_value_init_z (t);
+  _calc_value_init_z (z);
+  mpz_ui_pow_ui (t, 10, scale - sa);
+  mpz_mul (z, t, _calc_value_get_dec (a, &va, &sa));
+  mpz_ui_pow_ui (t, 10, scale - sb);
+  mpz_mul (t, t, _calc_value_get_dec (b, &vb, &sb));
+  result = mpz_cmp (z, t);
+  _calc_value_clear_z (t);
+  _calc_value_clear_z (z);
+  return result;
+}
+
+void
+_calc_value_decimal_neg (CalcValue *result, const CalcValue *self,
+			 gboolean abs)
+{
+  CalcValueView view;
+  guint scale = self->scale;
+  glong n;
+  mpz_t z;
+
+  if (!self->wide && self->decimal != G_MINLONG)
+    {
+      n = abs ? ABS (self->decimal) : -self->decimal;
+      _calc_value_release (result);
+      _calc_value_set_decimal (result, n, scale);
+      return;
+    }
+
+  _calc_value_init_z (z);
+  if (abs)
+    mpz_abs (z, _calc_value_get_dec (self, &view, &scale));
+  else
+    mpz_neg (z, _calc_value_get_dec (self, &view, &scale));
+  _calc_value_take_dec (result, z, scale);
+}
+
+/* The product is added to the negated addend through an accumulator, so
+   that a product whose scale is too large is rounded only once */
+
+void
+_calc_value_decimal_fma (CalcValue *result, const CalcValue *a,
+			 const CalcValue *b, const CalcValue *c,
+			 gboolean negate)
+{
+  CalcValueAcc acc;
+  CalcValue ta;
+  CalcValue tb;
+  CalcValue tc;
+  const CalcValue *qa;
+  const CalcValue *qb;
+  const CalcValue *qc;
+
+  if (_calc_value_get_final_type (_calc_value_get_final_type (a->type,
+							      b->type),
+				  c->type) != CALC_NUMBER_TYPE_DECIMAL)
+    {
+      qa = _calc_value_decimal_to_q (a, &ta);
+      qb = _calc_value_decimal_to_q (b, &tb);
+      qc = _calc_value_decimal_to_q (c, &tc);
+      if (negate)
+	calc_value_fms (result, qa, qb, qc);
+      else
+	calc_value_fma (result, qa, qb, qc);
+      if (qa == &ta)
+	calc_value_clear (&ta);
+      if (qb == &tb)
+	calc_value_clear (&tb);
+      if (qc == &tc)
+	calc_value_clear (&tc);
+      return;
+    }
+
+  _calc_value_acc_init (&acc);
+  _calc_value_acc_addmul (&acc, a, b);
+  if (negate)
+    {
+      calc_value_init (&tc);
+      calc_value_neg (&tc, c);
+      _calc_value_acc_add (&acc, &tc);
+      calc_value_clear (&tc);
+    }
+  else
+    _calc_value_acc_add (&acc, c);
+  _calc_value_acc_finish (&acc, result);
+}
+
+/* Appends the digits of a decimal to @str, with leading zeros so that there
+   is always a digit before the decimal point */
+
+void
+_calc_value_decimal_print (const CalcValue *self, GString *str)
+{
+  CalcValueView view;
+  mpz_srcptr coefficient;
+  mpz_t magnitude;
+  guint scale;
+  gsize start;
+  gsize digits;
+
+  coefficient = _calc_value_get_dec (self, &view, &scale);
+  if (mpz_sgn (coefficient) < 0)
+    g_string_append_c (str, '-');
+
+  /* The magnitude shares the limbs of the coefficient */
+  mpz_roinit_n (magnitude, mpz_limbs_read (coefficient),
+		mpz_size (coefficient));
+  start = str->len;
+  g_string_set_size (str, start + mpz_sizeinbase (magnitude, 10) + 1);
+  mpz_get_str (str->str + start, 10, magnitude);
+  digits = strlen (str->str + start);
+  g_string_truncate (str, start + digits);
+  if (scale == 0)
+    return;
+  while (digits <= scale)
+    {
+      g_string_insert_c (str, start, '0');
+      digits++;
+    }
+  g_string_insert_c (str, str->len - scale, '.');
+}
@@ -0,0 +1,682 @@
+/*************************************************************************
+ * calc-value-div.c -- This file is part of libcalc.                    *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+
+#define _LIBCALC_INTERNAL
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <float.h>
+#include "calc-value.h"
+
+/* Divides an exact number by a floating point number with only one rounding
+   step. The numerator and the product of the denominator and @b are both
+   computed exactly. */
+
+static void
+calc_value_q_div_fr (mpfr_ptr result, mpq_srcptr a, mpfr_srcptr b)
+{
+  mpfr_t num;
+  mpfr_t den;
+  mpfr_init2 (num, MAX (mpz_sizeinbase (mpq_numref (a), 2), MPFR_PREC_MIN));
+  mpfr_init2 (den, mpfr_get_prec (b) + mpz_sizeinbase (mpq_denref (a), 2));
+  mpfr_set_z (num, mpq_numref (a), MPFR_RNDN);
+  mpfr_mul_z (den, b, mpq_denref (a), MPFR_RNDN);
+  mpfr_div (result, num, den, MPFR_RNDN);
+  mpfr_clears (num, den, NULL);
+}
+
+/* Divides the integer @a by @b and stores the result in @result. The
+   quotient and remainder are found with a single division. If the
+   remainder is nonzero, the fraction is reduced with one GCD of @b and the
+   remainder, which is cheaper than a GCD of @a and @b and gives the same
+   result. */
+
+static void
+calc_value_z_div_z (CalcValue *result, mpz_srcptr a, mpz_srcptr b)
+{
+  mpz_t quot;
+  mpz_t rem;
+  mpq_t q;
+
+  _calc_value_init_z (quot);
+  _calc_value_init_z (rem);
+  mpz_tdiv_qr (quot, rem, a, b);
+  if (mpz_sgn (rem) == 0)
+    {
+      _calc_value_clear_z (rem);
+      _calc_value_take_z (result, quot);
+      return;
+    }
+
+  /* a/b = (quot * b/g + rem/g) / (b/g), using the numerator to hold g */
+  _calc_value_init_q (q);
+  mpz_gcd (mpq_numref (q), b, rem);
+  mpz_divexact (mpq_denref (q), b, mpq_numref (q));
+  mpz_divexact (rem, rem, mpq_numref (q));
+  mpz_mul (mpq_numref (q), quot, mpq_denref (q));
+  mpz_add (mpq_numref (q), mpq_numref (q), rem);
+  if (mpz_sgn (mpq_denref (q)) < 0)
+    {
+      mpz_neg (mpq_numref (q), mpq_numref (q));
+      mpz_neg (mpq_denref (q), mpq_denref (q));
+    }
+  _calc_value_clear_z (quot);
+  _calc_value_clear_z (rem);
+  _calc_value_take_q (result, q);
+}
+
+/* Same as calc_value_z_div_z(), but with a word-sized divisor */
+
+static void
+calc_value_z_div_ui (CalcValue *result, mpz_srcptr a, unsigned long b)
+{
+  unsigned long rem;
+  unsigned long gcd;
+  mpz_t quot;
+  mpq_t q;
+
+  _calc_value_init_z (quot);
+  rem = mpz_tdiv_q_ui (quot, a, b);
+  if (rem == 0)
+    {
+      _calc_value_take_z (result, quot);
+      return;
+    }
+
+  _calc_value_init_q (q);
+  mpz_set_ui (mpq_denref (q), b);
+  gcd = mpz_gcd_ui (NULL, mpq_denref (q), rem);
+  mpz_set_ui (mpq_denref (q), b / gcd);
+  mpz_mul_ui (mpq_numref (q), quot, b / gcd);
+  if (mpz_sgn (a) < 0)
+    mpz_sub_ui (mpq_numref (q), mpq_numref (q), rem / gcd);
+  else
+    mpz_add_ui (mpq_numref (q), mpq_numref (q), rem / gcd);
+  _calc_value_clear_z (quot);
+  _calc_value_take_q (result, q);
+}
+
+/**
+ * calc_value_div:
+ * @result: where to store the result of the division
+ * @a: the dividend
+ * @b: the divisor
+ *
+ * Divides @a by @b and stores the result in @result. Any previous value in
+ * @result will be erased. The type of @result is dependent on the types of
+ * @a and @b.
+ **/
+
+void
+calc_value_div (CalcValue *result, const CalcValue *a, const CalcValue *b)
+{
+  CalcValueView va;
+  CalcValueView vb;
+  CalcNumberType type;
+  mpq_t q;
+  mpfr_t fr;
+
+  if (a->type == CALC_NUMBER_TYPE_DECIMAL
+      || b->type == CALC_NUMBER_TYPE_DECIMAL)
+    {
+      _calc_value_decimal_div (result, a, b);
+      return;
+    }
+
+  type = _calc_value_get_final_type (a->type, b->type);
+  if (a->small && b->small)
+    {
+      glong num;
+      gulong den;
+      if (_calc_value_small_div (&num, &den, a->small_num, a->small_den,
+				 b->small_num, b->small_den))
+	{
+	  if (type == CALC_NUMBER_TYPE_INTEGER && den != 1)
+	    type = CALC_NUMBER_TYPE_RATIONAL;
+	  _calc_value_release (result);
+	  _calc_value_set_small (result, type, num, den);
+	  return;
+	}
+    }
+
+  switch (type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      calc_value_z_div_z (result, _calc_value_get_z (a, &va),
+			  _calc_value_get_z (b, &vb));
+      break;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      _calc_value_init_q (q);
+      mpq_div (q, _calc_value_get_q (a, &va), _calc_value_get_q (b, &vb));
+      _calc_value_take_q (result, q);
+      break;
+    case CALC_NUMBER_TYPE_DOUBLE:
+      _calc_value_take_d (result, calc_value_get_double (a)
+			  / calc_value_get_double (b));
+      break;
+    case CALC_NUMBER_TYPE_FLOATING:
+      _calc_value_init_fr (fr,
+			   _calc_value_result_prec (a,
+						    calc_value_get_prec (b)));
+      switch (b->type)
+	{
+	case CALC_NUMBER_TYPE_INTEGER:
+	  mpfr_div_z (fr, a->floating, _calc_value_get_z (b, &vb),
+		      MPFR_RNDN);
+	  break;
+	case CALC_NUMBER_TYPE_RATIONAL:
+	  mpfr_div_q (fr, a->floating, _calc_value_get_q (b, &vb),
+		      MPFR_RNDN);
+	  break;
+	case CALC_NUMBER_TYPE_DOUBLE:
+	  mpfr_div (fr, a->floating, _calc_value_get_fr (b, &vb), MPFR_RNDN);
+	  break;
+	case CALC_NUMBER_TYPE_FLOATING:
+	  if (!_calc_value_type_is_exact (a->type))
+	    mpfr_div (fr, _calc_value_get_fr (a, &va), b->floating,
+		      MPFR_RNDN);
+	  else
+	    calc_value_q_div_fr (fr, _calc_value_get_q (a, &va),
+				 b->floating);
+	  break;
+	}
+      _calc_value_take_fr (result, fr);
+      break;
+    }
+}
+
+/**
+ * calc_value_div_z:
+ * @result: where to store the result of the division
+ * @a: the dividend
+ * @b: the divisor
+ *
+ * Divides @a by @b and stores the result in @result. Any previous value in
+ * @result will be erased. The type of @result is dependent on the types of
+ * @a and @b.
+ **/
+
+void
+calc_value_div_z (CalcValue *result, const CalcValue *a, mpz_t b)
+{
+  CalcValue saved;
+  CalcValueView view;
+  mpq_t rb;
+
+  /* Decimals are handled by the generic function */
+  if (a->type == CALC_NUMBER_TYPE_DECIMAL)
+    {
+      CalcValue value;
+      calc_value_init_z (&value, b);
+      calc_value_div (result, a, &value);
+      calc_value_clear (&value);
+      return;
+    }
+
+  if (a->type == CALC_NUMBER_TYPE_DOUBLE)
+    {
+      _calc_value_take_d (result, a->native / _calc_value_get_d_z (b));
+      return;
+    }
+
+  a = _calc_value_prepare (result, a, &saved);
+  switch (a->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      calc_value_z_div_z (result, _calc_value_get_z (a, &view), b);
+      break;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      result->type = CALC_NUMBER_TYPE_RATIONAL;
+      _calc_value_init_q (result->rational);
+      mpq_init (rb);
+      mpq_set_z (rb, b);
+      mpq_div (result->rational, _calc_value_get_q (a, &view), rb);
+      mpq_clear (rb);
+      break;
+    case CALC_NUMBER_TYPE_FLOATING:
+      result->type = CALC_NUMBER_TYPE_FLOATING;
+      _calc_value_init_fr (result->floating, _calc_value_result_prec (a, 0));
+      mpfr_div_z (result->floating, a->floating, b, MPFR_RNDN);
+      break;
+    }
+  _calc_value_shrink (result);
+  if (a == &saved)
+    calc_value_clear (&saved);
+}
+
+/**
+ * calc_value_div_q:
+ * @result: where to store the result of the division
+ * @a: the dividend
+ * @b: the divisor
+ *
+ * Divides @a by @b and stores the result in @result. Any previous value in
+ * @result will be erased. The type of @result is dependent on the types of
+ * @a and @b.
+ **/
+
+void
+calc_value_div_q (CalcValue *result, const CalcValue *a, mpq_t b)
+{
+  CalcValue saved;
+  CalcValueView view;
+
+  /* Decimals are handled by the generic function */
+  if (a->type == CALC_NUMBER_TYPE_DECIMAL)
+    {
+      CalcValue value;
+      calc_value_init_q (&value, b);
+      calc_value_div (result, a, &value);
+      calc_value_clear (&value);
+      return;
+    }
+
+  if (a->type == CALC_NUMBER_TYPE_DOUBLE)
+    {
+      _calc_value_take_d (result, a->native / _calc_value_get_d_q (b));
+      return;
+    }
+
+  a = _calc_value_prepare (result, a, &saved);
+  result->type = a->type;
+  switch (a->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      result->type = CALC_NUMBER_TYPE_RATIONAL;
+      _calc_value_init_q (result->rational);
+      mpq_set_z (result->rational, _calc_value_get_z (a, &view));
+      mpq_div (result->rational, result->rational, b);
+      break;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      _calc_value_init_q (result->rational);
+      mpq_div (result->rational, _calc_value_get_q (a, &view), b);
+      break;
+    case CALC_NUMBER_TYPE_FLOATING:
+      _calc_value_init_fr (result->floating, _calc_value_result_prec (a, 0));
+      mpfr_div_q (result->floating, a->floating, b, MPFR_RNDN);
+      break;
+    }
+  _calc_value_shrink (result);
+  if (a == &saved)
+    calc_value_clear (&saved);
+}
+
+/**
+ * calc_value_div_f:
+ * @result: where to store the result of the division
+ * @a: the dividend
+ * @b: the divisor
+ *
+ * Divides @a by @b and stores the result in @result. Any previous value in
+ * @result will be erased. The type of @result is dependent on the types of
+ * @a and @b.
+ **/
+
+void
+calc_value_div_f (CalcValue *result, const CalcValue *a, mpf_t b)
+{
+  mpfr_t temp;
+  mpfr_init2 (temp, mpf_get_prec (b));
+  mpfr_set_f (temp, b, MPFR_RNDN);
+  calc_value_div_fr (result, a, temp);
+  mpfr_clear (temp);
+}
+
+/**
+ * calc_value_div_fr:
+ * @result: where to store the result of the division
+ * @a: the dividend
+ * @b: the divisor
+ *
+ * Divides @a by @b and stores the result in @result. Any previous value in
+ * @result will be erased. The type of @result is dependent on the types of
+ * @a and @b.
+ **/
+
+void
+calc_value_div_fr (CalcValue *result, const CalcValue *a, mpfr_t b)
+{
+  CalcValue saved;
+  CalcValueView view;
+
+  /* Decimals are handled by the generic function */
+  if (a->type == CALC_NUMBER_TYPE_DECIMAL)
+    {
+      CalcValue value;
+      calc_value_init_fr (&value, b);
+      calc_value_div (result, a, &value);
+      calc_value_clear (&value);
+      return;
+    }
+
+  a = _calc_value_prepare (result, a, &saved);
+  result->type = CALC_NUMBER_TYPE_FLOATING;
+  _calc_value_init_fr (result->floating,
+		       _calc_value_result_prec (a, mpfr_get_prec (b)));
+  switch (a->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      mpfr_set_z (result->floating, _calc_value_get_z (a, &view),
+		  MPFR_RNDN);
+      mpfr_div (result->floating, result->floating, b, MPFR_RNDN);
+      break;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      mpfr_set_q (result->floating, _calc_value_get_q (a, &view),
+		  MPFR_RNDN);
+      mpfr_div (result->floating, result->floating, b, MPFR_RNDN);
+      break;
+    case CALC_NUMBER_TYPE_DOUBLE:
+    case CALC_NUMBER_TYPE_FLOATING:
+      mpfr_div (result->floating, _calc_value_get_fr (a, &view), b,
+	       MPFR_RNDN);
+      break;
+    }
+  if (a == &saved)
+    calc_value_clear (&saved);
+}
+
+/**
+ * calc_value_div_d:
+ * @result: where to store the result of the division
+ * @a: the dividend
+ * @b: the divisor
+ *
+ * Divides @a by @b and stores the result in @result. Any previous value in
+ * @result will be erased. The type of @result is dependent on the types of
+ * @a and @b.
+ **/
+
+void
+calc_value_div_d (CalcValue *result, const CalcValue *a, double b)
+{
+  CalcValue saved;
+  CalcValueView view;
+
+  /* Decimals are handled by the generic function */
+  if (a->type == CALC_NUMBER_TYPE_DECIMAL)
+    {
+      CalcValue value;
+      calc_value_init_d (&value, b);
+      calc_value_div (result, a, &value);
+      calc_value_clear (&value);
+      return;
+    }
+
+  if (a->type == CALC_NUMBER_TYPE_DOUBLE)
+    {
+      _calc_value_take_d (result, a->native / b);
+      return;
+    }
+
+  a = _calc_value_prepare (result, a, &saved);
+  result->type = CALC_NUMBER_TYPE_FLOATING;
+  _calc_value_init_fr (result->floating,
+		       _calc_value_result_prec (a, DBL_MANT_DIG));
+  switch (a->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      mpfr_set_z (result->floating, _calc_value_get_z (a, &view),
+		  MPFR_RNDN);
+      mpfr_div_d (result->floating, result->floating, b, MPFR_RNDN);
+      break;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      mpfr_set_q (result->floating, _calc_value_get_q (a, &view),
+		  MPFR_RNDN);
+      mpfr_div_d (result->floating, result->floating, b, MPFR_RNDN);
+      break;
+    case CALC_NUMBER_TYPE_FLOATING:
+      mpfr_div_d (result->floating, a->floating, b, MPFR_RNDN);
+      break;
+    }
+  if (a == &saved)
+    calc_value_clear (&saved);
+}
+
+/**
+ * calc_value_div_ui:
+ * @result: where to store the result of the division
+ * @a: the dividend
+ * @b: the divisor
+ *
+ * Divides @a by @b and stores the result in @result. Any previous value in
+ * @result will be erased. The type of @result is dependent on the types of
+ * @a and @b.
+ **/
+
+void
+calc_value_div_ui (CalcValue *result, const CalcValue *a, unsigned long b)
+{
+  CalcValue saved;
+  CalcValueView view;
+  mpq_t rb;
+
+  /* Decimals are handled by the generic function */
+  if (a->type == CALC_NUMBER_TYPE_DECIMAL)
+    {
+      CalcValue value;
+      calc_value_init_ui (&value, b);
+      calc_value_div (result, a, &value);
+      calc_value_clear (&value);
+      return;
+    }
+
+  if (a->type == CALC_NUMBER_TYPE_DOUBLE)
+    {
+      _calc_value_take_d (result, a->native / b);
+      return;
+    }
+
+  if (a->small && b <= G_MAXLONG)
+    {
+      CalcNumberType type = a->type;
+      glong num;
+      gulong den;
+      if (_calc_value_small_div (&num, &den, a->small_num, a->small_den,
+				 (glong) b, 1))
+	{
+	  if (type == CALC_NUMBER_TYPE_INTEGER && den != 1)
+	    type = CALC_NUMBER_TYPE_RATIONAL;
+	  _calc_value_release (result);
+	  _calc_value_set_small (result, type, num, den);
+	  return;
+	}
+    }
+
+  a = _calc_value_prepare (result, a, &saved);
+  switch (a->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      calc_value_z_div_ui (result, _calc_value_get_z (a, &view), b);
+      break;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      result->type = CALC_NUMBER_TYPE_RATIONAL;
+      _calc_value_init_q (result->rational);
+      mpq_init (rb);
+      mpq_set_ui (rb, b, 1);
+      mpq_div (result->rational, _calc_value_get_q (a, &view), rb);
+      mpq_clear (rb);
+      break;
+    case CALC_NUMBER_TYPE_FLOATING:
+      result->type = CALC_NUMBER_TYPE_FLOATING;
+      _calc_value_init_fr (result->floating, _calc_value_result_prec (a, 0));
+      mpfr_div_ui (result->floating, a->floating, b, MPFR_RNDN);
+      break;
+    }
+  _calc_value_shrink (result);
+  if (a == &saved)
+    calc_value_clear (&saved);
+}
+
+/**
+ * calc_value_div_si:
+ * @result: where to store the result of the division
+ * @a: the dividend
+ * @b: the divisor
+ *
+ * Divides @a by @b and stores the result in @result. Any previous value in
+ * @result will be erased. The type of @result is dependent on the types of
+ * @a and @b.
+ **/
+
+void
+calc_value_div_si (CalcValue *result, const CalcValue *a, signed long b)
+{
+
+  /* Decimals are handled by the generic function */
+  if (a->type == CALC_NUMBER_TYPE_DECIMAL)
+    {
+      CalcValue value;
+      calc_value_init_si (&value, b);
+      calc_value_div (result, a, &value);
+      calc_value_clear (&value);
+      return;
+    }
+
+  if (a->type == CALC_NUMBER_TYPE_DOUBLE)
+    {
+      _calc_value_take_d (result, a->native / b);
+      return;
+    }
+
+  if (a->small)
+    {
+      CalcNumberType type = a->type;
+      glong num;
+      gulong den;
+      if (_calc_value_small_div (&num, &den, a->small_num, a->small_den, b,
+				 1))
+	{
+	  if (type == CALC_NUMBER_TYPE_INTEGER && den != 1)
+	    type = CALC_NUMBER_TYPE_RATIONAL;
+	  _calc_value_release (result);
+	  _calc_value_set_small (result, type, num, den);
+	  return;
+	}
+    }
+
+  if (b >= 0)
+    calc_value_div_ui (result, a, b);
+  else
+    {
+      calc_value_div_ui (result, a, -(unsigned long) b);
+      if (result->small && result->small_num != G_MINLONG)
+	{
+	  result->small_num = -result->small_num;
+	  return;
+	}
+      _calc_value_promote (result);
+      switch (result->type)
+	{
+	case CALC_NUMBER_TYPE_INTEGER:
+	  mpz_neg (result->integer, result->integer);
+	  break;
+	case CALC_NUMBER_TYPE_RATIONAL:
+	  mpq_neg (result->rational, result->rational);
+	  break;
+	case CALC_NUMBER_TYPE_FLOATING:
+	  mpfr_neg (result->floating, result->floating, MPFR_RNDN);
+	  break;
+	}
+      _calc_value_shrink (result);
+    }
+}
+
+/**
+ * calc_value_div_inplace:
+ * @self: the value to divide
+ * @value: the value to divide by
+ *
+ * Divides @self by @value and stores the result in @self. The result is the
+ * same as calling calc_value_div() with @self as both the result and the
+ * dividend, but the storage of @self is reused where possible. @value may
+ * be the same value as @self.
+ *
+ * A rational result is not reduced to lowest terms until it is read or
+ * calc_value_normalize() is called.
+ **/
+
+void
+calc_value_div_inplace (CalcValue *self, const CalcValue *value)
+{
+  CalcValueView view;
+
+  /* Integer quotients may change type, and division by zero and decimals
+     are left to the generic function */
+  if (self->small || value == self || calc_value_sgn (value) == 0
+      || _calc_value_get_final_type (self->type, value->type) != self->type
+      || self->type == CALC_NUMBER_TYPE_INTEGER
+      || self->type == CALC_NUMBER_TYPE_DECIMAL
+      || value->type == CALC_NUMBER_TYPE_DECIMAL)
+    {
+      calc_value_div (self, self, value);
+      return;
+    }
+
+  switch (self->type)
+    {
+    case CALC_NUMBER_TYPE_RATIONAL:
+      /* The quotient is not reduced until its value is needed */
+      if (value->type == CALC_NUMBER_TYPE_INTEGER)
+	mpz_mul (mpq_denref (self->rational), mpq_denref (self->rational),
+		 _calc_value_get_z (value, &view));
+      else
+	{
+	  mpq_srcptr q = _calc_value_get_q (value, &view);
+	  mpz_mul (mpq_numref (self->rational), mpq_numref (self->rational),
+		   mpq_denref (q));
+	  mpz_mul (mpq_denref (self->rational), mpq_denref (self->rational),
+		   mpq_numref (q));
+	}
+      if (calc_value_sgn (value) < 0)
+	{
+	  mpz_neg (mpq_numref (self->rational), mpq_numref (self->rational));
+	  mpz_neg (mpq_denref (self->rational), mpq_denref (self->rational));
+	}
+      _calc_value_defer_reduce (self);
+      break;
+    case CALC_NUMBER_TYPE_FLOATING:
+      /* Round to the precision the generic function would give first */
+      mpfr_prec_round (self->floating,
+		       _calc_value_result_prec (self,
+						calc_value_get_prec (value)),
+		       MPFR_RNDN);
+      switch (value->type)
+	{
+	case CALC_NUMBER_TYPE_INTEGER:
+	  mpfr_div_z (self->floating, self->floating,
+		      _calc_value_get_z (value, &view), MPFR_RNDN);
+	  break;
+	case CALC_NUMBER_TYPE_RATIONAL:
+	  mpfr_div_q (self->floating, self->floating,
+		      _calc_value_get_q (value, &view), MPFR_RNDN);
+	  break;
+	case CALC_NUMBER_TYPE_DOUBLE:
+	case CALC_NUMBER_TYPE_FLOATING:
+	  mpfr_div (self->floating, self->floating,
+		    _calc_value_get_fr (value, &view), MPFR_RNDN);
+	  break;
+	}
+      break;
+    case CALC_NUMBER_TYPE_DOUBLE:
+      self->native /= calc_value_get_double (value);
+      break;
+    }
+  _calc_value_shrink (self);
+}
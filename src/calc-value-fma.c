@@ -0,0 +1,554 @@
+/*************************************************************************
+ * calc-value-fma.c -- This file is part of libcalc.                     *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+
+#define _LIBCALC_INTERNAL
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <float.h>
+#include <math.h>
+#include "calc-value.h"
+
+#define ABS_SMALL(x) ((x) < 0 ? -(gulong) (x) : (gulong) (x))
+
+/* Extra precision used when a rational number has to be rounded before it
+   takes part in a floating-point operation */
+#define CALC_VALUE_GUARD_BITS (2 * GMP_NUMB_BITS)
+
+/* Gets @self as an MPFR number. Integers and doubles are converted exactly,
+   and rationals are rounded to @prec plus some guard bits. If @temp is
+   used to hold the converted value, it must be cleared by the caller. */
+
+static mpfr_srcptr
+calc_value_get_fr (const CalcValue *self, mpfr_ptr temp, mpfr_prec_t prec,
+		   gboolean *used)
+{
+  CalcValueView view;
+  mpz_srcptr z;
+  *used = self->type != CALC_NUMBER_TYPE_FLOATING;
+  switch (self->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      z = _calc_value_get_z (self, &view);
+      _calc_value_init_fr (temp, MAX (mpz_sizeinbase (z, 2), MPFR_PREC_MIN));
+      mpfr_set_z (temp, z, MPFR_RNDN);
+      return temp;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      _calc_value_init_fr (temp, prec + CALC_VALUE_GUARD_BITS);
+      mpfr_set_q (temp, _calc_value_get_q (self, &view), MPFR_RNDN);
+      return temp;
+    case CALC_NUMBER_TYPE_DOUBLE:
+      _calc_value_init_fr (temp, DBL_MANT_DIG);
+      mpfr_set_d (temp, self->native, MPFR_RNDN);
+      return temp;
+    default:
+      return self->floating;
+    }
+}
+
+/* Computes @a * @b + @c, or @a * @b - @c if @negate is set */
+
+static void
+calc_value_fma_common (CalcValue *result, const CalcValue *a,
+		       const CalcValue *b, const CalcValue *c, gboolean negate)
+{
+  CalcValueView va;
+  CalcValueView vb;
+  CalcValueView vc;
+  CalcNumberType type =
+    _calc_value_get_final_type (_calc_value_get_final_type (a->type,
+							    b->type),
+				c->type);
+  mpfr_prec_t prec;
+  mpz_t z;
+  mpq_t q;
+  mpfr_t fr;
+  mpfr_t temps[3];
+  gboolean used[3];
+  mpfr_srcptr fa;
+  mpfr_srcptr fb;
+  mpfr_srcptr fc;
+
+  if (a->type == CALC_NUMBER_TYPE_DECIMAL
+      || b->type == CALC_NUMBER_TYPE_DECIMAL
+      || c->type == CALC_NUMBER_TYPE_DECIMAL)
+    {
+      _calc_value_decimal_fma (result, a, b, c, negate);
+      return;
+    }
+
+  if (a->small && b->small && c->small)
+    {
+      glong pn;
+      gulong pd;
+      glong num;
+      gulong den;
+      if (_calc_value_small_mul (&pn, &pd, a->small_num, a->small_den,
+				 b->small_num, b->small_den)
+	  && (negate ? _calc_value_small_sub (&num, &den, pn, pd,
+					      c->small_num, c->small_den)
+	      : _calc_value_small_add (&num, &den, pn, pd, c->small_num,
+				       c->small_den)))
+	{
+	  _calc_value_release (result);
+	  _calc_value_set_small (result, type, num, den);
+	  return;
+	}
+    }
+
+  switch (type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      _calc_value_init_z (z);
+      if (negate)
+	mpz_neg (z, _calc_value_get_z (c, &vc));
+      else
+	mpz_set (z, _calc_value_get_z (c, &vc));
+      mpz_addmul (z, _calc_value_get_z (a, &va), _calc_value_get_z (b, &vb));
+      _calc_value_take_z (result, z);
+      break;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      _calc_value_init_q (q);
+      mpq_mul (q, _calc_value_get_q (a, &va), _calc_value_get_q (b, &vb));
+      if (negate)
+	mpq_sub (q, q, _calc_value_get_q (c, &vc));
+      else
+	mpq_add (q, q, _calc_value_get_q (c, &vc));
+      _calc_value_take_q (result, q);
+      break;
+    case CALC_NUMBER_TYPE_DOUBLE:
+      /* Negating the addend is exact, so fms(a, b, c) = fma(a, b, -c) */
+      _calc_value_take_d (result,
+			  fma (calc_value_get_double (a),
+			       calc_value_get_double (b),
+			       negate ? -calc_value_get_double (c)
+			       : calc_value_get_double (c)));
+      break;
+    case CALC_NUMBER_TYPE_FLOATING:
+      prec = _calc_value_result_prec (a, MAX (calc_value_get_prec (b),
+					      calc_value_get_prec (c)));
+      fa = calc_value_get_fr (a, temps[0], prec, &used[0]);
+      fb = calc_value_get_fr (b, temps[1], prec, &used[1]);
+      fc = calc_value_get_fr (c, temps[2], prec, &used[2]);
+      _calc_value_init_fr (fr, prec);
+      if (negate)
+	mpfr_fms (fr, fa, fb, fc, MPFR_RNDN);
+      else
+	mpfr_fma (fr, fa, fb, fc, MPFR_RNDN);
+      if (used[0])
+	_calc_value_clear_fr (temps[0]);
+      if (used[1])
+	_calc_value_clear_fr (temps[1]);
+      if (used[2])
+	_calc_value_clear_fr (temps[2]);
+      _calc_value_take_fr (result, fr);
+      break;
+    }
+}
+
+/**
+ * calc_value_fma:
+ * @result: where to store the result
+ * @a: the first multiplicand
+ * @b: the second multiplicand
+ * @c: the addend
+ *
+ * Computes @a * @b + @c and stores the result in @result. Any previous value
+ * in @result will be erased. The type of @result is dependent on the types of
+ * @a, @b and @c. Unlike a multiplication followed by an addition, a
+ * floating-point result is rounded only once, although rational operands
+ * are rounded first if any operand is a floating-point number.
+ **/
+
+void
+calc_value_fma (CalcValue *result, const CalcValue *a, const CalcValue *b,
+		const CalcValue *c)
+{
+  calc_value_fma_common (result, a, b, c, FALSE);
+}
+
+/**
+ * calc_value_fms:
+ * @result: where to store the result
+ * @a: the first multiplicand
+ * @b: the second multiplicand
+ * @c: the subtrahend
+ *
+ * Computes @a * @b - @c and stores the result in @result, rounding a
+ * floating-point result once like calc_value_fma().
+ **/
+
+void
+calc_value_fms (CalcValue *result, const CalcValue *a, const CalcValue *b,
+		const CalcValue *c)
+{
+  calc_value_fma_common (result, a, b, c, TRUE);
+}
+
+/**
+ * calc_value_dot:
+ * @result: where to store the result
+ * @a: (array length=n): the first array of values
+ * @b: (array length=n): the second array of values
+ * @n: the number of values in each array
+ *
+ * Computes the sum of the products of the corresponding elements of @a and
+ * @b and stores the result in @result. Any previous value in @result will be
+ * erased. If all of the values are integers or rationals, the result is
+ * exact. Otherwise, each product of floating-point numbers and integers is
+ * exact and the result is rounded only once. Rational operands are rounded
+ * before they take part in a floating-point sum.
+ **/
+
+void
+calc_value_dot (CalcValue *result, const CalcValue *a, const CalcValue *b,
+		gsize n)
+{
+  CalcValueAcc acc;
+  gsize i;
+  _calc_value_acc_init (&acc);
+  for (i = 0; i < n; i++)
+    _calc_value_acc_addmul (&acc, &a[i], &b[i]);
+  _calc_value_acc_finish (&acc, result);
+}
+
+void
+_calc_value_acc_init (CalcValueAcc *self)
+{
+  _calc_value_init_q (self->exact);
+  self->type = CALC_NUMBER_TYPE_INTEGER;
+  self->floating = NULL;
+  self->prec = 0;
+  self->scale = 0;
+}
+
+/* Adds @num / @den, which need not be in lowest terms, to the exact part of
+   the sum without reducing it */
+
+static void
+calc_value_acc_add_q (CalcValueAcc *self, mpz_srcptr num, mpz_srcptr den)
+{
+  mpz_ptr sn = mpq_numref (self->exact);
+  mpz_ptr sd = mpq_denref (self->exact);
+  if (mpz_cmp_ui (den, 1) == 0)
+    mpz_addmul (sn, num, sd);
+  else if (mpz_cmp_ui (sd, 1) == 0)
+    {
+      mpz_mul (sn, sn, den);
+      mpz_add (sn, sn, num);
+      mpz_set (sd, den);
+    }
+  else
+    {
+      mpz_mul (sn, sn, den);
+      mpz_addmul (sn, num, sd);
+      mpz_mul (sd, sd, den);
+      if (mpz_size (sn) > CALC_VALUE_UNREDUCED_MAX_LIMBS
+	  || mpz_size (sd) > CALC_VALUE_UNREDUCED_MAX_LIMBS)
+	mpq_canonicalize (self->exact);
+    }
+}
+
+/* Adds a decimal with the given coefficient and scale to the exact part of
+   the sum. The scale of a decimal sum is the largest scale of its terms. */
+
+static void
+calc_value_acc_add_dec (CalcValueAcc *self, mpz_srcptr coefficient,
+			guint scale)
+{
+  mpz_t den;
+  self->scale = MAX (self->scale, scale);
+  _calc_value_init_z (den);
+  mpz_ui_pow_ui (den, 10, scale);
+  calc_value_acc_add_q (self, coefficient, den);
+  _calc_value_clear_z (den);
+}
+
+/* Adds @a * @b to @self where at least one of them is a decimal. Unless
+   the other one is an integer or a decimal, the sum is no longer a decimal,
+   so the decimal operands are treated as rationals. */
+
+static void
+calc_value_acc_addmul_dec (CalcValueAcc *self, const CalcValue *a,
+			   const CalcValue *b)
+{
+  CalcValueView va;
+  CalcValueView vb;
+  CalcValue ta;
+  CalcValue tb;
+  const CalcValue *qa;
+  const CalcValue *qb;
+  guint sa;
+  guint sb;
+  mpz_t product;
+
+  if (_calc_value_type_rank (a->type)
+      > _calc_value_type_rank (CALC_NUMBER_TYPE_DECIMAL)
+      || _calc_value_type_rank (b->type)
+      > _calc_value_type_rank (CALC_NUMBER_TYPE_DECIMAL))
+    {
+      qa = _calc_value_decimal_to_q (a, &ta);
+      qb = _calc_value_decimal_to_q (b, &tb);
+      _calc_value_acc_addmul (self, qa, qb);
+      if (qa == &ta)
+	calc_value_clear (&ta);
+      if (qb == &tb)
+	calc_value_clear (&tb);
+      return;
+    }
+
+  _calc_value_init_z (product);
+  mpz_mul (product, _calc_value_get_dec (a, &va, &sa),
+	   _calc_value_get_dec (b, &vb, &sb));
+  calc_value_acc_add_dec (self, product, sa + sb);
+  _calc_value_clear_z (product);
+}
+
+/* Appends @term to the floating-point terms of the sum, which takes
+   ownership of it */
+
+static void
+calc_value_acc_append (CalcValueAcc *self, mpfr_t term)
+{
+  if (self->floating == NULL)
+    self->floating = g_array_new (FALSE, FALSE, sizeof (__mpfr_struct));
+  g_array_append_val (self->floating, *term);
+}
+
+/* Computes @a * @b exactly if both are integers or floating-point numbers,
+   and appends it to the floating-point terms of the sum */
+
+static void
+calc_value_acc_add_fr (CalcValueAcc *self, const CalcValue *a,
+		       const CalcValue *b)
+{
+  CalcValueView va;
+  CalcValueView vb;
+  mpfr_srcptr fa;
+  mpz_srcptr z;
+  mpfr_t term;
+
+  if (_calc_value_type_is_exact (a->type))
+    {
+      const CalcValue *temp = a;
+      a = b;
+      b = temp;
+    }
+  self->prec = MAX (self->prec, MAX (calc_value_get_prec (a),
+				     calc_value_get_prec (b)));
+  fa = _calc_value_get_fr (a, &va);
+  switch (b->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      z = _calc_value_get_z (b, &vb);
+      _calc_value_init_fr (term, mpfr_get_prec (fa) + mpz_sizeinbase (z, 2));
+      mpfr_mul_z (term, fa, z, MPFR_RNDN);
+      break;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      _calc_value_init_fr (term, mpfr_get_prec (fa) + CALC_VALUE_GUARD_BITS);
+      mpfr_mul_q (term, fa, _calc_value_get_q (b, &vb), MPFR_RNDN);
+      break;
+    case CALC_NUMBER_TYPE_DOUBLE:
+    case CALC_NUMBER_TYPE_FLOATING:
+      _calc_value_init_fr (term, mpfr_get_prec (fa)
+			   + calc_value_get_prec (b));
+      mpfr_mul (term, fa, _calc_value_get_fr (b, &vb), MPFR_RNDN);
+      break;
+    }
+  calc_value_acc_append (self, term);
+}
+
+/* Adds @value to @self */
+
+void
+_calc_value_acc_add (CalcValueAcc *self, const CalcValue *value)
+{
+  CalcValueView view;
+  mpq_srcptr q;
+  mpz_srcptr z;
+  mpfr_t term;
+  guint scale;
+
+  self->type = _calc_value_get_final_type (self->type, value->type);
+  switch (value->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      if (value->small && value->small_num < 0)
+	mpz_submul_ui (mpq_numref (self->exact), mpq_denref (self->exact),
+		       ABS_SMALL (value->small_num));
+      else if (value->small)
+	mpz_addmul_ui (mpq_numref (self->exact), mpq_denref (self->exact),
+		       value->small_num);
+      else
+	mpz_addmul (mpq_numref (self->exact), mpq_denref (self->exact),
+		    _calc_value_get_z (value, &view));
+      break;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      q = _calc_value_get_q (value, &view);
+      calc_value_acc_add_q (self, mpq_numref (q), mpq_denref (q));
+      break;
+    case CALC_NUMBER_TYPE_DECIMAL:
+      z = _calc_value_get_dec (value, &view, &scale);
+      calc_value_acc_add_dec (self, z, scale);
+      break;
+    case CALC_NUMBER_TYPE_DOUBLE:
+    case CALC_NUMBER_TYPE_FLOATING:
+      self->prec = MAX (self->prec, calc_value_get_prec (value));
+      _calc_value_init_fr (term, calc_value_get_prec (value));
+      mpfr_set (term, _calc_value_get_fr (value, &view), MPFR_RNDN);
+      calc_value_acc_append (self, term);
+      break;
+    }
+}
+
+/* Adds @a * @b to @self */
+
+void
+_calc_value_acc_addmul (CalcValueAcc *self, const CalcValue *a,
+			const CalcValue *b)
+{
+  CalcValueView va;
+  CalcValueView vb;
+  mpq_t product;
+  glong num;
+
+  self->type =
+    _calc_value_get_final_type (self->type,
+				_calc_value_get_final_type (a->type,
+							    b->type));
+  if (a->type == CALC_NUMBER_TYPE_DECIMAL
+      || b->type == CALC_NUMBER_TYPE_DECIMAL)
+    {
+      calc_value_acc_addmul_dec (self, a, b);
+      return;
+    }
+  if (!_calc_value_type_is_exact (a->type)
+      || !_calc_value_type_is_exact (b->type))
+    {
+      calc_value_acc_add_fr (self, a, b);
+      return;
+    }
+
+  if (a->small && b->small && a->small_den == 1 && b->small_den == 1
+      && !__builtin_mul_overflow (a->small_num, b->small_num, &num))
+    {
+      if (num < 0)
+	mpz_submul_ui (mpq_numref (self->exact), mpq_denref (self->exact),
+		       ABS_SMALL (num));
+      else
+	mpz_addmul_ui (mpq_numref (self->exact), mpq_denref (self->exact),
+		       num);
+    }
+  else if (a->type == CALC_NUMBER_TYPE_INTEGER
+	   && b->type == CALC_NUMBER_TYPE_INTEGER
+	   && mpz_cmp_ui (mpq_denref (self->exact), 1) == 0)
+    mpz_addmul (mpq_numref (self->exact), _calc_value_get_z (a, &va),
+		_calc_value_get_z (b, &vb));
+  else
+    {
+      _calc_value_init_q (product);
+      mpq_mul (product, _calc_value_get_q (a, &va),
+	       _calc_value_get_q (b, &vb));
+      calc_value_acc_add_q (self, mpq_numref (product),
+			    mpq_denref (product));
+      _calc_value_clear_q (product);
+    }
+}
+
+/* Frees the memory used by @self without reading the sum */
+
+void
+_calc_value_acc_clear (CalcValueAcc *self)
+{
+  guint i;
+  _calc_value_clear_q (self->exact);
+  if (self->floating == NULL)
+    return;
+  for (i = 0; i < self->floating->len; i++)
+    _calc_value_clear_fr (&g_array_index (self->floating, __mpfr_struct, i));
+  g_array_free (self->floating, TRUE);
+}
+
+/* Stores the sum in @result and frees the memory used by @self */
+
+void
+_calc_value_acc_finish (CalcValueAcc *self, CalcValue *result)
+{
+  mpfr_ptr *terms;
+  mpfr_prec_t prec;
+  mpz_t z;
+  mpfr_t fr;
+  guint i;
+
+  mpq_canonicalize (self->exact);
+  switch (self->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      *z = *mpq_numref (self->exact);
+      _calc_value_clear_z (mpq_denref (self->exact));
+      _calc_value_take_z (result, z);
+      return;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      _calc_value_take_q (result, self->exact);
+      return;
+    case CALC_NUMBER_TYPE_DECIMAL:
+      /* Products can have more digits than a decimal allows, in which case
+	 the sum is rounded once here */
+      _calc_value_set_decimal_q (result, self->exact,
+				 MIN (self->scale,
+				      CALC_VALUE_DECIMAL_MAX_SCALE));
+      _calc_value_clear_q (self->exact);
+      return;
+    }
+
+  /* The exact part of the sum becomes one more floating-point term. A sum
+     of doubles is rounded to a double, whatever the precision override. */
+  prec = calc_value_get_prec_override ();
+  if (prec == 0 || self->type == CALC_NUMBER_TYPE_DOUBLE)
+    prec = MAX (self->prec, MPFR_PREC_MIN);
+  if (mpq_sgn (self->exact) != 0)
+    {
+      if (mpz_cmp_ui (mpq_denref (self->exact), 1) == 0)
+	_calc_value_init_fr (fr, MAX (mpz_sizeinbase (mpq_numref (self->exact),
+						      2), MPFR_PREC_MIN));
+      else
+	_calc_value_init_fr (fr, prec + CALC_VALUE_GUARD_BITS);
+      mpfr_set_q (fr, self->exact, MPFR_RNDN);
+      g_array_append_val (self->floating, *fr);
+    }
+  _calc_value_clear_q (self->exact);
+
+  terms = g_new (mpfr_ptr, self->floating->len);
+  for (i = 0; i < self->floating->len; i++)
+    terms[i] = &g_array_index (self->floating, __mpfr_struct, i);
+  _calc_value_init_fr (fr, prec);
+  mpfr_sum (fr, terms, self->floating->len, MPFR_RNDN);
+  for (i = 0; i < self->floating->len; i++)
+    _calc_value_clear_fr (terms[i]);
+  g_free (terms);
+  g_array_free (self->floating, TRUE);
+  if (self->type == CALC_NUMBER_TYPE_DOUBLE)
+    {
+      _calc_value_take_d (result, mpfr_get_d (fr, MPFR_RNDN));
+      _calc_value_clear_fr (fr);
+    }
+  else
+    _calc_value_take_fr (result, fr);
+}
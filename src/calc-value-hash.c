@@ -0,0 +1,212 @@
+/*************************************************************************
+ * calc-value-hash.c -- This file is part of libcalc.                    *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+
+#define _LIBCALC_INTERNAL
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "calc-value.h"
+
+#define ABS_SMALL(x) ((x) < 0 ? -(gulong) (x) : (gulong) (x))
+
+/* Seeds for the different kinds of values. Every finite value that can be
+   written as m * 2^e with an odd m is hashed from m and e, so equal
+   integers, rationals and floating-point numbers hash equally regardless of
+   their type or precision. */
+#define CALC_VALUE_HASH_ZERO G_GUINT64_CONSTANT (0x6a09e667f3bcc908)
+#define CALC_VALUE_HASH_POSITIVE G_GUINT64_CONSTANT (0xbb67ae8584caa73b)
+#define CALC_VALUE_HASH_NEGATIVE G_GUINT64_CONSTANT (0x3c6ef372fe94f82b)
+#define CALC_VALUE_HASH_RATIO G_GUINT64_CONSTANT (0xa54ff53a5f1d36f1)
+#define CALC_VALUE_HASH_INF G_GUINT64_CONSTANT (0x510e527fade682d1)
+#define CALC_VALUE_HASH_NAN G_GUINT64_CONSTANT (0x9b05688c2b3e6c1f)
+
+static guint64
+calc_value_hash_limbs (guint64 hash, const mp_limb_t *limbs, gsize n)
+{
+  gsize i;
+  for (i = 0; i < n; i++)
+    hash = _calc_hash_combine (hash, limbs[i]);
+  return _calc_hash_combine (hash, n);
+}
+
+/* Hashes the value m * 2^@exp, where the magnitude of m is odd and stored
+   in @n limbs at @limbs */
+
+static guint64
+calc_value_hash_dyadic (gint sign, const mp_limb_t *limbs, gsize n,
+			glong exp)
+{
+  guint64 hash = sign < 0 ? CALC_VALUE_HASH_NEGATIVE :
+    CALC_VALUE_HASH_POSITIVE;
+  hash = calc_value_hash_limbs (hash, limbs, n);
+  return _calc_hash_combine (hash, (guint64) exp);
+}
+
+/* Hashes a rational number whose denominator is not a power of two, which
+   cannot be equal to any floating-point number */
+
+static guint64
+calc_value_hash_ratio (gint sign, const mp_limb_t *num, gsize num_size,
+		       const mp_limb_t *den, gsize den_size)
+{
+  guint64 hash = _calc_hash_combine (CALC_VALUE_HASH_RATIO, sign < 0);
+  hash = calc_value_hash_limbs (hash, num, num_size);
+  return calc_value_hash_limbs (hash, den, den_size);
+}
+
+static guint64
+calc_value_hash_small (glong num, gulong den)
+{
+  mp_limb_t mag = ABS_SMALL (num);
+  gint sign = num < 0 ? -1 : 1;
+  gint shift;
+  gint den_shift;
+
+  if (num == 0)
+    return CALC_VALUE_HASH_ZERO;
+  if ((den & (den - 1)) != 0)
+    {
+      mp_limb_t limb = den;
+      return calc_value_hash_ratio (sign, &mag, 1, &limb, 1);
+    }
+  den_shift = g_bit_nth_lsf (den, -1);
+  shift = g_bit_nth_lsf (mag, -1);
+  mag >>= shift;
+  return calc_value_hash_dyadic (sign, &mag, 1, (glong) shift - den_shift);
+}
+
+/* Hashes the odd part of @num times 2^@exp */
+
+static guint64
+calc_value_hash_z (mpz_srcptr num, glong exp)
+{
+  guint64 hash;
+  mp_bitcnt_t shift = mpz_scan1 (num, 0);
+  mpz_t odd;
+
+  if (shift == 0)
+    return calc_value_hash_dyadic (mpz_sgn (num), mpz_limbs_read (num),
+				   mpz_size (num), exp);
+  _calc_value_init_z (odd);
+  mpz_tdiv_q_2exp (odd, num, shift);
+  hash = calc_value_hash_dyadic (mpz_sgn (num), mpz_limbs_read (odd),
+				 mpz_size (odd), exp + (glong) shift);
+  _calc_value_clear_z (odd);
+  return hash;
+}
+
+static guint64
+calc_value_hash_fr (mpfr_srcptr value)
+{
+  guint64 hash;
+  mpfr_exp_t exp;
+  mpz_t num;
+
+  if (mpfr_nan_p (value))
+    return CALC_VALUE_HASH_NAN;
+  if (mpfr_inf_p (value))
+    return _calc_hash_combine (CALC_VALUE_HASH_INF, mpfr_sgn (value) < 0);
+  if (mpfr_zero_p (value))
+    return CALC_VALUE_HASH_ZERO;
+  _calc_value_init_z (num);
+  exp = mpfr_get_z_2exp (num, value);
+  hash = calc_value_hash_z (num, exp);
+  _calc_value_clear_z (num);
+  return hash;
+}
+
+/**
+ * calc_value_hash:
+ * @self: the value
+ *
+ * Computes a 64-bit hash of the value of @self. Values that compare equal
+ * have the same hash, even if they have different types or precisions.
+ * Rationals that are not reduced to lowest terms are reduced first.
+ *
+ * Returns: the hash of @self
+ **/
+
+guint64
+calc_value_hash (const CalcValue *self)
+{
+  CalcValueView view;
+  mpq_srcptr q;
+  mp_bitcnt_t den_shift;
+
+  if (self->small)
+    return calc_value_hash_small (self->small_num, self->small_den);
+  switch (self->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      if (mpz_sgn (self->integer) == 0)
+	return CALC_VALUE_HASH_ZERO;
+      return calc_value_hash_z (self->integer, 0);
+    case CALC_NUMBER_TYPE_RATIONAL:
+      q = _calc_value_get_q (self, &view);
+      if (mpq_sgn (q) == 0)
+	return CALC_VALUE_HASH_ZERO;
+      den_shift = mpz_scan1 (mpq_denref (q), 0);
+      if (den_shift + 1 == mpz_sizeinbase (mpq_denref (q), 2))
+	return calc_value_hash_z (mpq_numref (q), -(glong) den_shift);
+      return calc_value_hash_ratio (mpq_sgn (q),
+				    mpz_limbs_read (mpq_numref (q)),
+				    mpz_size (mpq_numref (q)),
+				    mpz_limbs_read (mpq_denref (q)),
+				    mpz_size (mpq_denref (q)));
+    case CALC_NUMBER_TYPE_DECIMAL:
+      {
+	/* A decimal hashes as the rational number it represents */
+	CalcValue temp;
+	guint64 hash = calc_value_hash (_calc_value_decimal_to_q (self,
+								  &temp));
+	calc_value_clear (&temp);
+	return hash;
+      }
+    case CALC_NUMBER_TYPE_DOUBLE:
+    case CALC_NUMBER_TYPE_FLOATING:
+      return calc_value_hash_fr (_calc_value_get_fr (self, &view));
+    default:
+      return 0;
+    }
+}
+
+/* Mixes the bits of @value so that every bit of the result depends on every
+   bit of @value, using the finalizer of MurmurHash3 */
+
+guint64
+_calc_hash_mix (guint64 value)
+{
+  value ^= value >> 33;
+  value *= G_GUINT64_CONSTANT (0xff51afd7ed558ccd);
+  value ^= value >> 33;
+  value *= G_GUINT64_CONSTANT (0xc4ceb9fe1a85ec53);
+  value ^= value >> 33;
+  return value;
+}
+
+/* Combines @value into @hash. The result depends on the order in which
+   values are combined. */
+
+guint64
+_calc_hash_combine (guint64 hash, guint64 value)
+{
+  value += G_GUINT64_CONSTANT (0x9e3779b97f4a7c15) + (hash << 6) + (hash >> 2);
+  return _calc_hash_mix (hash ^ value);
+}
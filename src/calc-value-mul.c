@@ -0,0 +1,609 @@
+/*************************************************************************
+ * calc-value-mul.c -- This file is part of libcalc.                    *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+
+#define _LIBCALC_INTERNAL
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <float.h>
+#include "calc-value.h"
+
+/**
+ * calc_value_mul:
+ * @result: where to store the result of the multiplication
+ * @a: the first multiplicand
+ * @b: the second multiplicand
+ *
+ * Multiplies @a and @b and stores the result in @result. Any previous value in
+ * @result will be erased. The type of @result is dependent on the types of
+ * @a and @b.
+ **/
+
+void
+calc_value_mul (CalcValue *result, const CalcValue *a, const CalcValue *b)
+{
+  CalcValueView va;
+  CalcValueView vb;
+  CalcNumberType type;
+  mpz_t z;
+  mpq_t q;
+  mpfr_t fr;
+
+  if (a->type == CALC_NUMBER_TYPE_DECIMAL
+      || b->type == CALC_NUMBER_TYPE_DECIMAL)
+    {
+      _calc_value_decimal_mul (result, a, b);
+      return;
+    }
+
+  type = _calc_value_get_final_type (a->type, b->type);
+  if (a->small && b->small)
+    {
+      glong num;
+      gulong den;
+      if (_calc_value_small_mul (&num, &den, a->small_num, a->small_den,
+				 b->small_num, b->small_den))
+	{
+	  _calc_value_release (result);
+	  _calc_value_set_small (result, type, num, den);
+	  return;
+	}
+    }
+
+  /* Multiplication is commutative, so only handle @a having the lower
+     type */
+  if (_calc_value_type_rank (a->type) > _calc_value_type_rank (b->type))
+    {
+      const CalcValue *temp = a;
+      a = b;
+      b = temp;
+    }
+
+  switch (type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      _calc_value_init_z (z);
+      mpz_mul (z, _calc_value_get_z (a, &va), _calc_value_get_z (b, &vb));
+      _calc_value_take_z (result, z);
+      break;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      _calc_value_init_q (q);
+      mpq_mul (q, _calc_value_get_q (a, &va), _calc_value_get_q (b, &vb));
+      _calc_value_take_q (result, q);
+      break;
+    case CALC_NUMBER_TYPE_DOUBLE:
+      _calc_value_take_d (result, calc_value_get_double (a)
+			  * calc_value_get_double (b));
+      break;
+    case CALC_NUMBER_TYPE_FLOATING:
+      _calc_value_init_fr (fr,
+			   _calc_value_result_prec (a,
+						    calc_value_get_prec (b)));
+      switch (a->type)
+	{
+	case CALC_NUMBER_TYPE_INTEGER:
+	  mpfr_mul_z (fr, b->floating, _calc_value_get_z (a, &va),
+		      MPFR_RNDN);
+	  break;
+	case CALC_NUMBER_TYPE_RATIONAL:
+	  mpfr_mul_q (fr, b->floating, _calc_value_get_q (a, &va),
+		      MPFR_RNDN);
+	  break;
+	case CALC_NUMBER_TYPE_DOUBLE:
+	case CALC_NUMBER_TYPE_FLOATING:
+	  mpfr_mul (fr, _calc_value_get_fr (a, &va), b->floating, MPFR_RNDN);
+	  break;
+	}
+      _calc_value_take_fr (result, fr);
+      break;
+    }
+}
+
+/**
+ * calc_value_mul_z:
+ * @result: where to store the result of the multiplication
+ * @a: the first multiplicand
+ * @b: the second multiplicand
+ *
+ * Multiplies @a and @b and stores the result in @result. Any previous value in
+ * @result will be erased. The type of @result is dependent on the types of
+ * @a and @b.
+ **/
+
+void
+calc_value_mul_z (CalcValue *result, const CalcValue *a, mpz_t b)
+{
+  CalcValue saved;
+  CalcValueView view;
+  mpq_t temp;
+
+  /* Decimals are handled by the generic function */
+  if (a->type == CALC_NUMBER_TYPE_DECIMAL)
+    {
+      CalcValue value;
+      calc_value_init_z (&value, b);
+      calc_value_mul (result, a, &value);
+      calc_value_clear (&value);
+      return;
+    }
+
+  if (a->type == CALC_NUMBER_TYPE_DOUBLE)
+    {
+      _calc_value_take_d (result, a->native * _calc_value_get_d_z (b));
+      return;
+    }
+
+  a = _calc_value_prepare (result, a, &saved);
+  result->type = a->type;
+  switch (a->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      _calc_value_init_z (result->integer);
+      mpz_mul (result->integer, _calc_value_get_z (a, &view), b);
+      break;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      _calc_value_init_q (result->rational);
+      mpq_init (temp);
+      mpq_set_z (temp, b);
+      mpq_mul (result->rational, _calc_value_get_q (a, &view), temp);
+      mpq_clear (temp);
+      break;
+    case CALC_NUMBER_TYPE_FLOATING:
+      _calc_value_init_fr (result->floating, _calc_value_result_prec (a, 0));
+      mpfr_mul_z (result->floating, a->floating, b, MPFR_RNDN);
+      break;
+    }
+  _calc_value_shrink (result);
+  if (a == &saved)
+    calc_value_clear (&saved);
+}
+
+/**
+ * calc_value_mul_q:
+ * @result: where to store the result of the multiplication
+ * @a: the first multiplicand
+ * @b: the second multiplicand
+ *
+ * Multiplies @a and @b and stores the result in @result. Any previous value in
+ * @result will be erased. The type of @result is dependent on the types of
+ * @a and @b.
+ **/
+
+void
+calc_value_mul_q (CalcValue *result, const CalcValue *a, mpq_t b)
+{
+  CalcValue saved;
+  CalcValueView view;
+  mpq_t temp;
+
+  /* Decimals are handled by the generic function */
+  if (a->type == CALC_NUMBER_TYPE_DECIMAL)
+    {
+      CalcValue value;
+      calc_value_init_q (&value, b);
+      calc_value_mul (result, a, &value);
+      calc_value_clear (&value);
+      return;
+    }
+
+  if (a->type == CALC_NUMBER_TYPE_DOUBLE)
+    {
+      _calc_value_take_d (result, a->native * _calc_value_get_d_q (b));
+      return;
+    }
+
+  a = _calc_value_prepare (result, a, &saved);
+  result->type = a->type;
+  switch (a->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      result->type = CALC_NUMBER_TYPE_RATIONAL;
+      _calc_value_init_q (result->rational);
+      mpq_init (temp);
+      mpq_set_z (temp, _calc_value_get_z (a, &view));
+      mpq_mul (result->rational, temp, b);
+      mpq_clear (temp);
+      break;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      _calc_value_init_q (result->rational);
+      mpq_mul (result->rational, _calc_value_get_q (a, &view), b);
+      break;
+    case CALC_NUMBER_TYPE_FLOATING:
+      _calc_value_init_fr (result->floating, _calc_value_result_prec (a, 0));
+      mpfr_mul_q (result->floating, a->floating, b, MPFR_RNDN);
+      break;
+    }
+  _calc_value_shrink (result);
+  if (a == &saved)
+    calc_value_clear (&saved);
+}
+
+/**
+ * calc_value_mul_f:
+ * @result: where to store the result of the multiplication
+ * @a: the first multiplicand
+ * @b: the second multiplicand
+ *
+ * Multiplies @a and @b and stores the result in @result. Any previous value in
+ * @result will be erased. The type of @result is dependent on the types of
+ * @a and @b.
+ **/
+
+void
+calc_value_mul_f (CalcValue *result, const CalcValue *a, mpf_t b)
+{
+  mpfr_t temp;
+  mpfr_init2 (temp, mpf_get_prec (b));
+  mpfr_set_f (temp, b, MPFR_RNDN);
+  calc_value_mul_fr (result, a, temp);
+  mpfr_clear (temp);
+}
+
+/**
+ * calc_value_mul_fr:
+ * @result: where to store the result of the multiplication
+ * @a: the first multiplicand
+ * @b: the second multiplicand
+ *
+ * Multiplies @a and @b and stores the result in @result. Any previous value in
+ * @result will be erased. The type of @result is dependent on the types of
+ * @a and @b.
+ **/
+
+void
+calc_value_mul_fr (CalcValue *result, const CalcValue *a, mpfr_t b)
+{
+  CalcValue saved;
+  CalcValueView view;
+
+  /* Decimals are handled by the generic function */
+  if (a->type == CALC_NUMBER_TYPE_DECIMAL)
+    {
+      CalcValue value;
+      calc_value_init_fr (&value, b);
+      calc_value_mul (result, a, &value);
+      calc_value_clear (&value);
+      return;
+    }
+
+  a = _calc_value_prepare (result, a, &saved);
+  result->type = CALC_NUMBER_TYPE_FLOATING;
+  _calc_value_init_fr (result->floating,
+		       _calc_value_result_prec (a, mpfr_get_prec (b)));
+  switch (a->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      mpfr_set_z (result->floating, _calc_value_get_z (a, &view),
+		  MPFR_RNDN);
+      mpfr_mul (result->floating, result->floating, b, MPFR_RNDN);
+      break;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      mpfr_set_q (result->floating, _calc_value_get_q (a, &view),
+		  MPFR_RNDN);
+      mpfr_mul (result->floating, result->floating, b, MPFR_RNDN);
+      break;
+    case CALC_NUMBER_TYPE_DOUBLE:
+    case CALC_NUMBER_TYPE_FLOATING:
+      mpfr_mul (result->floating, _calc_value_get_fr (a, &view), b,
+	       MPFR_RNDN);
+      break;
+    }
+  if (a == &saved)
+    calc_value_clear (&saved);
+}
+
+/**
+ * calc_value_mul_d:
+ * @result: where to store the result of the multiplication
+ * @a: the first multiplicand
+ * @b: the second multiplicand
+ *
+ * Multiplies @a and @b and stores the result in @result. Any previous value in
+ * @result will be erased. The type of @result is dependent on the types of
+ * @a and @b.
+ **/
+
+void
+calc_value_mul_d (CalcValue *result, const CalcValue *a, double b)
+{
+  CalcValue saved;
+  CalcValueView view;
+
+  /* Decimals are handled by the generic function */
+  if (a->type == CALC_NUMBER_TYPE_DECIMAL)
+    {
+      CalcValue value;
+      calc_value_init_d (&value, b);
+      calc_value_mul (result, a, &value);
+      calc_value_clear (&value);
+      return;
+    }
+
+  if (a->type == CALC_NUMBER_TYPE_DOUBLE)
+    {
+      _calc_value_take_d (result, a->native * b);
+      return;
+    }
+
+  a = _calc_value_prepare (result, a, &saved);
+  result->type = CALC_NUMBER_TYPE_FLOATING;
+  _calc_value_init_fr (result->floating,
+		       _calc_value_result_prec (a, DBL_MANT_DIG));
+  switch (a->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      mpfr_set_z (result->floating, _calc_value_get_z (a, &view),
+		  MPFR_RNDN);
+      mpfr_mul_d (result->floating, result->floating, b, MPFR_RNDN);
+      break;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      mpfr_set_q (result->floating, _calc_value_get_q (a, &view),
+		  MPFR_RNDN);
+      mpfr_mul_d (result->floating, result->floating, b, MPFR_RNDN);
+      break;
+    case CALC_NUMBER_TYPE_FLOATING:
+      mpfr_mul_d (result->floating, a->floating, b, MPFR_RNDN);
+      break;
+    }
+  if (a == &saved)
+    calc_value_clear (&saved);
+}
+/**
+ * calc_value_mul_ui:
+ * @result: where to store the result of the multiplication
+ * @a: the first multiplicand
+ * @b: the second multiplicand
+ *
+ * Multiplies @a and @b and stores the result in @result. Any previous value in
+ * @result will be erased. The type of @result is dependent on the types of
+ * @a and @b.
+ **/
+
+void
+calc_value_mul_ui (CalcValue *result, const CalcValue *a, unsigned long b)
+{
+  CalcValue saved;
+  CalcValueView view;
+  mpq_t temp;
+
+  /* Decimals are handled by the generic function */
+  if (a->type == CALC_NUMBER_TYPE_DECIMAL)
+    {
+      CalcValue value;
+      calc_value_init_ui (&value, b);
+      calc_value_mul (result, a, &value);
+      calc_value_clear (&value);
+      return;
+    }
+
+  if (a->type == CALC_NUMBER_TYPE_DOUBLE)
+    {
+      _calc_value_take_d (result, a->native * b);
+      return;
+    }
+
+  if (a->small && b <= G_MAXLONG)
+    {
+      CalcNumberType type = a->type;
+      glong num;
+      gulong den;
+      if (_calc_value_small_mul (&num, &den, a->small_num, a->small_den,
+				 (glong) b, 1))
+	{
+	  _calc_value_release (result);
+	  _calc_value_set_small (result, type, num, den);
+	  return;
+	}
+    }
+
+  a = _calc_value_prepare (result, a, &saved);
+  result->type = a->type;
+  switch (a->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      _calc_value_init_z (result->integer);
+      mpz_mul_ui (result->integer, _calc_value_get_z (a, &view), b);
+      break;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      _calc_value_init_q (result->rational);
+      mpq_init (temp);
+      mpq_set_ui (temp, b, 1);
+      mpq_mul (result->rational, _calc_value_get_q (a, &view), temp);
+      mpq_clear (temp);
+      break;
+    case CALC_NUMBER_TYPE_FLOATING:
+      _calc_value_init_fr (result->floating, _calc_value_result_prec (a, 0));
+      mpfr_mul_ui (result->floating, a->floating, b, MPFR_RNDN);
+      break;
+    }
+  _calc_value_shrink (result);
+  if (a == &saved)
+    calc_value_clear (&saved);
+}
+
+/**
+ * calc_value_mul_si:
+ * @result: where to store the result of the multiplication
+ * @a: the first multiplicand
+ * @b: the second multiplicand
+ *
+ * Multiplies @a and @b and stores the result in @result. Any previous value in
+ * @result will be erased. The type of @result is dependent on the types of
+ * @a and @b.
+ **/
+
+void
+calc_value_mul_si (CalcValue *result, const CalcValue *a, signed long b)
+{
+  CalcValue saved;
+  CalcValueView view;
+  mpq_t temp;
+
+  /* Decimals are handled by the generic function */
+  if (a->type == CALC_NUMBER_TYPE_DECIMAL)
+    {
+      CalcValue value;
+      calc_value_init_si (&value, b);
+      calc_value_mul (result, a, &value);
+      calc_value_clear (&value);
+      return;
+    }
+
+  if (a->type == CALC_NUMBER_TYPE_DOUBLE)
+    {
+      _calc_value_take_d (result, a->native * b);
+      return;
+    }
+
+  if (a->small)
+    {
+      CalcNumberType type = a->type;
+      glong num;
+      gulong den;
+      if (_calc_value_small_mul (&num, &den, a->small_num, a->small_den,
+				 b, 1))
+	{
+	  _calc_value_release (result);
+	  _calc_value_set_small (result, type, num, den);
+	  return;
+	}
+    }
+
+  a = _calc_value_prepare (result, a, &saved);
+  result->type = a->type;
+  switch (a->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      _calc_value_init_z (result->integer);
+      mpz_mul_si (result->integer, _calc_value_get_z (a, &view), b);
+      break;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      _calc_value_init_q (result->rational);
+      mpq_init (temp);
+      mpq_set_si (temp, b, 1);
+      mpq_mul (result->rational, _calc_value_get_q (a, &view), temp);
+      mpq_clear (temp);
+      break;
+    case CALC_NUMBER_TYPE_FLOATING:
+      _calc_value_init_fr (result->floating, _calc_value_result_prec (a, 0));
+      mpfr_mul_si (result->floating, a->floating, b, MPFR_RNDN);
+      break;
+    }
+  _calc_value_shrink (result);
+  if (a == &saved)
+    calc_value_clear (&saved);
+}
+
+/**
+ * calc_value_mul_inplace:
+ * @self: the value to multiply
+ * @value: the value to multiply by
+ *
+ * Multiplies @self by @value and stores the result in @self. The result is
+ * the same as calling calc_value_mul() with @self as both the result and
+ * the first factor, but the storage of @self is reused where possible, which
+ * makes this suitable for accumulating a running product. @value may be the
+ * same value as @self.
+ *
+ * A rational result is not reduced to lowest terms until it is read or
+ * calc_value_normalize() is called.
+ **/
+
+void
+calc_value_mul_inplace (CalcValue *self, const CalcValue *value)
+{
+  CalcValueView view;
+
+  if (self->small && value->small)
+    {
+      glong num;
+      gulong den;
+      if (_calc_value_small_mul (&num, &den, self->small_num,
+				 self->small_den, value->small_num,
+				 value->small_den))
+	{
+	  _calc_value_set_small (self,
+				 _calc_value_get_final_type (self->type,
+							     value->type),
+				 num, den);
+	  return;
+	}
+    }
+
+  /* Only reuse the storage of @self if the result has the same type, and
+     leave decimals to the generic function */
+  if (self->small || self->type == CALC_NUMBER_TYPE_DECIMAL
+      || value->type == CALC_NUMBER_TYPE_DECIMAL
+      || _calc_value_get_final_type (self->type, value->type) != self->type)
+    {
+      calc_value_mul (self, self, value);
+      return;
+    }
+
+  switch (self->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      mpz_mul (self->integer, self->integer,
+	       _calc_value_get_z (value, &view));
+      break;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      /* The product is not reduced until its value is needed */
+      if (value->type == CALC_NUMBER_TYPE_INTEGER)
+	mpz_mul (mpq_numref (self->rational), mpq_numref (self->rational),
+		 _calc_value_get_z (value, &view));
+      else
+	{
+	  mpq_srcptr q = _calc_value_get_q (value, &view);
+	  mpz_mul (mpq_numref (self->rational), mpq_numref (self->rational),
+		   mpq_numref (q));
+	  mpz_mul (mpq_denref (self->rational), mpq_denref (self->rational),
+		   mpq_denref (q));
+	}
+      _calc_value_defer_reduce (self);
+      break;
+    case CALC_NUMBER_TYPE_FLOATING:
+      /* Round to the precision the generic function would give first */
+      mpfr_prec_round (self->floating,
+		       _calc_value_result_prec (self,
+						calc_value_get_prec (value)),
+		       MPFR_RNDN);
+      switch (value->type)
+	{
+	case CALC_NUMBER_TYPE_INTEGER:
+	  mpfr_mul_z (self->floating, self->floating,
+		      _calc_value_get_z (value, &view), MPFR_RNDN);
+	  break;
+	case CALC_NUMBER_TYPE_RATIONAL:
+	  mpfr_mul_q (self->floating, self->floating,
+		      _calc_value_get_q (value, &view), MPFR_RNDN);
+	  break;
+	case CALC_NUMBER_TYPE_DOUBLE:
+	case CALC_NUMBER_TYPE_FLOATING:
+	  mpfr_mul (self->floating, self->floating,
+		    _calc_value_get_fr (value, &view), MPFR_RNDN);
+	  break;
+	}
+      break;
+    case CALC_NUMBER_TYPE_DOUBLE:
+      self->native *= calc_value_get_double (value);
+      break;
+    }
+  _calc_value_shrink (self);
+}
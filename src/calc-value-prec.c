@@ -0,0 +1,108 @@
+/*************************************************************************
+ * calc-value-prec.c -- This file is part of libcalc.                    *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+
+#define _LIBCALC_INTERNAL
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <float.h>
+#include "calc-value.h"
+
+/* Precision override of the current thread, stored directly in the
+   pointer. Zero means that no override is set. */
+static GPrivate calc_value_prec_override;
+
+/**
+ * calc_value_get_prec:
+ * @self: the value
+ *
+ * Gets the precision of a floating-point value in bits. Exact values do not
+ * have a precision and do not affect the precision of a result. A double
+ * has a precision of %DBL_MANT_DIG bits.
+ *
+ * Returns: the precision of @self, or zero if @self is an integer or a
+ * rational number
+ **/
+
+mpfr_prec_t
+calc_value_get_prec (const CalcValue *self)
+{
+  switch (self->type)
+    {
+    case CALC_NUMBER_TYPE_DOUBLE:
+      return DBL_MANT_DIG;
+    case CALC_NUMBER_TYPE_FLOATING:
+      return mpfr_get_prec (self->floating);
+    default:
+      return 0;
+    }
+}
+
+/**
+ * calc_value_set_prec_override:
+ * @prec: the precision in bits, or zero
+ *
+ * Sets the precision of every floating-point result computed by the calling
+ * thread to @prec bits, regardless of the precisions of the operands. This
+ * allows selected computations to run at a higher or lower precision than
+ * the rest of the program. If @prec is zero, the override is removed and
+ * results once again take the largest precision of their operands.
+ *
+ * The override only affects the calling thread. A caller that changes the
+ * override temporarily should restore the value returned by
+ * calc_value_get_prec_override() afterwards.
+ **/
+
+void
+calc_value_set_prec_override (mpfr_prec_t prec)
+{
+  g_return_if_fail (prec == 0
+		    || (prec >= MPFR_PREC_MIN && prec <= MPFR_PREC_MAX));
+  g_private_set (&calc_value_prec_override, GSIZE_TO_POINTER (prec));
+}
+
+/**
+ * calc_value_get_prec_override:
+ *
+ * Gets the precision override of the calling thread set by
+ * calc_value_set_prec_override().
+ *
+ * Returns: the precision override in bits, or zero if none is set
+ **/
+
+mpfr_prec_t
+calc_value_get_prec_override (void)
+{
+  return GPOINTER_TO_SIZE (g_private_get (&calc_value_prec_override));
+}
+
+/* Returns the precision of a floating-point result computed from @a and an
+   operand of precision @b, where zero is the precision of an exact
+   operand. */
+
+mpfr_prec_t
+_calc_value_result_prec (const CalcValue *a, mpfr_prec_t b)
+{
+  mpfr_prec_t prec = calc_value_get_prec_override ();
+  if (prec != 0)
+    return prec;
+  prec = MAX (calc_value_get_prec (a), b);
+  return prec != 0 ? prec : mpfr_get_default_prec ();
+}
@@ -0,0 +1,414 @@
+/*************************************************************************
+ * calc-value-str.c -- This file is part of libcalc.                     *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+
+#define _LIBCALC_INTERNAL
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+#include "calc-value.h"
+
+/* Number of decimal digits that always fit in a 64-bit word */
+#define CALC_VALUE_STR_WORD_DIGITS 19
+
+/* Longest digit string converted without allocating scratch memory */
+#define CALC_VALUE_STR_STACK_DIGITS 1024
+
+/* Largest power of five that fits in a 64-bit word */
+#define CALC_VALUE_STR_POW5_MAX 27
+
+/* Largest accepted magnitude of an exponent */
+#define CALC_VALUE_STR_EXP_MAX G_MAXINT
+
+/* The significant digits of a literal, which may be split by a decimal
+   point into two runs of digits */
+typedef struct
+{
+  const gchar *head;
+  gsize head_len;
+  const gchar *tail;
+  gsize tail_len;
+} CalcValueDigits;
+
+static gsize
+calc_value_str_span (const gchar *p, const gchar *end)
+{
+  const gchar *start = p;
+  while (p < end && g_ascii_isdigit (*p))
+    p++;
+  return p - start;
+}
+
+static void
+calc_value_str_skip_zeros (const gchar **p, gsize *len)
+{
+  while (*len > 0 && **p == '0')
+    {
+      (*p)++;
+      (*len)--;
+    }
+}
+
+/* Removes leading and trailing zeros from @digits, returning the number
+   of trailing zeros removed */
+
+static gsize
+calc_value_str_trim (CalcValueDigits *digits)
+{
+  gsize zeros = 0;
+  calc_value_str_skip_zeros (&digits->head, &digits->head_len);
+  if (digits->head_len == 0)
+    calc_value_str_skip_zeros (&digits->tail, &digits->tail_len);
+  while (digits->tail_len > 0 && digits->tail[digits->tail_len - 1] == '0')
+    {
+      digits->tail_len--;
+      zeros++;
+    }
+  if (digits->tail_len > 0)
+    return zeros;
+  while (digits->head_len > 0 && digits->head[digits->head_len - 1] == '0')
+    {
+      digits->head_len--;
+      zeros++;
+    }
+  return zeros;
+}
+
+static guint64
+calc_value_str_word (const CalcValueDigits *digits)
+{
+  guint64 value = 0;
+  gsize i;
+  for (i = 0; i < digits->head_len; i++)
+    value = value * 10 + (digits->head[i] - '0');
+  for (i = 0; i < digits->tail_len; i++)
+    value = value * 10 + (digits->tail[i] - '0');
+  return value;
+}
+
+static guint64
+calc_value_str_pow (guint64 base, guint exp)
+{
+  guint64 result = 1;
+  while (exp-- > 0)
+    result *= base;
+  return result;
+}
+
+static guint64
+calc_value_str_gcd (guint64 a, guint64 b)
+{
+  while (b != 0)
+    {
+      guint64 temp = a % b;
+      a = b;
+      b = temp;
+    }
+  return a;
+}
+
+/* Stores @num / @den inline if it fits in a word. The fraction must be in
+   lowest terms. */
+
+static gboolean
+calc_value_str_set_small (CalcValue *self, CalcNumberType type,
+			  gboolean negative, guint64 num, guint64 den)
+{
+  glong value;
+  if (den > G_MAXULONG
+      || num > (negative ? (guint64) G_MAXLONG + 1 : (guint64) G_MAXLONG))
+    return FALSE;
+  value = negative && num > 0 ? -(glong) (num - 1) - 1 : (glong) num;
+  _calc_value_release (self);
+  _calc_value_set_small (self, type, value, den);
+  return TRUE;
+}
+
+/* Converts @digits to an integer. The conversion is done by GNU MP, which
+   switches to a subquadratic algorithm for long digit strings. */
+
+static void
+calc_value_str_z (mpz_ptr result, const CalcValueDigits *digits)
+{
+  guchar stack[CALC_VALUE_STR_STACK_DIGITS];
+  guchar *buffer = stack;
+  gsize len = digits->head_len + digits->tail_len;
+  mp_size_t size;
+  gsize i;
+
+  if (len == 0)
+    {
+      mpz_set_ui (result, 0);
+      return;
+    }
+  if (len > CALC_VALUE_STR_STACK_DIGITS)
+    buffer = g_malloc (len);
+  for (i = 0; i < digits->head_len; i++)
+    buffer[i] = digits->head[i] - '0';
+  for (i = 0; i < digits->tail_len; i++)
+    buffer[digits->head_len + i] = digits->tail[i] - '0';
+
+  /* Each decimal digit needs less than 10/3 bits */
+  size = (len / 3 * 10 + 10) / GMP_NUMB_BITS + 1;
+  size = mpn_set_str (mpz_limbs_write (result, size), buffer, len, 10);
+  mpz_limbs_finish (result, size);
+  if (buffer != stack)
+    g_free (buffer);
+}
+
+/* Multiplies @value by 5^@exp */
+
+static void
+calc_value_str_mul_pow5 (mpz_ptr value, gulong exp)
+{
+  mpz_t temp;
+  if (exp <= CALC_VALUE_STR_POW5_MAX && sizeof (gulong) >= sizeof (guint64))
+    {
+      mpz_mul_ui (value, value, calc_value_str_pow (5, exp));
+      return;
+    }
+  _calc_value_init_z (temp);
+  mpz_ui_pow_ui (temp, 5, exp);
+  mpz_mul (value, value, temp);
+  _calc_value_clear_z (temp);
+}
+
+/* Stores @digits * 10^@scale in @self. Since @digits has no trailing zeros,
+   the only factors common to the numerator and the denominator 10^-@scale
+   are either twos or fives, which are removed without a full reduction. */
+
+static void
+calc_value_str_decimal (CalcValue *self, CalcNumberType type,
+			gboolean negative, const CalcValueDigits *digits,
+			glong scale)
+{
+  gsize len = digits->head_len + digits->tail_len;
+  gulong k = scale < 0 ? -(gulong) scale : 0;
+  mpq_t value;
+
+  if (len == 0)
+    scale = 0;
+  if (len <= CALC_VALUE_STR_WORD_DIGITS)
+    {
+      guint64 num = calc_value_str_word (digits);
+      if (scale >= 0 && scale < CALC_VALUE_STR_WORD_DIGITS
+	  && num <= G_MAXUINT64 / calc_value_str_pow (10, scale)
+	  && calc_value_str_set_small (self, type, negative,
+				       num * calc_value_str_pow (10, scale),
+				       1))
+	return;
+      if (scale < 0 && k <= CALC_VALUE_STR_WORD_DIGITS)
+	{
+	  guint twos = MIN ((guint) __builtin_ctzll (num), k);
+	  guint fives = 0;
+	  num >>= twos;
+	  while (fives < k && num % 5 == 0)
+	    {
+	      num /= 5;
+	      fives++;
+	    }
+	  if (calc_value_str_set_small (self, type, negative, num,
+					calc_value_str_pow (5, k - fives)
+					<< (k - twos)))
+	    return;
+	}
+    }
+
+  _calc_value_init_q (value);
+  calc_value_str_z (mpq_numref (value), digits);
+  if (scale >= 0)
+    {
+      calc_value_str_mul_pow5 (mpq_numref (value), scale);
+      mpz_mul_2exp (mpq_numref (value), mpq_numref (value), scale);
+    }
+  else if (len > 0)
+    {
+      mp_bitcnt_t twos = MIN (mpz_scan1 (mpq_numref (value), 0), k);
+      mp_bitcnt_t fives = 0;
+      mp_limb_t limb = 5;
+      mpz_t five;
+
+      mpz_tdiv_q_2exp (mpq_numref (value), mpq_numref (value), twos);
+      if (mpz_divisible_ui_p (mpq_numref (value), 5))
+	{
+	  mpz_roinit_n (five, &limb, 1);
+	  fives = mpz_remove (mpq_numref (value), mpq_numref (value), five);
+	  if (fives > k)
+	    {
+	      calc_value_str_mul_pow5 (mpq_numref (value), fives - k);
+	      fives = k;
+	    }
+	}
+      calc_value_str_mul_pow5 (mpq_denref (value), k - fives);
+      mpz_mul_2exp (mpq_denref (value), mpq_denref (value), k - twos);
+    }
+  if (negative)
+    mpz_neg (mpq_numref (value), mpq_numref (value));
+
+  if (type == CALC_NUMBER_TYPE_INTEGER)
+    {
+      mpz_t num;
+      *num = *mpq_numref (value);
+      _calc_value_clear_z (mpq_denref (value));
+      _calc_value_take_z (self, num);
+    }
+  else
+    _calc_value_take_q (self, value);
+}
+
+/* Stores the fraction @num / @den in @self */
+
+static gboolean
+calc_value_str_ratio (CalcValue *self, gboolean negative,
+		      CalcValueDigits *num, CalcValueDigits *den)
+{
+  mpq_t value;
+  calc_value_str_skip_zeros (&num->head, &num->head_len);
+  calc_value_str_skip_zeros (&den->head, &den->head_len);
+  if (den->head_len == 0)
+    return FALSE;
+
+  if (num->head_len <= CALC_VALUE_STR_WORD_DIGITS
+      && den->head_len <= CALC_VALUE_STR_WORD_DIGITS)
+    {
+      guint64 n = calc_value_str_word (num);
+      guint64 d = calc_value_str_word (den);
+      guint64 g = calc_value_str_gcd (n, d);
+      if (calc_value_str_set_small (self, CALC_NUMBER_TYPE_RATIONAL, negative,
+				    n / g, d / g))
+	return TRUE;
+    }
+
+  _calc_value_init_q (value);
+  calc_value_str_z (mpq_numref (value), num);
+  calc_value_str_z (mpq_denref (value), den);
+  mpq_canonicalize (value);
+  if (negative)
+    mpz_neg (mpq_numref (value), mpq_numref (value));
+  _calc_value_take_q (self, value);
+  return TRUE;
+}
+
+/* Parses the exponent of a literal in scientific notation starting after
+   the exponent marker */
+
+static gboolean
+calc_value_str_exp (const gchar **p, const gchar *end, glong *exp)
+{
+  gboolean negative = FALSE;
+  glong value = 0;
+  gsize len;
+  gsize i;
+
+  if (*p < end && (**p == '+' || **p == '-'))
+    negative = *(*p)++ == '-';
+  len = calc_value_str_span (*p, end);
+  if (len == 0)
+    return FALSE;
+  for (i = 0; i < len; i++)
+    {
+      value = value * 10 + ((*p)[i] - '0');
+      if (value > CALC_VALUE_STR_EXP_MAX)
+	return FALSE;
+    }
+  *p += len;
+  *exp = negative ? -value : value;
+  return TRUE;
+}
+
+/**
+ * calc_value_set_str:
+ * @self: the value to set
+ * @str: the string to parse
+ * @len: the length of @str in bytes, or -1 if @str is nul-terminated
+ *
+ * Sets @self to the number written in decimal in @str. Accepted strings are
+ * integers such as "-42", fractions of two integers such as "3/4", and
+ * decimals such as "2.5", ".5" or "6.02e23" with an optional exponent.
+ * Surrounding whitespace is not accepted.
+ *
+ * Decimals are parsed exactly, so @self is set to a rational number even
+ * if it cannot be represented exactly in binary. The value will have a type
+ * set to %CALC_NUMBER_TYPE_RATIONAL if @str is a fraction, has a decimal
+ * point or has a negative exponent, and to %CALC_NUMBER_TYPE_INTEGER
+ * otherwise. Literals that fit in a word are parsed without allocating
+ * memory.
+ *
+ * Since @len bounds the parsed string, this function can be used to parse
+ * numbers in place from a larger buffer.
+ *
+ * Returns: %TRUE on success, or %FALSE if @str is not a valid number, in
+ * which case @self is not modified
+ **/
+
+gboolean
+calc_value_set_str (CalcValue *self, const gchar *str, gssize len)
+{
+  CalcValueDigits num = { NULL, 0, NULL, 0 };
+  CalcValueDigits den = { NULL, 0, NULL, 0 };
+  CalcNumberType type = CALC_NUMBER_TYPE_INTEGER;
+  gboolean negative = FALSE;
+  const gchar *p = str;
+  const gchar *end;
+  glong exp = 0;
+  glong scale;
+
+  g_return_val_if_fail (str != NULL, FALSE);
+  end = str + (len < 0 ? strlen (str) : (gsize) len);
+  if (p < end && (*p == '+' || *p == '-'))
+    negative = *p++ == '-';
+  num.head = p;
+  num.head_len = calc_value_str_span (p, end);
+  p += num.head_len;
+
+  if (p < end && *p == '/')
+    {
+      den.head = ++p;
+      den.head_len = calc_value_str_span (p, end);
+      if (num.head_len == 0 || p + den.head_len != end)
+	return FALSE;
+      return calc_value_str_ratio (self, negative, &num, &den);
+    }
+
+  if (p < end && *p == '.')
+    {
+      type = CALC_NUMBER_TYPE_RATIONAL;
+      num.tail = ++p;
+      num.tail_len = calc_value_str_span (p, end);
+      p += num.tail_len;
+    }
+  if (num.head_len + num.tail_len == 0)
+    return FALSE;
+  if (p < end && (*p == 'e' || *p == 'E'))
+    {
+      p++;
+      if (!calc_value_str_exp (&p, end, &exp))
+	return FALSE;
+      if (exp < 0)
+	type = CALC_NUMBER_TYPE_RATIONAL;
+    }
+  if (p != end || num.tail_len > CALC_VALUE_STR_EXP_MAX)
+    return FALSE;
+
+  scale = exp - (glong) num.tail_len;
+  scale += calc_value_str_trim (&num);
+  calc_value_str_decimal (self, type, negative, &num, scale);
+  return TRUE;
+}
@@ -0,0 +1,546 @@
+/*************************************************************************
+ * calc-value-sub.c -- This file is part of libcalc.                    *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+
+#define _LIBCALC_INTERNAL
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <float.h>
+#include "calc-value.h"
+
+/**
+ * calc_value_sub:
+ * @result: where to store the result of the subtraction
+ * @a: the first subtrahend
+ * @b: the second subtrahend
+ *
+ * Subtracts @b from @a and stores the result in @result. Any previous value in
+ * @result will be erased. The type of @result is dependent on the types of
+ * @a and @b.
+ **/
+
+void
+calc_value_sub (CalcValue *result, const CalcValue *a, const CalcValue *b)
+{
+  CalcValueView va;
+  CalcValueView vb;
+  CalcNumberType type;
+  mpz_t z;
+  mpq_t q;
+  mpfr_t fr;
+
+  if (a->type == CALC_NUMBER_TYPE_DECIMAL
+      || b->type == CALC_NUMBER_TYPE_DECIMAL)
+    {
+      _calc_value_decimal_add (result, a, b, TRUE);
+      return;
+    }
+
+  type = _calc_value_get_final_type (a->type, b->type);
+  if (a->small && b->small)
+    {
+      glong num;
+      gulong den;
+      if (_calc_value_small_sub (&num, &den, a->small_num, a->small_den,
+				 b->small_num, b->small_den))
+	{
+	  _calc_value_release (result);
+	  _calc_value_set_small (result, type, num, den);
+	  return;
+	}
+    }
+
+  switch (type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      _calc_value_init_z (z);
+      mpz_sub (z, _calc_value_get_z (a, &va), _calc_value_get_z (b, &vb));
+      _calc_value_take_z (result, z);
+      break;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      _calc_value_init_q (q);
+      if (a->type == CALC_NUMBER_TYPE_INTEGER)
+	{
+	  /* a - n/d = (ad - n)/d is already in lowest terms */
+	  mpq_srcptr qb = _calc_value_get_q (b, &vb);
+	  mpz_mul (mpq_numref (q), _calc_value_get_z (a, &va),
+		   mpq_denref (qb));
+	  mpz_sub (mpq_numref (q), mpq_numref (q), mpq_numref (qb));
+	  mpz_set (mpq_denref (q), mpq_denref (qb));
+	}
+      else if (b->type == CALC_NUMBER_TYPE_INTEGER)
+	{
+	  mpq_srcptr qa = _calc_value_get_q (a, &va);
+	  mpz_set (mpq_numref (q), mpq_numref (qa));
+	  mpz_submul (mpq_numref (q), _calc_value_get_z (b, &vb),
+		      mpq_denref (qa));
+	  mpz_set (mpq_denref (q), mpq_denref (qa));
+	}
+      else
+	mpq_sub (q, _calc_value_get_q (a, &va), _calc_value_get_q (b, &vb));
+      _calc_value_take_q (result, q);
+      break;
+    case CALC_NUMBER_TYPE_DOUBLE:
+      _calc_value_take_d (result, calc_value_get_double (a)
+			  - calc_value_get_double (b));
+      break;
+    case CALC_NUMBER_TYPE_FLOATING:
+      _calc_value_init_fr (fr,
+			   _calc_value_result_prec (a,
+						    calc_value_get_prec (b)));
+      switch (b->type)
+	{
+	case CALC_NUMBER_TYPE_INTEGER:
+	  mpfr_sub_z (fr, a->floating, _calc_value_get_z (b, &vb),
+		      MPFR_RNDN);
+	  break;
+	case CALC_NUMBER_TYPE_RATIONAL:
+	  mpfr_sub_q (fr, a->floating, _calc_value_get_q (b, &vb),
+		      MPFR_RNDN);
+	  break;
+	case CALC_NUMBER_TYPE_DOUBLE:
+	  mpfr_sub (fr, a->floating, _calc_value_get_fr (b, &vb), MPFR_RNDN);
+	  break;
+	case CALC_NUMBER_TYPE_FLOATING:
+	  /* Rounding to nearest is symmetric, so a - b = -(b - a) */
+	  switch (a->type)
+	    {
+	    case CALC_NUMBER_TYPE_INTEGER:
+	      mpfr_sub_z (fr, b->floating, _calc_value_get_z (a, &va),
+			  MPFR_RNDN);
+	      mpfr_neg (fr, fr, MPFR_RNDN);
+	      break;
+	    case CALC_NUMBER_TYPE_RATIONAL:
+	      mpfr_sub_q (fr, b->floating, _calc_value_get_q (a, &va),
+			  MPFR_RNDN);
+	      mpfr_neg (fr, fr, MPFR_RNDN);
+	      break;
+	    case CALC_NUMBER_TYPE_DOUBLE:
+	    case CALC_NUMBER_TYPE_FLOATING:
+	      mpfr_sub (fr, _calc_value_get_fr (a, &va), b->floating,
+			MPFR_RNDN);
+	      break;
+	    }
+	  break;
+	}
+      _calc_value_take_fr (result, fr);
+      break;
+    }
+}
+
+/**
+ * calc_value_sub_z:
+ * @result: where to store the result of the subtraction
+ * @a: the first subtrahend
+ * @b: the second subtrahend
+ *
+ * Subtracts @b from @a and stores the result in @result. Any previous value in
+ * @result will be erased. The type of @result is dependent on the types of
+ * @a and @b.
+ **/
+
+void
+calc_value_sub_z (CalcValue *result, const CalcValue *a, mpz_t b)
+{
+  CalcValue saved;
+  CalcValueView view;
+  mpq_t temp;
+
+  /* Decimals are handled by the generic function */
+  if (a->type == CALC_NUMBER_TYPE_DECIMAL)
+    {
+      CalcValue value;
+      calc_value_init_z (&value, b);
+      calc_value_sub (result, a, &value);
+      calc_value_clear (&value);
+      return;
+    }
+
+  if (a->type == CALC_NUMBER_TYPE_DOUBLE)
+    {
+      _calc_value_take_d (result, a->native - _calc_value_get_d_z (b));
+      return;
+    }
+
+  a = _calc_value_prepare (result, a, &saved);
+  result->type = a->type;
+  switch (a->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      _calc_value_init_z (result->integer);
+      mpz_sub (result->integer, _calc_value_get_z (a, &view), b);
+      break;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      _calc_value_init_q (result->rational);
+      mpq_init (temp);
+      mpq_set_z (temp, b);
+      mpq_sub (result->rational, _calc_value_get_q (a, &view), temp);
+      mpq_clear (temp);
+      break;
+    case CALC_NUMBER_TYPE_FLOATING:
+      _calc_value_init_fr (result->floating, _calc_value_result_prec (a, 0));
+      mpfr_sub_z (result->floating, a->floating, b, MPFR_RNDN);
+      break;
+    }
+  _calc_value_shrink (result);
+  if (a == &saved)
+    calc_value_clear (&saved);
+}
+
+/**
+ * calc_value_sub_q:
+ * @result: where to store the result of the subtraction
+ * @a: the first subtrahend
+ * @b: the second subtrahend
+ *
+ * Subtracts @b from @a and stores the result in @result. Any previous value in
+ * @result will be erased. The type of @result is dependent on the types of
+ * @a and @b.
+ **/
+
+void
+calc_value_sub_q (CalcValue *result, const CalcValue *a, mpq_t b)
+{
+  CalcValue saved;
+  CalcValueView view;
+  mpq_t temp;
+
+  /* Decimals are handled by the generic function */
+  if (a->type == CALC_NUMBER_TYPE_DECIMAL)
+    {
+      CalcValue value;
+      calc_value_init_q (&value, b);
+      calc_value_sub (result, a, &value);
+      calc_value_clear (&value);
+      return;
+    }
+
+  if (a->type == CALC_NUMBER_TYPE_DOUBLE)
+    {
+      _calc_value_take_d (result, a->native - _calc_value_get_d_q (b));
+      return;
+    }
+
+  a = _calc_value_prepare (result, a, &saved);
+  result->type = a->type;
+  switch (a->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      result->type = CALC_NUMBER_TYPE_RATIONAL;
+      _calc_value_init_q (result->rational);
+      mpq_init (temp);
+      mpq_set_z (temp, _calc_value_get_z (a, &view));
+      mpq_sub (result->rational, temp, b);
+      mpq_clear (temp);
+      break;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      _calc_value_init_q (result->rational);
+      mpq_sub (result->rational, _calc_value_get_q (a, &view), b);
+      break;
+    case CALC_NUMBER_TYPE_FLOATING:
+      _calc_value_init_fr (result->floating, _calc_value_result_prec (a, 0));
+      mpfr_sub_q (result->floating, a->floating, b, MPFR_RNDN);
+      break;
+    }
+  _calc_value_shrink (result);
+  if (a == &saved)
+    calc_value_clear (&saved);
+}
+
+/**
+ * calc_value_sub_f:
+ * @result: where to store the result of the subtraction
+ * @a: the first subtrahend
+ * @b: the second subtrahend
+ *
+ * Subtracts @b from @a and stores the result in @result. Any previous value in
+ * @result will be erased. The type of @result is dependent on the types of
+ * @a and @b.
+ **/
+
+void
+calc_value_sub_f (CalcValue *result, const CalcValue *a, mpf_t b)
+{
+  mpfr_t temp;
+  mpfr_init2 (temp, mpf_get_prec (b));
+  mpfr_set_f (temp, b, MPFR_RNDN);
+  calc_value_sub_fr (result, a, temp);
+  mpfr_clear (temp);
+}
+
+/**
+ * calc_value_sub_fr:
+ * @result: where to store the result of the subtraction
+ * @a: the first subtrahend
+ * @b: the second subtrahend
+ *
+ * Subtracts @b from @a and stores the result in @result. Any previous value in
+ * @result will be erased. The type of @result is dependent on the types of
+ * @a and @b.
+ **/
+
+void
+calc_value_sub_fr (CalcValue *result, const CalcValue *a, mpfr_t b)
+{
+  CalcValue saved;
+  CalcValueView view;
+
+  /* Decimals are handled by the generic function */
+  if (a->type == CALC_NUMBER_TYPE_DECIMAL)
+    {
+      CalcValue value;
+      calc_value_init_fr (&value, b);
+      calc_value_sub (result, a, &value);
+      calc_value_clear (&value);
+      return;
+    }
+
+  a = _calc_value_prepare (result, a, &saved);
+  result->type = CALC_NUMBER_TYPE_FLOATING;
+  _calc_value_init_fr (result->floating,
+		       _calc_value_result_prec (a, mpfr_get_prec (b)));
+  switch (a->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      mpfr_set_z (result->floating, _calc_value_get_z (a, &view),
+		  MPFR_RNDN);
+      mpfr_sub (result->floating, result->floating, b, MPFR_RNDN);
+      break;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      mpfr_set_q (result->floating, _calc_value_get_q (a, &view),
+		  MPFR_RNDN);
+      mpfr_sub (result->floating, result->floating, b, MPFR_RNDN);
+      break;
+    case CALC_NUMBER_TYPE_DOUBLE:
+    case CALC_NUMBER_TYPE_FLOATING:
+      mpfr_sub (result->floating, _calc_value_get_fr (a, &view), b,
+	       MPFR_RNDN);
+      break;
+    }
+  if (a == &saved)
+    calc_value_clear (&saved);
+}
+
+/**
+ * calc_value_sub_d:
+ * @result: where to store the result of the subtraction
+ * @a: the first subtrahend
+ * @b: the second subtrahend
+ *
+ * Subtracts @b from @a and stores the result in @result. Any previous value in
+ * @result will be erased. The type of @result is dependent on the types of
+ * @a and @b.
+ **/
+
+void
+calc_value_sub_d (CalcValue *result, const CalcValue *a, double b)
+{
+  CalcValue saved;
+  CalcValueView view;
+
+  /* Decimals are handled by the generic function */
+  if (a->type == CALC_NUMBER_TYPE_DECIMAL)
+    {
+      CalcValue value;
+      calc_value_init_d (&value, b);
+      calc_value_sub (result, a, &value);
+      calc_value_clear (&value);
+      return;
+    }
+
+  if (a->type == CALC_NUMBER_TYPE_DOUBLE)
+    {
+      _calc_value_take_d (result, a->native - b);
+      return;
+    }
+
+  a = _calc_value_prepare (result, a, &saved);
+  result->type = CALC_NUMBER_TYPE_FLOATING;
+  _calc_value_init_fr (result->floating,
+		       _calc_value_result_prec (a, DBL_MANT_DIG));
+  switch (a->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      mpfr_set_z (result->floating, _calc_value_get_z (a, &view),
+		  MPFR_RNDN);
+      mpfr_sub_d (result->floating, result->floating, b, MPFR_RNDN);
+      break;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      mpfr_set_q (result->floating, _calc_value_get_q (a, &view),
+		  MPFR_RNDN);
+      mpfr_sub_d (result->floating, result->floating, b, MPFR_RNDN);
+      break;
+    case CALC_NUMBER_TYPE_FLOATING:
+      mpfr_sub_d (result->floating, a->floating, b, MPFR_RNDN);
+      break;
+    }
+  if (a == &saved)
+    calc_value_clear (&saved);
+}
+
+/**
+ * calc_value_sub_ui:
+ * @result: where to store the result of the subtraction
+ * @a: the first subtrahend
+ * @b: the second subtrahend
+ *
+ * Subtracts @b from @a and stores the result in @result. Any previous value in
+ * @result will be erased. The type of @result is dependent on the types of
+ * @a and @b.
+ **/
+
+void
+calc_value_sub_ui (CalcValue *result, const CalcValue *a, unsigned long b)
+{
+  CalcValue saved;
+  CalcValueView view;
+  mpq_t temp;
+
+  /* Decimals are handled by the generic function */
+  if (a->type == CALC_NUMBER_TYPE_DECIMAL)
+    {
+      CalcValue value;
+      calc_value_init_ui (&value, b);
+      calc_value_sub (result, a, &value);
+      calc_value_clear (&value);
+      return;
+    }
+
+  if (a->type == CALC_NUMBER_TYPE_DOUBLE)
+    {
+      _calc_value_take_d (result, a->native - b);
+      return;
+    }
+
+  if (a->small && b <= G_MAXLONG)
+    {
+      CalcNumberType type = a->type;
+      glong num;
+      gulong den;
+      if (_calc_value_small_sub (&num, &den, a->small_num, a->small_den,
+				 (glong) b, 1))
+	{
+	  _calc_value_release (result);
+	  _calc_value_set_small (result, type, num, den);
+	  return;
+	}
+    }
+
+  a = _calc_value_prepare (result, a, &saved);
+  result->type = a->type;
+  switch (a->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      _calc_value_init_z (result->integer);
+      mpz_sub_ui (result->integer, _calc_value_get_z (a, &view), b);
+      break;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      _calc_value_init_q (result->rational);
+      mpq_init (temp);
+      mpq_set_ui (temp, b, 1);
+      mpq_sub (result->rational, _calc_value_get_q (a, &view), temp);
+      mpq_clear (temp);
+      break;
+    case CALC_NUMBER_TYPE_FLOATING:
+      _calc_value_init_fr (result->floating, _calc_value_result_prec (a, 0));
+      mpfr_sub_ui (result->floating, a->floating, b, MPFR_RNDN);
+      break;
+    }
+  _calc_value_shrink (result);
+  if (a == &saved)
+    calc_value_clear (&saved);
+}
+
+/**
+ * calc_value_sub_si:
+ * @result: where to store the result of the subtraction
+ * @a: the first subtrahend
+ * @b: the second subtrahend
+ *
+ * Subtracts @b from @a and stores the result in @result. Any previous value in
+ * @result will be erased. The type of @result is dependent on the types of
+ * @a and @b.
+ **/
+
+void
+calc_value_sub_si (CalcValue *result, const CalcValue *a, signed long b)
+{
+  CalcValue saved;
+  CalcValueView view;
+  mpq_t temp;
+
+  /* Decimals are handled by the generic function */
+  if (a->type == CALC_NUMBER_TYPE_DECIMAL)
+    {
+      CalcValue value;
+      calc_value_init_si (&value, b);
+      calc_value_sub (result, a, &value);
+      calc_value_clear (&value);
+      return;
+    }
+
+  if (a->type == CALC_NUMBER_TYPE_DOUBLE)
+    {
+      _calc_value_take_d (result, a->native - b);
+      return;
+    }
+
+  if (a->small)
+    {
+      CalcNumberType type = a->type;
+      glong num;
+      gulong den;
+      if (_calc_value_small_sub (&num, &den, a->small_num, a->small_den,
+				 b, 1))
+	{
+	  _calc_value_release (result);
+	  _calc_value_set_small (result, type, num, den);
+	  return;
+	}
+    }
+
+  a = _calc_value_prepare (result, a, &saved);
+  result->type = a->type;
+  switch (a->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      _calc_value_init_z (result->integer);
+      if (b >= 0)
+	mpz_sub_ui (result->integer, _calc_value_get_z (a, &view), b);
+      else
+	mpz_add_ui (result->integer, _calc_value_get_z (a, &view),
+		    -(unsigned long) b);
+      break;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      _calc_value_init_q (result->rational);
+      mpq_init (temp);
+      mpq_set_si (temp, b, 1);
+      mpq_sub (result->rational, _calc_value_get_q (a, &view), temp);
+      mpq_clear (temp);
+      break;
+    case CALC_NUMBER_TYPE_FLOATING:
+      _calc_value_init_fr (result->floating, _calc_value_result_prec (a, 0));
+      mpfr_sub_si (result->floating, a->floating, b, MPFR_RNDN);
+      break;
+    }
+  _calc_value_shrink (result);
+  if (a == &saved)
+    calc_value_clear (&saved);
+}
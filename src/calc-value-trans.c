@@ -0,0 +1,1011 @@
+/*************************************************************************
+ * calc-value-trans.c -- This file is part of libcalc.                   *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+
+#define _LIBCALC_INTERNAL
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <math.h>
+#include "calc-value.h"
+
+typedef gint (*CalcValueUnaryFunc) (CalcValue *, const CalcValue *);
+
+/* Functions other than arithmetic treat a decimal as the rational number it
+   represents, so @func is applied to a rational copy of @self */
+
+static gint
+calc_value_trans_decimal (CalcValue *result, const CalcValue *self,
+			  CalcValueUnaryFunc func)
+{
+  CalcValue temp;
+  gint ret = func (result, _calc_value_decimal_to_q (self, &temp));
+  calc_value_clear (&temp);
+  return ret;
+}
+
+/**
+ * calc_value_log:
+ * @result: where to store the result
+ * @self: the value
+ *
+ * Sets the value of @result to the natural logarithm of @self. Any previous
+ * value in @result is erased.
+ *
+ * Returns: zero if the calculation is exact, positive if the calculation is
+ * slightly larger than the actual value, and negative if the calculation is
+ * slightly smaller than the actual value
+ **/
+
+gint
+calc_value_log (CalcValue *result, const CalcValue *self)
+{
+  CalcValueView view;
+  gint ret;
+  mpfr_t temp;
+  mpfr_t fr;
+  if (self->type == CALC_NUMBER_TYPE_DECIMAL)
+    return calc_value_trans_decimal (result, self, calc_value_log);
+  if (self->type == CALC_NUMBER_TYPE_DOUBLE)
+    {
+      _calc_value_take_d (result, log (self->native));
+      return 0;
+    }
+  _calc_value_init_fr (fr, _calc_value_result_prec (self, 0));
+  switch (self->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      mpfr_init2 (temp, mpfr_get_prec (fr));
+      mpfr_set_z (temp, _calc_value_get_z (self, &view), MPFR_RNDN);
+      ret = mpfr_log (fr, temp, MPFR_RNDN);
+      mpfr_clear (temp);
+      break;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      mpfr_init2 (temp, mpfr_get_prec (fr));
+      mpfr_set_q (temp, _calc_value_get_q (self, &view), MPFR_RNDN);
+      ret = mpfr_log (fr, temp, MPFR_RNDN);
+      mpfr_clear (temp);
+      break;
+    case CALC_NUMBER_TYPE_FLOATING:
+      ret = mpfr_log (fr, self->floating, MPFR_RNDN);
+      break;
+    default:
+      _calc_value_clear_fr (fr);
+      return -1;
+    }
+  _calc_value_take_fr (result, fr);
+  return ret;
+}
+
+/**
+ * calc_value_log2:
+ * @result: where to store the result
+ * @self: the value
+ *
+ * Sets the value of @result to the binary logarithm of @self. Any previous
+ * value in @result is erased.
+ *
+ * Returns: zero if the calculation is exact, positive if the calculation is
+ * slightly larger than the actual value, and negative if the calculation is
+ * slightly smaller than the actual value
+ **/
+
+gint
+calc_value_log2 (CalcValue *result, const CalcValue *self)
+{
+  CalcValueView view;
+  gint ret;
+  mpfr_t temp;
+  mpfr_t fr;
+  if (self->type == CALC_NUMBER_TYPE_DECIMAL)
+    return calc_value_trans_decimal (result, self, calc_value_log2);
+  if (self->type == CALC_NUMBER_TYPE_DOUBLE)
+    {
+      _calc_value_take_d (result, log2 (self->native));
+      return 0;
+    }
+  _calc_value_init_fr (fr, _calc_value_result_prec (self, 0));
+  switch (self->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      mpfr_init2 (temp, mpfr_get_prec (fr));
+      mpfr_set_z (temp, _calc_value_get_z (self, &view), MPFR_RNDN);
+      ret = mpfr_log2 (fr, temp, MPFR_RNDN);
+      mpfr_clear (temp);
+      break;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      mpfr_init2 (temp, mpfr_get_prec (fr));
+      mpfr_set_q (temp, _calc_value_get_q (self, &view), MPFR_RNDN);
+      ret = mpfr_log2 (fr, temp, MPFR_RNDN);
+      mpfr_clear (temp);
+      break;
+    case CALC_NUMBER_TYPE_FLOATING:
+      ret = mpfr_log2 (fr, self->floating, MPFR_RNDN);
+      break;
+    default:
+      _calc_value_clear_fr (fr);
+      return -1;
+    }
+  _calc_value_take_fr (result, fr);
+  return ret;
+}
+
+/**
+ * calc_value_log10:
+ * @result: where to store the result
+ * @self: the value
+ *
+ * Sets the value of @result to the decimal logarithm of @self. Any previous
+ * value in @result is erased.
+ *
+ * Returns: zero if the calculation is exact, positive if the calculation is
+ * slightly larger than the actual value, and negative if the calculation is
+ * slightly smaller than the actual value
+ **/
+
+gint
+calc_value_log10 (CalcValue *result, const CalcValue *self)
+{
+  CalcValueView view;
+  gint ret;
+  mpfr_t temp;
+  mpfr_t fr;
+  if (self->type == CALC_NUMBER_TYPE_DECIMAL)
+    return calc_value_trans_decimal (result, self, calc_value_log10);
+  if (self->type == CALC_NUMBER_TYPE_DOUBLE)
+    {
+      _calc_value_take_d (result, log10 (self->native));
+      return 0;
+    }
+  _calc_value_init_fr (fr, _calc_value_result_prec (self, 0));
+  switch (self->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      mpfr_init2 (temp, mpfr_get_prec (fr));
+      mpfr_set_z (temp, _calc_value_get_z (self, &view), MPFR_RNDN);
+      ret = mpfr_log10 (fr, temp, MPFR_RNDN);
+      mpfr_clear (temp);
+      break;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      mpfr_init2 (temp, mpfr_get_prec (fr));
+      mpfr_set_q (temp, _calc_value_get_q (self, &view), MPFR_RNDN);
+      ret = mpfr_log10 (fr, temp, MPFR_RNDN);
+      mpfr_clear (temp);
+      break;
+    case CALC_NUMBER_TYPE_FLOATING:
+      ret = mpfr_log10 (fr, self->floating, MPFR_RNDN);
+      break;
+    default:
+      _calc_value_clear_fr (fr);
+      return -1;
+    }
+  _calc_value_take_fr (result, fr);
+  return ret;
+}
+
+/* Number of bases whose logarithms are cached by each thread */
+#define CALC_VALUE_LOG_CACHE_SIZE 8
+
+/* A logarithm base, where @base is @root raised to @power and @root is not a
+   perfect power */
+typedef struct
+{
+  gulong base;
+  gulong root;
+  gulong power;
+  mpfr_t log2;
+} CalcValueLogBase;
+
+typedef struct
+{
+  CalcValueLogBase bases[CALC_VALUE_LOG_CACHE_SIZE];
+  guint n_bases;
+  guint next;
+} CalcValueLogCache;
+
+static void calc_value_log_cache_free (gpointer data);
+
+static GPrivate calc_value_log_cache =
+  G_PRIVATE_INIT (calc_value_log_cache_free);
+
+static void
+calc_value_log_cache_free (gpointer data)
+{
+  CalcValueLogCache *cache = data;
+  while (cache->n_bases > 0)
+    mpfr_clear (cache->bases[--cache->n_bases].log2);
+  g_free (cache);
+}
+
+static void
+calc_value_log_base_init (CalcValueLogBase *self, gulong base)
+{
+  mpz_t z;
+  mpz_t root;
+  mpfr_t temp;
+  gulong n;
+
+  self->base = base;
+  self->root = base;
+  self->power = 1;
+  mpz_init_set_ui (z, base);
+  if (mpz_perfect_power_p (z))
+    {
+      /* The largest power gives the smallest root */
+      mpz_init (root);
+      for (n = mpz_sizeinbase (z, 2) - 1; n > 1; n--)
+	{
+	  if (mpz_root (root, z, n))
+	    {
+	      self->root = mpz_get_ui (root);
+	      self->power = n;
+	      break;
+	    }
+	}
+      mpz_clear (root);
+    }
+  mpz_clear (z);
+
+  mpfr_init2 (temp, GLIB_SIZEOF_LONG * 8);
+  mpfr_set_ui (temp, base, MPFR_RNDN);
+  mpfr_log2 (self->log2, temp, MPFR_RNDN);
+  mpfr_clear (temp);
+}
+
+/* Looks up @base in the cache of the calling thread, computing its binary
+   logarithm with a precision of @prec if it is not already cached */
+
+static const CalcValueLogBase *
+calc_value_log_base_get (gulong base, mpfr_prec_t prec)
+{
+  CalcValueLogCache *cache = g_private_get (&calc_value_log_cache);
+  CalcValueLogBase *entry;
+  guint i;
+
+  if (cache == NULL)
+    {
+      cache = g_new0 (CalcValueLogCache, 1);
+      g_private_set (&calc_value_log_cache, cache);
+    }
+  for (i = 0; i < cache->n_bases; i++)
+    {
+      entry = &cache->bases[i];
+      if (entry->base == base && mpfr_get_prec (entry->log2) == prec)
+	return entry;
+    }
+
+  if (cache->n_bases < CALC_VALUE_LOG_CACHE_SIZE)
+    {
+      entry = &cache->bases[cache->n_bases++];
+      mpfr_init2 (entry->log2, prec);
+    }
+  else
+    {
+      entry = &cache->bases[cache->next];
+      cache->next = (cache->next + 1) % CALC_VALUE_LOG_CACHE_SIZE;
+      mpfr_set_prec (entry->log2, prec);
+    }
+  calc_value_log_base_init (entry, base);
+  return entry;
+}
+
+/* Stores the logarithm of @self in @result if @self is an integer or
+   reciprocal power of the root of @base, which makes the logarithm
+   rational */
+
+static gboolean
+calc_value_logn_exact (CalcValue *result, const CalcValue *self,
+		       const CalcValueLogBase *base)
+{
+  CalcValueView view;
+  mpq_srcptr q;
+  mpz_srcptr x;
+  mpz_t rest;
+  mpz_t root;
+  gboolean exact;
+  gulong k;
+  glong num;
+  gulong den;
+
+  if (!_calc_value_type_is_exact (self->type) || calc_value_sgn (self) <= 0)
+    return FALSE;
+  q = _calc_value_get_q (self, &view);
+  if (mpz_cmp_ui (mpq_denref (q), 1) == 0)
+    x = mpq_numref (q);
+  else if (mpz_cmp_ui (mpq_numref (q), 1) == 0)
+    x = mpq_denref (q);
+  else
+    return FALSE;
+
+  mpz_init (rest);
+  mpz_init_set_ui (root, base->root);
+  k = mpz_remove (rest, x, root);
+  exact = mpz_cmp_ui (rest, 1) == 0;
+  mpz_clears (rest, root, NULL);
+  if (!exact || k > G_MAXLONG)
+    return FALSE;
+
+  _calc_value_small_div (&num, &den, x == mpq_numref (q) ? k : -(glong) k, 1,
+			 base->power, 1);
+  _calc_value_release (result);
+  _calc_value_set_small (result, den == 1 ? CALC_NUMBER_TYPE_INTEGER :
+			 CALC_NUMBER_TYPE_RATIONAL, num, den);
+  return TRUE;
+}
+
+/**
+ * calc_value_logn:
+ * @result: where to store the result
+ * @self: the value
+ * @base: the base of the logarithm
+ *
+ * Sets the value of @result to the base-@base logarithm of @self. Any
+ * previous value of @result will be erased. If @self is an exact power of
+ * @base with an integer or rational exponent, the result is that exponent
+ * and is exact. If @base is zero or one, no action is performed and this
+ * function returns -1.
+ *
+ * The binary logarithm of @base is cached by each thread, so repeated
+ * logarithms in the same base only compute one logarithm each.
+ *
+ * Returns: zero if the calculation succeeded
+ **/
+
+gint
+calc_value_logn (CalcValue *result, const CalcValue *self, unsigned long base)
+{
+  const CalcValueLogBase *entry;
+  mpfr_prec_t prec;
+  if (base < 2)
+    return -1;
+  if (self->type == CALC_NUMBER_TYPE_DECIMAL)
+    {
+      CalcValue temp;
+      gint ret = calc_value_logn (result,
+				  _calc_value_decimal_to_q (self, &temp),
+				  base);
+      calc_value_clear (&temp);
+      return ret;
+    }
+  if (self->type == CALC_NUMBER_TYPE_DOUBLE)
+    {
+      _calc_value_take_d (result, log2 (self->native) / log2 (base));
+      return 0;
+    }
+
+  prec = _calc_value_result_prec (self, 0);
+  entry = calc_value_log_base_get (base, prec);
+  if (calc_value_logn_exact (result, self, entry))
+    return 0;
+  calc_value_log2 (result, self);
+  mpfr_div (result->floating, result->floating, entry->log2, MPFR_RNDN);
+  return 0;
+}
+
+/* Exact powers are not attempted if the result would be larger than this
+   many bits */
+#define CALC_VALUE_POW_MAX_BITS (1UL << 24)
+
+/* Raises @a to the integer power @b exactly and stores the result in
+   @result. An integer result is only produced if @type is an integer type.
+   Returns FALSE without modifying @result if the result is not a rational
+   number or would be too large. */
+
+static gboolean
+calc_value_pow_exact_z (CalcValue *result, mpq_srcptr a, CalcNumberType type,
+			mpz_srcptr b)
+{
+  gsize bits;
+  gulong exp;
+  mpq_t q;
+  mpz_t z;
+
+  if (mpz_sgn (b) < 0 && mpq_sgn (a) == 0)
+    return FALSE;
+  if (mpz_cmp_ui (mpq_denref (a), 1) == 0
+      && mpz_cmpabs_ui (mpq_numref (a), 1) <= 0)
+    {
+      /* Powers of 0, 1 and -1 can be found for any exponent */
+      glong num = mpz_get_si (mpq_numref (a));
+      if (mpz_sgn (b) == 0 || (num == -1 && mpz_even_p (b)))
+	num = 1;
+      _calc_value_release (result);
+      _calc_value_set_small (result, type, num, 1);
+      return TRUE;
+    }
+
+  /* Any other base has at least two bits in its numerator or denominator */
+  if (mpz_cmpabs_ui (b, CALC_VALUE_POW_MAX_BITS) > 0)
+    return FALSE;
+
+  exp = mpz_get_ui (b);
+  bits = MAX (mpz_sizeinbase (mpq_numref (a), 2),
+	      mpz_sizeinbase (mpq_denref (a), 2));
+  if (exp > CALC_VALUE_POW_MAX_BITS / bits)
+    return FALSE;
+
+  _calc_value_init_q (q);
+  mpz_pow_ui (mpq_numref (q), mpq_numref (a), exp);
+  mpz_pow_ui (mpq_denref (q), mpq_denref (a), exp);
+  if (mpz_sgn (b) < 0)
+    mpq_inv (q, q);
+  if (type == CALC_NUMBER_TYPE_INTEGER && mpz_cmp_ui (mpq_denref (q), 1) == 0)
+    {
+      _calc_value_init_z (z);
+      mpz_swap (z, mpq_numref (q));
+      _calc_value_clear_q (q);
+      _calc_value_take_z (result, z);
+    }
+  else
+    _calc_value_take_q (result, q);
+  return TRUE;
+}
+
+/* Raises @a to the rational power @b exactly if the numerator and
+   denominator of @a are perfect powers of the denominator of @b. Roots of
+   negative numbers are left to MPFR. */
+
+static gboolean
+calc_value_pow_exact_q (CalcValue *result, mpq_srcptr a, CalcNumberType type,
+			mpq_srcptr b)
+{
+  gboolean ret;
+  gulong n;
+  mpq_t root;
+
+  if (!mpz_fits_ulong_p (mpq_denref (b)))
+    return FALSE;
+  n = mpz_get_ui (mpq_denref (b));
+  if (n == 1)
+    return calc_value_pow_exact_z (result, a, type, mpq_numref (b));
+  if (mpq_sgn (a) < 0)
+    return FALSE;
+  mpq_init (root);
+  ret = mpz_root (mpq_numref (root), mpq_numref (a), n)
+    && mpz_root (mpq_denref (root), mpq_denref (a), n)
+    && calc_value_pow_exact_z (result, root, type, mpq_numref (b));
+  mpq_clear (root);
+  return ret;
+}
+
+/**
+ * calc_value_pow:
+ * @result: where to store the result of the exponentiation
+ * @a: the base value
+ * @b: the power to raise the base to
+ *
+ * Sets the value of @result to @a raised the @b power. Any previous value in
+ * @result will be erased. If @a and @b are exact and the result is a
+ * rational number, the result is exact and has the type of @a, or is a
+ * rational number if @b is negative and the result is not an integer.
+ * Otherwise the result is a floating-point number.
+ *
+ * Returns: zero if the calculation is exact, positive if the calculation is
+ * slightly larger than the actual value, and negative if the calculation is
+ * slightly smaller than the actual value
+ **/
+
+gint
+calc_value_pow (CalcValue *result, const CalcValue *a, const CalcValue *b)
+{
+  CalcValueView va;
+  CalcValueView vb;
+  gint ret;
+  mpfr_prec_t prec;
+  mpfr_t base;
+  mpfr_t power;
+  mpfr_t fr;
+
+  if (a->type == CALC_NUMBER_TYPE_DECIMAL
+      || b->type == CALC_NUMBER_TYPE_DECIMAL)
+    {
+      CalcValue ta;
+      CalcValue tb;
+      const CalcValue *qa = _calc_value_decimal_to_q (a, &ta);
+      const CalcValue *qb = _calc_value_decimal_to_q (b, &tb);
+      ret = calc_value_pow (result, qa, qb);
+      if (qa == &ta)
+	calc_value_clear (&ta);
+      if (qb == &tb)
+	calc_value_clear (&tb);
+      return ret;
+    }
+  if (_calc_value_get_final_type (a->type, b->type)
+      == CALC_NUMBER_TYPE_DOUBLE)
+    {
+      _calc_value_take_d (result, pow (calc_value_get_double (a),
+				       calc_value_get_double (b)));
+      return 0;
+    }
+  if (b->small && b->type == CALC_NUMBER_TYPE_INTEGER)
+    {
+      CalcNumberType type = a->type;
+      if (b->small_num == 1)
+	{
+	  calc_value_set (result, a);
+	  return 0;
+	}
+      if (b->small_num == 0 && _calc_value_type_is_exact (type))
+	{
+	  _calc_value_release (result);
+	  _calc_value_set_small (result, type, 1, 1);
+	  return 0;
+	}
+    }
+
+  prec = _calc_value_result_prec (a, calc_value_get_prec (b));
+  if (_calc_value_type_is_exact (a->type))
+    {
+      switch (b->type)
+	{
+	case CALC_NUMBER_TYPE_INTEGER:
+	  if (calc_value_pow_exact_z (result, _calc_value_get_q (a, &va),
+				      a->type, _calc_value_get_z (b, &vb)))
+	    return 0;
+	  break;
+	case CALC_NUMBER_TYPE_RATIONAL:
+	  if (calc_value_pow_exact_q (result, _calc_value_get_q (a, &va),
+				      a->type, _calc_value_get_q (b, &vb)))
+	    return 0;
+	  break;
+	}
+    }
+  else if (b->type == CALC_NUMBER_TYPE_INTEGER)
+    {
+      _calc_value_init_fr (fr, prec);
+      ret = mpfr_pow_z (fr, _calc_value_get_fr (a, &va),
+			_calc_value_get_z (b, &vb), MPFR_RNDN);
+      _calc_value_take_fr (result, fr);
+      return ret;
+    }
+
+  switch (a->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      mpfr_init2 (base, prec);
+      mpfr_set_z (base, _calc_value_get_z (a, &va), MPFR_RNDN);
+      break;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      mpfr_init2 (base, prec);
+      mpfr_set_q (base, _calc_value_get_q (a, &va), MPFR_RNDN);
+      break;
+    case CALC_NUMBER_TYPE_DOUBLE:
+    case CALC_NUMBER_TYPE_FLOATING:
+      mpfr_init2 (base, calc_value_get_prec (a));
+      mpfr_set (base, _calc_value_get_fr (a, &va), MPFR_RNDN);
+      break;
+    default:
+      return -1;
+    }
+  switch (b->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      mpfr_init2 (power, prec);
+      mpfr_set_z (power, _calc_value_get_z (b, &vb), MPFR_RNDN);
+      break;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      mpfr_init2 (power, prec);
+      mpfr_set_q (power, _calc_value_get_q (b, &vb), MPFR_RNDN);
+      break;
+    case CALC_NUMBER_TYPE_DOUBLE:
+    case CALC_NUMBER_TYPE_FLOATING:
+      mpfr_init2 (power, calc_value_get_prec (b));
+      mpfr_set (power, _calc_value_get_fr (b, &vb), MPFR_RNDN);
+      break;
+    default:
+      mpfr_clear (base);
+      return -1;
+    }
+
+  _calc_value_init_fr (fr, prec);
+  ret = mpfr_pow (fr, base, power, MPFR_RNDN);
+  _calc_value_take_fr (result, fr);
+  mpfr_clear (base);
+  mpfr_clear (power);
+  return ret;
+}
+
+/* An MPFR function of one argument, and the same function from the C
+   library */
+typedef int (*CalcValueFunc) (mpfr_ptr, mpfr_srcptr, mpfr_rnd_t);
+typedef gdouble (*CalcValueNativeFunc) (gdouble);
+
+/* Stores @func applied to @self in @result, or @native if @self is a
+   double. Exact operands are converted with enough precision that only the
+   result is rounded, except that rationals are rounded to a few more bits
+   than the result. If @self is exactly @x, the result is the exact integer
+   @y. */
+
+static gint
+calc_value_apply (CalcValue *result, const CalcValue *self,
+		  CalcValueFunc func, CalcValueNativeFunc native, glong x,
+		  glong y)
+{
+  CalcValueView view;
+  mpz_srcptr z;
+  gint ret;
+  mpfr_t temp;
+  mpfr_t fr;
+
+  if (self->type == CALC_NUMBER_TYPE_DECIMAL)
+    {
+      CalcValue q;
+      ret = calc_value_apply (result, _calc_value_decimal_to_q (self, &q),
+			      func, native, x, y);
+      calc_value_clear (&q);
+      return ret;
+    }
+  if (self->type == CALC_NUMBER_TYPE_DOUBLE)
+    {
+      _calc_value_take_d (result, native (self->native));
+      return 0;
+    }
+  if (self->type != CALC_NUMBER_TYPE_FLOATING
+      && calc_value_cmp_si (self, x) == 0)
+    {
+      _calc_value_release (result);
+      _calc_value_set_small (result, CALC_NUMBER_TYPE_INTEGER, y, 1);
+      return 0;
+    }
+
+  _calc_value_init_fr (fr, _calc_value_result_prec (self, 0));
+  switch (self->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      z = _calc_value_get_z (self, &view);
+      mpfr_init2 (temp, MAX (mpz_sizeinbase (z, 2), MPFR_PREC_MIN));
+      mpfr_set_z (temp, z, MPFR_RNDN);
+      ret = func (fr, temp, MPFR_RNDN);
+      mpfr_clear (temp);
+      break;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      mpfr_init2 (temp, mpfr_get_prec (fr) + GMP_NUMB_BITS);
+      mpfr_set_q (temp, _calc_value_get_q (self, &view), MPFR_RNDN);
+      ret = func (fr, temp, MPFR_RNDN);
+      mpfr_clear (temp);
+      break;
+    case CALC_NUMBER_TYPE_FLOATING:
+      ret = func (fr, self->floating, MPFR_RNDN);
+      break;
+    default:
+      _calc_value_clear_fr (fr);
+      return -1;
+    }
+  _calc_value_take_fr (result, fr);
+  return ret;
+}
+
+/**
+ * calc_value_exp:
+ * @result: where to store the result
+ * @self: the value
+ *
+ * Sets the value of @result to the exponential of @self. Any previous value
+ * in @result is erased. If @self is exactly zero, the result is exactly one.
+ *
+ * Returns: zero if the calculation is exact, positive if the calculation is
+ * slightly larger than the actual value, and negative if the calculation is
+ * slightly smaller than the actual value
+ **/
+
+gint
+calc_value_exp (CalcValue *result, const CalcValue *self)
+{
+  return calc_value_apply (result, self, mpfr_exp, exp, 0, 1);
+}
+
+/* Stores the square root of @self in @result if @self is an exact perfect
+   square, or the quotient of two perfect squares */
+
+static gboolean
+calc_value_sqrt_exact (CalcValue *result, const CalcValue *self)
+{
+  CalcValueView view;
+  mpz_srcptr x;
+  mpq_srcptr q;
+  mpz_t z;
+  mpq_t root;
+
+  if (self->type == CALC_NUMBER_TYPE_INTEGER)
+    {
+      x = _calc_value_get_z (self, &view);
+      if (!mpz_perfect_square_p (x))
+	return FALSE;
+      _calc_value_init_z (z);
+      mpz_sqrt (z, x);
+      _calc_value_take_z (result, z);
+      return TRUE;
+    }
+
+  q = _calc_value_get_q (self, &view);
+  if (!mpz_perfect_square_p (mpq_numref (q))
+      || !mpz_perfect_square_p (mpq_denref (q)))
+    return FALSE;
+  _calc_value_init_q (root);
+  mpz_sqrt (mpq_numref (root), mpq_numref (q));
+  mpz_sqrt (mpq_denref (root), mpq_denref (q));
+  _calc_value_take_q (result, root);
+  return TRUE;
+}
+
+/**
+ * calc_value_sqrt:
+ * @result: where to store the result
+ * @self: the value
+ *
+ * Sets the value of @result to the square root of @self. Any previous value
+ * in @result is erased. If @self is an integer or rational whose numerator
+ * and denominator are perfect squares, the result is exact and has the same
+ * type as @self.
+ *
+ * Returns: zero if the calculation is exact, positive if the calculation is
+ * slightly larger than the actual value, and negative if the calculation is
+ * slightly smaller than the actual value
+ **/
+
+gint
+calc_value_sqrt (CalcValue *result, const CalcValue *self)
+{
+  if (self->type == CALC_NUMBER_TYPE_DECIMAL)
+    return calc_value_trans_decimal (result, self, calc_value_sqrt);
+  if (_calc_value_type_is_exact (self->type) && calc_value_sgn (self) >= 0
+      && calc_value_sqrt_exact (result, self))
+    return 0;
+  return calc_value_apply (result, self, mpfr_sqrt, sqrt, 0, 0);
+}
+
+/**
+ * calc_value_sin:
+ * @result: where to store the result
+ * @self: the value
+ *
+ * Sets the value of @result to the sine of @self, in radians. Any previous
+ * value in @result is erased. If @self is exactly zero, the result is
+ * exactly zero.
+ *
+ * Returns: zero if the calculation is exact, positive if the calculation is
+ * slightly larger than the actual value, and negative if the calculation is
+ * slightly smaller than the actual value
+ **/
+
+gint
+calc_value_sin (CalcValue *result, const CalcValue *self)
+{
+  return calc_value_apply (result, self, mpfr_sin, sin, 0, 0);
+}
+
+/**
+ * calc_value_cos:
+ * @result: where to store the result
+ * @self: the value
+ *
+ * Sets the value of @result to the cosine of @self, in radians. Any previous
+ * value in @result is erased. If @self is exactly zero, the result is
+ * exactly one.
+ *
+ * Returns: zero if the calculation is exact, positive if the calculation is
+ * slightly larger than the actual value, and negative if the calculation is
+ * slightly smaller than the actual value
+ **/
+
+gint
+calc_value_cos (CalcValue *result, const CalcValue *self)
+{
+  return calc_value_apply (result, self, mpfr_cos, cos, 0, 1);
+}
+
+/**
+ * calc_value_tan:
+ * @result: where to store the result
+ * @self: the value
+ *
+ * Sets the value of @result to the tangent of @self, in radians. Any
+ * previous value in @result is erased. If @self is exactly zero, the result
+ * is exactly zero.
+ *
+ * Returns: zero if the calculation is exact, positive if the calculation is
+ * slightly larger than the actual value, and negative if the calculation is
+ * slightly smaller than the actual value
+ **/
+
+gint
+calc_value_tan (CalcValue *result, const CalcValue *self)
+{
+  return calc_value_apply (result, self, mpfr_tan, tan, 0, 0);
+}
+
+/**
+ * calc_value_asin:
+ * @result: where to store the result
+ * @self: the value
+ *
+ * Sets the value of @result to the arc-sine of @self in radians. Any
+ * previous value in @result is erased. If @self is exactly zero, the result
+ * is exactly zero.
+ *
+ * Returns: zero if the calculation is exact, positive if the calculation is
+ * slightly larger than the actual value, and negative if the calculation is
+ * slightly smaller than the actual value
+ **/
+
+gint
+calc_value_asin (CalcValue *result, const CalcValue *self)
+{
+  return calc_value_apply (result, self, mpfr_asin, asin, 0, 0);
+}
+
+/**
+ * calc_value_acos:
+ * @result: where to store the result
+ * @self: the value
+ *
+ * Sets the value of @result to the arc-cosine of @self in radians. Any
+ * previous value in @result is erased. If @self is exactly one, the result
+ * is exactly zero.
+ *
+ * Returns: zero if the calculation is exact, positive if the calculation is
+ * slightly larger than the actual value, and negative if the calculation is
+ * slightly smaller than the actual value
+ **/
+
+gint
+calc_value_acos (CalcValue *result, const CalcValue *self)
+{
+  return calc_value_apply (result, self, mpfr_acos, acos, 1, 0);
+}
+
+/**
+ * calc_value_atan:
+ * @result: where to store the result
+ * @self: the value
+ *
+ * Sets the value of @result to the arc-tangent of @self in radians. Any
+ * previous value in @result is erased. If @self is exactly zero, the result
+ * is exactly zero.
+ *
+ * Returns: zero if the calculation is exact, positive if the calculation is
+ * slightly larger than the actual value, and negative if the calculation is
+ * slightly smaller than the actual value
+ **/
+
+gint
+calc_value_atan (CalcValue *result, const CalcValue *self)
+{
+  return calc_value_apply (result, self, mpfr_atan, atan, 0, 0);
+}
+
+/**
+ * calc_value_sinh:
+ * @result: where to store the result
+ * @self: the value
+ *
+ * Sets the value of @result to the hyperbolic sine of @self. Any previous
+ * value in @result is erased. If @self is exactly zero, the result is
+ * exactly zero.
+ *
+ * Returns: zero if the calculation is exact, positive if the calculation is
+ * slightly larger than the actual value, and negative if the calculation is
+ * slightly smaller than the actual value
+ **/
+
+gint
+calc_value_sinh (CalcValue *result, const CalcValue *self)
+{
+  return calc_value_apply (result, self, mpfr_sinh, sinh, 0, 0);
+}
+
+/**
+ * calc_value_cosh:
+ * @result: where to store the result
+ * @self: the value
+ *
+ * Sets the value of @result to the hyperbolic cosine of @self. Any previous
+ * value in @result is erased. If @self is exactly zero, the result is
+ * exactly one.
+ *
+ * Returns: zero if the calculation is exact, positive if the calculation is
+ * slightly larger than the actual value, and negative if the calculation is
+ * slightly smaller than the actual value
+ **/
+
+gint
+calc_value_cosh (CalcValue *result, const CalcValue *self)
+{
+  return calc_value_apply (result, self, mpfr_cosh, cosh, 0, 1);
+}
+
+/**
+ * calc_value_tanh:
+ * @result: where to store the result
+ * @self: the value
+ *
+ * Sets the value of @result to the hyperbolic tangent of @self. Any previous
+ * value in @result is erased. If @self is exactly zero, the result is
+ * exactly zero.
+ *
+ * Returns: zero if the calculation is exact, positive if the calculation is
+ * slightly larger than the actual value, and negative if the calculation is
+ * slightly smaller than the actual value
+ **/
+
+gint
+calc_value_tanh (CalcValue *result, const CalcValue *self)
+{
+  return calc_value_apply (result, self, mpfr_tanh, tanh, 0, 0);
+}
+
+/**
+ * calc_value_asinh:
+ * @result: where to store the result
+ * @self: the value
+ *
+ * Sets the value of @result to the inverse hyperbolic sine of @self. Any
+ * previous value in @result is erased. If @self is exactly zero, the result
+ * is exactly zero.
+ *
+ * Returns: zero if the calculation is exact, positive if the calculation is
+ * slightly larger than the actual value, and negative if the calculation is
+ * slightly smaller than the actual value
+ **/
+
+gint
+calc_value_asinh (CalcValue *result, const CalcValue *self)
+{
+  return calc_value_apply (result, self, mpfr_asinh, asinh, 0, 0);
+}
+
+/**
+ * calc_value_acosh:
+ * @result: where to store the result
+ * @self: the value
+ *
+ * Sets the value of @result to the inverse hyperbolic cosine of @self. Any
+ * previous value in @result is erased. If @self is exactly one, the result
+ * is exactly zero.
+ *
+ * Returns: zero if the calculation is exact, positive if the calculation is
+ * slightly larger than the actual value, and negative if the calculation is
+ * slightly smaller than the actual value
+ **/
+
+gint
+calc_value_acosh (CalcValue *result, const CalcValue *self)
+{
+  return calc_value_apply (result, self, mpfr_acosh, acosh, 1, 0);
+}
+
+/**
+ * calc_value_atanh:
+ * @result: where to store the result
+ * @self: the value
+ *
+ * Sets the value of @result to the inverse hyperbolic tangent of @self. Any
+ * previous value in @result is erased. If @self is exactly zero, the result
+ * is exactly zero.
+ *
+ * Returns: zero if the calculation is exact, positive if the calculation is
+ * slightly larger than the actual value, and negative if the calculation is
+ * slightly smaller than the actual value
+ **/
+
+gint
+calc_value_atanh (CalcValue *result, const CalcValue *self)
+{
+  return calc_value_apply (result, self, mpfr_atanh, atanh, 0, 0);
+}
@@ -0,0 +1,1153 @@
+/*************************************************************************
+ * calc-value.c -- This file is part of libcalc.                         *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+
+#define _LIBCALC_INTERNAL
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <float.h>
+#include <math.h>
+#include "calc-value.h"
+
+/* Magnitude of an inline numerator, valid for G_MINLONG */
+#define ABS_SMALL(x) ((x) < 0 ? -(gulong) (x) : (gulong) (x))
+
+/* Largest magnitude below which every integer is exactly a double */
+#define CALC_VALUE_DOUBLE_EXACT (G_GUINT64_CONSTANT (1) << DBL_MANT_DIG)
+
+G_STATIC_ASSERT (sizeof (mp_limb_t) >= sizeof (gulong));
+
+/**
+ * calc_value_init:
+ * @self: the value to initialize
+ *
+ * Initializes @self to an integer value of zero.
+ **/
+
+void
+calc_value_init (CalcValue *self)
+{
+  _calc_value_set_small (self, CALC_NUMBER_TYPE_INTEGER, 0, 1);
+}
+
+/**
+ * calc_value_init_set:
+ * @self: the value to initialize
+ * @value: the value to initialize to
+ *
+ * Initializes @self to a copy of @value.
+ **/
+
+void
+calc_value_init_set (CalcValue *self, const CalcValue *value)
+{
+  self->small = FALSE;
+  self->unreduced = FALSE;
+  self->type = -1; /* Don't free anything */
+  calc_value_set (self, value);
+}
+
+/**
+ * calc_value_init_z:
+ * @self: the value to initialize
+ * @value: the value to initialize to
+ *
+ * Initializes @self to the GNU MP integer @value. The value will have a type
+ * set to %CALC_NUMBER_TYPE_INTEGER.
+ **/
+
+void
+calc_value_init_z (CalcValue *self, mpz_t value)
+{
+  if (mpz_fits_slong_p (value))
+    _calc_value_set_small (self, CALC_NUMBER_TYPE_INTEGER, mpz_get_si (value),
+			   1);
+  else
+    {
+      mpz_init_set (self->integer, value);
+      self->small = FALSE;
+      self->unreduced = FALSE;
+      self->type = CALC_NUMBER_TYPE_INTEGER;
+    }
+}
+
+/**
+ * calc_value_init_q:
+ * @self: the value to initialize
+ * @value: the value to initialize to
+ *
+ * Initializes @self to the GNU MP rational number @value. The value will have
+ * a type set to %CALC_NUMBER_TYPE_RATIONAL.
+ **/
+
+void
+calc_value_init_q (CalcValue *self, mpq_t value)
+{
+  if (mpz_fits_slong_p (mpq_numref (value))
+      && mpz_fits_ulong_p (mpq_denref (value)))
+    _calc_value_set_small (self, CALC_NUMBER_TYPE_RATIONAL,
+			   mpz_get_si (mpq_numref (value)),
+			   mpz_get_ui (mpq_denref (value)));
+  else
+    {
+      mpq_init (self->rational);
+      mpq_set (self->rational, value);
+      self->small = FALSE;
+      self->unreduced = FALSE;
+      self->type = CALC_NUMBER_TYPE_RATIONAL;
+    }
+}
+
+/**
+ * calc_value_init_f:
+ * @self: the value to initialize
+ * @value: the value to initialize to
+ *
+ * Initializes @self to the GNU MP floating-point number @value. The value
+ * will have a type set to %CALC_NUMBER_TYPE_FLOATING and the same precision
+ * as @value.
+ **/
+
+void
+calc_value_init_f (CalcValue *self, mpf_t value)
+{
+  mpfr_init2 (self->floating, mpf_get_prec (value));
+  mpfr_set_f (self->floating, value, MPFR_RNDN);
+  self->small = FALSE;
+  self->unreduced = FALSE;
+  self->type = CALC_NUMBER_TYPE_FLOATING;
+}
+
+/**
+ * calc_value_init_fr:
+ * @self: the value to initialize
+ * @value: the value to initialize to
+ *
+ * Initializes @self to the GNU MPFR floating-point number @value. The value
+ * will have a type set to %CALC_NUMBER_TYPE_FLOATING and the same precision
+ * as @value.
+ **/
+
+void
+calc_value_init_fr (CalcValue *self, mpfr_t value)
+{
+  mpfr_init2 (self->floating, mpfr_get_prec (value));
+  mpfr_set (self->floating, value, MPFR_RNDN);
+  self->small = FALSE;
+  self->unreduced = FALSE;
+  self->type = CALC_NUMBER_TYPE_FLOATING;
+}
+
+/**
+ * calc_value_init_d:
+ * @self: the value to initialize
+ * @value: the value to initialize to
+ *
+ * Initializes @self to the 64-bit floating-point number @value. The value
+ * will have a type set to %CALC_NUMBER_TYPE_FLOATING and a precision of
+ * %DBL_MANT_DIG bits.
+ **/
+
+void
+calc_value_init_d (CalcValue *self, double value)
+{
+  mpfr_init2 (self->floating, DBL_MANT_DIG);
+  mpfr_set_d (self->floating, value, MPFR_RNDN);
+  self->small = FALSE;
+  self->unreduced = FALSE;
+  self->type = CALC_NUMBER_TYPE_FLOATING;
+}
+
+/**
+ * calc_value_init_double:
+ * @self: the value to initialize
+ * @value: the value to initialize to
+ *
+ * Initializes @self to the hardware double @value. The value will have a
+ * type set to %CALC_NUMBER_TYPE_DOUBLE, and arithmetic on it is done
+ * natively instead of with GNU MPFR.
+ **/
+
+void
+calc_value_init_double (CalcValue *self, gdouble value)
+{
+  self->native = value;
+  self->small = FALSE;
+  self->unreduced = FALSE;
+  self->type = CALC_NUMBER_TYPE_DOUBLE;
+}
+
+/**
+ * calc_value_init_decimal:
+ * @self: the value to initialize
+ * @coefficient: the digits of the value
+ * @scale: the number of digits after the decimal point
+ *
+ * Initializes @self to @coefficient divided by 10 raised to @scale, so a
+ * @coefficient of 1250 and a @scale of 2 give 12.50. The value will have a
+ * type set to %CALC_NUMBER_TYPE_DECIMAL. If @scale is greater than
+ * %CALC_VALUE_DECIMAL_MAX_SCALE, @self is initialized to zero instead.
+ **/
+
+void
+calc_value_init_decimal (CalcValue *self, signed long coefficient,
+			 guint scale)
+{
+  _calc_value_set_decimal (self, 0, 0);
+  g_return_if_fail (scale <= CALC_VALUE_DECIMAL_MAX_SCALE);
+  _calc_value_set_decimal (self, coefficient, scale);
+}
+
+/**
+ * calc_value_init_ui:
+ * @self: the value to initialize
+ * @value: the value to initialize to
+ *
+ * Initializes @self to the unsigned integer @value. The value will have a
+ * type set to %CALC_NUMBER_TYPE_INTEGER.
+ **/
+
+void
+calc_value_init_ui (CalcValue *self, unsigned long value)
+{
+  if (value <= G_MAXLONG)
+    _calc_value_set_small (self, CALC_NUMBER_TYPE_INTEGER, value, 1);
+  else
+    {
+      mpz_init_set_ui (self->integer, value);
+      self->small = FALSE;
+      self->unreduced = FALSE;
+      self->type = CALC_NUMBER_TYPE_INTEGER;
+    }
+}
+
+/**
+ * calc_value_init_si:
+ * @self: the value to initialize
+ * @value: the value to initialize to
+ *
+ * Initializes @self to the signed integer @value. The value will have a type
+ * set to %CALC_NUMBER_TYPE_INTEGER.
+ **/
+
+void
+calc_value_init_si (CalcValue *self, signed long value)
+{
+  _calc_value_set_small (self, CALC_NUMBER_TYPE_INTEGER, value, 1);
+}
+
+/**
+ * calc_value_clear:
+ * @self: the value to clear
+ *
+ * Frees the memory used by @self. @self must be initialized again before
+ * being used.
+ **/
+
+void
+calc_value_clear (CalcValue *self)
+{
+  _calc_value_release (self);
+}
+
+/**
+ * calc_value_get_double:
+ * @self: the value
+ *
+ * Converts @self to the nearest hardware double. Values too large in
+ * magnitude to be represented become infinite.
+ *
+ * Returns: the value of @self as a double
+ **/
+
+gdouble
+calc_value_get_double (const CalcValue *self)
+{
+  CalcValueView view;
+
+  /* Both parts convert exactly, so the division rounds only once */
+  if (self->small && ABS_SMALL (self->small_num) <= CALC_VALUE_DOUBLE_EXACT
+      && self->small_den <= CALC_VALUE_DOUBLE_EXACT)
+    return (gdouble) self->small_num / (gdouble) self->small_den;
+  switch (self->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      if (self->small)
+	return self->small_num;
+      return _calc_value_get_d_z (self->integer);
+    case CALC_NUMBER_TYPE_RATIONAL:
+      return _calc_value_get_d_q (_calc_value_get_q (self, &view));
+    case CALC_NUMBER_TYPE_DECIMAL:
+      {
+	CalcValue temp;
+	gdouble value;
+	value = calc_value_get_double (_calc_value_decimal_to_q (self, &temp));
+	calc_value_clear (&temp);
+	return value;
+      }
+    case CALC_NUMBER_TYPE_DOUBLE:
+      return self->native;
+    case CALC_NUMBER_TYPE_FLOATING:
+      return mpfr_get_d (self->floating, MPFR_RNDN);
+    default:
+      return 0;
+    }
+}
+
+/**
+ * calc_value_set:
+ * @result: where to store the copied value
+ * @self: the value to copy
+ *
+ * Copies the value of @self into @result. Any previous value of @result is
+ * erased.
+ **/
+
+void
+calc_value_set (CalcValue *result, const CalcValue *self)
+{
+  if (result == self)
+    return;
+  _calc_value_release (result);
+  if (self->small)
+    {
+      _calc_value_set_small (result, self->type, self->small_num,
+			     self->small_den);
+      return;
+    }
+  result->type = self->type;
+  switch (self->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      _calc_value_init_z (result->integer);
+      mpz_set (result->integer, self->integer);
+      break;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      _calc_value_init_q (result->rational);
+      mpq_set (result->rational, self->rational);
+      result->unreduced = self->unreduced;
+      break;
+    case CALC_NUMBER_TYPE_FLOATING:
+      _calc_value_init_fr (result->floating,
+			   mpfr_get_prec (self->floating));
+      mpfr_set (result->floating, self->floating, MPFR_RNDN);
+      break;
+    case CALC_NUMBER_TYPE_DECIMAL:
+      if (self->wide)
+	{
+	  _calc_value_init_z (result->integer);
+	  mpz_set (result->integer, self->integer);
+	}
+      else
+	result->decimal = self->decimal;
+      result->wide = self->wide;
+      result->scale = self->scale;
+      break;
+    case CALC_NUMBER_TYPE_DOUBLE:
+      result->native = self->native;
+      break;
+    }
+}
+
+/**
+ * calc_value_cast:
+ * @self: the value to cast
+ * @type: the type to cast to
+ *
+ * Changes the type of @self to @type and sets its value to a representation
+ * of the original value with the new type. If @type is not a valid type or
+ * is a type that cannot be cast to without losing precision, no action is
+ * performed.
+ **/
+
+void
+calc_value_cast (CalcValue *self, CalcNumberType type)
+{
+  CalcValueView view;
+  mpq_t q;
+  mpfr_t fr;
+  guint scale;
+  glong num;
+  if (self->type == type)
+    return;
+  g_return_if_fail (_calc_value_type_rank (type)
+		    > _calc_value_type_rank (self->type));
+
+  /* Decimals are converted to other types through their exact value */
+  if (self->type == CALC_NUMBER_TYPE_DECIMAL)
+    {
+      _calc_value_init_q (q);
+      mpz_set (mpq_numref (q), _calc_value_get_dec (self, &view, &scale));
+      mpz_ui_pow_ui (mpq_denref (q), 10, scale);
+      mpq_canonicalize (q);
+      _calc_value_take_q (self, q);
+      if (type == CALC_NUMBER_TYPE_RATIONAL)
+	return;
+    }
+
+  /* The new value is built separately since it shares storage with the old
+     value */
+  switch (type)
+    {
+    case CALC_NUMBER_TYPE_DECIMAL:
+      /* An integer is a decimal with no digits after the point, and keeps
+	 its storage as the coefficient */
+      if (self->small)
+	{
+	  num = self->small_num;
+	  _calc_value_set_decimal (self, num, 0);
+	  break;
+	}
+      self->wide = TRUE;
+      self->scale = 0;
+      self->type = type;
+      break;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      /* Small integers already have a denominator of one */
+      if (self->small)
+	{
+	  self->type = type;
+	  break;
+	}
+      _calc_value_init_q (q);
+      mpq_set_z (q, self->integer);
+      _calc_value_take_q (self, q);
+      break;
+    case CALC_NUMBER_TYPE_DOUBLE:
+      _calc_value_take_d (self, calc_value_get_double (self));
+      break;
+    case CALC_NUMBER_TYPE_FLOATING:
+      _calc_value_init_fr (fr, _calc_value_result_prec (self, 0));
+      if (self->type == CALC_NUMBER_TYPE_DOUBLE)
+	mpfr_set_d (fr, self->native, MPFR_RNDN);
+      else if (self->type == CALC_NUMBER_TYPE_RATIONAL)
+	mpfr_set_q (fr, _calc_value_get_q (self, &view), MPFR_RNDN);
+      else
+	mpfr_set_z (fr, _calc_value_get_z (self, &view), MPFR_RNDD);
+      _calc_value_take_fr (self, fr);
+      break;
+    }
+}
+
+/**
+ * calc_value_neg:
+ * @result: where to store the result
+ * @self: the value
+ *
+ * Sets the value of @result to the additive inverse of @self.
+ **/
+
+void
+calc_value_neg (CalcValue *result, const CalcValue *self)
+{
+  CalcValueView view;
+  CalcValue temp;
+
+  if (self->type == CALC_NUMBER_TYPE_DECIMAL)
+    {
+      _calc_value_decimal_neg (result, self, FALSE);
+      return;
+    }
+
+  if (self->small && self->small_num != G_MINLONG)
+    {
+      CalcNumberType type = self->type;
+      glong num = -self->small_num;
+      gulong den = self->small_den;
+      _calc_value_release (result);
+      _calc_value_set_small (result, type, num, den);
+      return;
+    }
+
+  self = _calc_value_prepare (result, self, &temp);
+  result->type = self->type;
+  switch (self->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      _calc_value_init_z (result->integer);
+      mpz_neg (result->integer, _calc_value_get_z (self, &view));
+      break;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      _calc_value_init_q (result->rational);
+      mpq_neg (result->rational, _calc_value_get_q (self, &view));
+      break;
+    case CALC_NUMBER_TYPE_FLOATING:
+      _calc_value_init_fr (result->floating,
+			   _calc_value_result_prec (self, 0));
+      mpfr_neg (result->floating, self->floating, MPFR_RNDN);
+      break;
+    case CALC_NUMBER_TYPE_DOUBLE:
+      result->native = -self->native;
+      break;
+    }
+  if (self == &temp)
+    calc_value_clear (&temp);
+}
+
+/**
+ * calc_value_abs:
+ * @result: where to store the result
+ * @self: the value
+ *
+ * Sets the value of @result to the absolute value of @self.
+ **/
+
+void
+calc_value_abs (CalcValue *result, const CalcValue *self)
+{
+  CalcValueView view;
+  CalcValue temp;
+
+  if (self->type == CALC_NUMBER_TYPE_DECIMAL)
+    {
+      _calc_value_decimal_neg (result, self, TRUE);
+      return;
+    }
+
+  if (self->small && self->small_num != G_MINLONG)
+    {
+      CalcNumberType type = self->type;
+      glong num = ABS (self->small_num);
+      gulong den = self->small_den;
+      _calc_value_release (result);
+      _calc_value_set_small (result, type, num, den);
+      return;
+    }
+
+  self = _calc_value_prepare (result, self, &temp);
+  result->type = self->type;
+  switch (self->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      _calc_value_init_z (result->integer);
+      mpz_abs (result->integer, _calc_value_get_z (self, &view));
+      break;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      _calc_value_init_q (result->rational);
+      mpq_abs (result->rational, _calc_value_get_q (self, &view));
+      break;
+    case CALC_NUMBER_TYPE_FLOATING:
+      _calc_value_init_fr (result->floating,
+			   _calc_value_result_prec (self, 0));
+      mpfr_abs (result->floating, self->floating, MPFR_RNDN);
+      break;
+    case CALC_NUMBER_TYPE_DOUBLE:
+      result->native = fabs (self->native);
+      break;
+    }
+  if (self == &temp)
+    calc_value_clear (&temp);
+}
+
+/**
+ * calc_value_normalize:
+ * @self: the value
+ *
+ * Reduces a rational @self to lowest terms. The in-place arithmetic
+ * functions such as calc_value_add_inplace() do not reduce rational results
+ * immediately, which saves computing a GCD for every term of a long sum or
+ * product. Any function that reads the value of @self, such as a comparison
+ * or conversion to a string, works on a reduced copy, so calling this
+ * function is never required for correct results. It saves reducing the
+ * value again every time it is read.
+ **/
+
+void
+calc_value_normalize (CalcValue *self)
+{
+  if (!self->unreduced)
+    return;
+  mpq_canonicalize (self->rational);
+  self->unreduced = FALSE;
+  _calc_value_shrink (self);
+}
+
+/**
+ * calc_value_sgn:
+ * @self: the value
+ *
+ * Determines the sign of the value @self.
+ *
+ * Returns: positive if @self is positive, zero if @self is zero, or negative
+ * if @self is negative or invalid
+ **/
+
+gint
+calc_value_sgn (const CalcValue *self)
+{
+  if (self->small)
+    return (self->small_num > 0) - (self->small_num < 0);
+  switch (self->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      return mpz_sgn (self->integer);
+    case CALC_NUMBER_TYPE_RATIONAL:
+      return mpq_sgn (self->rational);
+    case CALC_NUMBER_TYPE_DECIMAL:
+      if (self->wide)
+	return mpz_sgn (self->integer);
+      return (self->decimal > 0) - (self->decimal < 0);
+    case CALC_NUMBER_TYPE_FLOATING:
+      return mpfr_sgn (self->floating);
+    case CALC_NUMBER_TYPE_DOUBLE:
+      return (self->native > 0) - (self->native < 0);
+    default:
+      return -1;
+    }
+}
+
+/* Returns the position of @type in the order in which types are promoted
+   by arithmetic. Types are appended to #CalcNumberType as they are added,
+   so its values do not follow this order. */
+
+guint
+_calc_value_type_rank (CalcNumberType type)
+{
+  switch (type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      return 1;
+    case CALC_NUMBER_TYPE_DECIMAL:
+      return 2;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      return 3;
+    case CALC_NUMBER_TYPE_DOUBLE:
+      return 4;
+    case CALC_NUMBER_TYPE_FLOATING:
+      return 5;
+    default:
+      return 0;
+    }
+}
+
+/* Returns whether values of @type are exact, which is whether they rank
+   below the floating-point types */
+
+gboolean
+_calc_value_type_is_exact (CalcNumberType type)
+{
+  return _calc_value_type_rank (type)
+    < _calc_value_type_rank (CALC_NUMBER_TYPE_DOUBLE);
+}
+
+CalcNumberType
+_calc_value_get_final_type (CalcNumberType a, CalcNumberType b)
+{
+  return _calc_value_type_rank (a) > _calc_value_type_rank (b) ? a : b;
+}
+
+void
+_calc_value_release (CalcValue *self)
+{
+  if (self->type == -1)
+    return;
+  if (self->small)
+    {
+      self->small = FALSE;
+      self->unreduced = FALSE;
+      self->type = -1;
+      return;
+    }
+  switch (self->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      _calc_value_clear_z (self->integer);
+      break;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      _calc_value_clear_q (self->rational);
+      break;
+    case CALC_NUMBER_TYPE_DECIMAL:
+      if (self->wide)
+	_calc_value_clear_z (self->integer);
+      break;
+    case CALC_NUMBER_TYPE_FLOATING:
+      _calc_value_clear_fr (self->floating);
+      break;
+    }
+  self->unreduced = FALSE;
+  self->type = -1;
+}
+
+/* Releases @result so that it can be overwritten. If @result is the same
+   value as the operand @a, the value of @a is moved into @temp, which the
+   caller must clear after computing the result, and @temp is returned as
+   the operand to use instead. */
+
+const CalcValue *
+_calc_value_prepare (CalcValue *result, const CalcValue *a, CalcValue *temp)
+{
+  if (result != a)
+    {
+      _calc_value_release (result);
+      return a;
+    }
+  *temp = *a;
+  result->small = FALSE;
+  result->unreduced = FALSE;
+  result->type = -1;
+  return temp;
+}
+
+/* These functions replace the value of @result with @value, which must be
+   initialized and becomes owned by @result. Since the old value is released
+   only after the result has been computed, @result may be one of the
+   operands that @value was computed from. */
+
+void
+_calc_value_take_z (CalcValue *result, mpz_ptr value)
+{
+  _calc_value_release (result);
+  *result->integer = *value;
+  result->type = CALC_NUMBER_TYPE_INTEGER;
+  _calc_value_shrink (result);
+}
+
+void
+_calc_value_take_q (CalcValue *result, mpq_ptr value)
+{
+  _calc_value_release (result);
+  *result->rational = *value;
+  result->type = CALC_NUMBER_TYPE_RATIONAL;
+  _calc_value_shrink (result);
+}
+
+void
+_calc_value_take_fr (CalcValue *result, mpfr_ptr value)
+{
+  _calc_value_release (result);
+  *result->floating = *value;
+  result->type = CALC_NUMBER_TYPE_FLOATING;
+}
+
+void
+_calc_value_take_d (CalcValue *result, gdouble value)
+{
+  _calc_value_release (result);
+  result->native = value;
+  result->type = CALC_NUMBER_TYPE_DOUBLE;
+}
+
+/* The coefficient of a decimal is stored inline if it fits in a word, and
+   in GNU MP storage otherwise */
+
+void
+_calc_value_take_dec (CalcValue *result, mpz_ptr coefficient, guint scale)
+{
+  glong num;
+  _calc_value_release (result);
+  if (mpz_fits_slong_p (coefficient))
+    {
+      num = mpz_get_si (coefficient);
+      _calc_value_clear_z (coefficient);
+      _calc_value_set_decimal (result, num, scale);
+      return;
+    }
+  *result->integer = *coefficient;
+  result->wide = TRUE;
+  result->scale = scale;
+  result->type = CALC_NUMBER_TYPE_DECIMAL;
+}
+
+void
+_calc_value_set_decimal (CalcValue *self, glong coefficient, guint scale)
+{
+  self->decimal = coefficient;
+  self->small = FALSE;
+  self->unreduced = FALSE;
+  self->wide = FALSE;
+  self->scale = scale;
+  self->type = CALC_NUMBER_TYPE_DECIMAL;
+}
+
+void
+_calc_value_set_small (CalcValue *self, CalcNumberType type, glong num,
+		       gulong den)
+{
+  self->small_num = num;
+  self->small_den = den;
+  self->small = TRUE;
+  self->unreduced = FALSE;
+  self->type = type;
+}
+
+/* Moves a number stored inline into GNU MP storage. The inline fields share
+   storage with the GNU MP ones, so they must be read first. */
+
+void
+_calc_value_promote (CalcValue *self)
+{
+  glong num = self->small_num;
+  gulong den = self->small_den;
+  if (!self->small)
+    return;
+  self->small = FALSE;
+  switch (self->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      _calc_value_init_z (self->integer);
+      mpz_set_si (self->integer, num);
+      break;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      _calc_value_init_q (self->rational);
+      mpz_set_si (mpq_numref (self->rational), num);
+      mpz_set_ui (mpq_denref (self->rational), den);
+      break;
+    }
+}
+
+/* Moves a number stored in GNU MP storage inline if it fits in a word */
+
+void
+_calc_value_shrink (CalcValue *self)
+{
+  glong num;
+  if (self->small)
+    return;
+  switch (self->type)
+    {
+    case CALC_NUMBER_TYPE_INTEGER:
+      if (mpz_fits_slong_p (self->integer))
+	{
+	  num = mpz_get_si (self->integer);
+	  _calc_value_clear_z (self->integer);
+	  _calc_value_set_small (self, CALC_NUMBER_TYPE_INTEGER, num, 1);
+	}
+      break;
+    case CALC_NUMBER_TYPE_RATIONAL:
+      if (mpz_fits_slong_p (mpq_numref (self->rational))
+	  && mpz_fits_ulong_p (mpq_denref (self->rational)))
+	{
+	  if (self->unreduced)
+	    {
+	      mpq_canonicalize (self->rational);
+	      self->unreduced = FALSE;
+	    }
+	  gulong den = mpz_get_ui (mpq_denref (self->rational));
+	  num = mpz_get_si (mpq_numref (self->rational));
+	  _calc_value_clear_q (self->rational);
+	  _calc_value_set_small (self, CALC_NUMBER_TYPE_RATIONAL, num, den);
+	}
+      break;
+    }
+}
+
+/* Marks the rational value of @self as possibly not being in lowest terms,
+   or reduces it if it has grown large enough that the reduction is cheaper
+   than carrying the common factors through further operations */
+
+void
+_calc_value_defer_reduce (CalcValue *self)
+{
+  if (mpz_size (mpq_numref (self->rational)) > CALC_VALUE_UNREDUCED_MAX_LIMBS
+      || mpz_size (mpq_denref (self->rational))
+      > CALC_VALUE_UNREDUCED_MAX_LIMBS)
+    {
+      mpq_canonicalize (self->rational);
+      self->unreduced = FALSE;
+    }
+  else
+    self->unreduced = TRUE;
+}
+
+/* Stores the rational @value reduced to lowest terms in @view. @value is
+   left as it is, since it may be read by other threads at the same
+   time. */
+
+static mpq_srcptr
+calc_value_view_reduce (CalcValueView *view, mpq_srcptr value)
+{
+  mp_limb_t *limbs = view->q_limbs;
+  mpz_t gcd;
+  mpz_t part;
+  gsize size;
+
+  _calc_value_init_z (gcd);
+  _calc_value_init_z (part);
+  mpz_gcd (gcd, mpq_numref (value), mpq_denref (value));
+  mpz_divexact (part, mpq_numref (value), gcd);
+  size = mpz_size (part);
+  mpn_copyi (limbs, mpz_limbs_read (part), size);
+  mpz_roinit_n (mpq_numref (view->q), limbs,
+		mpz_sgn (part) < 0 ? -(mp_size_t) size : (mp_size_t) size);
+
+  limbs += CALC_VALUE_UNREDUCED_MAX_LIMBS;
+  mpz_divexact (part, mpq_denref (value), gcd);
+  size = mpz_size (part);
+  mpn_copyi (limbs, mpz_limbs_read (part), size);
+  mpz_roinit_n (mpq_denref (view->q), limbs, size);
+  _calc_value_clear_z (gcd);
+  _calc_value_clear_z (part);
+  return view->q;
+}
+
+/* The returned views are read-only and only valid until @self or @view is
+   modified. A view of an integer as a rational shares its limbs. A rational
+   that is not in lowest terms is reduced into @view, since every GNU MP
+   function expects canonical rationals; @self itself is never written, so
+   values can be read by several threads at once. */
+
+mpz_srcptr
+_calc_value_get_z (const CalcValue *self, CalcValueView *view)
+{
+  if (!self->small)
+    return self->integer;
+  view->limbs[0] = ABS_SMALL (self->small_num);
+  return mpz_roinit_n (view->z, view->limbs, self->small_num < 0 ? -1 : 1);
+}
+
+/* Returns the coefficient and scale of a decimal or an integer, which is a
+   decimal with a scale of zero */
+
+mpz_srcptr
+_calc_value_get_dec (const CalcValue *self, CalcValueView *view,
+		     guint *scale)
+{
+  if (self->type != CALC_NUMBER_TYPE_DECIMAL)
+    {
+      *scale = 0;
+      return _calc_value_get_z (self, view);
+    }
+  *scale = self->scale;
+  if (self->wide)
+    return self->integer;
+  view->limbs[0] = ABS_SMALL (self->decimal);
+  return mpz_roinit_n (view->z, view->limbs, self->decimal < 0 ? -1 : 1);
+}
+
+mpq_srcptr
+_calc_value_get_q (const CalcValue *self, CalcValueView *view)
+{
+  if (self->small)
+    {
+      view->limbs[0] = ABS_SMALL (self->small_num);
+      mpz_roinit_n (mpq_numref (view->q), view->limbs,
+		    self->small_num < 0 ? -1 : 1);
+      view->limbs[1] = self->small_den;
+    }
+  else if (self->type == CALC_NUMBER_TYPE_RATIONAL)
+    return self->unreduced ? calc_value_view_reduce (view, self->rational)
+      : self->rational;
+  else
+    {
+      *mpq_numref (view->q) = *self->integer;
+      view->limbs[1] = 1;
+    }
+  mpz_roinit_n (mpq_denref (view->q), view->limbs + 1, 1);
+  return view->q;
+}
+
+/* Returns a floating-point value as an MPFR number. A double is viewed as
+   an MPFR number with the same precision, which represents it exactly. */
+
+mpfr_srcptr
+_calc_value_get_fr (const CalcValue *self, CalcValueView *view)
+{
+  if (self->type != CALC_NUMBER_TYPE_DOUBLE)
+    return self->floating;
+  mpfr_custom_init (view->fr_limbs, DBL_MANT_DIG);
+  mpfr_custom_init_set (view->fr, MPFR_ZERO_KIND, 0, DBL_MANT_DIG,
+			view->fr_limbs);
+  mpfr_set_d (view->fr, self->native, MPFR_RNDN);
+  return view->fr;
+}
+
+/* Convert GNU MP numbers to the nearest double, unlike mpz_get_d() and
+   mpq_get_d(), which truncate */
+
+gdouble
+_calc_value_get_d_z (mpz_srcptr value)
+{
+  CalcValueView view;
+  mpfr_ptr fr = view.fr;
+  mpfr_custom_init (view.fr_limbs, DBL_MANT_DIG);
+  mpfr_custom_init_set (fr, MPFR_ZERO_KIND, 0, DBL_MANT_DIG, view.fr_limbs);
+  mpfr_set_z (fr, value, MPFR_RNDN);
+  return mpfr_get_d (fr, MPFR_RNDN);
+}
+
+gdouble
+_calc_value_get_d_q (mpq_srcptr value)
+{
+  CalcValueView view;
+  mpfr_ptr fr = view.fr;
+  mpfr_custom_init (view.fr_limbs, DBL_MANT_DIG);
+  mpfr_custom_init_set (fr, MPFR_ZERO_KIND, 0, DBL_MANT_DIG, view.fr_limbs);
+  mpfr_set_q (fr, value, MPFR_RNDN);
+  return mpfr_get_d (fr, MPFR_RNDN);
+}
+
+static gulong
+calc_value_gcd (gulong a, gulong b)
+{
+  while (b != 0)
+    {
+      gulong temp = a % b;
+      a = b;
+      b = temp;
+    }
+  return a;
+}
+
+static gboolean
+calc_value_small_pack (glong *num, gboolean negative, gulong mag)
+{
+  if (negative)
+    {
+      if (mag > (gulong) G_MAXLONG + 1)
+	return FALSE;
+      *num = mag == 0 ? 0 : -(glong) (mag - 1) - 1;
+    }
+  else
+    {
+      if (mag > G_MAXLONG)
+	return FALSE;
+      *num = mag;
+    }
+  return TRUE;
+}
+
+/* Arithmetic on inline numbers. Each operand is a fraction in lowest terms
+   with a positive denominator, and integers have a denominator of one. These
+   functions return FALSE without storing anything if the result does not fit
+   inline, in which case the caller should fall back to GNU MP. */
+
+gboolean
+_calc_value_small_add (glong *num, gulong *den, glong an, gulong ad, glong bn,
+		       gulong bd)
+{
+  gulong g;
+  gulong d;
+  glong x;
+  glong y;
+  glong n;
+
+  if (ad == 1 && bd == 1)
+    {
+      if (__builtin_add_overflow (an, bn, &n))
+	return FALSE;
+      *num = n;
+      *den = 1;
+      return TRUE;
+    }
+
+  g = calc_value_gcd (ad, bd);
+  if (__builtin_mul_overflow (an, bd / g, &x)
+      || __builtin_mul_overflow (bn, ad / g, &y)
+      || __builtin_add_overflow (x, y, &n)
+      || __builtin_mul_overflow (ad, bd / g, &d))
+    return FALSE;
+  if (n == 0)
+    {
+      *num = 0;
+      *den = 1;
+      return TRUE;
+    }
+
+  /* Any common factor of the new numerator and denominator divides g */
+  g = calc_value_gcd (ABS_SMALL (n), g);
+  calc_value_small_pack (num, n < 0, ABS_SMALL (n) / g);
+  *den = d / g;
+  return TRUE;
+}
+
+gboolean
+_calc_value_small_sub (glong *num, gulong *den, glong an, gulong ad, glong bn,
+		       gulong bd)
+{
+  if (bn == G_MINLONG)
+    return FALSE;
+  return _calc_value_small_add (num, den, an, ad, -bn, bd);
+}
+
+gboolean
+_calc_value_small_mul (glong *num, gulong *den, glong an, gulong ad, glong bn,
+		       gulong bd)
+{
+  gulong am = ABS_SMALL (an);
+  gulong bm = ABS_SMALL (bn);
+  gulong g1;
+  gulong g2;
+  gulong mag;
+  gulong d;
+
+  if (am == 0 || bm == 0)
+    {
+      *num = 0;
+      *den = 1;
+      return TRUE;
+    }
+
+  g1 = calc_value_gcd (am, bd);
+  g2 = calc_value_gcd (bm, ad);
+  if (__builtin_mul_overflow (am / g1, bm / g2, &mag)
+      || __builtin_mul_overflow (ad / g2, bd / g1, &d)
+      || !calc_value_small_pack (num, (an < 0) != (bn < 0), mag))
+    return FALSE;
+  *den = d;
+  return TRUE;
+}
+
+gboolean
+_calc_value_small_div (glong *num, gulong *den, glong an, gulong ad, glong bn,
+		       gulong bd)
+{
+  gulong am = ABS_SMALL (an);
+  gulong bm = ABS_SMALL (bn);
+  gulong g1;
+  gulong g2;
+  gulong mag;
+  gulong d;
+
+  /* Let GNU MP handle division by zero */
+  if (bm == 0)
+    return FALSE;
+  if (am == 0)
+    {
+      *num = 0;
+      *den = 1;
+      return TRUE;
+    }
+
+  g1 = calc_value_gcd (am, bm);
+  g2 = calc_value_gcd (ad, bd);
+  if (__builtin_mul_overflow (am / g1, bd / g2, &mag)
+      || __builtin_mul_overflow (ad / g2, bm / g1, &d)
+      || !calc_value_small_pack (num, (an < 0) != (bn < 0), mag))
+    return FALSE;
+  *den = d;
+  return TRUE;
+}
+
+gboolean
+_calc_value_small_cmp (gint *result, glong an, gulong ad, glong bn, gulong bd)
+{
+  glong x;
+  glong y;
+  if (ad == bd)
+    {
+      x = an;
+      y = bn;
+    }
+  else if (__builtin_mul_overflow (an, bd, &x)
+	   || __builtin_mul_overflow (bn, ad, &y))
+    return FALSE;
+  *result = (x > y) - (x < y);
+  return TRUE;
+}
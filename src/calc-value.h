@@ -0,0 +1,415 @@
+/*************************************************************************
+ * calc-value.h -- This file is part of libcalc.                         *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+
+#ifndef _CALC_VALUE_H
+#define _CALC_VALUE_H
+
+#include <glib.h>
+#include <mpfr.h>
+
+G_BEGIN_DECLS
+
+/**
+ * CalcNumberType:
+ * @CALC_NUMBER_TYPE_INTEGER: an integer
+ * @CALC_NUMBER_TYPE_RATIONAL: a rational number
+ * @CALC_NUMBER_TYPE_FLOATING: an arbitrary floating-point real number
+ * @CALC_NUMBER_TYPE_DOUBLE: a hardware double-precision floating-point
+ * number
+ * @CALC_NUMBER_TYPE_DECIMAL: a fixed-point decimal number
+ *
+ * Contains the types of values used for a #CalcValue or #CalcNumber
+ * instance. An arithmetic result has the higher ranked of the types of its
+ * operands, where types are ranked as integer, decimal, rational, double
+ * and arbitrary floating-point: an integer combined with a decimal gives a
+ * decimal, a decimal combined with a rational gives a rational, an exact
+ * value combined with a double gives a double, and a double combined with
+ * an arbitrary floating-point number gives an arbitrary floating-point
+ * number with at least %DBL_MANT_DIG bits of precision.
+ **/
+
+typedef enum
+{
+  /*< public >*/
+  CALC_NUMBER_TYPE_INTEGER = 1,
+  CALC_NUMBER_TYPE_RATIONAL,
+  CALC_NUMBER_TYPE_FLOATING,
+  CALC_NUMBER_TYPE_DOUBLE,
+  CALC_NUMBER_TYPE_DECIMAL,
+
+  /*< private >*/
+  N_CALC_NUMBER_TYPE
+} CalcNumberType;
+
+/**
+ * CalcDecimalRound:
+ * @CALC_DECIMAL_ROUND_HALF_EVEN: round to the nearest decimal, and to an
+ * even last digit if there are two
+ * @CALC_DECIMAL_ROUND_HALF_UP: round to the nearest decimal, and away from
+ * zero if there are two
+ * @CALC_DECIMAL_ROUND_DOWN: round towards zero
+ * @CALC_DECIMAL_ROUND_UP: round away from zero
+ * @CALC_DECIMAL_ROUND_FLOOR: round towards negative infinity
+ * @CALC_DECIMAL_ROUND_CEILING: round towards positive infinity
+ *
+ * Contains the rounding modes that can be set with
+ * calc_value_set_decimal_round().
+ **/
+
+typedef enum
+{
+  /*< public >*/
+  CALC_DECIMAL_ROUND_HALF_EVEN,
+  CALC_DECIMAL_ROUND_HALF_UP,
+  CALC_DECIMAL_ROUND_DOWN,
+  CALC_DECIMAL_ROUND_UP,
+  CALC_DECIMAL_ROUND_FLOOR,
+  CALC_DECIMAL_ROUND_CEILING,
+
+  /*< private >*/
+  N_CALC_DECIMAL_ROUND
+} CalcDecimalRound;
+
+/**
+ * CALC_VALUE_DECIMAL_MAX_SCALE:
+ *
+ * The largest number of digits a decimal can have after the decimal point.
+ **/
+
+#define CALC_VALUE_DECIMAL_MAX_SCALE 63
+
+/**
+ * CalcConstant:
+ * @CALC_CONSTANT_PI: the ratio of the circumference of a circle to its
+ * diameter
+ * @CALC_CONSTANT_E: the base of the natural logarithm
+ * @CALC_CONSTANT_LN2: the natural logarithm of 2
+ * @CALC_CONSTANT_LN10: the natural logarithm of 10
+ * @CALC_CONSTANT_LOG2_10: the binary logarithm of 10
+ *
+ * Contains the mathematical constants that can be set with
+ * calc_value_set_const().
+ **/
+
+typedef enum
+{
+  /*< public >*/
+  CALC_CONSTANT_PI,
+  CALC_CONSTANT_E,
+  CALC_CONSTANT_LN2,
+  CALC_CONSTANT_LN10,
+  CALC_CONSTANT_LOG2_10,
+
+  /*< private >*/
+  N_CALC_CONSTANT
+} CalcConstant;
+
+/**
+ * CalcValue:
+ * @type: the type of the value
+ *
+ * A plain real number that can be allocated on the stack. Like the GNU MP
+ * types, a #CalcValue must be initialized with one of the calc_value_init()
+ * functions before use and cleared with calc_value_clear() afterwards. The
+ * result of any arithmetic function may be the same value as one of its
+ * operands.
+ *
+ * A floating-point result has the largest precision of the floating-point
+ * operands it was computed from, or the default precision of GNU MPFR if
+ * all of them are exact. Use calc_value_set_prec_override() to compute
+ * results at a fixed precision instead.
+ *
+ * A value of type %CALC_NUMBER_TYPE_DECIMAL is an integer coefficient
+ * divided by 10 raised to its scale, so 12.50 has a coefficient of 1250 and
+ * a scale of 2. Sums, differences and products of decimals are exact and
+ * have the larger scale of their operands or the sum of their scales
+ * respectively. A quotient has the larger scale of its operands, and like
+ * a product whose scale would exceed %CALC_VALUE_DECIMAL_MAX_SCALE, is
+ * rounded with the mode set by calc_value_set_decimal_round(). Other
+ * functions, such as calc_value_log(), treat decimals as rationals.
+ *
+ * Arithmetic on values of type %CALC_NUMBER_TYPE_DOUBLE is done with the
+ * hardware floating-point unit, so it is as fast and has the same rounding
+ * and overflow behavior as arithmetic on C doubles. Functions such as
+ * calc_value_log() that return the direction of rounding return zero for
+ * a double result, since the C library does not report it.
+ **/
+
+typedef struct
+{
+  /*< private >*/
+  G_GNUC_EXTENSION union
+  {
+    mpz_t integer;
+    mpq_t rational;
+    mpfr_t floating;
+    gdouble native;
+    glong decimal;
+    G_GNUC_EXTENSION struct
+    {
+      glong small_num;
+      gulong small_den;
+    };
+  };
+  guint small : 1;
+  guint unreduced : 1;
+  guint wide : 1;
+  guint scale : 6;
+
+  /*< public >*/
+  CalcNumberType type;
+} CalcValue;
+
+void calc_value_init (CalcValue *self);
+void calc_value_init_set (CalcValue *self, const CalcValue *value);
+void calc_value_init_z (CalcValue *self, mpz_t value);
+void calc_value_init_q (CalcValue *self, mpq_t value);
+void calc_value_init_f (CalcValue *self, mpf_t value);
+void calc_value_init_fr (CalcValue *self, mpfr_t value);
+void calc_value_init_d (CalcValue *self, double value);
+void calc_value_init_double (CalcValue *self, gdouble value);
+void calc_value_init_decimal (CalcValue *self, signed long coefficient,
+			      guint scale);
+void calc_value_init_ui (CalcValue *self, unsigned long value);
+void calc_value_init_si (CalcValue *self, signed long value);
+void calc_value_clear (CalcValue *self);
+gboolean calc_value_set_str (CalcValue *self, const gchar *str, gssize len);
+void calc_value_set_const (CalcValue *self, CalcConstant constant);
+gdouble calc_value_get_double (const CalcValue *self);
+void calc_value_quantize (CalcValue *result, const CalcValue *self,
+			  guint scale);
+
+void calc_value_add (CalcValue *result, const CalcValue *a,
+		     const CalcValue *b);
+void calc_value_add_z (CalcValue *result, const CalcValue *a, mpz_t b);
+void calc_value_add_q (CalcValue *result, const CalcValue *a, mpq_t b);
+void calc_value_add_f (CalcValue *result, const CalcValue *a, mpf_t b);
+void calc_value_add_fr (CalcValue *result, const CalcValue *a, mpfr_t b);
+void calc_value_add_d (CalcValue *result, const CalcValue *a, double b);
+void calc_value_add_ui (CalcValue *result, const CalcValue *a,
+			unsigned long b);
+void calc_value_add_si (CalcValue *result, const CalcValue *a,
+			signed long b);
+void calc_value_add_inplace (CalcValue *self, const CalcValue *value);
+void calc_value_sum (CalcValue *result, const CalcValue *values, gsize n);
+
+void calc_value_div (CalcValue *result, const CalcValue *a,
+		     const CalcValue *b);
+void calc_value_div_z (CalcValue *result, const CalcValue *a, mpz_t b);
+void calc_value_div_q (CalcValue *result, const CalcValue *a, mpq_t b);
+void calc_value_div_f (CalcValue *result, const CalcValue *a, mpf_t b);
+void calc_value_div_fr (CalcValue *result, const CalcValue *a, mpfr_t b);
+void calc_value_div_d (CalcValue *result, const CalcValue *a, double b);
+void calc_value_div_ui (CalcValue *result, const CalcValue *a,
+			unsigned long b);
+void calc_value_div_si (CalcValue *result, const CalcValue *a,
+			signed long b);
+void calc_value_div_inplace (CalcValue *self, const CalcValue *value);
+
+void calc_value_mul (CalcValue *result, const CalcValue *a,
+		     const CalcValue *b);
+void calc_value_mul_z (CalcValue *result, const CalcValue *a, mpz_t b);
+void calc_value_mul_q (CalcValue *result, const CalcValue *a, mpq_t b);
+void calc_value_mul_f (CalcValue *result, const CalcValue *a, mpf_t b);
+void calc_value_mul_fr (CalcValue *result, const CalcValue *a, mpfr_t b);
+void calc_value_mul_d (CalcValue *result, const CalcValue *a, double b);
+void calc_value_mul_ui (CalcValue *result, const CalcValue *a,
+			unsigned long b);
+void calc_value_mul_si (CalcValue *result, const CalcValue *a,
+			signed long b);
+void calc_value_mul_inplace (CalcValue *self, const CalcValue *value);
+
+void calc_value_fma (CalcValue *result, const CalcValue *a, const CalcValue *b,
+		     const CalcValue *c);
+void calc_value_fms (CalcValue *result, const CalcValue *a, const CalcValue *b,
+		     const CalcValue *c);
+void calc_value_dot (CalcValue *result, const CalcValue *a, const CalcValue *b,
+		     gsize n);
+
+void calc_value_sub (CalcValue *result, const CalcValue *a,
+		     const CalcValue *b);
+void calc_value_sub_z (CalcValue *result, const CalcValue *a, mpz_t b);
+void calc_value_sub_q (CalcValue *result, const CalcValue *a, mpq_t b);
+void calc_value_sub_f (CalcValue *result, const CalcValue *a, mpf_t b);
+void calc_value_sub_fr (CalcValue *result, const CalcValue *a, mpfr_t b);
+void calc_value_sub_d (CalcValue *result, const CalcValue *a, double b);
+void calc_value_sub_ui (CalcValue *result, const CalcValue *a,
+			unsigned long b);
+void calc_value_sub_si (CalcValue *result, const CalcValue *a,
+			signed long b);
+
+gint calc_value_cmp (const CalcValue *a, const CalcValue *b);
+gint calc_value_cmp_z (const CalcValue *a, mpz_t b);
+gint calc_value_cmp_q (const CalcValue *a, mpq_t b);
+gint calc_value_cmp_f (const CalcValue *a, mpf_t b);
+gint calc_value_cmp_fr (const CalcValue *a, mpfr_t b);
+gint calc_value_cmp_d (const CalcValue *a, double b);
+gint calc_value_cmp_ui (const CalcValue *a, unsigned long b);
+gint calc_value_cmp_si (const CalcValue *a, signed long b);
+
+guint64 calc_value_hash (const CalcValue *self);
+
+void calc_value_set (CalcValue *result, const CalcValue *self);
+void calc_value_cast (CalcValue *self, CalcNumberType type);
+void calc_value_neg (CalcValue *result, const CalcValue *self);
+void calc_value_abs (CalcValue *result, const CalcValue *self);
+void calc_value_normalize (CalcValue *self);
+gint calc_value_sgn (const CalcValue *self);
+
+gint calc_value_log (CalcValue *result, const CalcValue *self);
+gint calc_value_log2 (CalcValue *result, const CalcValue *self);
+gint calc_value_log10 (CalcValue *result, const CalcValue *self);
+gint calc_value_logn (CalcValue *result, const CalcValue *self,
+		      unsigned long base);
+gint calc_value_pow (CalcValue *result, const CalcValue *a,
+		     const CalcValue *b);
+gint calc_value_exp (CalcValue *result, const CalcValue *self);
+gint calc_value_sqrt (CalcValue *result, const CalcValue *self);
+gint calc_value_sin (CalcValue *result, const CalcValue *self);
+gint calc_value_cos (CalcValue *result, const CalcValue *self);
+gint calc_value_tan (CalcValue *result, const CalcValue *self);
+gint calc_value_asin (CalcValue *result, const CalcValue *self);
+gint calc_value_acos (CalcValue *result, const CalcValue *self);
+gint calc_value_atan (CalcValue *result, const CalcValue *self);
+gint calc_value_sinh (CalcValue *result, const CalcValue *self);
+gint calc_value_cosh (CalcValue *result, const CalcValue *self);
+gint calc_value_tanh (CalcValue *result, const CalcValue *self);
+gint calc_value_asinh (CalcValue *result, const CalcValue *self);
+gint calc_value_acosh (CalcValue *result, const CalcValue *self);
+gint calc_value_atanh (CalcValue *result, const CalcValue *self);
+
+mpfr_prec_t calc_value_get_prec (const CalcValue *self);
+void calc_value_set_prec_override (mpfr_prec_t prec);
+mpfr_prec_t calc_value_get_prec_override (void);
+void calc_value_set_decimal_round (CalcDecimalRound mode);
+CalcDecimalRound calc_value_get_decimal_round (void);
+
+#ifdef _LIBCALC_INTERNAL
+
+/*< private >*/
+
+/* Rationals computed in place are reduced once their numerator or
+   denominator is longer than this many limbs */
+#define CALC_VALUE_UNREDUCED_MAX_LIMBS 32
+
+/* Accumulates a sum of products. Products of integers and rationals are
+   summed exactly, while products involving floating-point numbers are kept
+   exact where possible and summed with a single rounding at the end. */
+typedef struct
+{
+  mpq_t exact;
+  CalcNumberType type;
+  GArray *floating;
+  mpfr_prec_t prec;
+  guint scale;
+} CalcValueAcc;
+
+/* Storage for read-only GNU MP views of values stored inline, and of
+   rationals that are not in lowest terms. Such rationals never have more
+   than CALC_VALUE_UNREDUCED_MAX_LIMBS limbs in either part, so their
+   reduced forms fit in @q_limbs. */
+typedef struct
+{
+  mpz_t z;
+  mpq_t q;
+  mpfr_t fr;
+  mp_limb_t limbs[2];
+  mp_limb_t fr_limbs[2]; /* Enough for the significand of a double */
+  mp_limb_t q_limbs[2 * CALC_VALUE_UNREDUCED_MAX_LIMBS];
+} CalcValueView;
+
+void _calc_value_init_z (mpz_ptr value);
+void _calc_value_init_q (mpq_ptr value);
+void _calc_value_init_fr (mpfr_ptr value, mpfr_prec_t prec);
+void _calc_value_clear_z (mpz_ptr value);
+void _calc_value_clear_q (mpq_ptr value);
+void _calc_value_clear_fr (mpfr_ptr value);
+
+mpfr_prec_t _calc_value_result_prec (const CalcValue *a, mpfr_prec_t b);
+
+guint _calc_value_type_rank (CalcNumberType type);
+gboolean _calc_value_type_is_exact (CalcNumberType type);
+CalcNumberType _calc_value_get_final_type (CalcNumberType a, CalcNumberType b);
+void _calc_value_release (CalcValue *self);
+const CalcValue *_calc_value_prepare (CalcValue *result, const CalcValue *a,
+				      CalcValue *temp);
+void _calc_value_take_z (CalcValue *result, mpz_ptr value);
+void _calc_value_take_q (CalcValue *result, mpq_ptr value);
+void _calc_value_take_fr (CalcValue *result, mpfr_ptr value);
+void _calc_value_take_d (CalcValue *result, gdouble value);
+void _calc_value_take_dec (CalcValue *result, mpz_ptr coefficient,
+			   guint scale);
+void _calc_value_set_small (CalcValue *self, CalcNumberType type, glong num,
+			    gulong den);
+void _calc_value_set_decimal (CalcValue *self, glong coefficient,
+			      guint scale);
+void _calc_value_set_decimal_q (CalcValue *result, mpq_srcptr value,
+				guint scale);
+void _calc_value_promote (CalcValue *self);
+void _calc_value_shrink (CalcValue *self);
+void _calc_value_defer_reduce (CalcValue *self);
+mpz_srcptr _calc_value_get_z (const CalcValue *self, CalcValueView *view);
+mpq_srcptr _calc_value_get_q (const CalcValue *self, CalcValueView *view);
+mpfr_srcptr _calc_value_get_fr (const CalcValue *self, CalcValueView *view);
+mpz_srcptr _calc_value_get_dec (const CalcValue *self, CalcValueView *view,
+				guint *scale);
+gdouble _calc_value_get_d_z (mpz_srcptr value);
+gdouble _calc_value_get_d_q (mpq_srcptr value);
+
+void _calc_value_acc_init (CalcValueAcc *self);
+void _calc_value_acc_add (CalcValueAcc *self, const CalcValue *value);
+void _calc_value_acc_addmul (CalcValueAcc *self, const CalcValue *a,
+			     const CalcValue *b);
+void _calc_value_acc_finish (CalcValueAcc *self, CalcValue *result);
+void _calc_value_acc_clear (CalcValueAcc *self);
+
+const CalcValue *_calc_value_decimal_to_q (const CalcValue *self,
+					   CalcValue *temp);
+void _calc_value_decimal_add (CalcValue *result, const CalcValue *a,
+			      const CalcValue *b, gboolean negate);
+void _calc_value_decimal_mul (CalcValue *result, const CalcValue *a,
+			      const CalcValue *b);
+void _calc_value_decimal_div (CalcValue *result, const CalcValue *a,
+			      const CalcValue *b);
+gint _calc_value_decimal_cmp (const CalcValue *a, const CalcValue *b);
+void _calc_value_decimal_neg (CalcValue *result, const CalcValue *self,
+			      gboolean abs);
+void _calc_value_decimal_fma (CalcValue *result, const CalcValue *a,
+			      const CalcValue *b, const CalcValue *c,
+			      gboolean negate);
+void _calc_value_decimal_print (const CalcValue *self, GString *str);
+
+guint64 _calc_hash_mix (guint64 value);
+guint64 _calc_hash_combine (guint64 hash, guint64 value);
+
+gboolean _calc_value_small_add (glong *num, gulong *den, glong an, gulong ad,
+				glong bn, gulong bd);
+gboolean _calc_value_small_sub (glong *num, gulong *den, glong an, gulong ad,
+				glong bn, gulong bd);
+gboolean _calc_value_small_mul (glong *num, gulong *den, glong an, gulong ad,
+				glong bn, gulong bd);
+gboolean _calc_value_small_div (glong *num, gulong *den, glong an, gulong ad,
+				glong bn, gulong bd);
+gboolean _calc_value_small_cmp (gint *result, glong an, gulong ad, glong bn,
+				gulong bd);
+
+#endif
+
+G_END_DECLS
+
+#endif
@@ -23,18 +23,25 @@
 #endif
 
 #include "calc-number.h"
+#include "calc-program.h"
 #include "calc-variable.h"
 
+#define CALC_VARIABLE_HASH_SEED G_GUINT64_CONSTANT (0x9b05688c2b3e6c1f)
+
 G_DEFINE_TYPE (CalcVariable, calc_variable, CALC_TYPE_EXPR)
 
 static void calc_variable_render (CalcExpr *expr, cairo_t *cr, gsize size);
 static void calc_variable_get_dims (CalcExpr *expr, cairo_t *cr, gint *width,
 				    gint *height, gsize size);
-static void calc_variable_print (CalcExpr *expr, FILE *stream);
+static void calc_variable_print_string (CalcExpr *expr, GString *str,
+					const CalcPrintFormat *format);
 static gboolean calc_variable_equivalent (CalcExpr *self, CalcExpr *other);
 static gboolean calc_variable_like_terms (CalcExpr *self, CalcExpr *other);
-static gulong calc_variable_hash (CalcExpr *expr);
+static guint64 calc_variable_hash (CalcExpr *expr);
 static gboolean calc_variable_evaluate (CalcExpr *expr, CalcExpr *result);
+static gboolean calc_variable_evaluate_approx (CalcExpr *expr,
+					       CalcApprox *result, gdouble tolerance);
+static gint calc_variable_compile (CalcExpr *expr, CalcProgram *program);
 
 static GHashTable *calc_variable_values;
 
@@ -48,6 +55,7 @@ static void
 calc_variable_dispose (GObject *obj)
 {
   g_free (CALC_VARIABLE (obj)->text);
+  G_OBJECT_CLASS (calc_variable_parent_class)->dispose (obj);
 }
 
 static void
@@ -57,11 +65,13 @@ calc_variable_class_init (CalcVariableClass *klass)
   G_OBJECT_CLASS (klass)->dispose = calc_variable_dispose;
   exprclass->render = calc_variable_render;
   exprclass->get_dims = calc_variable_get_dims;
-  exprclass->print = calc_variable_print;
+  exprclass->print_string = calc_variable_print_string;
   exprclass->equivalent = calc_variable_equivalent;
   exprclass->like_terms = calc_variable_like_terms;
   exprclass->hash = calc_variable_hash;
   exprclass->evaluate = calc_variable_evaluate;
+  exprclass->evaluate_approx = calc_variable_evaluate_approx;
+  exprclass->compile = calc_variable_compile;
 
   calc_variable_values =
     g_hash_table_new_full (g_str_hash, calc_variable_key_equal, g_free, NULL);
@@ -94,9 +104,10 @@ calc_variable_get_dims (CalcExpr *expr, cairo_t *cr, gint *width, gint *height,
 }
 
 static void
-calc_variable_print (CalcExpr *expr, FILE *stream)
+calc_variable_print_string (CalcExpr *expr, GString *str,
+			    const CalcPrintFormat *format)
 {
-  fprintf (stream, "%s", CALC_VARIABLE (expr)->text);
+  g_string_append (str, CALC_VARIABLE (expr)->text);
 }
 
 static gboolean
@@ -114,10 +125,14 @@ calc_variable_like_terms (CalcExpr *self, CalcExpr *other)
   return calc_variable_equivalent (self, other);
 }
 
-static gulong
+static guint64
 calc_variable_hash (CalcExpr *expr)
 {
-  return g_str_hash (CALC_VARIABLE (expr)->text);
+  const gchar *p;
+  guint64 hash = CALC_VARIABLE_HASH_SEED;
+  for (p = CALC_VARIABLE (expr)->text; *p != '\0'; p++)
+    hash = _calc_hash_combine (hash, (guchar) *p);
+  return hash;
 }
 
 static gboolean
@@ -131,6 +146,22 @@ calc_variable_evaluate (CalcExpr *expr, CalcExpr *result)
   return calc_expr_evaluate (value, result);
 }
 
+static gboolean
+calc_variable_evaluate_approx (CalcExpr *expr, CalcApprox *result,
+			       gdouble tolerance)
+{
+  CalcExpr *value = calc_variable_get_value (CALC_VARIABLE (expr)->text);
+  if (value == NULL)
+    return FALSE;
+  return _calc_expr_approx (value, result, tolerance);
+}
+
+static gint
+calc_variable_compile (CalcExpr *expr, CalcProgram *program)
+{
+  return _calc_program_add_variable (program, CALC_VARIABLE (expr)->text);
+}
+
 /**
  * calc_variable_new:
  * @text: the name of the variable
@@ -167,6 +198,7 @@ calc_variable_set_name (CalcVariable *self, const gchar *text)
 {
   g_return_if_fail (CALC_IS_VARIABLE (self));
   g_return_if_fail (text != NULL);
+  calc_expr_changed (CALC_EXPR (self));
   g_free (self->text);
   self->text = g_strdup (text);
 }
@@ -22,8 +22,11 @@
 #include "calc-exponent.h"
 #include "calc-fraction.h"
 #include "calc-number.h"
+#include "calc-number-array.h"
+#include "calc-program.h"
 #include "calc-sum.h"
 #include "calc-term.h"
+#include "calc-value.h"
 #include "calc-variable.h"
 
 #endif
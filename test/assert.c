@@ -59,9 +59,9 @@ assert_num_equals_si (CalcNumber *num, signed long value)
 void
 assert_num_type_equals (CalcNumber *num, CalcNumberType type)
 {
-  if (num->type != type)
+  if (num->value.type != type)
     {
-      fprintf (stderr, "expected type %d but got %d\n", type, num->type);
+      fprintf (stderr, "expected type %d but got %d\n", type, num->value.type);
       abort ();
     }
 }
@@ -0,0 +1,120 @@
+/*************************************************************************
+ * bench-batch.c -- This file is part of libcalc.                        *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+
+/* Compares evaluating a polynomial in two variables at many points with
+   calc_expr_evaluate() against a single call to calc_program_run_batch(),
+   both interpreted and with native code if it can be loaded. This program
+   is not run as part of the test suite; build it with `make bench-batch'. */
+
+#include <stdio.h>
+#include "libtest.h"
+
+#define BENCH_POINTS 1000000
+#define BENCH_TREE_POINTS 10000
+#define BENCH_VARIABLE_X "x"
+#define BENCH_VARIABLE_Y "y"
+
+int
+main (void)
+{
+  CalcNumber *two = calc_number_new_ui (2);
+  CalcNumber *three = calc_number_new_ui (3);
+  CalcVariable *x = calc_variable_new (BENCH_VARIABLE_X);
+  CalcVariable *y = calc_variable_new (BENCH_VARIABLE_Y);
+  CalcTerm *a = calc_term_new (three);
+  CalcTerm *b = calc_term_new (two);
+  CalcSum *c;
+  CalcNumber *result = calc_number_new (NULL);
+  const gchar *names[] = { BENCH_VARIABLE_X, BENCH_VARIABLE_Y, NULL };
+  const gdouble *columns[2];
+  gdouble *xs = g_new (gdouble, BENCH_POINTS);
+  gdouble *ys = g_new (gdouble, BENCH_POINTS);
+  gdouble *out = g_new (gdouble, BENCH_POINTS);
+  CalcProgram *program;
+  gint64 start;
+  gint64 tree_time;
+  gint64 time;
+  gint64 native_time = 0;
+  guint i;
+
+  /* 3x^2 + 2xy + y */
+  calc_term_add_factor (a, CALC_EXPR (x));
+  calc_term_add_factor (a, CALC_EXPR (x));
+  calc_term_add_factor (b, CALC_EXPR (x));
+  calc_term_add_factor (b, CALC_EXPR (y));
+  c = calc_sum_new (CALC_EXPR (a));
+  calc_sum_add_term (c, CALC_EXPR (b));
+  calc_sum_add_term (c, CALC_EXPR (y));
+  for (i = 0; i < BENCH_POINTS; i++)
+    {
+      xs[i] = i * 1e-6;
+      ys[i] = 1 - i * 1e-6;
+    }
+
+  start = g_get_monotonic_time ();
+  for (i = 0; i < BENCH_TREE_POINTS; i++)
+    {
+      CalcNumber *vx = calc_number_new_double (xs[i]);
+      CalcNumber *vy = calc_number_new_double (ys[i]);
+      calc_variable_set_value (BENCH_VARIABLE_X, CALC_EXPR (vx));
+      calc_variable_set_value (BENCH_VARIABLE_Y, CALC_EXPR (vy));
+      assert (calc_expr_evaluate (CALC_EXPR (c), CALC_EXPR (result)));
+      g_object_unref (vx);
+      g_object_unref (vy);
+    }
+  tree_time = g_get_monotonic_time () - start;
+
+  start = g_get_monotonic_time ();
+  program = calc_expr_compile (CALC_EXPR (c));
+  columns[0] = xs;
+  columns[1] = ys;
+  assert (calc_program_run_batch (program, names, columns, out,
+				  BENCH_POINTS));
+  time = g_get_monotonic_time () - start;
+
+  if (calc_program_load_native (program))
+    {
+      start = g_get_monotonic_time ();
+      assert (calc_program_run_batch (program, names, columns, out,
+				      BENCH_POINTS));
+      native_time = g_get_monotonic_time () - start;
+    }
+
+  printf ("calc_expr_evaluate: %8.1f ns/point  "
+	  "calc_program_run_batch: %8.2f ns/point\n",
+	  tree_time * 1000.0 / BENCH_TREE_POINTS,
+	  time * 1000.0 / BENCH_POINTS);
+  if (native_time != 0)
+    printf ("native code: %8.2f ns/point\n",
+	    native_time * 1000.0 / BENCH_POINTS);
+  calc_variable_set_value (BENCH_VARIABLE_X, NULL);
+  calc_variable_set_value (BENCH_VARIABLE_Y, NULL);
+  g_object_unref (program);
+  g_object_unref (a);
+  g_object_unref (b);
+  g_object_unref (c);
+  g_object_unref (x);
+  g_object_unref (y);
+  g_object_unref (two);
+  g_object_unref (three);
+  g_object_unref (result);
+  g_free (xs);
+  g_free (ys);
+  g_free (out);
+  return 0;
+}
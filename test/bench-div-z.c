@@ -0,0 +1,120 @@
+/*************************************************************************
+ * bench-div-z.c -- This file is part of libcalc.                        *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+
+/* Compares integer division of 10000-limb operands against dividing with a
+   separate divisibility test and mpq_div(), which is what calc_number_div()
+   used to do. This program is not run as part of the test suite; build it
+   with `make bench-div-z'. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "libtest.h"
+
+#define BENCH_LIMBS 10000
+#define BENCH_RUNS 10
+
+static void
+bench_reference (mpq_t result, mpz_t a, mpz_t b)
+{
+  mpz_t rem;
+  mpq_t qa;
+  mpq_t qb;
+  mpz_init (rem);
+  mpz_mod (rem, a, b);
+  if (mpz_sgn (rem) == 0)
+    {
+      mpz_divexact (mpq_numref (result), a, b);
+      mpz_set_ui (mpq_denref (result), 1);
+    }
+  else
+    {
+      mpq_inits (qa, qb, NULL);
+      mpq_set_z (qa, a);
+      mpq_set_z (qb, b);
+      mpq_div (result, qa, qb);
+      mpq_clears (qa, qb, NULL);
+    }
+  mpz_clear (rem);
+}
+
+static void
+bench_run (const char *name, mpz_t a, mpz_t b)
+{
+  CalcNumber *na = calc_number_new_z (a);
+  CalcNumber *nb = calc_number_new_z (b);
+  CalcNumber *result = NULL;
+  mpq_t expected;
+  gint64 start;
+  gint64 ref_time;
+  gint64 time;
+  int i;
+
+  mpq_init (expected);
+  start = g_get_monotonic_time ();
+  for (i = 0; i < BENCH_RUNS; i++)
+    bench_reference (expected, a, b);
+  ref_time = g_get_monotonic_time () - start;
+
+  start = g_get_monotonic_time ();
+  for (i = 0; i < BENCH_RUNS; i++)
+    calc_number_div (&result, na, nb);
+  time = g_get_monotonic_time () - start;
+
+  assert (calc_number_cmp_q (result, expected) == 0);
+  printf ("%-10s mod + mpq_div: %8.3f ms  calc_number_div: %8.3f ms\n", name,
+	  ref_time / 1000.0 / BENCH_RUNS, time / 1000.0 / BENCH_RUNS);
+  g_object_unref (na);
+  g_object_unref (nb);
+  g_object_unref (result);
+  mpq_clear (expected);
+}
+
+int
+main (void)
+{
+  gmp_randstate_t state;
+  mpz_t a;
+  mpz_t b;
+  mpz_t c;
+
+  gmp_randinit_default (state);
+  mpz_inits (a, b, c, NULL);
+  mpz_urandomb (a, state, BENCH_LIMBS * GMP_NUMB_BITS);
+  mpz_urandomb (b, state, BENCH_LIMBS / 2 * GMP_NUMB_BITS);
+  mpz_urandomb (c, state, BENCH_LIMBS / 2 * GMP_NUMB_BITS);
+
+  /* Exact quotient */
+  mpz_mul (a, b, c);
+  bench_run ("exact", a, b);
+
+  /* Inexact quotient sharing a large common factor with the divisor */
+  mpz_add (a, a, c);
+  mpz_mul (b, b, c);
+  bench_run ("inexact", a, b);
+
+  /* Random operands of equal size */
+  mpz_urandomb (a, state, BENCH_LIMBS * GMP_NUMB_BITS);
+  mpz_urandomb (b, state, BENCH_LIMBS * GMP_NUMB_BITS);
+  mpz_setbit (a, 0);
+  mpz_setbit (b, 0);
+  bench_run ("random", a, b);
+
+  mpz_clears (a, b, c, NULL);
+  gmp_randclear (state);
+  return 0;
+}
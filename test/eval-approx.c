@@ -0,0 +1,96 @@
+/*************************************************************************
+ * eval-approx.c -- This file is part of libcalc.                        *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+#include <math.h>
+#include "libtest.h"
+
+#define TEST_DIGITS 12
+#define TEST_ESCALATE_DIGITS 6
+#define TEST_ESCALATE_VALUE 500000000
+#define TEST_VARIABLE_X "x"
+#define TEST_VARIABLE_Y "y"
+
+int
+main (void)
+{
+  CalcNumber *one = calc_number_new_ui (1);
+  CalcNumber *three = calc_number_new_ui (3);
+  CalcNumber *big = calc_number_new_str ("100000000000000000000");
+  CalcNumber *neg = calc_number_new_str ("-100000000000000000000");
+  CalcFraction *a = calc_fraction_new (CALC_EXPR (one), CALC_EXPR (three));
+  CalcSum *b = calc_sum_new (CALC_EXPR (one));
+  CalcVariable *x = calc_variable_new (TEST_VARIABLE_X);
+  CalcVariable *y = calc_variable_new (TEST_VARIABLE_Y);
+  CalcNumber *c = calc_number_new (NULL);
+  CalcNumber *d = calc_number_new_si (TEST_ESCALATE_VALUE);
+  CalcNumber *e = calc_number_new_si (-TEST_ESCALATE_VALUE);
+  CalcSum *s = calc_sum_new (CALC_EXPR (x));
+  CalcFraction *f = calc_fraction_new (CALC_EXPR (s), CALC_EXPR (s));
+
+  /* A fraction fits easily in a double */
+  assert (calc_expr_evaluate_approx (CALC_EXPR (a), CALC_EXPR (c),
+				     TEST_DIGITS));
+  assert_num_type_equals (c, CALC_NUMBER_TYPE_FLOATING);
+  assert (calc_number_get_prec (c) == 53);
+  assert_num_equals_d (c, 1.0 / 3.0);
+
+  /* Asking for more digits than a double has gives the exact result */
+  assert (calc_expr_evaluate_approx (CALC_EXPR (a), CALC_EXPR (c), 20));
+  assert_num_type_equals (c, CALC_NUMBER_TYPE_RATIONAL);
+
+  /* An unset variable cannot be evaluated either way */
+  calc_sum_add_term (b, CALC_EXPR (x));
+  calc_sum_add_term (b, CALC_EXPR (y));
+  assert (!calc_expr_evaluate_approx (CALC_EXPR (b), CALC_EXPR (c),
+				      TEST_DIGITS));
+
+  /* 1 + 10^20 - 10^20 cancels, so the doubles are not accurate enough */
+  calc_variable_set_value (TEST_VARIABLE_X, CALC_EXPR (big));
+  calc_variable_set_value (TEST_VARIABLE_Y, CALC_EXPR (neg));
+  assert (calc_expr_evaluate_approx (CALC_EXPR (b), CALC_EXPR (c),
+				     TEST_DIGITS));
+  assert_num_type_equals (c, CALC_NUMBER_TYPE_INTEGER);
+  assert_num_equals_ui (c, 1);
+
+  /* x + 1/3 + y is accurate enough on its own, but dividing it by itself
+     doubles the error, so only the numerator is evaluated exactly */
+  calc_sum_add_term (s, CALC_EXPR (a));
+  calc_sum_add_term (s, CALC_EXPR (y));
+  calc_variable_set_value (TEST_VARIABLE_X, CALC_EXPR (d));
+  calc_variable_set_value (TEST_VARIABLE_Y, CALC_EXPR (e));
+  assert (calc_expr_evaluate_approx (CALC_EXPR (f), CALC_EXPR (c),
+				     TEST_ESCALATE_DIGITS));
+  assert_num_type_equals (c, CALC_NUMBER_TYPE_FLOATING);
+  assert (fabs (calc_number_get_double (c) - 1) < 1e-6);
+
+  calc_variable_set_value (TEST_VARIABLE_X, NULL);
+  calc_variable_set_value (TEST_VARIABLE_Y, NULL);
+  g_object_unref (a);
+  g_object_unref (b);
+  g_object_unref (c);
+  g_object_unref (d);
+  g_object_unref (e);
+  g_object_unref (f);
+  g_object_unref (s);
+  g_object_unref (x);
+  g_object_unref (y);
+  g_object_unref (one);
+  g_object_unref (three);
+  g_object_unref (big);
+  g_object_unref (neg);
+  return 0;
+}
@@ -0,0 +1,113 @@
+/*************************************************************************
+ * eval-batch.c -- This file is part of libcalc.                         *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+
+#include <math.h>
+#include "libtest.h"
+
+#define TEST_POINTS 1003
+#define TEST_VARIABLE_X "x"
+#define TEST_VARIABLE_Y "y"
+
+int
+main (void)
+{
+  CalcNumber *one = calc_number_new_ui (1);
+  CalcNumber *two = calc_number_new_ui (2);
+  CalcNumber *three = calc_number_new_ui (3);
+  CalcNumber *half = calc_number_new_d (0.5);
+  CalcVariable *x = calc_variable_new (TEST_VARIABLE_X);
+  CalcVariable *y = calc_variable_new (TEST_VARIABLE_Y);
+  CalcTerm *a = calc_term_new (three);
+  CalcTerm *b = calc_term_new (two);
+  CalcSum *c = calc_sum_new (CALC_EXPR (x));
+  CalcFraction *d;
+  CalcExponent *e = calc_exponent_new (CALC_EXPR (x), CALC_EXPR (half));
+  CalcFraction *f = calc_fraction_new (CALC_EXPR (one), CALC_EXPR (three));
+  CalcSum *g;
+  CalcNumber *h = calc_number_new (NULL);
+  const gchar *names[] = { TEST_VARIABLE_X, TEST_VARIABLE_Y, NULL };
+  const gdouble *columns[2];
+  gdouble xs[TEST_POINTS];
+  gdouble ys[TEST_POINTS];
+  gdouble out[TEST_POINTS];
+  CalcProgram *program;
+  guint i;
+
+  /* 3x^2 + 2xy + y / (x + 1) + x^0.5 */
+  calc_term_add_factor (a, CALC_EXPR (x));
+  calc_term_add_factor (a, CALC_EXPR (x));
+  calc_term_add_factor (b, CALC_EXPR (x));
+  calc_term_add_factor (b, CALC_EXPR (y));
+  calc_sum_add_term (c, CALC_EXPR (one));
+  d = calc_fraction_new (CALC_EXPR (y), CALC_EXPR (c));
+  g = calc_sum_new (CALC_EXPR (a));
+  calc_sum_add_term (g, CALC_EXPR (b));
+  calc_sum_add_term (g, CALC_EXPR (d));
+  calc_sum_add_term (g, CALC_EXPR (e));
+  program = calc_expr_compile (CALC_EXPR (g));
+  assert (program != NULL);
+
+  for (i = 0; i < TEST_POINTS; i++)
+    {
+      xs[i] = i * 0.25;
+      ys[i] = 100.0 - i / 3.0;
+    }
+  columns[0] = xs;
+  columns[1] = ys;
+  assert (calc_program_run_batch (program, names, columns, out,
+				  TEST_POINTS));
+  for (i = 0; i < TEST_POINTS; i++)
+    {
+      gdouble px = xs[i];
+      gdouble py = ys[i];
+      gdouble expected =
+	3 * px * px + 2 * px * py + py / (px + 1) + sqrt (px);
+      assert (fabs (out[i] - expected) <= 1e-12 * fabs (expected));
+    }
+
+  /* Variables without a column take their current values. The point
+     where x = 3 is checked against the exact result. */
+  names[1] = NULL;
+  assert (!calc_program_run_batch (program, names, columns, out,
+				   TEST_POINTS));
+  calc_variable_set_value (TEST_VARIABLE_Y, CALC_EXPR (f));
+  assert (calc_program_run_batch (program, names, columns, out,
+				  TEST_POINTS));
+  calc_variable_set_value (TEST_VARIABLE_X, CALC_EXPR (three));
+  assert (calc_expr_evaluate (CALC_EXPR (g), CALC_EXPR (h)));
+  assert (fabs (out[12] - calc_number_get_double (h)) <= 1e-12 * out[12]);
+  g_object_unref (program);
+
+  calc_variable_set_value (TEST_VARIABLE_X, NULL);
+  calc_variable_set_value (TEST_VARIABLE_Y, NULL);
+  g_object_unref (a);
+  g_object_unref (b);
+  g_object_unref (c);
+  g_object_unref (d);
+  g_object_unref (e);
+  g_object_unref (f);
+  g_object_unref (g);
+  g_object_unref (h);
+  g_object_unref (x);
+  g_object_unref (y);
+  g_object_unref (one);
+  g_object_unref (two);
+  g_object_unref (three);
+  g_object_unref (half);
+  return 0;
+}
@@ -0,0 +1,118 @@
+/*************************************************************************
+ * eval-compile.c -- This file is part of libcalc.                       *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+
+#include "libtest.h"
+
+#define TEST_VARIABLE_X "x"
+#define TEST_VARIABLE_Y "y"
+
+static void
+test_compare (CalcExpr *expr, CalcProgram *program)
+{
+  CalcNumber *a = calc_number_new (NULL);
+  CalcNumber *b = calc_number_new (NULL);
+  assert (calc_expr_evaluate (expr, CALC_EXPR (a)));
+  assert (calc_program_run (program, CALC_EXPR (b)));
+  assert_num_type_equals (b, a->value.type);
+  assert (calc_number_get_prec (a) == calc_number_get_prec (b));
+  assert (calc_number_cmp (a, b) == 0);
+
+  /* Running the program again reuses its registers */
+  assert (calc_program_run (program, CALC_EXPR (b)));
+  assert (calc_number_cmp (a, b) == 0);
+  g_object_unref (a);
+  g_object_unref (b);
+}
+
+int
+main (void)
+{
+  CalcNumber *one = calc_number_new_ui (1);
+  CalcNumber *two = calc_number_new_ui (2);
+  CalcNumber *three = calc_number_new_ui (3);
+  CalcNumber *half = calc_number_new_d (0.5);
+  CalcVariable *x = calc_variable_new (TEST_VARIABLE_X);
+  CalcVariable *y = calc_variable_new (TEST_VARIABLE_Y);
+  CalcTerm *a = calc_term_new (three);
+  CalcTerm *b = calc_term_new (two);
+  CalcSum *c = calc_sum_new (CALC_EXPR (x));
+  CalcFraction *d;
+  CalcExponent *e = calc_exponent_new (CALC_EXPR (x), CALC_EXPR (half));
+  CalcSum *f;
+  CalcFraction *g = calc_fraction_new (CALC_EXPR (two), CALC_EXPR (three));
+  CalcNumber *h = calc_number_new_double (1.5);
+  CalcNumber *i = calc_number_new_str ("100000000000000000000");
+  CalcNumber *j = calc_number_new_decimal (-25, 1);
+  CalcProgram *program;
+
+  /* 3x^2 + 2xy + y / (x + 1) + x^0.5 */
+  calc_term_add_factor (a, CALC_EXPR (x));
+  calc_term_add_factor (a, CALC_EXPR (x));
+  calc_term_add_factor (b, CALC_EXPR (x));
+  calc_term_add_factor (b, CALC_EXPR (y));
+  calc_sum_add_term (c, CALC_EXPR (one));
+  d = calc_fraction_new (CALC_EXPR (y), CALC_EXPR (c));
+  f = calc_sum_new (CALC_EXPR (a));
+  calc_sum_add_term (f, CALC_EXPR (b));
+  calc_sum_add_term (f, CALC_EXPR (d));
+  calc_sum_add_term (f, CALC_EXPR (e));
+  program = calc_expr_compile (CALC_EXPR (f));
+  assert (program != NULL);
+
+  /* Variables are looked up when the program is run */
+  calc_variable_set_value (TEST_VARIABLE_X, CALC_EXPR (three));
+  assert (!calc_program_run (program, CALC_EXPR (one)));
+
+  calc_variable_set_value (TEST_VARIABLE_Y, CALC_EXPR (two));
+  test_compare (CALC_EXPR (f), program);
+  calc_variable_set_value (TEST_VARIABLE_X, CALC_EXPR (h));
+  calc_variable_set_value (TEST_VARIABLE_Y, CALC_EXPR (g));
+  test_compare (CALC_EXPR (f), program);
+  calc_variable_set_value (TEST_VARIABLE_X, CALC_EXPR (i));
+  calc_variable_set_value (TEST_VARIABLE_Y, CALC_EXPR (j));
+  test_compare (CALC_EXPR (f), program);
+  g_object_unref (program);
+
+  /* Subexpressions compile on their own */
+  program = calc_expr_compile (CALC_EXPR (d));
+  test_compare (CALC_EXPR (d), program);
+  g_object_unref (program);
+  program = calc_expr_compile (CALC_EXPR (x));
+  test_compare (CALC_EXPR (x), program);
+  g_object_unref (program);
+
+  calc_variable_set_value (TEST_VARIABLE_X, NULL);
+  calc_variable_set_value (TEST_VARIABLE_Y, NULL);
+  g_object_unref (a);
+  g_object_unref (b);
+  g_object_unref (c);
+  g_object_unref (d);
+  g_object_unref (e);
+  g_object_unref (f);
+  g_object_unref (g);
+  g_object_unref (h);
+  g_object_unref (i);
+  g_object_unref (j);
+  g_object_unref (x);
+  g_object_unref (y);
+  g_object_unref (one);
+  g_object_unref (two);
+  g_object_unref (three);
+  g_object_unref (half);
+  return 0;
+}
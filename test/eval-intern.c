@@ -0,0 +1,247 @@
+/*************************************************************************
+ * eval-intern.c -- This file is part of libcalc.                        *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+
+#include "libtest.h"
+
+#define TEST_VARIABLE_X "x"
+#define TEST_VARIABLE_Y "y"
+
+/* Builds 2y / (x + 1) + 3xy / (x + 1) + x from new nodes each time */
+
+static CalcSum *
+test_build (CalcNumber *one, CalcNumber *two, CalcNumber *three,
+	    CalcVariable *x, CalcVariable *y, GPtrArray *nodes)
+{
+  CalcSum *c1 = calc_sum_new (CALC_EXPR (x));
+  CalcSum *c2 = calc_sum_new (CALC_EXPR (x));
+  CalcFraction *d1;
+  CalcFraction *d2;
+  CalcTerm *t1 = calc_term_new (two);
+  CalcTerm *t2 = calc_term_new (three);
+  CalcSum *f;
+
+  calc_sum_add_term (c1, CALC_EXPR (one));
+  calc_sum_add_term (c2, CALC_EXPR (one));
+  d1 = calc_fraction_new (CALC_EXPR (y), CALC_EXPR (c1));
+  d2 = calc_fraction_new (CALC_EXPR (y), CALC_EXPR (c2));
+  calc_term_add_factor (t1, CALC_EXPR (d1));
+  calc_term_add_factor (t2, CALC_EXPR (x));
+  calc_term_add_factor (t2, CALC_EXPR (d2));
+  f = calc_sum_new (CALC_EXPR (t1));
+  calc_sum_add_term (f, CALC_EXPR (t2));
+  calc_sum_add_term (f, CALC_EXPR (x));
+
+  /* Fractions do not hold references to their operands */
+  g_ptr_array_add (nodes, c1);
+  g_ptr_array_add (nodes, c2);
+  g_ptr_array_add (nodes, d1);
+  g_ptr_array_add (nodes, d2);
+  g_ptr_array_add (nodes, t1);
+  g_ptr_array_add (nodes, t2);
+  return f;
+}
+
+/* Builds n * x + y */
+
+static CalcSum *
+test_build_linear (unsigned long n, CalcVariable *x, CalcVariable *y)
+{
+  CalcNumber *coefficient = calc_number_new_ui (n);
+  CalcTerm *term = calc_term_new (coefficient);
+  CalcSum *sum;
+
+  calc_term_add_factor (term, CALC_EXPR (x));
+  sum = calc_sum_new (CALC_EXPR (term));
+  calc_sum_add_term (sum, CALC_EXPR (y));
+  g_object_unref (term);
+  g_object_unref (coefficient);
+  return sum;
+}
+
+/* Counts the factors of the terms of @sum that are the same object as a
+   factor seen before */
+
+static guint
+test_count_shared (CalcSum *sum)
+{
+  GHashTable *seen = g_hash_table_new (NULL, NULL);
+  CalcTerm *term;
+  guint count = 0;
+  guint i;
+  guint j;
+
+  for (i = 0; i < sum->terms->len; i++)
+    {
+      term = sum->terms->pdata[i];
+      for (j = 0; j < term->factors->len; j++)
+	{
+	  if (!g_hash_table_add (seen, term->factors->pdata[j]))
+	    count++;
+	}
+    }
+  g_hash_table_destroy (seen);
+  return count;
+}
+
+static void
+test_compare (CalcExpr *expr, CalcProgram *program)
+{
+  CalcNumber *a = calc_number_new (NULL);
+  CalcNumber *b = calc_number_new (NULL);
+  assert (calc_expr_evaluate (expr, CALC_EXPR (a)));
+  assert (calc_program_run (program, CALC_EXPR (b)));
+  assert_num_type_equals (b, a->value.type);
+  assert (calc_number_cmp (a, b) == 0);
+  g_object_unref (a);
+  g_object_unref (b);
+}
+
+int
+main (void)
+{
+  CalcNumber *one = calc_number_new_ui (1);
+  CalcNumber *two = calc_number_new_ui (2);
+  CalcNumber *three = calc_number_new_ui (3);
+  CalcNumber *half = calc_number_new_d (0.5);
+  CalcVariable *x = calc_variable_new (TEST_VARIABLE_X);
+  CalcVariable *y = calc_variable_new (TEST_VARIABLE_Y);
+  GPtrArray *nodes = g_ptr_array_new_with_free_func (g_object_unref);
+  CalcSum *plain = test_build (one, two, three, x, y, nodes);
+  CalcSum *f = test_build (one, two, three, x, y, nodes);
+  CalcSum *g = test_build (one, two, three, x, y, nodes);
+  CalcProgram *plain_program;
+  CalcProgram *program;
+  CalcExpr *a;
+  CalcExpr *b;
+  CalcSum *h;
+  CalcSum *u;
+  CalcSum *w;
+  CalcSum *v;
+  CalcTerm *t;
+  CalcFraction *d;
+  CalcNumber *r;
+
+  /* Equal expressions built separately intern to the same object */
+  assert (!calc_expr_is_interned (CALC_EXPR (f)));
+  a = calc_expr_intern (CALC_EXPR (f));
+  b = calc_expr_intern (CALC_EXPR (g));
+  assert (a == CALC_EXPR (f));
+  assert (b == a);
+  assert (calc_expr_is_interned (a));
+  assert (calc_expr_equivalent (CALC_EXPR (plain), a));
+  assert (calc_expr_hash (CALC_EXPR (plain)) == calc_expr_hash (a));
+  g_object_unref (b);
+
+  /* Repeated subexpressions are shared within the expression, so both x
+     and y / (x + 1) appear once */
+  assert (test_count_shared (plain) == 0);
+  assert (test_count_shared (f) == 2);
+
+  /* Shared subexpressions are computed once by compiled programs */
+  plain_program = calc_expr_compile (CALC_EXPR (plain));
+  program = calc_expr_compile (a);
+  assert (plain_program != NULL && program != NULL);
+  assert (program->code->len < plain_program->code->len);
+  calc_variable_set_value (TEST_VARIABLE_X, CALC_EXPR (three));
+  calc_variable_set_value (TEST_VARIABLE_Y, CALC_EXPR (two));
+  test_compare (a, program);
+  test_compare (CALC_EXPR (plain), plain_program);
+  calc_variable_set_value (TEST_VARIABLE_X, CALC_EXPR (half));
+  test_compare (a, program);
+  g_object_unref (program);
+  g_object_unref (plain_program);
+  g_object_unref (a);
+
+  /* Interned expressions can be modified again once released */
+  calc_expr_clear_interned ();
+  assert (!calc_expr_is_interned (CALC_EXPR (f)));
+  calc_sum_add_term (f, CALC_EXPR (y));
+  assert (!calc_expr_equivalent (CALC_EXPR (plain), CALC_EXPR (f)));
+
+  /* Interned operands outlive the table for as long as they are used */
+  h = calc_sum_new (CALC_EXPR (x));
+  calc_sum_add_term (h, CALC_EXPR (one));
+  a = calc_expr_intern (CALC_EXPR (h));
+  g_object_unref (a);
+  g_object_unref (h);
+  h = calc_sum_new (CALC_EXPR (x));
+  calc_sum_add_term (h, CALC_EXPR (one));
+  d = calc_fraction_new (CALC_EXPR (y), CALC_EXPR (h));
+  a = calc_expr_intern (CALC_EXPR (d));
+  assert (a == CALC_EXPR (d));
+  assert (d->denom != CALC_EXPR (h));
+  g_object_unref (a);
+  calc_expr_clear_interned ();
+  assert (calc_expr_equivalent (d->denom, CALC_EXPR (h)));
+  r = calc_number_new (NULL);
+  assert (calc_expr_evaluate (CALC_EXPR (d), CALC_EXPR (r)));
+  g_object_unref (r);
+  g_object_unref (d);
+  g_object_unref (h);
+
+  /* Folding like terms into a sum sharing interned terms leaves the
+     interned expression alone */
+  u = test_build_linear (3, x, y);
+  a = calc_expr_intern (CALC_EXPR (u));
+  w = test_build_linear (3, x, y);
+  b = calc_expr_intern (CALC_EXPR (w));
+  assert (a == CALC_EXPR (u) && b == a);
+  assert (w->terms->pdata[0] == u->terms->pdata[0]);
+  g_object_unref (b);
+  t = calc_term_new (two);
+  calc_term_add_factor (t, CALC_EXPR (x));
+  calc_sum_add_term (w, CALC_EXPR (t));
+  g_object_unref (t);
+  assert (calc_expr_is_interned (a));
+  v = test_build_linear (3, x, y);
+  assert (calc_expr_equivalent (a, CALC_EXPR (v)));
+  assert (calc_expr_hash (a) == calc_expr_hash (CALC_EXPR (v)));
+  g_object_unref (v);
+  v = test_build_linear (5, x, y);
+  assert (calc_expr_equivalent (CALC_EXPR (w), CALC_EXPR (v)));
+  g_object_unref (v);
+
+  /* Changing a number inside an interned expression releases it */
+  v = test_build_linear (3, x, y);
+  calc_number_add_inplace (calc_term_get_coefficient (u->terms->pdata[0]),
+			   one);
+  assert (!calc_expr_is_interned (a));
+  assert (!calc_expr_equivalent (a, CALC_EXPR (v)));
+  b = calc_expr_intern (CALC_EXPR (v));
+  assert (b == CALC_EXPR (v));
+  g_object_unref (b);
+  g_object_unref (v);
+  g_object_unref (a);
+  g_object_unref (u);
+  g_object_unref (w);
+  calc_expr_clear_interned ();
+
+  calc_variable_set_value (TEST_VARIABLE_X, NULL);
+  calc_variable_set_value (TEST_VARIABLE_Y, NULL);
+  g_object_unref (f);
+  g_object_unref (g);
+  g_object_unref (plain);
+  g_ptr_array_free (nodes, TRUE);
+  g_object_unref (x);
+  g_object_unref (y);
+  g_object_unref (one);
+  g_object_unref (two);
+  g_object_unref (three);
+  g_object_unref (half);
+  return 0;
+}
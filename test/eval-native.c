@@ -0,0 +1,147 @@
+/*************************************************************************
+ * eval-native.c -- This file is part of libcalc.                        *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+
+#include <glib/gstdio.h>
+#include <string.h>
+#include "libtest.h"
+
+#define TEST_POINTS 3000
+#define TEST_VARIABLE_X "x"
+#define TEST_VARIABLE_Y "y"
+
+/* Exit status of skipped tests */
+#define TEST_SKIP 77
+
+static void
+test_remove_cache (const gchar *dir)
+{
+  gchar *cache = g_build_filename (dir, "libcalc", NULL);
+  GDir *d = g_dir_open (cache, 0, NULL);
+  const gchar *name;
+  if (d != NULL)
+    {
+      while ((name = g_dir_read_name (d)) != NULL)
+	{
+	  gchar *path = g_build_filename (cache, name, NULL);
+
+	  /* Only finished objects are left behind */
+	  assert (g_str_has_prefix (name, "expr-"));
+	  assert (strchr (name, '.') == strrchr (name, '.'));
+	  assert (g_str_has_suffix (name, ".so"));
+	  g_unlink (path);
+	  g_free (path);
+	}
+      g_dir_close (d);
+      assert (g_rmdir (cache) == 0);
+    }
+  assert (g_rmdir (dir) == 0);
+  g_free (cache);
+}
+
+int
+main (void)
+{
+  CalcNumber *two = calc_number_new_ui (2);
+  CalcNumber *three = calc_number_new_ui (3);
+  CalcNumber *half = calc_number_new_d (0.5);
+  CalcVariable *x = calc_variable_new (TEST_VARIABLE_X);
+  CalcVariable *y = calc_variable_new (TEST_VARIABLE_Y);
+  CalcTerm *a = calc_term_new (three);
+  CalcExponent *b = calc_exponent_new (CALC_EXPR (x), CALC_EXPR (half));
+  CalcFraction *c = calc_fraction_new (CALC_EXPR (y), CALC_EXPR (b));
+  CalcSum *d;
+  const gchar *names[] = { TEST_VARIABLE_X, TEST_VARIABLE_Y, NULL };
+  const gdouble *columns[2];
+  gdouble xs[TEST_POINTS];
+  gdouble ys[TEST_POINTS];
+  gdouble expected[TEST_POINTS];
+  gdouble out[TEST_POINTS];
+  CalcProgram *interp;
+  CalcProgram *native;
+  gchar *dir;
+  guint i;
+
+  /* Keep the object cache of this test away from the user's */
+  dir = g_dir_make_tmp ("libcalc-XXXXXX", NULL);
+  assert (dir != NULL);
+  g_setenv ("XDG_CACHE_HOME", dir, TRUE);
+
+  /* 3x^2 + y / x^0.5 + 2 */
+  calc_term_add_factor (a, CALC_EXPR (x));
+  calc_term_add_factor (a, CALC_EXPR (x));
+  d = calc_sum_new (CALC_EXPR (a));
+  calc_sum_add_term (d, CALC_EXPR (c));
+  calc_sum_add_term (d, CALC_EXPR (two));
+  interp = calc_expr_compile (CALC_EXPR (d));
+  native = calc_expr_compile (CALC_EXPR (d));
+  if (!calc_program_load_native (native))
+    {
+      test_remove_cache (dir);
+      g_free (dir);
+      return TEST_SKIP;
+    }
+
+  for (i = 0; i < TEST_POINTS; i++)
+    {
+      xs[i] = 1 + i * 0.125;
+      ys[i] = i / 7.0 - 100;
+    }
+  columns[0] = xs;
+  columns[1] = ys;
+
+  /* Native code does the same operations as the interpreter */
+  assert (calc_program_run_batch (interp, names, columns, expected,
+				  TEST_POINTS));
+  assert (calc_program_run_batch (native, names, columns, out,
+				  TEST_POINTS));
+  assert (memcmp (expected, out, sizeof (out)) == 0);
+
+  /* Variables without a column are split into blocks */
+  names[1] = NULL;
+  calc_variable_set_value (TEST_VARIABLE_Y, CALC_EXPR (two));
+  assert (calc_program_run_batch (interp, names, columns, expected,
+				  TEST_POINTS));
+  assert (calc_program_run_batch (native, names, columns, out,
+				  TEST_POINTS));
+  assert (memcmp (expected, out, sizeof (out)) == 0);
+  g_object_unref (native);
+
+  /* The cached object is loaded without running the compiler */
+  g_setenv ("CC", "false", TRUE);
+  native = calc_expr_compile (CALC_EXPR (d));
+  assert (calc_program_load_native (native));
+  assert (calc_program_run_batch (native, names, columns, out,
+				  TEST_POINTS));
+  assert (memcmp (expected, out, sizeof (out)) == 0);
+
+  calc_variable_set_value (TEST_VARIABLE_Y, NULL);
+  test_remove_cache (dir);
+  g_free (dir);
+  g_object_unref (interp);
+  g_object_unref (native);
+  g_object_unref (a);
+  g_object_unref (b);
+  g_object_unref (c);
+  g_object_unref (d);
+  g_object_unref (x);
+  g_object_unref (y);
+  g_object_unref (two);
+  g_object_unref (three);
+  g_object_unref (half);
+  return 0;
+}
@@ -0,0 +1,60 @@
+/*************************************************************************
+ * num-add-inplace.c -- This file is part of libcalc.                    *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+
+#include "libtest.h"
+
+#define TEST_COUNT 1000
+#define TEST_TERM 0.5
+
+int
+main (void)
+{
+  CalcNumber *total = calc_number_new (NULL);
+  CalcNumber *one = calc_number_new_ui (1);
+  CalcNumber *term = NULL;
+  CalcNumber *max = calc_number_new_si (G_MAXLONG);
+  int i;
+
+  calc_number_div_ui (&term, one, 2);
+  for (i = 0; i < TEST_COUNT; i++)
+    calc_number_add_inplace (total, term);
+  assert_num_type_equals (total, CALC_NUMBER_TYPE_RATIONAL);
+  assert_num_equals_d (total, TEST_COUNT * TEST_TERM);
+
+  /* Overflow past a machine word and come back */
+  calc_number_add_inplace (total, max);
+  calc_number_add_inplace (total, total);
+  calc_number_mul_inplace (total, term);
+  calc_number_neg (&term, max);
+  calc_number_add_inplace (total, term);
+  assert_num_type_equals (total, CALC_NUMBER_TYPE_RATIONAL);
+  assert_num_equals_d (total, TEST_COUNT * TEST_TERM);
+
+  /* Squaring in place */
+  calc_number_mul_inplace (max, max);
+  calc_number_mul_inplace (max, one);
+  calc_number_div_si (&term, max, G_MAXLONG);
+  assert_num_type_equals (term, CALC_NUMBER_TYPE_INTEGER);
+  assert_num_equals_si (term, G_MAXLONG);
+
+  g_object_unref (total);
+  g_object_unref (one);
+  g_object_unref (term);
+  g_object_unref (max);
+  return 0;
+}
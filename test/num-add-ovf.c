@@ -0,0 +1,48 @@
+/*************************************************************************
+ * num-add-ovf.c -- This file is part of libcalc.                        *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+
+#include "libtest.h"
+
+int
+main (void)
+{
+  CalcNumber *a = calc_number_new_si (G_MAXLONG);
+  CalcNumber *b = NULL;
+  CalcNumber *c = NULL;
+  mpz_t value;
+
+  /* The sum no longer fits in a machine word */
+  calc_number_add_ui (&b, a, 1);
+  assert (b != NULL);
+  assert_num_type_equals (b, CALC_NUMBER_TYPE_INTEGER);
+  mpz_init_set_si (value, G_MAXLONG);
+  mpz_add_ui (value, value, 1);
+  assert (calc_number_cmp_z (b, value) == 0);
+  assert (calc_number_cmp (b, a) > 0);
+  mpz_clear (value);
+
+  /* Subtracting brings it back into range */
+  calc_number_sub_ui (&c, b, 1);
+  assert_num_equals_si (c, G_MAXLONG);
+  assert (calc_number_cmp (c, a) == 0);
+
+  g_object_unref (a);
+  g_object_unref (b);
+  g_object_unref (c);
+  return 0;
+}
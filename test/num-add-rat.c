@@ -0,0 +1,51 @@
+/*************************************************************************
+ * num-add-rat.c -- This file is part of libcalc.                        *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+
+#include "libtest.h"
+
+#define TEST_DENOM_A 2
+#define TEST_DENOM_B -6
+
+int
+main (void)
+{
+  CalcNumber *one = calc_number_new_ui (1);
+  CalcNumber *a = NULL;
+  CalcNumber *b = NULL;
+  CalcNumber *c = NULL;
+  CalcNumber *d = NULL;
+  calc_number_div_ui (&a, one, TEST_DENOM_A);
+  calc_number_div_si (&b, one, TEST_DENOM_B);
+  g_object_unref (one);
+  assert (a != NULL);
+  assert (b != NULL);
+  assert_num_type_equals (a, CALC_NUMBER_TYPE_RATIONAL);
+  assert_num_type_equals (b, CALC_NUMBER_TYPE_RATIONAL);
+  calc_number_sub (&c, a, b);
+  g_object_unref (a);
+  g_object_unref (b);
+  assert (c != NULL);
+  assert_num_type_equals (c, CALC_NUMBER_TYPE_RATIONAL);
+  calc_number_mul_ui (&d, c, 3);
+  g_object_unref (c);
+  assert (d != NULL);
+  assert_num_type_equals (d, CALC_NUMBER_TYPE_RATIONAL);
+  assert_num_equals_ui (d, 2);
+  g_object_unref (d);
+  return 0;
+}
@@ -0,0 +1,115 @@
+/*************************************************************************
+ * num-array.c -- This file is part of libcalc.                          *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+
+#include "libtest.h"
+
+#define TEST_LENGTH 1000
+
+static void
+assert_element_equals_d (CalcNumberArray *array, gsize index, double value)
+{
+  CalcNumber *num = calc_number_array_get (array, index);
+  assert_num_equals_d (num, value);
+  g_object_unref (num);
+}
+
+static void
+test_integer (void)
+{
+  CalcNumberArray *a = calc_number_array_new (TEST_LENGTH);
+  CalcNumberArray *b = calc_number_array_new (TEST_LENGTH);
+  CalcNumberArray *c = NULL;
+  CalcNumber *num = NULL;
+  gint cmp[TEST_LENGTH];
+  gsize i;
+
+  for (i = 0; i < TEST_LENGTH; i++)
+    {
+      calc_number_array_set_si (a, i, i);
+      calc_number_array_set_si (b, i, 2);
+    }
+  calc_number_array_mul (&c, a, b);
+  assert_element_equals_d (c, 500, 1000);
+  calc_number_array_sum (&num, c);
+  assert_num_equals_ui (num, TEST_LENGTH * (TEST_LENGTH - 1));
+  calc_number_array_dot (&num, a, b);
+  assert_num_equals_ui (num, TEST_LENGTH * (TEST_LENGTH - 1));
+
+  /* Only the quotients that are not integers are spilled */
+  calc_number_array_div (&c, a, b);
+  assert_element_equals_d (c, 4, 2);
+  g_object_unref (num);
+  num = calc_number_array_get (c, 3);
+  assert_num_type_equals (num, CALC_NUMBER_TYPE_RATIONAL);
+  assert_num_equals_d (num, 1.5);
+
+  /* Overflowing elements are spilled, and the result may be an operand */
+  calc_number_array_set_si (a, 700, G_MAXLONG);
+  calc_number_array_add (&a, a, b);
+  calc_number_array_sub (&a, a, b);
+  calc_number_array_get_value (a, 700, &num->value);
+  assert_num_equals_si (num, G_MAXLONG);
+  calc_number_array_cmp (cmp, a, b);
+  assert (cmp[0] < 0 && cmp[2] == 0 && cmp[700] > 0);
+
+  g_object_unref (a);
+  g_object_unref (b);
+  g_object_unref (c);
+  g_object_unref (num);
+}
+
+static void
+test_floating (void)
+{
+  CalcNumberArray *a = calc_number_array_new (TEST_LENGTH);
+  CalcNumberArray *c = NULL;
+  CalcNumber *scalar = calc_number_new_d (0.1);
+  CalcNumber *num = NULL;
+  gint cmp[TEST_LENGTH];
+  gsize i;
+
+  for (i = 0; i < TEST_LENGTH; i++)
+    calc_number_array_set_d (a, i, i * 0.5);
+  calc_number_array_mul_scalar (&c, a, scalar);
+  assert_element_equals_d (c, 3, 1.5 * 0.1);
+  calc_number_array_div_scalar (&c, c, scalar);
+  assert_element_equals_d (c, 3, 1.5 * 0.1 / 0.1);
+  calc_number_array_cmp_scalar (cmp, a, scalar);
+  assert (cmp[0] < 0 && cmp[1] > 0);
+
+  /* Mixed with exact elements */
+  calc_number_array_set_si (a, 0, 3);
+  calc_number_array_pow_scalar (&c, a, scalar);
+  num = calc_number_array_get (c, 1);
+  assert_num_type_equals (num, CALC_NUMBER_TYPE_FLOATING);
+  calc_number_array_sum (&num, a);
+  assert_num_equals_d (num, 3 + 0.25 * TEST_LENGTH * (TEST_LENGTH - 1));
+
+  g_object_unref (a);
+  g_object_unref (c);
+  g_object_unref (scalar);
+  g_object_unref (num);
+}
+
+int
+main (void)
+{
+  test_integer ();
+  test_floating ();
+  return 0;
+}
@@ -25,10 +25,20 @@ int
 main (void)
 {
   CalcNumber *a = calc_number_new_ui (TEST_VALUE);
+  CalcNumber *b = calc_number_new_decimal (TEST_VALUE * 10 + 5, 1);
   calc_number_cast (NULL, TEST_TYPE);
   calc_number_cast (a, TEST_TYPE);
   assert_num_type_equals (a, TEST_TYPE);
   assert_num_equals_d (a, TEST_VALUE);
+
+  /* Types are promoted by rank rather than by the values of their
+     enumerators, which do not change as types are added */
+  assert (CALC_NUMBER_TYPE_RATIONAL == 2);
+  assert (CALC_NUMBER_TYPE_FLOATING == 3);
+  calc_number_cast (b, CALC_NUMBER_TYPE_RATIONAL);
+  assert_num_type_equals (b, CALC_NUMBER_TYPE_RATIONAL);
+  assert_num_equals_d (b, TEST_VALUE + 0.5);
   g_object_unref (a);
+  g_object_unref (b);
   return 0;
 }
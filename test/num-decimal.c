@@ -0,0 +1,160 @@
+/*************************************************************************
+ * num-decimal.c -- This file is part of libcalc.                        *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+
+#include <string.h>
+#include "libtest.h"
+
+#define TEST_PREC 200
+
+static void
+assert_num_prints (CalcNumber *num, const gchar *text)
+{
+  GString *str = g_string_new (NULL);
+  calc_expr_print_string (CALC_EXPR (num), str, NULL);
+  assert (strcmp (str->str, text) == 0);
+  g_string_free (str, TRUE);
+}
+
+int
+main (void)
+{
+  CalcNumber *a = calc_number_new_decimal (1999, 2);
+  CalcNumber *b = calc_number_new_decimal (5, 3);
+  CalcNumber *c = NULL;
+  CalcNumber *values[3];
+  CalcNumber *n;
+  mpfr_t fr;
+
+  /* Sums take the larger scale and are exact */
+  calc_number_add (&c, a, b);
+  assert_num_type_equals (c, CALC_NUMBER_TYPE_DECIMAL);
+  assert_num_prints (c, "19.995");
+  calc_number_sub (&c, b, a);
+  assert_num_prints (c, "-19.985");
+  calc_number_add_ui (&c, a, 1);
+  assert_num_prints (c, "20.99");
+
+  /* Products add the scales */
+  calc_number_mul (&c, a, b);
+  assert_num_type_equals (c, CALC_NUMBER_TYPE_DECIMAL);
+  assert_num_prints (c, "0.09995");
+  calc_number_mul_si (&c, b, -2);
+  assert_num_prints (c, "-0.010");
+
+  /* Quotients keep the larger scale and round half to even by default */
+  n = calc_number_new_ui (3);
+  calc_number_div (&c, a, n);
+  assert_num_prints (c, "6.66");
+  g_object_unref (n);
+  n = calc_number_new_decimal (125, 2);
+  calc_number_div_ui (&c, n, 2);
+  assert_num_prints (c, "0.62");
+  calc_value_set_decimal_round (CALC_DECIMAL_ROUND_HALF_UP);
+  calc_number_div_ui (&c, n, 2);
+  assert_num_prints (c, "0.63");
+  calc_value_set_decimal_round (CALC_DECIMAL_ROUND_FLOOR);
+  calc_number_div_si (&c, n, -2);
+  assert_num_prints (c, "-0.63");
+  calc_value_set_decimal_round (CALC_DECIMAL_ROUND_HALF_EVEN);
+  g_object_unref (n);
+
+  /* Coefficients that overflow a word move to GNU MP storage */
+  n = calc_number_new_decimal (G_MAXLONG, 2);
+  calc_number_add (&c, n, n);
+  assert (calc_number_cmp (c, n) > 0);
+  calc_number_sub (&c, c, n);
+  assert (calc_number_cmp (c, n) == 0);
+  calc_number_mul (&c, n, n);
+  calc_number_div (&c, c, n);
+  assert (calc_number_cmp (c, n) == 0);
+  g_object_unref (n);
+
+  /* Mixing with rationals gives exact rationals */
+  n = calc_number_new_str ("1/3");
+  calc_number_add (&c, a, n);
+  assert_num_type_equals (c, CALC_NUMBER_TYPE_RATIONAL);
+  calc_number_sub (&c, c, n);
+  assert (calc_number_cmp (c, a) == 0);
+  g_object_unref (n);
+
+  /* Parsed strings are quantized to a fixed scale */
+  n = calc_number_new_str ("12.5");
+  calc_number_quantize (&c, n, 2);
+  assert_num_type_equals (c, CALC_NUMBER_TYPE_DECIMAL);
+  assert_num_prints (c, "12.50");
+  assert (calc_number_cmp (c, n) == 0);
+  g_object_unref (n);
+  n = calc_number_new_double (0.1);
+  calc_number_quantize (&c, n, 20);
+  assert_num_prints (c, "0.10000000000000000555");
+  g_object_unref (n);
+
+  /* Floating-point zeros quantize without building their exponent */
+  n = calc_number_new_double (0.0);
+  calc_number_quantize (&c, n, 3);
+  assert_num_type_equals (c, CALC_NUMBER_TYPE_DECIMAL);
+  assert_num_prints (c, "0.000");
+  g_object_unref (n);
+  mpfr_init2 (fr, TEST_PREC);
+  mpfr_set_zero (fr, 1);
+  n = calc_number_new_fr (fr);
+  calc_number_quantize (&c, n, 2);
+  assert_num_type_equals (c, CALC_NUMBER_TYPE_DECIMAL);
+  assert_num_prints (c, "0.00");
+  assert_num_equals_ui (c, 0);
+  g_object_unref (n);
+  mpfr_clear (fr);
+
+  /* Sums are exact and keep the largest scale */
+  values[0] = calc_number_new_decimal (10, 1);
+  values[1] = calc_number_new_decimal (-1, 2);
+  values[2] = calc_number_new_ui (2);
+  calc_number_sum (&c, values, 3);
+  assert_num_type_equals (c, CALC_NUMBER_TYPE_DECIMAL);
+  assert_num_prints (c, "2.99");
+  calc_number_fma (&c, values[0], values[1], values[2]);
+  assert_num_prints (c, "1.990");
+  g_object_unref (values[0]);
+  g_object_unref (values[1]);
+  g_object_unref (values[2]);
+
+  /* Other functions treat decimals as rationals */
+  n = calc_number_new_decimal (225, 2);
+  calc_number_sqrt (&c, n);
+  assert (calc_number_cmp_d (c, 1.5) == 0);
+  assert (calc_number_get_double (n) == 2.25);
+  calc_number_neg (&c, n);
+  assert_num_prints (c, "-2.25");
+  calc_number_cast (n, CALC_NUMBER_TYPE_DOUBLE);
+  assert_num_type_equals (n, CALC_NUMBER_TYPE_DOUBLE);
+  assert (calc_number_get_double (n) == 2.25);
+  g_object_unref (n);
+
+  /* Equal values hash equally */
+  n = calc_number_new_decimal (250, 2);
+  g_object_unref (b);
+  b = calc_number_new_str ("5/2");
+  assert (calc_expr_hash (CALC_EXPR (n)) == calc_expr_hash (CALC_EXPR (b)));
+  assert (calc_number_cmp (n, b) == 0);
+  g_object_unref (n);
+  g_object_unref (b);
+
+  g_object_unref (a);
+  g_object_unref (c);
+  return 0;
+}
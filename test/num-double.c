@@ -0,0 +1,130 @@
+/*************************************************************************
+ * num-double.c -- This file is part of libcalc.                         *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+#include <math.h>
+#include "libtest.h"
+
+#define TEST_PREC 100
+
+int
+main (void)
+{
+  CalcNumber *a = calc_number_new_double (0.1);
+  CalcNumber *b = calc_number_new_double (0.2);
+  CalcNumber *c = NULL;
+  CalcNumber *values[3];
+  CalcNumber *n;
+  mpz_t z;
+  mpfr_t fr;
+
+  /* Doubles round like hardware arithmetic, not like exact decimals */
+  assert_num_type_equals (a, CALC_NUMBER_TYPE_DOUBLE);
+  calc_number_add (&c, a, b);
+  assert_num_type_equals (c, CALC_NUMBER_TYPE_DOUBLE);
+  assert (calc_number_get_double (c) == 0.1 + 0.2);
+  assert (calc_number_get_prec (c) == 53);
+
+  /* Exact operands give a double */
+  n = calc_number_new_ui (3);
+  calc_number_mul (&c, n, a);
+  assert_num_type_equals (c, CALC_NUMBER_TYPE_DOUBLE);
+  assert (calc_number_get_double (c) == 3 * 0.1);
+  calc_number_div (&c, a, n);
+  assert (calc_number_get_double (c) == 0.1 / 3);
+  calc_number_sub_ui (&c, a, 1);
+  assert_num_type_equals (c, CALC_NUMBER_TYPE_DOUBLE);
+  assert (calc_number_get_double (c) == 0.1 - 1);
+  g_object_unref (n);
+
+  /* Arbitrary floating-point operands keep their precision */
+  mpfr_init2 (fr, TEST_PREC);
+  mpfr_set_ui (fr, 1, MPFR_RNDN);
+  n = calc_number_new_fr (fr);
+  calc_number_add (&c, a, n);
+  assert_num_type_equals (c, CALC_NUMBER_TYPE_FLOATING);
+  assert (calc_number_get_prec (c) == TEST_PREC);
+  assert (calc_number_cmp_d (c, 1.1) != 0);
+  mpfr_clear (fr);
+  g_object_unref (n);
+
+  /* Comparisons with exact values are exact */
+  mpz_init_set_ui (z, 1);
+  mpz_mul_2exp (z, z, 53);
+  mpz_add_ui (z, z, 1);
+  n = calc_number_new_double (0x1p53);
+  assert (calc_number_cmp_z (n, z) < 0);
+  assert (calc_number_get_double (n) == 0x1p53);
+  mpz_clear (z);
+  calc_number_div_ui (&c, n, 1UL << 52);
+  assert (calc_number_cmp_ui (c, 2) == 0);
+  g_object_unref (n);
+
+  /* Overflow and division by zero follow IEEE 754 */
+  n = calc_number_new_ui (0);
+  calc_number_div (&c, a, n);
+  assert_num_type_equals (c, CALC_NUMBER_TYPE_DOUBLE);
+  assert (isinf (calc_number_get_double (c)));
+  g_object_unref (n);
+
+  /* Functions are computed natively */
+  g_object_unref (b);
+  n = calc_number_new_ui (10);
+  b = calc_number_new_double (2);
+  calc_number_pow (&c, b, n);
+  assert_num_type_equals (c, CALC_NUMBER_TYPE_DOUBLE);
+  assert_num_equals_ui (c, 1024);
+  calc_number_sqrt (&c, b);
+  assert (calc_number_get_double (c) == sqrt (2));
+  calc_number_log (&c, b);
+  assert (calc_number_get_double (c) == log (2));
+  calc_number_logn (&c, c, 10);
+  assert_num_type_equals (c, CALC_NUMBER_TYPE_DOUBLE);
+  g_object_unref (n);
+  g_object_unref (b);
+
+  /* A sum of doubles is rounded once */
+  values[0] = calc_number_new_double (1e100);
+  values[1] = calc_number_new_ui (1);
+  values[2] = calc_number_new_double (-1e100);
+  calc_number_sum (&c, values, 3);
+  assert_num_type_equals (c, CALC_NUMBER_TYPE_DOUBLE);
+  assert_num_equals_ui (c, 1);
+  g_object_unref (values[0]);
+  g_object_unref (values[1]);
+  g_object_unref (values[2]);
+
+  /* Casts go towards less exact types */
+  n = calc_number_new_si (-3);
+  calc_number_cast (n, CALC_NUMBER_TYPE_DOUBLE);
+  assert_num_type_equals (n, CALC_NUMBER_TYPE_DOUBLE);
+  assert_num_equals_si (n, -3);
+  calc_number_cast (n, CALC_NUMBER_TYPE_FLOATING);
+  assert_num_type_equals (n, CALC_NUMBER_TYPE_FLOATING);
+  assert_num_equals_si (n, -3);
+  g_object_unref (n);
+
+  /* Equal values hash equally */
+  n = calc_number_new_double (-3);
+  b = calc_number_new_si (-3);
+  assert (calc_expr_hash (CALC_EXPR (n)) == calc_expr_hash (CALC_EXPR (b)));
+  g_object_unref (n);
+  g_object_unref (b);
+
+  g_object_unref (a);
+  g_object_unref (c);
+  return 0;
+}
@@ -0,0 +1,94 @@
+/*************************************************************************
+ * num-fma.c -- This file is part of libcalc.                            *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+
+#include "libtest.h"
+
+#define TEST_LENGTH 3
+
+static void
+test_integer (void)
+{
+  CalcNumber *a = calc_number_new_ui (3);
+  CalcNumber *b = calc_number_new_ui (4);
+  CalcNumber *c = calc_number_new_ui (5);
+  CalcNumber *d = NULL;
+  calc_number_fma (&d, a, b, c);
+  assert_num_type_equals (d, CALC_NUMBER_TYPE_INTEGER);
+  assert_num_equals_ui (d, 17);
+  calc_number_fms (&d, a, b, c);
+  assert_num_equals_ui (d, 7);
+  g_object_unref (a);
+  g_object_unref (b);
+  g_object_unref (c);
+  g_object_unref (d);
+}
+
+/* (1 + 2^-52) * (1 - 2^-52) - 1 is -2^-104, but rounding the product to
+   53 bits first would give zero */
+
+static void
+test_single_rounding (void)
+{
+  CalcNumber *a = calc_number_new_d (1.0 + 0x1p-52);
+  CalcNumber *b = calc_number_new_d (1.0 - 0x1p-52);
+  CalcNumber *c = calc_number_new_d (1.0);
+  CalcNumber *d = NULL;
+  calc_number_fms (&d, a, b, c);
+  assert_num_type_equals (d, CALC_NUMBER_TYPE_FLOATING);
+  assert_num_equals_d (d, -0x1p-104);
+  g_object_unref (a);
+  g_object_unref (b);
+  g_object_unref (c);
+  g_object_unref (d);
+}
+
+static void
+test_dot (void)
+{
+  double values[TEST_LENGTH] = {1e100, 1.0, -1e100};
+  CalcNumber *a[TEST_LENGTH];
+  CalcNumber *b[TEST_LENGTH];
+  CalcNumber *c = NULL;
+  int i;
+
+  for (i = 0; i < TEST_LENGTH; i++)
+    {
+      a[i] = calc_number_new_d (values[i]);
+      b[i] = calc_number_new_ui (1);
+    }
+  calc_number_dot (&c, a, b, TEST_LENGTH);
+  assert_num_equals_ui (c, 1);
+  calc_number_dot (&c, a, b, 0);
+  assert_num_type_equals (c, CALC_NUMBER_TYPE_INTEGER);
+  assert_num_equals_ui (c, 0);
+  for (i = 0; i < TEST_LENGTH; i++)
+    {
+      g_object_unref (a[i]);
+      g_object_unref (b[i]);
+    }
+  g_object_unref (c);
+}
+
+int
+main (void)
+{
+  test_integer ();
+  test_single_rounding ();
+  test_dot ();
+  return 0;
+}
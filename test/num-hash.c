@@ -0,0 +1,123 @@
+/*************************************************************************
+ * num-hash.c -- This file is part of libcalc.                           *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+
+#include "libtest.h"
+
+#define TEST_VALUE 6
+#define TEST_PREC 200
+
+static guint64
+term_hash (unsigned long coefficient, CalcVariable *var)
+{
+  CalcNumber *a = calc_number_new_ui (coefficient);
+  CalcTerm *term = calc_term_new (a);
+  guint64 hash;
+  calc_term_add_factor (term, CALC_EXPR (var));
+  hash = calc_expr_hash (CALC_EXPR (term));
+  g_object_unref (term);
+  g_object_unref (a);
+  return hash;
+}
+
+int
+main (void)
+{
+  CalcNumber *a = calc_number_new_ui (TEST_VALUE);
+  CalcNumber *b;
+  CalcVariable *x = calc_variable_new ("x");
+  CalcVariable *y = calc_variable_new ("y");
+  CalcSum *s;
+  CalcSum *t;
+  CalcTerm *c;
+  CalcVariable *v;
+  guint64 hash = calc_expr_hash (CALC_EXPR (a));
+  mpq_t q;
+  mpfr_t fr;
+
+  /* Equal values hash equally regardless of representation */
+  mpq_init (q);
+  mpq_set_ui (q, TEST_VALUE, 1);
+  b = calc_number_new_q (q);
+  assert_num_type_equals (b, CALC_NUMBER_TYPE_RATIONAL);
+  assert (calc_expr_hash (CALC_EXPR (b)) == hash);
+  g_object_unref (b);
+  b = calc_number_new_d (TEST_VALUE);
+  assert (calc_expr_hash (CALC_EXPR (b)) == hash);
+  g_object_unref (b);
+  mpfr_init2 (fr, TEST_PREC);
+  mpfr_set_ui (fr, TEST_VALUE, MPFR_RNDN);
+  b = calc_number_new_fr (fr);
+  assert (calc_expr_hash (CALC_EXPR (b)) == hash);
+  g_object_unref (b);
+  b = calc_number_new_ui (TEST_VALUE + 1);
+  assert (calc_expr_hash (CALC_EXPR (b)) != hash);
+  g_object_unref (b);
+
+  /* 1/6 + 1/3 is left unreduced but must hash as 1/2 and 0.5 */
+  mpq_set_ui (q, 1, 6);
+  g_object_unref (a);
+  a = calc_number_new_q (q);
+  mpq_set_ui (q, 1, 3);
+  b = calc_number_new_q (q);
+  calc_number_add_inplace (a, b);
+  g_object_unref (b);
+  hash = calc_expr_hash (CALC_EXPR (a));
+  b = calc_number_new_d (0.5);
+  assert (calc_expr_hash (CALC_EXPR (b)) == hash);
+  g_object_unref (b);
+  mpq_set_ui (q, 1, 2);
+  b = calc_number_new_q (q);
+  assert (calc_expr_hash (CALC_EXPR (b)) == hash);
+  g_object_unref (b);
+
+  /* Sums do not depend on the order of their terms */
+  s = calc_sum_new (CALC_EXPR (x));
+  calc_sum_add_term (s, CALC_EXPR (y));
+  t = calc_sum_new (CALC_EXPR (y));
+  calc_sum_add_term (t, CALC_EXPR (x));
+  assert (calc_expr_hash (CALC_EXPR (x)) != calc_expr_hash (CALC_EXPR (y)));
+  assert (calc_expr_hash (CALC_EXPR (s)) == calc_expr_hash (CALC_EXPR (t)));
+  assert (calc_expr_equivalent (CALC_EXPR (s), CALC_EXPR (t)));
+
+  /* Mutating a term invalidates the cached hashes of it and its parent */
+  hash = calc_expr_hash (CALC_EXPR (s));
+  c = CALC_TERM (s->terms->pdata[0]);
+  v = CALC_VARIABLE (CALC_EXPONENT (c->factors->pdata[0])->base);
+  assert (calc_expr_hash (CALC_EXPR (c)) == term_hash (1, v));
+  b = calc_number_new_ui (1);
+  calc_number_add_inplace (calc_term_get_coefficient (c), b);
+  g_object_unref (b);
+  assert (calc_expr_hash (CALC_EXPR (c)) == term_hash (2, v));
+  assert (calc_expr_hash (CALC_EXPR (s)) != hash);
+  assert (!calc_expr_equivalent (CALC_EXPR (s), CALC_EXPR (t)));
+
+  /* Renaming a shared variable invalidates every sum containing it */
+  hash = calc_expr_hash (CALC_EXPR (t));
+  calc_variable_set_name (v, "z");
+  assert (calc_expr_hash (CALC_EXPR (t)) != hash);
+  assert (calc_expr_hash (CALC_EXPR (c)) == term_hash (2, v));
+
+  g_object_unref (a);
+  g_object_unref (s);
+  g_object_unref (t);
+  g_object_unref (x);
+  g_object_unref (y);
+  mpfr_clear (fr);
+  mpq_clear (q);
+  return 0;
+}
@@ -0,0 +1,137 @@
+/*************************************************************************
+ * num-lazy-q.c -- This file is part of libcalc.                         *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "libtest.h"
+
+#define TEST_TERMS 300
+
+static void
+assert_num_prints (CalcNumber *num, mpq_t value)
+{
+  char *expected = mpq_get_str (NULL, 10, value);
+  char *text;
+  size_t len;
+  FILE *stream = open_memstream (&text, &len);
+  calc_expr_print (CALC_EXPR (num), stream);
+  fclose (stream);
+  assert (strcmp (text, expected) == 0);
+  free (expected);
+  free (text);
+}
+
+int
+main (void)
+{
+  CalcNumber *a;
+  CalcNumber *b;
+  mpq_t sum;
+  mpq_t q;
+  unsigned long i;
+
+  /* Harmonic sum, whose unreduced denominator grows past the threshold */
+  mpq_inits (sum, q, NULL);
+  mpq_set_ui (sum, 1, 2);
+  a = calc_number_new_q (sum);
+  for (i = 3; i <= TEST_TERMS; i++)
+    {
+      mpq_set_ui (q, 1, i);
+      mpq_add (sum, sum, q);
+      b = calc_number_new_q (q);
+      calc_number_add_inplace (a, b);
+      g_object_unref (b);
+    }
+  assert_num_type_equals (a, CALC_NUMBER_TYPE_RATIONAL);
+  assert (calc_number_cmp_q (a, sum) == 0);
+  assert_num_prints (a, sum);
+
+  /* Telescoping product of f(i)/f(i+1) for i from 2 to 99, where f(i) is
+     i * 2^64 + 1 so that the product does not fit in a word */
+  g_object_unref (a);
+  a = calc_number_new_ui (1);
+  calc_number_div_ui (&a, a, 2);
+  for (i = 2; i < 100; i++)
+    {
+      mpz_set_ui (mpq_numref (q), i);
+      mpz_mul_2exp (mpq_numref (q), mpq_numref (q), 64);
+      mpz_add_ui (mpq_numref (q), mpq_numref (q), 1);
+      mpz_set_ui (mpq_denref (q), i + 1);
+      mpz_mul_2exp (mpq_denref (q), mpq_denref (q), 64);
+      mpz_add_ui (mpq_denref (q), mpq_denref (q), 1);
+      mpq_canonicalize (q);
+      b = calc_number_new_q (q);
+      calc_number_mul_inplace (a, b);
+      g_object_unref (b);
+    }
+  calc_number_normalize (a);
+  mpz_set_ui (mpq_numref (q), 2);
+  mpz_mul_2exp (mpq_numref (q), mpq_numref (q), 64);
+  mpz_add_ui (mpq_numref (q), mpq_numref (q), 1);
+  mpz_set_ui (mpq_denref (q), 100);
+  mpz_mul_2exp (mpq_denref (q), mpq_denref (q), 64);
+  mpz_add_ui (mpq_denref (q), mpq_denref (q), 1);
+  mpq_canonicalize (q);
+  mpq_div_2exp (sum, q, 1);
+  assert_num_prints (a, sum);
+
+  /* Dividing by -3/7 and then 7 */
+  mpq_set_si (q, -3, 7);
+  b = calc_number_new_q (q);
+  calc_number_div_inplace (a, b);
+  mpq_div (sum, sum, q);
+  g_object_unref (b);
+  b = calc_number_new_ui (7);
+  calc_number_div_inplace (a, b);
+  mpq_set (q, sum);
+  mpz_mul_ui (mpq_denref (q), mpq_denref (q), 7);
+  mpq_canonicalize (q);
+  assert (calc_number_cmp_q (a, q) == 0);
+  assert_num_prints (a, q);
+
+  /* Adding a number to itself */
+  calc_number_add_inplace (a, a);
+  mpq_mul_2exp (q, q, 1);
+  assert_num_prints (a, q);
+  g_object_unref (a);
+  g_object_unref (b);
+
+  /* Reading an unreduced value does not write to it, so that it can be
+     read by several threads at once */
+  mpq_set_ui (q, 1, 3);
+  mpq_div_2exp (q, q, 64);
+  a = calc_number_new_q (q);
+  mpq_div_2exp (q, q, 1);
+  b = calc_number_new_q (q);
+  calc_number_add_inplace (a, b);
+  mpq_set_ui (sum, 1, 2);
+  mpq_div_2exp (sum, sum, 64);
+  assert (a->value.unreduced);
+  assert (calc_number_cmp_q (a, sum) == 0);
+  assert_num_prints (a, sum);
+  assert (a->value.unreduced);
+  calc_number_normalize (a);
+  assert (!a->value.unreduced);
+  assert_num_prints (a, sum);
+
+  g_object_unref (a);
+  g_object_unref (b);
+  mpq_clears (sum, q, NULL);
+  return 0;
+}
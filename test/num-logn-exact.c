@@ -0,0 +1,69 @@
+/*************************************************************************
+ * num-logn-exact.c -- This file is part of libcalc.                     *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+
+#include "libtest.h"
+
+int
+main (void)
+{
+  CalcNumber *a = calc_number_new_ui (1024);
+  CalcNumber *b = NULL;
+  CalcNumber *c = NULL;
+  mpq_t q;
+  int i;
+
+  calc_number_logn (&b, a, 2);
+  assert_num_type_equals (b, CALC_NUMBER_TYPE_INTEGER);
+  assert_num_equals_ui (b, 10);
+
+  /* log_32 1024 = 2, log_8 1024 = 10/3 */
+  calc_number_logn (&b, a, 32);
+  assert_num_type_equals (b, CALC_NUMBER_TYPE_INTEGER);
+  assert_num_equals_ui (b, 2);
+  calc_number_logn (&b, a, 8);
+  assert_num_type_equals (b, CALC_NUMBER_TYPE_RATIONAL);
+  mpq_init (q);
+  mpq_set_ui (q, 10, 3);
+  assert (calc_number_cmp_q (b, q) == 0);
+
+  /* log_10 1/1000 = -3 */
+  g_object_unref (a);
+  a = calc_number_new_ui (1);
+  calc_number_div_ui (&a, a, 1000);
+  calc_number_logn (&b, a, 10);
+  assert_num_equals_si (b, -3);
+
+  /* Inexact logarithms use the cached logarithm of the base */
+  g_object_unref (a);
+  a = calc_number_new_ui (2000);
+  calc_number_logn (&c, a, 10);
+  assert_num_type_equals (c, CALC_NUMBER_TYPE_FLOATING);
+  assert (calc_number_cmp_d (c, 3.301) > 0);
+  assert (calc_number_cmp_d (c, 3.302) < 0);
+  for (i = 0; i < 3; i++)
+    {
+      calc_number_logn (&b, a, 10);
+      assert (calc_number_cmp (b, c) == 0);
+    }
+
+  g_object_unref (a);
+  g_object_unref (b);
+  g_object_unref (c);
+  mpq_clear (q);
+  return 0;
+}
@@ -0,0 +1,122 @@
+/*************************************************************************
+ * num-new-str.c -- This file is part of libcalc.                        *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+
+#include <string.h>
+#include "libtest.h"
+
+#define TEST_LONG_DIGITS 5000
+
+static void
+assert_str_equals (const char *str, const char *value, CalcNumberType type)
+{
+  CalcNumber *num = calc_number_new_str (str);
+  mpq_t q;
+  assert (num != NULL);
+  assert_num_type_equals (num, type);
+  mpq_init (q);
+  assert (mpq_set_str (q, value, 10) == 0);
+  mpq_canonicalize (q);
+  assert (calc_number_cmp_q (num, q) == 0);
+  mpq_clear (q);
+  g_object_unref (num);
+}
+
+int
+main (void)
+{
+  const char *invalid[] = {
+    "", "-", "+", ".", "e5", "1e", "1e+", "1/", "/2", "1/0", "1/-2", "1.5/2",
+    "1..2", " 1", "1 ", "0x10", "1e99999999999", "--1"
+  };
+  const char *buffer = "12.5,-3/4,7e2";
+  CalcNumber *a;
+  char *str;
+  char *value;
+  mpq_t q;
+  size_t i;
+
+  assert_str_equals ("0", "0", CALC_NUMBER_TYPE_INTEGER);
+  assert_str_equals ("-0", "0", CALC_NUMBER_TYPE_INTEGER);
+  assert_str_equals ("+42", "42", CALC_NUMBER_TYPE_INTEGER);
+  assert_str_equals ("-9223372036854775808", "-9223372036854775808",
+		     CALC_NUMBER_TYPE_INTEGER);
+  assert_str_equals ("9223372036854775808", "9223372036854775808",
+		     CALC_NUMBER_TYPE_INTEGER);
+  assert_str_equals ("1200e3", "1200000", CALC_NUMBER_TYPE_INTEGER);
+  assert_str_equals ("1E30", "1000000000000000000000000000000",
+		     CALC_NUMBER_TYPE_INTEGER);
+  assert_str_equals ("6/8", "3/4", CALC_NUMBER_TYPE_RATIONAL);
+  assert_str_equals ("-0/5", "0", CALC_NUMBER_TYPE_RATIONAL);
+  assert_str_equals ("0.1", "1/10", CALC_NUMBER_TYPE_RATIONAL);
+  assert_str_equals ("-2.50", "-5/2", CALC_NUMBER_TYPE_RATIONAL);
+  assert_str_equals ("3.", "3", CALC_NUMBER_TYPE_RATIONAL);
+  assert_str_equals (".75", "3/4", CALC_NUMBER_TYPE_RATIONAL);
+  assert_str_equals ("000.0000", "0", CALC_NUMBER_TYPE_RATIONAL);
+  assert_str_equals ("1.5e-3", "3/2000", CALC_NUMBER_TYPE_RATIONAL);
+  assert_str_equals ("100e-2", "1", CALC_NUMBER_TYPE_RATIONAL);
+  assert_str_equals ("6.02214076e23", "602214076000000000000000",
+		     CALC_NUMBER_TYPE_RATIONAL);
+  assert_str_equals ("1e-25", "1/10000000000000000000000000",
+		     CALC_NUMBER_TYPE_RATIONAL);
+  assert_str_equals ("0.0000000000000000000000000000032",
+		     "1/312500000000000000000000000000",
+		     CALC_NUMBER_TYPE_RATIONAL);
+  assert_str_equals ("1234567890123456789012345.6789",
+		     "12345678901234567890123456789/10000",
+		     CALC_NUMBER_TYPE_RATIONAL);
+
+  for (i = 0; i < G_N_ELEMENTS (invalid); i++)
+    assert (calc_number_new_str (invalid[i]) == NULL);
+
+  /* Long digit strings, with a decimal point in the middle */
+  str = g_malloc (TEST_LONG_DIGITS + 2);
+  value = g_malloc (TEST_LONG_DIGITS * 2 + 3);
+  for (i = 0; i < TEST_LONG_DIGITS; i++)
+    str[i] = '0' + (i * 7 + 3) % 10;
+  str[TEST_LONG_DIGITS] = '\0';
+  memcpy (value, str, TEST_LONG_DIGITS + 1);
+  assert_str_equals (str, value, CALC_NUMBER_TYPE_INTEGER);
+  memmove (str + TEST_LONG_DIGITS / 2 + 1, str + TEST_LONG_DIGITS / 2,
+	   TEST_LONG_DIGITS / 2 + 1);
+  str[TEST_LONG_DIGITS / 2] = '.';
+  value[TEST_LONG_DIGITS] = '/';
+  value[TEST_LONG_DIGITS + 1] = '1';
+  memset (value + TEST_LONG_DIGITS + 2, '0', TEST_LONG_DIGITS / 2);
+  value[TEST_LONG_DIGITS + 2 + TEST_LONG_DIGITS / 2] = '\0';
+  assert_str_equals (str, value, CALC_NUMBER_TYPE_RATIONAL);
+  g_free (str);
+  g_free (value);
+
+  /* Parsing fields in place from a buffer */
+  a = calc_number_new (NULL);
+  mpq_init (q);
+  assert (calc_number_set_str (a, buffer, 4));
+  mpq_set_ui (q, 25, 2);
+  assert (calc_number_cmp_q (a, q) == 0);
+  assert (calc_number_set_str (a, buffer + 5, 4));
+  mpq_set_si (q, -3, 4);
+  assert (calc_number_cmp_q (a, q) == 0);
+  assert (!calc_number_set_str (a, buffer + 5, 5));
+  assert (calc_number_cmp_q (a, q) == 0);
+  assert (calc_number_set_str (a, buffer + 10, -1));
+  assert_num_equals_ui (a, 700);
+
+  mpq_clear (q);
+  g_object_unref (a);
+  return 0;
+}
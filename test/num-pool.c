@@ -0,0 +1,95 @@
+/*************************************************************************
+ * num-pool.c -- This file is part of libcalc.                           *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+
+#include "libtest.h"
+
+#define TEST_COUNT 100
+#define TEST_DATA_KEY "test-data"
+
+static void
+test_weak_notify (gpointer data, GObject *obj)
+{
+  *(gboolean *) data = TRUE;
+}
+
+int
+main (void)
+{
+  CalcNumber *a;
+  CalcNumber *b = NULL;
+  guint64 hits;
+  guint64 misses;
+  gboolean notified = FALSE;
+  mpz_t value;
+  int i;
+
+  assert (!calc_number_pool_get_enabled ());
+  calc_number_pool_set_enabled (TRUE);
+
+  /* Freed numbers, including their GNU MP storage, should be reused */
+  mpz_init_set_si (value, G_MAXLONG);
+  mpz_mul (value, value, value);
+  for (i = 0; i < TEST_COUNT; i++)
+    {
+      a = calc_number_new_z (value);
+      calc_number_add_ui (&b, a, i);
+      calc_number_sub (&b, b, a);
+      assert_num_type_equals (b, CALC_NUMBER_TYPE_INTEGER);
+      assert_num_equals_si (b, i);
+      g_object_unref (a);
+      g_object_unref (b);
+      b = NULL;
+    }
+  mpz_clear (value);
+
+  calc_number_pool_get_stats (&hits, &misses);
+  assert (hits + misses == 2 * TEST_COUNT);
+  assert (hits >= 2 * TEST_COUNT - 2);
+
+  /* Recycled numbers start from a clean state */
+  a = calc_number_new (NULL);
+  assert_num_type_equals (a, CALC_NUMBER_TYPE_INTEGER);
+  assert_num_equals_ui (a, 0);
+  g_object_unref (a);
+
+  /* Numbers carrying data or weak references are finalized rather than
+     handed to the next caller */
+  a = calc_number_new_ui (1);
+  g_object_set_data (G_OBJECT (a), TEST_DATA_KEY, &notified);
+  g_object_weak_ref (G_OBJECT (a), test_weak_notify, &notified);
+  g_object_unref (a);
+  assert (notified);
+  a = calc_number_new (NULL);
+  assert (g_object_get_data (G_OBJECT (a), TEST_DATA_KEY) == NULL);
+  g_object_unref (a);
+
+  /* Storage of large values is freed rather than kept */
+  mpz_init_set_ui (value, 1);
+  mpz_mul_2exp (value, value, 100000);
+  a = calc_number_new_z (value);
+  g_object_unref (a);
+  mpz_clear (value);
+
+  calc_number_pool_trim ();
+  calc_number_pool_set_enabled (FALSE);
+  a = calc_number_new_ui (1);
+  g_object_unref (a);
+  calc_number_pool_get_stats (&hits, &misses);
+  assert (hits + misses == 2 * TEST_COUNT + 4);
+  return 0;
+}
@@ -0,0 +1,73 @@
+/*************************************************************************
+ * num-pow-exact.c -- This file is part of libcalc.                      *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+
+#include <stdlib.h>
+#include "libtest.h"
+
+int
+main (void)
+{
+  CalcNumber *a = calc_number_new_ui (2);
+  CalcNumber *b = calc_number_new_si (-3);
+  CalcNumber *c = NULL;
+  CalcExponent *exp;
+  mpq_t q;
+
+  /* 3/2 ^ -3 = 8/27 */
+  calc_number_add_si (&a, a, 1);
+  calc_number_div_ui (&a, a, 2);
+  assert (calc_number_pow (&c, a, b) == 0);
+  assert_num_type_equals (c, CALC_NUMBER_TYPE_RATIONAL);
+  mpq_init (q);
+  mpq_set_ui (q, 8, 27);
+  assert (calc_number_cmp_q (c, q) == 0);
+
+  /* 16 ^ 3/4 = 8 */
+  g_object_unref (a);
+  a = calc_number_new_ui (16);
+  mpq_set_ui (q, 3, 4);
+  g_object_unref (b);
+  b = calc_number_new_q (q);
+  assert (calc_number_pow (&c, a, b) == 0);
+  assert_num_type_equals (c, CALC_NUMBER_TYPE_INTEGER);
+  assert_num_equals_ui (c, 8);
+
+  /* 2 ^ 1/2 is irrational */
+  calc_number_div_ui (&a, a, 8);
+  mpq_set_ui (q, 1, 2);
+  g_object_unref (b);
+  b = calc_number_new_q (q);
+  calc_number_pow (&c, a, b);
+  assert_num_type_equals (c, CALC_NUMBER_TYPE_FLOATING);
+
+  /* 2 ^ 100 overflows a machine word */
+  calc_number_mul_ui (&c, a, 50);
+  exp = calc_exponent_new (CALC_EXPR (a), CALC_EXPR (c));
+  assert (calc_expr_evaluate (CALC_EXPR (exp), CALC_EXPR (b)));
+  assert_num_type_equals (b, CALC_NUMBER_TYPE_INTEGER);
+  calc_number_div (&b, b, a);
+  calc_number_log2 (&b, b);
+  assert_num_equals_ui (b, 99);
+
+  g_object_unref (exp);
+  g_object_unref (a);
+  g_object_unref (b);
+  g_object_unref (c);
+  mpq_clear (q);
+  return 0;
+}
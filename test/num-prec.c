@@ -0,0 +1,98 @@
+/*************************************************************************
+ * num-prec.c -- This file is part of libcalc.                           *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+
+#include <stdlib.h>
+#include "libtest.h"
+
+int
+main (void)
+{
+  CalcNumber *a;
+  CalcNumber *b;
+  CalcNumber *c = NULL;
+  mpfr_t fr;
+
+  mpfr_init2 (fr, 200);
+  mpfr_set_ui (fr, 3, MPFR_RNDN);
+  a = calc_number_new_fr (fr);
+  b = calc_number_new_ui (7);
+  assert (calc_number_get_prec (a) == 200);
+  assert (calc_number_get_prec (b) == 0);
+
+  /* Exact operands do not lower the precision */
+  calc_number_div (&c, a, b);
+  assert (calc_number_get_prec (c) == 200);
+  calc_number_log (&c, b);
+  assert (calc_number_get_prec (c) == mpfr_get_default_prec ());
+
+  /* Mixed precisions take the largest one */
+  mpfr_set_prec (fr, 80);
+  mpfr_set_ui (fr, 5, MPFR_RNDN);
+  calc_number_mul_fr (&c, a, fr);
+  assert (calc_number_get_prec (c) == 200);
+  g_object_unref (b);
+  b = calc_number_new_fr (fr);
+  calc_number_sub (&c, b, a);
+  assert (calc_number_get_prec (c) == 200);
+  calc_number_neg (&c, b);
+  assert (calc_number_get_prec (c) == 80);
+
+  /* The override applies to every result */
+  calc_value_set_prec_override (1024);
+  calc_number_add (&c, a, b);
+  assert (calc_number_get_prec (c) == 1024);
+  calc_number_pow (&c, a, b);
+  assert (calc_number_get_prec (c) == 1024);
+  calc_value_set_prec_override (0);
+  calc_number_add (&c, a, b);
+  assert (calc_number_get_prec (c) == 200);
+
+  /* In-place operations follow the same rules */
+  g_object_unref (a);
+  g_object_unref (b);
+  mpfr_set_prec (fr, 64);
+  mpfr_set_ui (fr, 3, MPFR_RNDN);
+  a = calc_number_new_fr (fr);
+  mpfr_set_prec (fr, 256);
+  mpfr_set_ui (fr, 7, MPFR_RNDN);
+  b = calc_number_new_fr (fr);
+  calc_number_add_inplace (a, b);
+  assert (calc_number_get_prec (a) == 256);
+  g_object_unref (a);
+  mpfr_set_prec (fr, 64);
+  mpfr_set_ui (fr, 3, MPFR_RNDN);
+  a = calc_number_new_fr (fr);
+  calc_number_mul_inplace (a, b);
+  assert (calc_number_get_prec (a) == 256);
+  g_object_unref (a);
+  a = calc_number_new_fr (fr);
+  calc_number_div_inplace (a, b);
+  assert (calc_number_get_prec (a) == 256);
+  calc_value_set_prec_override (512);
+  calc_number_add_inplace (a, b);
+  assert (calc_number_get_prec (a) == 512);
+  calc_number_mul_inplace (a, b);
+  assert (calc_number_get_prec (a) == 512);
+  calc_value_set_prec_override (0);
+
+  g_object_unref (a);
+  g_object_unref (b);
+  g_object_unref (c);
+  mpfr_clear (fr);
+  return 0;
+}
@@ -0,0 +1,52 @@
+/*************************************************************************
+ * num-sum.c -- This file is part of libcalc.                            *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+
+#include "libtest.h"
+
+#define TEST_LENGTH 1025
+#define TEST_SMALL 0x1p-60
+
+/* Adding 2^-60 to one at a time at 53 bits never changes the total, but the
+   correctly rounded sum of 1024 such terms is 1 + 2^-50 */
+
+int
+main (void)
+{
+  CalcNumber *values[TEST_LENGTH];
+  CalcNumber *result = NULL;
+  int i;
+
+  values[0] = calc_number_new_d (1.0);
+  for (i = 1; i < TEST_LENGTH; i++)
+    values[i] = calc_number_new_d (TEST_SMALL);
+  calc_number_sum (&result, values, TEST_LENGTH);
+  assert_num_type_equals (result, CALC_NUMBER_TYPE_FLOATING);
+  assert_num_equals_d (result, 1.0 + 0x1p-50);
+  for (i = 0; i < TEST_LENGTH; i++)
+    g_object_unref (values[i]);
+
+  values[0] = calc_number_new_ui (2);
+  values[1] = calc_number_new_str ("1/3");
+  values[2] = calc_number_new_str ("-1/3");
+  calc_number_sum (&result, values, 3);
+  assert_num_equals_ui (result, 2);
+  for (i = 0; i < 3; i++)
+    g_object_unref (values[i]);
+  g_object_unref (result);
+  return 0;
+}
@@ -0,0 +1,64 @@
+/*************************************************************************
+ * num-trans.c -- This file is part of libcalc.                          *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+
+#include <math.h>
+#include "libtest.h"
+
+int
+main (void)
+{
+  CalcNumber *a = calc_number_new_ui (0);
+  CalcNumber *b = NULL;
+  CalcNumber *c;
+
+  /* Exact operands with exact results */
+  assert (calc_number_exp (&b, a) == 0);
+  assert_num_type_equals (b, CALC_NUMBER_TYPE_INTEGER);
+  assert_num_equals_ui (b, 1);
+  assert (calc_number_sin (&b, a) == 0);
+  assert_num_equals_ui (b, 0);
+  g_object_unref (a);
+  a = calc_number_new_str ("9/4");
+  assert (calc_number_sqrt (&b, a) == 0);
+  assert_num_type_equals (b, CALC_NUMBER_TYPE_RATIONAL);
+  assert_num_equals_d (b, 1.5);
+
+  /* Everything else is rounded at the default precision */
+  g_object_unref (a);
+  a = calc_number_new_ui (2);
+  calc_number_sqrt (&b, a);
+  assert_num_type_equals (b, CALC_NUMBER_TYPE_FLOATING);
+  assert_num_equals_d (b, sqrt (2.0));
+  calc_number_atan (&b, a);
+  assert_num_equals_d (b, atan (2.0));
+
+  /* Constants follow the precision override */
+  c = calc_number_new_const (CALC_CONSTANT_PI);
+  assert_num_equals_d (c, M_PI);
+  calc_value_set_prec_override (256);
+  calc_value_set_const (&c->value, CALC_CONSTANT_PI);
+  assert (calc_number_get_prec (c) == 256);
+  calc_number_cos (&b, c);
+  assert_num_equals_si (b, -1);
+  calc_value_set_prec_override (0);
+
+  g_object_unref (a);
+  g_object_unref (b);
+  g_object_unref (c);
+  return 0;
+}
@@ -0,0 +1,103 @@
+/*************************************************************************
+ * print-str.c -- This file is part of libcalc.                          *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "libtest.h"
+
+static void
+assert_prints (CalcExpr *expr, const CalcPrintFormat *format,
+	       const char *expected)
+{
+  char *text = calc_expr_to_string (expr, format);
+  assert (strcmp (text, expected) == 0);
+  g_free (text);
+}
+
+/* The stdio and string sinks must produce identical text */
+
+static void
+assert_prints_stream (CalcExpr *expr, const char *expected)
+{
+  char *text;
+  size_t len;
+  FILE *stream = open_memstream (&text, &len);
+  calc_expr_print (expr, stream);
+  fclose (stream);
+  assert (strcmp (text, expected) == 0);
+  assert_prints (expr, NULL, expected);
+  free (text);
+}
+
+int
+main (void)
+{
+  CalcPrintFormat format = CALC_PRINT_FORMAT_INIT;
+  CalcNumber *a = calc_number_new_si (-42);
+  CalcNumber *b = calc_number_new_str ("-3/4");
+  CalcNumber *c = calc_number_new_d (1.5);
+  CalcNumber *d = calc_number_new_str ("1267650600228229401496703205376");
+  CalcVariable *x = calc_variable_new ("x");
+  CalcSum *sum = calc_sum_new (CALC_EXPR (x));
+  GString *str = g_string_new (NULL);
+  char buffer[8];
+
+  assert_prints_stream (CALC_EXPR (a), "-42");
+  assert_prints_stream (CALC_EXPR (b), "-3/4");
+  assert_prints_stream (CALC_EXPR (c), "1.50000000");
+  assert_prints_stream (CALC_EXPR (d), "1267650600228229401496703205376");
+  calc_sum_add_term (sum, CALC_EXPR (b));
+  assert_prints_stream (CALC_EXPR (sum), "(1((x)^(1)))-(3/4)");
+
+  /* Floating-point formats */
+  format.precision = 3;
+  format.conversion = 'e';
+  assert_prints (CALC_EXPR (c), &format, "1.500e+00");
+  format.precision = 40;
+  format.conversion = 'f';
+  assert_prints (CALC_EXPR (c), &format,
+		 "1.5000000000000000000000000000000000000000");
+
+  /* Appending to a reused string */
+  calc_expr_print_string (CALC_EXPR (a), str, NULL);
+  g_string_append_c (str, ',');
+  calc_expr_print_string (CALC_EXPR (c), str, &format);
+  g_string_append_c (str, ',');
+  calc_expr_print_string (CALC_EXPR (sum), str, NULL);
+  assert (strcmp (str->str, "-42,1.5000000000000000000000000000000000000000,"
+		  "(1((x)^(1)))-(3/4)") == 0);
+
+  /* Printing into a caller buffer truncates like snprintf() */
+  assert (calc_expr_print_buffer (CALC_EXPR (a), buffer, sizeof (buffer),
+				  NULL) == 3);
+  assert (strcmp (buffer, "-42") == 0);
+  assert (calc_expr_print_buffer (CALC_EXPR (sum), buffer, sizeof (buffer),
+				  NULL) == 18);
+  assert (strcmp (buffer, "(1((x)^") == 0);
+  assert (calc_expr_print_buffer (CALC_EXPR (d), NULL, 0, NULL) == 31);
+
+  g_string_free (str, TRUE);
+  g_object_unref (sum);
+  g_object_unref (x);
+  g_object_unref (a);
+  g_object_unref (b);
+  g_object_unref (c);
+  g_object_unref (d);
+  return 0;
+}
@@ -0,0 +1,58 @@
+/*************************************************************************
+ * value-arith.c -- This file is part of libcalc.                        *
+ * Copyright (C) 2020 XNSC                                               *
+ *                                                                       *
+ * libcalc is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * libcalc is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have received a copy of the GNU General Public License     *
+ * along with this program. If not, see <https://www.gnu.org/licenses/>. *
+ *************************************************************************/
+
+#include "libtest.h"
+
+#define TEST_COUNT 100
+
+int
+main (void)
+{
+  CalcValue total;
+  CalcValue term;
+  CalcValue big;
+  int i;
+
+  /* Results may share storage with their operands */
+  calc_value_init (&total);
+  calc_value_init_ui (&term, 1);
+  calc_value_div_ui (&term, &term, 3);
+  for (i = 0; i < TEST_COUNT * 3; i++)
+    calc_value_add (&total, &total, &term);
+  assert (total.type == CALC_NUMBER_TYPE_RATIONAL);
+  assert (calc_value_cmp_ui (&total, TEST_COUNT) == 0);
+
+  /* Overflow past a machine word and come back */
+  calc_value_init_si (&big, G_MAXLONG);
+  calc_value_mul (&big, &big, &big);
+  calc_value_sub_si (&big, &big, 1);
+  calc_value_div_si (&big, &big, G_MAXLONG - 1);
+  assert (big.type == CALC_NUMBER_TYPE_INTEGER);
+  assert (calc_value_cmp_ui (&big, (unsigned long) G_MAXLONG + 1) == 0);
+  calc_value_sub (&big, &big, &big);
+  assert (calc_value_sgn (&big) == 0);
+
+  calc_value_mul_d (&total, &total, 0.5);
+  assert (total.type == CALC_NUMBER_TYPE_FLOATING);
+  assert (calc_value_cmp_d (&total, TEST_COUNT * 0.5) == 0);
+
+  calc_value_clear (&total);
+  calc_value_clear (&term);
+  calc_value_clear (&big);
+  return 0;
+}